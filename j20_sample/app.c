@@ -26,10 +26,22 @@
 #include "device_init.h"
 #include "app_bt.h"
 #include "mcu_parser.h"
+#include "level.h"
+#include "cycle_count.h"
 
 
 volatile uint16_t app_audio_int = 0;
 
+uint32_t app_boot_us[APP_BOOT_NUM];
+static uint32_t app_boot_cycles;            /* count at the last stamp */
+static uint32_t app_boot_elapsed_us;        /* us at the last stamp */
+static uint32_t app_boot_stamped;           /* one bit per stage */
+
+static const char *const app_boot_names[APP_BOOT_NUM] =
+{
+    "main", "device", "dsp", "audio start", "audio out", "ble", "dsp full"
+};
+
 //这是传给libosj20 作为license 验证，此处没有实现，默认lib 会隔断时间播放滴滴声,正式商用需采用正确的security_key
 uint8_t security_key[64] = {0x1,0x2,0x3,0x4};
 
@@ -61,6 +73,7 @@ void APP_Initialize (void)
     APP_Audio_Init();
     /* Load Codec */
     App_Codec_Load();
+    APP_Boot_Stamp(APP_BOOT_DSP);
 
 	APP_DMIC_Init();
 	APP_OD_Init();
@@ -91,6 +104,69 @@ void APP_Initialize (void)
 
 }
 
+/**
+ * @brief Record that a boot stage was reached
+ */
+void APP_Boot_Stamp(APP_Boot_t stage)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t now;
+
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    if (stage == APP_BOOT_MAIN)
+    {
+        Cycle_Count_Init();
+        app_boot_cycles = Cycle_Count_Get();
+#if APP_BOOT_GPIO_ENABLED
+        SYS_GPIO_CONFIG(APP_BOOT_GPIO, (GPIO_MODE_GPIO_OUT | GPIO_LPF_DISABLE | GPIO_2X_DRIVE));
+        Sys_GPIO_Set_High(APP_BOOT_GPIO);
+#endif /* APP_BOOT_GPIO_ENABLED */
+    }
+#if APP_BOOT_GPIO_ENABLED
+    if (stage == APP_BOOT_AUDIO_OUT)
+        Sys_GPIO_Set_Low(APP_BOOT_GPIO);
+#endif /* APP_BOOT_GPIO_ENABLED */
+    now = Cycle_Count_Get();
+    app_boot_elapsed_us += (now - app_boot_cycles) / (SystemCoreClock / 1000000);
+    app_boot_cycles = now;
+    app_boot_us[stage] = app_boot_elapsed_us;
+    app_boot_stamped |= 1u << stage;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Print the boot stages once every stage is stamped
+ */
+void APP_Boot_Report(void)
+{
+    static bool audio_reported = false;
+    static bool reported = false;
+
+    /* First audio on its own, so it is there even if a later stage never
+     * comes, as in main_simple */
+    if (!audio_reported && (app_boot_stamped & (1u << APP_BOOT_AUDIO_OUT)) != 0)
+    {
+        audio_reported = true;
+        if (app_boot_us[APP_BOOT_AUDIO_OUT] > APP_BOOT_AUDIO_TARGET_US)
+            swmLogWarn("boot: first audio after %lu us, target %lu us\r\n",
+                       (unsigned long)app_boot_us[APP_BOOT_AUDIO_OUT], (unsigned long)APP_BOOT_AUDIO_TARGET_US);
+        else
+            swmLogInfo("boot: first audio after %lu us\r\n", (unsigned long)app_boot_us[APP_BOOT_AUDIO_OUT]);
+    }
+
+    if (reported || app_boot_stamped != (1u << APP_BOOT_NUM) - 1)
+        return;
+    reported = true;
+
+    for (int i = 0; i < APP_BOOT_NUM; i++)
+        swmLogInfo("boot %-12s %7lu us\r\n", app_boot_names[i], (unsigned long)app_boot_us[i]);
+    swmLogInfo("boot: longest deferred region load %lu us from the main loop, DSP frame 1024 us\r\n",
+               (unsigned long)App_Codec_DeferredTime());
+    if (App_Codec_Deferred() != 0)
+        swmLogWarn("boot: DSP regions not loaded, Control bits 0x%04x stay off\r\n",
+                   (unsigned)App_Codec_Deferred());
+}
+
 /**
  * @brief Disable interrupts
  */
@@ -140,70 +216,40 @@ void APP_DisableAudioPath(void)
 extern int sine_wav[];
 void APP_PlayPCM() {
 	//这是 16k采样率， int32 数组
-	int total_bytes =  48*4;
+	//The stream resampler takes it to the SM_Dec rate, so any source rate works here
 	int sine_wav_gained[48];
 	for (int i=0;i<48;i++)
 		sine_wav_gained[i] = sine_wav[i]>>8;
 
-	uint8_t* arr_playfile = (uint8_t*)sine_wav_gained;
 	 int index_encoded =0;
-	 int buffer_idx = 0;
-	 //16个int *3
-	 //这里假设arr_encodeddata是uint8_t
-	 //total 3+2+3+48*4 =200
-	 //uint8_t arr_flags[3];
-	 //uint8_t mixe;
-	 //uint8_t pcm_process;
-	 //int    arr_data[16][3];
-
-	 uint8_t* Buffer_PCM  = (uint8_t*)&RSL20_Buffer.SM_Dec[0];
-	 //头3个字节是3个buffer的flag
-	 uint8_t* arr_flags = (uint8_t*)Buffer_PCM;
-	 //Decode 区块一共 16*2*4 = 128 byte
-	  memset(Buffer_PCM,0,AUDIO_BLOCK_SIZE*2*4);
+	 int loops_256 =0;
+
+	  //APP_Audio_StreamOpen 设置 mixed=1, processed=1
 	  //1，1 配置没有电流音，耳朵里可听到滴滴，对MIC吹气，也可听到吹气
 	  //1 ,0 才表示经过算法处理 ,无电流音，可感知AFC,也通过调节volume ,知道经过算法
 	  // processed = 0,才表示经过算法处理 ,无电流音，可感知AFC,也通过调节volume ,知道经过算法
 
 	  //0,0 电流音
 	  //0,1  也有电流音
-	  Buffer_PCM[3] = 1;  //mixed
-	  Buffer_PCM[4] = 1;  //processed
+	 APP_Audio_StreamOpen(16000);
 
 	 //以下两句是mute 了DMIC ,可以不Mute的（如果希望同时听到音乐和助听器声音)
 	  AUDIO->DMIC0_GAIN =0x0;
 	  AUDIO->DMIC1_GAIN =0x0;
 
-
-
-	  int loops_256 =0;
-
-    while (index_encoded <= (total_bytes-64) ) {
-
-		if (arr_flags[buffer_idx] ==0) {
-
-				memcpy((uint8_t*)&Buffer_PCM[8+64*buffer_idx],
-						(void*)&arr_playfile[index_encoded],
-				16*4);
-				index_encoded +=64;
-				if (index_encoded >=192)  {
-					index_encoded = 0;
-					loops_256++;
-
-				}
-
-				arr_flags[buffer_idx]=1;
-
-				buffer_idx ++;
-				buffer_idx &=0x02;
-				SYS_WATCHDOG_REFRESH();
-
-				if (loops_256>100)  break;
-
+    while (loops_256 <= 100) {
+		index_encoded += APP_Audio_StreamWrite(&sine_wav_gained[index_encoded], 48 - index_encoded);
+		if (index_encoded >= 48) {
+			index_encoded = 0;
+			loops_256++;
 		}
+		APP_Audio_StreamPump();
+		App_Codec_Poll();
+		SYS_WATCHDOG_REFRESH();
     }
     AUDIO->DMIC0_GAIN =0x800;
    	AUDIO->DMIC1_GAIN =0x800;
+	APP_Audio_StreamClose();
 
 }
 
@@ -212,6 +258,8 @@ int log_tickcnt = 0;
 int ccc = 0;
 int main_simple(void)
 {
+    APP_Boot_Stamp(APP_BOOT_MAIN);
+
     /* General System Initialization */
     Device_Initialize();
 
@@ -242,9 +290,9 @@ int main_simple(void)
 	{
 
 
-		#define LOG_RMS_DBFS(A) 		((int)((float)SM_Ptr->UPLOAD.RMS_dBSPL[A]/128.0f))
-		#define GAIN_DB(A) 			((int)(20*log10(MAX(1,SM_Ptr->UPLOAD.Gain_8Band[A])/32.0f)))
-		#define W_DBFS(A) 			((int)(20*log10(MAX(1,SM_Ptr->UPLOAD.NC_Dump[37+A])/32.0f)))
+		#define LOG_RMS_DBFS(A) 		(SM_Ptr->UPLOAD.RMS_dBSPL[A]/128)
+		#define GAIN_DB(A) 			((LVL_AmpDb(MAX(1,SM_Ptr->UPLOAD.Gain_8Band[A]))-LVL_AmpDb(32))/256)
+		#define W_DBFS(A) 			((LVL_AmpDb(MAX(1,SM_Ptr->UPLOAD.NC_Dump[37+A]))-LVL_AmpDb(32))/256)
 		loops = 0;
 		SM_UPLOAD_DATA* Ptr = &SM_Ptr->UPLOAD;
 		swmLog(SWM_LOG_LEVEL_WARNING,"RMS_dBFs:%d,%d,%d,%d,%d,%d,%d,%d\n",LOG_RMS_DBFS(0),LOG_RMS_DBFS(1),LOG_RMS_DBFS(2),LOG_RMS_DBFS(3),LOG_RMS_DBFS(4),LOG_RMS_DBFS(5),LOG_RMS_DBFS(6),LOG_RMS_DBFS(7));
@@ -276,6 +324,11 @@ int main_simple(void)
         /* Wait for interrupts */
         //__WFI();
 		Check_Timing();
+		App_Codec_Poll();
+		APP_Boot_Report();
+		APP_Audio_Scene();
+		APP_Audio_Wind();
+		APP_Audio_StreamPump();
 
 
 
@@ -291,8 +344,11 @@ int main_simple(void)
 
 #define ENABLE_HA  1
 int main_full() {
+	    APP_Boot_Stamp(APP_BOOT_MAIN);
+
 	  /* Initialize the application*/
 	    App_Init();
+	    APP_Boot_Stamp(APP_BOOT_DEVICE);
 
 
 
@@ -302,19 +358,24 @@ int main_full() {
 	        .app_sleep_request = false, /* No sleep */
 	    };
 
-	    /* Initialize Bluetooth Stack */
-	    BT_InitOptions_t options;
-	    options.power_supply_cfg = power_supply_cfg;
-	    BT_Stack_Init(&options);
-
-	    /* APP-specific Initialization */
-
+	    /* Staged boot: the audio path comes first. APP_Initialize loads the
+	     * DSP without the deferred regions; App_Codec_Poll loads them from the
+	     * loops below once the output runs. */
 	       APP_Initialize();
 
 
 	    /* Enable Interrupts that were disabled in Device_Initialize() */
 	    App_EnableInterrupts();
 
+	    /* Start DMIC to run audio path */
+	       APP_Audio_Start();
+	    APP_Boot_Stamp(APP_BOOT_AUDIO_START);
+
+	    /* Initialize Bluetooth Stack */
+	    BT_InitOptions_t options;
+	    options.power_supply_cfg = power_supply_cfg;
+	    BT_Stack_Init(&options);
+
 	    /* Initialize Bluetooth Services */
 	    BatteryServiceServerInit();
 	    DeviceInformationServiceServerInit();
@@ -327,14 +388,13 @@ int main_full() {
 
 	    /* Configure the Bluetooth stack and app */
 	    App_BTConfig();
+	    APP_Boot_Stamp(APP_BOOT_BLE);
 
 	    //2025-05-09：此时频响曲线和第一次打开网页，点save config 的不一样，是不是网页的默认值和这里的默认值不太对？强制执行J20_UPDATE_DSP ?
 	    //  app_env_cs.rx_changed ==1;
 
 	    //另外markgain 参数还没起作用，以后改
 
-	    /* Start DMIC to run audio path */
-	       APP_Audio_Start();
 	     //2025-08-04：此处展示了如何播放纯音，也可以改为从BT 传来的音乐数据，或任何语音提示
 	       //APP_PlayPCM 支持和助听器DMIC的数据混音，以及对BT数据进行LPDSP32的算法处理
 	       APP_PlayPCM();
@@ -346,6 +406,11 @@ int main_full() {
 	   // 	Check_Timing();
 
 	         J20_UPDATE_DSP();
+	         App_Codec_Poll();
+	         APP_Boot_Report();
+	         APP_Audio_Scene();
+	         APP_Audio_Wind();
+	         APP_Audio_StreamPump();
 
 
 	         extern short dmic_int;
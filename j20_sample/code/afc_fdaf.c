@@ -0,0 +1,191 @@
+/**
+ * @file afc_fdaf.c
+ * @brief Subband frequency-domain adaptive feedback canceller (Pre-FDAF)
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "basic_op.h"
+#include "afc_fdaf.h"
+#include "level.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define FDAF_TAP_Q                  24
+
+/* Log2 power (Q8) of a full-scale white Word32 signal in one bin: 2^62 per
+ * sample times the window energy of 2^5 */
+#define FDAF_LOG_FULL_SCALE         (67 << 8)
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Smooth the reference power linearly while keeping it in log2 Q8
+ * @note  P' = 0.75 P + 0.25 |X|^2, as P + log2(0.75 + 0.25 * 2^(L - P)).
+ *        Smoothing the log directly would sit several dB under the mean
+ *        power and let the normalized step overshoot.
+ */
+static Word32 fdaf_power_update(Word32 p, Word32 l)
+{
+    Word32 d = l - p;
+    Word32 y;
+    UWord32 v;
+
+    if (d >= (14 << 8))
+        return l - (2 << 8);
+    if (d < -(16 << 8))
+        d = -(16 << 8);
+
+    /* 2^(16 + d) */
+    y = d + (16 << 8);
+    v = LVL_Pow2Frac(y & 0xFF);
+    v = ((y >> 8) >= 16) ? (v << ((y >> 8) - 16)) : (v >> (16 - (y >> 8)));
+
+    return p + LVL_Log2(49152u + (v >> 2)) - (16 << 8);
+}
+
+static Word32 fdaf_shift(int64_t v, int sh)
+{
+    v = (sh >= 0) ? (v >> sh) : (v << -sh);
+    if (v > MAX_32)
+        return MAX_32;
+    if (v < MIN_32)
+        return MIN_32;
+    return (Word32)v;
+}
+
+static int fdaf_speed(int speed)
+{
+    return ((speed < 0) ? 0 : ((speed > FDAF_SPEED_MAX) ? FDAF_SPEED_MAX : speed)) + FDAF_MU_SHIFT;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Reset the canceller and bind the parameter block
+ */
+void FDAF_Init(FDAF_State_t *fdaf, const SM_CONFIG_FBC *cfg)
+{
+    memset(fdaf, 0, sizeof(*fdaf));
+    fdaf->cfg = cfg;
+    FB_Init(&fdaf->ref_fb);
+}
+
+/**
+ * @brief Subtract the feedback estimate from the microphone spectrum and adapt
+ */
+void FDAF_Process(FDAF_State_t *fdaf, const FB_State_t *fb, FB_Spectrum_t *spec)
+{
+    const SM_CONFIG_FBC *cfg = fdaf->cfg;
+    int leak = cfg->LeakNorm;
+    Word32 floor_log = FDAF_LOG_FULL_SCALE - 2 * 256 * (Word32)(unsigned char)cfg->Power_NormalizationBias;
+    int idle = fdaf_speed(cfg->Idle_Speed);
+
+    if (!cfg->Pre_Adaptive_Filter)
+        return;
+
+    leak = (leak <= 0) ? 0 : (17 - ((leak > 15) ? 15 : leak));
+
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word32 d = FB_GetBin(fb, spec, k);
+        int64_t y_re = 0;
+        int64_t y_im = 0;
+        Word32 e;
+        Word32 p;
+        Word32 m;
+        int i;
+        int speed;
+
+        /* Feedback estimate, accumulated in Q24 at the microphone exponent */
+        for (int t = 0; t < FDAF_TAPS; t++)
+        {
+            Word32 x = fdaf->x[t][k];
+            int sh = spec->exp - fdaf->x_exp[t];
+            int64_t re = (int64_t)fdaf->w_re[t][k] * PK_LO(x) - (int64_t)fdaf->w_im[t][k] * PK_HI(x);
+            int64_t im = (int64_t)fdaf->w_re[t][k] * PK_HI(x) + (int64_t)fdaf->w_im[t][k] * PK_LO(x);
+
+            if (sh >= 0)
+            {
+                y_re += re >> sh;
+                y_im += im >> sh;
+            }
+            else if (sh > -16)
+            {
+                y_re += re << -sh;
+                y_im += im << -sh;
+            }
+        }
+
+        e = pk_sub(d, pk_pack(sat16(fdaf_shift(y_re, FDAF_TAP_Q)), sat16(fdaf_shift(y_im, FDAF_TAP_Q))));
+        FB_SetBin(fb, spec, k, e);
+
+        /* Normalized step mu / P with 1/P = m * 2^(1 - i) / 2^15 */
+        p = (fdaf->power[k] > floor_log) ? fdaf->power[k] : floor_log;
+        speed = (fdaf->power[k] > floor_log) ? fdaf_speed(cfg->Normalized_Adapt_Speed[(k > 0) ? (k - 1) : 0]) : idle;
+        i = (p + 255) >> 8;
+        m = (Word32)(LVL_Pow2Frac((i << 8) - p) >> 2);
+
+        for (int t = 0; t < FDAF_TAPS; t++)
+        {
+            Word32 x = fdaf->x[t][k];
+            Word32 g_re = pk_smuad(e, x);
+            Word32 g_im = pk_smusdx(x, e);
+            int sh = spec->exp + fdaf->x_exp[t] + 1 - i + FDAF_TAP_Q - speed;
+
+            g_re = Mpy_32_16(g_re, (Word16)m);
+            g_im = Mpy_32_16(g_im, (Word16)m);
+
+            if (leak)
+            {
+                fdaf->w_re[t][k] -= fdaf->w_re[t][k] >> leak;
+                fdaf->w_im[t][k] -= fdaf->w_im[t][k] >> leak;
+            }
+            fdaf->w_re[t][k] = L_add(fdaf->w_re[t][k], (sh >= 0) ? L_shl(g_re, sh) : L_shr(g_re, -sh));
+            fdaf->w_im[t][k] = L_add(fdaf->w_im[t][k], (sh >= 0) ? L_shl(g_im, sh) : L_shr(g_im, -sh));
+        }
+    }
+}
+
+/**
+ * @brief Analyze the block sent to the loudspeaker for the next frame
+ */
+void FDAF_Reference(FDAF_State_t *fdaf, const Word32 *out)
+{
+    const SM_CONFIG_FBC *cfg = fdaf->cfg;
+    int delay = (unsigned char)cfg->Pre_Delay;
+    FB_Spectrum_t ref;
+
+    if (!cfg->Pre_Adaptive_Filter)
+        return;
+
+    if (delay >= FDAF_MAX_DELAY)
+        delay = FDAF_MAX_DELAY - 1;
+
+    memmove(&fdaf->ref_delay[0], &fdaf->ref_delay[FB_HOP], FDAF_MAX_DELAY * sizeof(Word32));
+    memcpy(&fdaf->ref_delay[FDAF_MAX_DELAY], out, FB_HOP * sizeof(Word32));
+    FB_Analysis(&fdaf->ref_fb, &fdaf->ref_delay[FDAF_MAX_DELAY - delay], &ref);
+
+    memmove(&fdaf->x[1], &fdaf->x[0], (FDAF_TAPS - 1) * sizeof(fdaf->x[0]));
+    memmove(&fdaf->x_exp[1], &fdaf->x_exp[0], (FDAF_TAPS - 1) * sizeof(fdaf->x_exp[0]));
+    fdaf->x_exp[0] = ref.exp;
+
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word32 x = FB_GetBin(&fdaf->ref_fb, &ref, k);
+        UWord32 pw = (UWord32)((Word32)PK_LO(x) * PK_LO(x)) + (UWord32)((Word32)PK_HI(x) * PK_HI(x));
+        Word32 l = LVL_Log2(pw) + ref.exp * 512;
+
+        fdaf->x[0][k] = x;
+        fdaf->power[k] = fdaf_power_update(fdaf->power[k], l);
+    }
+}
@@ -0,0 +1,320 @@
+/**
+ * @file afc_nlms.c
+ * @brief Time-domain partitioned block-NLMS feedback canceller
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "basic_op.h"
+#include "afc_nlms.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AFC_QSHIFT_MIN              (-4)
+#define AFC_QSHIFT_MAX              8
+#define AFC_PART_LEN(taps)          (((taps) + AFC_PARTITIONS - 1) / AFC_PARTITIONS)
+
+/* Regularization of the reference block energy, about -70 dBFS per sample */
+#define AFC_POWER_FLOOR             ((int64_t)AFC_BLOCK << 10)
+
+#define AFC_PEM_SMOOTH              3       /* autocorrelation smoothing, 2^-3 */
+#define AFC_PEM_K_MAX               32440   /* reflection coefficient clamp, 0.99 */
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/** @brief Two consecutive Word16 as a packed pair, any alignment */
+static inline Word32 afc_pair(const Word16 *p)
+{
+    Word32 v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/** @brief Significant bits of |v| */
+static int afc_bits64(int64_t v)
+{
+    uint64_t m = (uint64_t)((v < 0) ? -v : v);
+    UWord32 hi = (UWord32)(m >> 32);
+
+    if (hi != 0)
+        return 64 - clz32(hi);
+    return 32 - clz32((UWord32)m);
+}
+
+static Word32 afc_sat32(int64_t v)
+{
+    if (v > MAX_32)
+        return MAX_32;
+    if (v < MIN_32)
+        return MIN_32;
+    return (Word32)v;
+}
+
+/**
+ * @brief Pick up length, coefficient format and crossover from the config
+ * @return true if any of them changed and the taps were reset
+ */
+static bool afc_config(AFC_State_t *afc)
+{
+    const SM_CONFIG_FBC *cfg = afc->cfg;
+    int taps = cfg->EcTaps;
+    int qshift = cfg->DerivedQshift;
+    bool split = !BQ_IsEmpty(cfg->Hp_BQs) && !BQ_IsEmpty(cfg->Lp_BQs);
+
+    taps = (taps < 2) ? 2 : ((taps > AFC_MAX_TAPS) ? AFC_MAX_TAPS : ((taps + 1) & ~1));
+    qshift = (qshift < AFC_QSHIFT_MIN) ? AFC_QSHIFT_MIN : ((qshift > AFC_QSHIFT_MAX) ? AFC_QSHIFT_MAX : qshift);
+
+    if ((taps == afc->taps) && (qshift == afc->qshift) && (split == afc->split))
+        return false;
+
+    afc->taps = taps;
+    afc->qshift = qshift;
+    afc->split = split;
+    afc->part = 0;
+    memset(afc->w, 0, sizeof(afc->w));
+    memset(afc->wr, 0, sizeof(afc->wr));
+    BQ_Reset(&afc->hp_mic);
+    BQ_Reset(&afc->lp_mic);
+    BQ_Reset(&afc->hp_ref);
+    return true;
+}
+
+/**
+ * @brief Update one tap partition with the block NLMS gradient
+ * @note  w += mu/L * sum(e*x) / sigma^2, i.e. one block update does the
+ *        work of AFC_BLOCK sample updates; sigma^2 is the smoothed power of
+ *        the prefiltered reference.
+ */
+static void afc_update(AFC_State_t *afc, const Word16 *ew)
+{
+    const SM_CONFIG_FBC *cfg = afc->cfg;
+    int64_t energy = (afc->ref_energy + AFC_POWER_FLOOR) / AFC_BLOCK;
+    int len = AFC_PART_LEN(afc->taps);
+    int k0 = afc->part * len;
+    int k1 = (k0 + len < afc->taps) ? (k0 + len) : afc->taps;
+    int e_exp = afc_bits64(energy) - 31;
+    Word32 mant = (Word32)((e_exp >= 0) ? (energy >> e_exp) : (energy << -e_exp));
+    Word32 mu = (cfg->MuDivNumTaps < 0) ? 0 : ((cfg->MuDivNumTaps > MAX_16) ? MAX_16 : cfg->MuDivNumTaps);
+    int slow = (cfg->ConvergenceSpeed < 0) ? 0 : ((cfg->ConvergenceSpeed > 15) ? 15 : cfg->ConvergenceSpeed);
+    Word32 step;
+
+    afc->part = (afc->part + 1) % AFC_PARTITIONS;
+
+    /* mu / energy = step * 2^-(61 + e_exp), with one 32-bit division per frame */
+    step = mu * (MAX_32 / (mant >> 15));
+    if (step == 0)
+        return;
+
+    for (int k = k0; k < k1; k++)
+    {
+        const Word16 *xp = &afc->xw[AFC_HIST - afc->delay - k];
+        int64_t g = 0;
+        int g_exp;
+        int sh;
+        Word32 dw;
+
+        for (int n = 0; n < AFC_BLOCK; n += 2)
+            g += pk_smuad(afc_pair(&ew[n]), afc_pair(&xp[n]));
+
+        g_exp = afc_bits64(g) - 31;
+        if (g_exp < 0)
+            g_exp = 0;
+        dw = Mpy_32_32((Word32)(g >> g_exp), step);
+
+        /* Back to Q(31 + qshift) taps, then slow down by ConvergenceSpeed */
+        sh = g_exp + 1 + afc->qshift - e_exp - slow;
+        dw = (sh >= 0) ? L_shl(dw, sh) : L_shr(dw, -sh);
+
+        afc->w[k] = L_add(afc->w[k], dw);
+        afc->wr[afc->taps - 1 - k] = round_fx(afc->w[k]);
+    }
+}
+
+/**
+ * @brief Re-estimate the prediction-error filter from one block of error
+ * @note  Smoothed autocorrelation followed by Levinson-Durbin, taps in Q28
+ *        while solving.
+ */
+static void afc_pem_estimate(AFC_State_t *afc, const Word16 *e)
+{
+    int order = afc->pem_order;
+    Word32 r[AFC_PEM_MAX_ORDER + 1];
+    Word32 aq[AFC_PEM_MAX_ORDER + 1];
+    Word32 tmp[AFC_PEM_MAX_ORDER + 1];
+    Word32 err;
+    int sh;
+
+    for (int i = 0; i <= order; i++)
+    {
+        int64_t acc = 0;
+        for (int n = i; n < AFC_BLOCK; n++)
+            acc += (Word32)e[n] * e[n - i];
+        afc->corr[i] += (acc - afc->corr[i]) >> AFC_PEM_SMOOTH;
+    }
+
+    if (afc->corr[0] <= 0)
+        return;
+
+    /* Normalize to 30 bits and add a small white-noise correction */
+    sh = afc_bits64(afc->corr[0]) - 30;
+    for (int i = 0; i <= order; i++)
+        r[i] = (Word32)((sh >= 0) ? (afc->corr[i] >> sh) : (afc->corr[i] << -sh));
+    r[0] += r[0] >> 9;
+
+    aq[0] = 1 << 28;
+    err = r[0];
+    for (int i = 1; i <= order; i++)
+    {
+        int64_t acc = 0;
+        Word32 k;
+
+        for (int j = 0; j < i; j++)
+            acc += (int64_t)aq[j] * r[i - j];
+
+        k = (Word32)(-(acc >> 13) / err);
+        k = (k > AFC_PEM_K_MAX) ? AFC_PEM_K_MAX : ((k < -AFC_PEM_K_MAX) ? -AFC_PEM_K_MAX : k);
+
+        for (int j = 1; j < i; j++)
+            tmp[j] = aq[j] + (Word32)(((int64_t)k * aq[i - j]) >> 15);
+        for (int j = 1; j < i; j++)
+            aq[j] = tmp[j];
+        aq[i] = k << 13;
+
+        err -= (Word32)(((int64_t)err * (k * k)) >> 30);
+        if (err <= 0)
+            break;
+    }
+
+    for (int i = 1; i <= order; i++)
+        afc->a[i - 1] = sat16((aq[i] + (1 << 15)) >> 16);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Reset the canceller
+ */
+bool AFC_Init(AFC_State_t *afc, const SM_CONFIG_FBC *cfg, int delay, int pem_order)
+{
+    memset(afc, 0, sizeof(*afc));
+    afc->cfg = cfg;
+
+    if ((delay < AFC_BLOCK) || (delay > AFC_MAX_DELAY) ||
+        (pem_order < 0) || (pem_order > AFC_PEM_MAX_ORDER))
+        return false;
+
+    afc->delay = delay;
+    afc->pem_order = pem_order;
+    afc->taps = -1;
+    afc_config(afc);
+    return true;
+}
+
+/**
+ * @brief Cancel the feedback estimate from one microphone block, in place
+ */
+void AFC_Process(AFC_State_t *afc, Word32 *block)
+{
+    const SM_CONFIG_FBC *cfg = afc->cfg;
+    Word32 lo[AFC_BLOCK];
+    Word16 e[AFC_BLOCK];
+    Word16 ew[AFC_BLOCK];
+    int order = afc->pem_order;
+    int base;
+
+    if (!cfg->TFBC_Enable || (afc->delay == 0))
+        return;
+
+    afc_config(afc);
+
+    if (afc->split)
+    {
+        BQ_Process(cfg->Lp_BQs, &afc->lp_mic, block, lo, AFC_BLOCK);
+        BQ_Process(cfg->Hp_BQs, &afc->hp_mic, block, block, AFC_BLOCK);
+    }
+
+    /* Feedback estimate: wr holds the taps reversed so that both operands
+     * of every dual MAC run forwards through memory */
+    base = AFC_HIST - afc->delay - afc->taps + 1;
+    for (int n = 0; n < AFC_BLOCK; n++)
+    {
+        const Word16 *xp = &afc->x[base + n];
+        int64_t acc = 0;
+        Word32 y;
+
+        for (int j = 0; j < afc->taps; j += 2)
+            acc += pk_smuad(afc_pair(&afc->wr[j]), afc_pair(&xp[j]));
+
+        y = afc_sat32((afc->qshift <= 1) ? (acc << (1 - afc->qshift)) : (acc >> (afc->qshift - 1)));
+        block[n] = L_sub(block[n], y);
+        e[n] = round_fx(block[n]);
+
+        if (afc->split)
+            block[n] = L_add(lo[n], block[n]);
+    }
+
+    /* Prefilter the error with the current A(z) */
+    for (int n = 0; n < AFC_BLOCK; n++)
+    {
+        int64_t acc = (int64_t)e[n] << 12;
+
+        for (int i = 1; i <= order; i++)
+            acc += (Word32)afc->a[i - 1] * ((n >= i) ? e[n - i] : afc->e_hist[i - n - 1]);
+        ew[n] = sat16((Word32)(acc >> 12));
+    }
+    for (int i = 0; i < order; i++)
+        afc->e_hist[i] = e[AFC_BLOCK - 1 - i];
+
+    afc_update(afc, (order > 0) ? ew : e);
+
+    if (order > 0)
+        afc_pem_estimate(afc, e);
+}
+
+/**
+ * @brief Append the block sent to the loudspeaker to the reference history
+ */
+void AFC_Reference(AFC_State_t *afc, const Word32 *out)
+{
+    const SM_CONFIG_FBC *cfg = afc->cfg;
+    Word32 hi[AFC_BLOCK];
+    const Word32 *src = out;
+    int64_t energy = 0;
+
+    if (!cfg->TFBC_Enable || (afc->delay == 0))
+        return;
+
+    if (afc->split)
+    {
+        BQ_Process(cfg->Hp_BQs, &afc->hp_ref, out, hi, AFC_BLOCK);
+        src = hi;
+    }
+
+    memmove(&afc->x[0], &afc->x[AFC_BLOCK], (AFC_HIST - AFC_BLOCK) * sizeof(Word16));
+    memmove(&afc->xw[0], &afc->xw[AFC_BLOCK], (AFC_HIST - AFC_BLOCK) * sizeof(Word16));
+
+    for (int n = AFC_HIST - AFC_BLOCK; n < AFC_HIST; n++)
+    {
+        int64_t acc;
+
+        afc->x[n] = round_fx(src[n - (AFC_HIST - AFC_BLOCK)]);
+
+        acc = (int64_t)afc->x[n] << 12;
+        for (int i = 1; i <= afc->pem_order; i++)
+            acc += (Word32)afc->a[i - 1] * afc->x[n - i];
+        afc->xw[n] = sat16((Word32)(acc >> 12));
+        energy += (Word32)afc->xw[n] * afc->xw[n];
+    }
+
+    afc->ref_energy += (energy - afc->ref_energy) >> 2;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file agc.c
+ * @brief Table-driven broadband AGC for the CM33 stages
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "agc.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AGC_PEAK_MIN_DB             (-30.0)
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile dB_gain/dB_peak into the interpolated gain table
+ */
+void AGC_Parser(const MCU_Config_AGC *Cfg, SM_CONFIG_AGC *AGC_Cfg)
+{
+    double gain = Cfg->dB_gain;
+    double peak = Cfg->dB_peak;
+    double knee;
+    double ratio;
+
+    memset(AGC_Cfg, 0, sizeof(*AGC_Cfg));
+    if (gain < 0.0)
+        gain = 0.0;
+    if (gain > AGC_GAIN_MAX_DB)
+        gain = AGC_GAIN_MAX_DB;
+    if (peak > 0.0)
+        peak = 0.0;
+    if (peak < AGC_PEAK_MIN_DB)
+        peak = AGC_PEAK_MIN_DB;
+
+    /* Linear up to the knee, then one ratio from the knee to the peak line
+     * at full-scale input; gain >= 0 >= peak keeps the ratio at 1 or above */
+    knee = peak - AGC_KNEE_DB - gain;
+    ratio = -knee / AGC_KNEE_DB;
+
+    for (int j = 0; j < AGC_TABLE_POINTS; j++)
+    {
+        /* Envelope 2^k or 1.5*2^k, where 2^31 is 0 dBFS */
+        double level = 20.0 * log10(((j & 1) ? 1.5 : 1.0) * ldexp(1.0, j/2 - 31));
+        double out;
+
+        if (level <= knee)
+            out = level + gain;
+        else if (level < 0.0)
+            out = peak - AGC_KNEE_DB + (level - knee) / ratio;
+        else
+            out = peak;
+
+        AGC_Cfg->drc_Table[j] = (INT32)lround(65536.0 * pow(10.0, (out - level) / 20.0));
+    }
+
+    AGC_Cfg->drcpeakline = (INT32)(2147483647.0 * pow(10.0, peak / 20.0));
+    AGC_Cfg->point = AGC_TABLE_POINTS;
+}
+
+/**
+ * @brief Reset the envelope and bind the parameter block
+ */
+void AGC_Init(AGC_State_t *agc, const SM_CONFIG_AGC *cfg)
+{
+    memset(agc, 0, sizeof(*agc));
+    agc->cfg = cfg;
+}
+
+/**
+ * @brief Apply the table gain to one block in place
+ */
+void AGC_Process(AGC_State_t *agc, Word32 *block)
+{
+    const SM_CONFIG_AGC *cfg = agc->cfg;
+    const Word32 peakline = cfg->drcpeakline;
+    UWord32 env = agc->env;
+    Word32 g = 65536;
+
+    if (cfg->point != AGC_TABLE_POINTS)
+        return;
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        Word32 x = block[i];
+        UWord32 a = (x < 0) ? (UWord32)(-(int64_t)x) : (UWord32)x;
+        int64_t y;
+
+        /* Instant attack, release by a shift */
+        env -= env >> AGC_RELEASE_SHIFT;
+        if (a > env)
+            env = a;
+
+        /* Integer log2: the point is twice the exponent plus the first
+         * mantissa bit, the next 15 bits interpolate linearly */
+        if (env > 1)
+        {
+            int n = clz32(env);
+            UWord32 m = (env << n) << 1;
+            int j = 2 * (31 - n) + (int)(m >> 31);
+            Word16 f = (Word16)((m << 1) >> 17);
+
+            g = cfg->drc_Table[j] + Mpy_32_16(cfg->drc_Table[j + 1] - cfg->drc_Table[j], f);
+        }
+        else
+        {
+            g = cfg->drc_Table[0];
+        }
+
+        y = ((int64_t)x * g) >> 16;
+        if (y > peakline)
+            y = peakline;
+        if (y < -(int64_t)peakline)
+            y = -(int64_t)peakline;
+        block[i] = (Word32)y;
+    }
+
+    agc->env = env;
+}
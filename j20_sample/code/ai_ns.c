@@ -0,0 +1,242 @@
+/**
+ * @file ai_ns.c
+ * @brief GRU mask estimator for speech enhancement on the shared filterbank
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "ai_ns.h"
+#include "level.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AINS_FRAME_MS               (1000.0 * AUDIO_BLOCK_SIZE / AUDIO_SAMPLE_RATE)
+
+/* ----------------------------------------------------------------------------
+ * Module Variable Definitions
+ * --------------------------------------------------------------------------*/
+
+/* Placeholder until a trained model is linked; its zero magic keeps the
+ * stage unloaded */
+__attribute__((weak)) const AINS_Model_t ains_model = { 0 };
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief One-pole coefficient for a time constant in ms, Q15
+ */
+static Word16 ains_coef(double ms, double fallback)
+{
+    if (ms <= 0.0)
+        ms = fallback;
+    return sat16(lround(32768.0 * (1.0 - exp(-AINS_FRAME_MS / ms))));
+}
+
+/**
+ * @brief Bind a GRU and output layer to the model's natural-order matrices
+ */
+static void ains_bind(const AINS_Model_t *model, NNQ_GRU_t *gru, NNQ_Mat_t *out)
+{
+    gru->hidden = AINS_HIDDEN;
+    gru->shift = model->gru_shift;
+    gru->wi = (NNQ_Mat_t){ AINS_GATES, AINS_BANDS, model->gru_wi, model->gru_bi, false };
+    gru->wh = (NNQ_Mat_t){ AINS_GATES, AINS_HIDDEN, model->gru_wh, model->gru_bh, false };
+    *out = (NNQ_Mat_t){ AINS_BANDS, AINS_HIDDEN, model->out_w, model->out_b, false };
+}
+
+/**
+ * @brief Run the network on one feature vector and write the band masks
+ */
+static void ains_infer(const NNQ_GRU_t *gru, const NNQ_Mat_t *out, int out_shift,
+                       const Word16 *x, Word16 *h, Word32 *acc, Word16 *mask)
+{
+    NNQ_GRU_Step(gru, x, h);
+    NNQ_MatVec(out, h, acc);
+    for (int b = 0; b < AINS_BANDS; b++)
+        mask[b] = NNQ_Sigmoid(NNQ_Requant(acc[b], out_shift));
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile NS_LEVEL, ATTACK and RELEASE
+ */
+void AINS_Parser(const MCU_Config_AI_NS *Cfg, AINS_Config_t *cfg)
+{
+    double s = Cfg->NS_LEVEL;
+
+    if (s < 0.0)
+        s = 0.0;
+    if (s > 1.0)
+        s = 1.0;
+
+    cfg->strength = sat16(lround(32768.0 * s));
+    cfg->attack = ains_coef(Cfg->ATTACK, AINS_ATTACK_MS);
+    cfg->release = ains_coef(Cfg->RELEASE, AINS_RELEASE_MS);
+}
+
+/**
+ * @brief Reset the gains to unity and apply a configuration
+ */
+void AINS_Init(AINS_State_t *ains, const AINS_Config_t *cfg)
+{
+    memset(ains, 0, sizeof(*ains));
+    ains->cfg = *cfg;
+
+    for (int k = 0; k < FB_BINS; k++)
+        ains->gain[k] = MAX_16;
+    ains->scale = MAX_16;
+}
+
+/**
+ * @brief Check a model against this build and pack it into the arena
+ */
+bool AINS_Load(AINS_State_t *ains, const AINS_Model_t *model)
+{
+    NNQ_GRU_t gru;
+    NNQ_Mat_t out;
+    bool ok;
+
+    ains->loaded = false;
+    if (model->magic != AINS_MODEL_MAGIC || model->version != AINS_MODEL_VERSION ||
+        model->bands != AINS_BANDS || model->hidden != AINS_HIDDEN)
+        return false;
+
+    ains_bind(model, &gru, &out);
+    NNQ_ArenaInit(&ains->arena, ains->arena_buf, sizeof(ains->arena_buf));
+
+    ok = NNQ_Pack(&ains->arena, &gru.wi, &ains->gru.wi) &&
+         NNQ_Pack(&ains->arena, &gru.wh, &ains->gru.wh) &&
+         NNQ_Pack(&ains->arena, &out, &ains->out);
+    ains->gru.acc_i = NNQ_Alloc(&ains->arena, AINS_GATES * sizeof(Word32));
+    ains->gru.acc_h = NNQ_Alloc(&ains->arena, AINS_GATES * sizeof(Word32));
+    ains->acc_out = NNQ_Alloc(&ains->arena, AINS_BANDS * sizeof(Word32));
+    ains->x = NNQ_Alloc(&ains->arena, AINS_BANDS * sizeof(Word16));
+    ains->h = NNQ_Alloc(&ains->arena, AINS_HIDDEN * sizeof(Word16));
+    if (!ok || ains->h == NULL)
+        return false;
+
+    ains->gru.hidden = AINS_HIDDEN;
+    ains->gru.shift = model->gru_shift;
+    memset(ains->h, 0, AINS_HIDDEN * sizeof(Word16));
+    ains->model = model;
+    ains->loaded = true;
+    return true;
+}
+
+/**
+ * @brief Apply a new configuration
+ */
+void AINS_SetConfig(AINS_State_t *ains, const AINS_Config_t *cfg)
+{
+    ains->cfg = *cfg;
+}
+
+/**
+ * @brief Scale the fitted strength, e.g. by the scene program
+ */
+void AINS_SetScale(AINS_State_t *ains, Word16 scale)
+{
+    ains->scale = scale;
+}
+
+/**
+ * @brief Estimate the mask from one spectrum and apply it in place
+ */
+void AINS_Process(AINS_State_t *ains, const FB_State_t *fb, FB_Spectrum_t *spec)
+{
+    const AINS_Model_t *model = ains->model;
+    Word16 strength = mult_r(ains->cfg.strength, ains->scale);
+
+    if (!ains->loaded)
+        return;
+
+    /* Normalized log2 band power, Q8 to Q12 */
+    for (int b = 0; b < AINS_BANDS; b++)
+    {
+        Word32 v = FB_GetBin(fb, spec, b + 1);
+        UWord32 p = (UWord32)((Word32)PK_LO(v) * PK_LO(v)) + (UWord32)((Word32)PK_HI(v) * PK_HI(v));
+        Word32 l = LVL_Log2(p) + spec->exp * 512 - model->in_mean[b];
+
+        ains->x[b] = sat16(Mpy_32_16(l << (NNQ_Q - 8), model->in_scale[b]));
+    }
+
+    ains_infer(&ains->gru, &ains->out, model->out_shift, ains->x, ains->h, ains->acc_out, ains->mask);
+
+    /* g = 1 - strength * (1 - mask), smoothed with attack/release */
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word16 m = ains->mask[(k > 0) ? (k - 1) : 0];
+        Word16 target;
+        Word16 g = ains->gain[k];
+        Word32 v;
+
+        if (m < AINS_MASK_FLOOR)
+            m = AINS_MASK_FLOOR;
+        target = sub(MAX_16, mult(strength, sub(MAX_16, m)));
+        g = add(g, mult((target < g) ? ains->cfg.attack : ains->cfg.release, sub(target, g)));
+        ains->gain[k] = g;
+
+        v = FB_GetBin(fb, spec, k);
+        FB_SetBin(fb, spec, k, pk_pack(mult_r(PK_LO(v), g), mult_r(PK_HI(v), g)));
+    }
+}
+
+#if AINS_REFERENCE
+/**
+ * @brief Run frames of pseudo-random features through the packed and the
+ *        reference network side by side
+ */
+int AINS_Reference(AINS_State_t *ains, int frames)
+{
+    const AINS_Model_t *model = ains->model;
+    NNQ_GRU_t ref;
+    NNQ_Mat_t ref_out;
+    Word32 acc_i[AINS_GATES];
+    Word32 acc_h[AINS_GATES];
+    Word32 acc[AINS_BANDS];
+    Word16 h[AINS_HIDDEN] = { 0 };
+    Word16 mask[AINS_BANDS];
+    UWord32 s = 0x2502A5A5u;
+    int bad = 0;
+
+    if (!ains->loaded)
+        return -1;
+
+    ains_bind(model, &ref, &ref_out);
+    ref.acc_i = acc_i;
+    ref.acc_h = acc_h;
+    memset(ains->h, 0, AINS_HIDDEN * sizeof(Word16));
+
+    for (int f = 0; f < frames; f++)
+    {
+        for (int b = 0; b < AINS_BANDS; b++)
+        {
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            ains->x[b] = (Word16)((Word32)s >> 18);     /* +/-2 in Q12 */
+        }
+
+        ains_infer(&ains->gru, &ains->out, model->out_shift, ains->x, ains->h, ains->acc_out, ains->mask);
+        ains_infer(&ref, &ref_out, model->out_shift, ains->x, h, acc, mask);
+
+        if (memcmp(h, ains->h, sizeof(h)) != 0 || memcmp(mask, ains->mask, sizeof(mask)) != 0)
+            bad++;
+    }
+
+    memset(ains->h, 0, AINS_HIDDEN * sizeof(Word16));
+    return bad;
+}
+#endif
@@ -18,10 +18,32 @@
  * Include files
  * --------------------------------------------------------------------------*/
 
+#include <string.h>
 #include "app.h"
 #include "app_audio.h"
 #include "app_od_dmic.h"
 #include "mcu_parser.h"
+#include "cycle_count.h"
+#include "basic_op.h"
+#include "filterbank.h"
+#include "nr_wiener.h"
+#include "afc_nlms.h"
+#include "afc_fdaf.h"
+#include "limiter.h"
+#include "dyn_eq.h"
+#include "agc.h"
+#include "xover.h"
+#include "audiometry.h"
+#include "tinnitus.h"
+#include "ai_ns.h"
+#include "vad.h"
+#include "scene.h"
+#include "howl.h"
+#include "wind.h"
+#include "nfc.h"
+#include "fshift.h"
+#include "transient.h"
+#include "resample.h"
 
 /* ----------------------------------------------------------------------------
  * Module Variable Definitions
@@ -29,6 +51,52 @@
 
 static bool app_run;
 
+volatile uint32_t app_stage_control = 0;
+uint32_t app_stage_cycles[APP_STAGE_NUM];
+uint32_t app_stage_cycles_max[APP_STAGE_NUM];
+uint32_t app_stage_cycles_saved;
+
+static FB_State_t app_fb;
+static FB_Spectrum_t app_spec;
+static NR_State_t app_nr;
+static AFC_State_t app_afc;
+static FDAF_State_t app_fdaf;
+static LIM_State_t app_lim;
+static DYNEQ_State_t app_dyneq;
+static AGC_State_t app_agc;
+static SM_CONFIG_AGC app_agc_cfg;   /* CM33 only; ShareMemoryData is sized by the DSP library */
+static XO_State_t app_xo;
+static Word32 app_xo_band[XO_MAX_BANDS][AUDIO_BLOCK_SIZE];
+static AUD_State_t app_aud;
+static TM_State_t app_tm;
+static AINS_State_t app_ains;
+static VAD_State_t app_vad;
+static SCENE_State_t app_scene;
+static HOWL_State_t app_howl;
+static WIND_State_t app_wind;
+static NFC_State_t app_nfc;
+static FSHIFT_State_t app_fshift;
+static TR_State_t app_tr;
+static SRC_Config_t app_src_cfg;
+static SRC_State_t app_src;
+static bool app_stream_open;
+static int app_stream_buf;          /* next SM_Dec buffer to fill */
+static volatile uint32_t app_frames;
+static uint32_t app_scene_frame;
+static uint32_t app_wind_frame;
+static int app_wind_step;           /* shelf step loaded in the DSP */
+
+/* Broadband AGC curve, fitted in bytes 106-107; 0 dB gain and peak line
+ * until then */
+MCU_Config_AGC MCU_AGC = { 0.0f, 0.0f };
+
+/* Frequency compression; off until the fitting sets a cutoff */
+MCU_Config_NFC MCU_NFC = { 0.0f, 1.0f };
+
+/* Feedback decorrelation shift; not part of the fitting protocol, which only
+ * switches it through the FSHIFT Control bit */
+MCU_Config_FSHIFT MCU_FSHIFT = { 5.0f };
+
 /** Forward definition of the context structure type */
 struct asrc_context;
 
@@ -65,6 +133,9 @@ static void stateASRCInDMADone(asrc_context_t *context);
 static void stateASRCDone(asrc_context_t *context);
 static void Enable_Output(uint32_t channel);
 static void Reset_Audio_State(void);
+static Word32 *App_Audio_Block(void);
+static const Word32 *App_Audio_Input(void);
+static void App_Stage_Cycles(APP_Stage_t stage, uint32_t cycles);
 /* ----------------------------------------------------------------------------
  * Function Definitions
  * --------------------------------------------------------------------------*/
@@ -75,6 +146,16 @@ static void Reset_Audio_State(void);
 void APP_Audio_Init(void)
 {
     int32_t i;
+    LIM_Config_t lim_cfg;
+    DYNEQ_Config_t dyneq_cfg;
+    XO_Config_t xo_cfg;
+    AINS_Config_t ains_cfg;
+    VAD_Config_t vad_cfg;
+    SCENE_Config_t scene_cfg;
+    WIND_Config_t wind_cfg;
+    NFC_Config_t nfc_cfg;
+    FSHIFT_Config_t fshift_cfg;
+    TR_Config_t tr_cfg;
 
     Reset_Audio_State();
     Fill_SmData_Buffer();
@@ -85,6 +166,38 @@ void APP_Audio_Init(void)
 
     AUDIO->INT_CFG = APP_AUDIO_INT_CFG;
 
+    FB_Init(&app_fb);
+    NR_Init(&app_nr, &SM_Ptr->NS_ShareMem);
+    AFC_Init(&app_afc, &SM_Ptr->FBC_ShareMem, APP_AFC_DELAY, APP_AFC_PEM_ORDER);
+    FDAF_Init(&app_fdaf, &SM_Ptr->FBC_ShareMem);
+    LIM_Parser(&MCU_AGCO, &lim_cfg);
+    LIM_Init(&app_lim, &lim_cfg);
+    DYNEQ_Parser(&MCU_DPEQ, &MCU_EQ, &dyneq_cfg);
+    DYNEQ_Init(&app_dyneq, &dyneq_cfg);
+    AGC_Parser(&MCU_AGC, &app_agc_cfg);
+    AGC_Init(&app_agc, &app_agc_cfg);
+    XO_Parser(&MCU_WDRC, &xo_cfg);
+    XO_Init(&app_xo, &xo_cfg);
+    AUD_Init(&app_aud);
+    TM_Init(&app_tm);
+    AINS_Parser(&MCU_AI_NS, &ains_cfg);
+    AINS_Init(&app_ains, &ains_cfg);
+    AINS_Load(&app_ains, &ains_model);
+    VAD_Parser(MCU_WDRC.maxdB, &vad_cfg);
+    VAD_Init(&app_vad, &vad_cfg);
+    SCENE_Parser(MCU_WDRC.maxdB, &scene_cfg);
+    SCENE_Init(&app_scene, &scene_cfg);
+    HOWL_Init(&app_howl);
+    WIND_Parser(&wind_cfg);
+    WIND_Init(&app_wind, &wind_cfg);
+    NFC_Parser(&MCU_NFC, &nfc_cfg);
+    NFC_Init(&app_nfc, &nfc_cfg);
+    FSHIFT_Parser(MCU_FSHIFT.Shift_Hz, &fshift_cfg);
+    FSHIFT_Init(&app_fshift, &fshift_cfg);
+    TR_Parser(MCU_WDRC.maxdB, &tr_cfg);
+    TR_Init(&app_tr, &tr_cfg);
+    Cycle_Count_Init();
+
 
 
 
@@ -112,6 +225,236 @@ void Check_Timing()
 
 
 
+/**
+ * @brief Recompile the stage parameters that come from the MCU_* fitting data
+ * @note  The parameters are compiled in floating point from the main loop and
+ *        handed over with interrupts masked, so a frame never sees half of
+ *        an update.
+ */
+void APP_Audio_Config(void)
+{
+    LIM_Config_t lim_cfg;
+    DYNEQ_Config_t dyneq_cfg;
+    SM_CONFIG_AGC agc_cfg;
+    XO_Config_t xo_cfg;
+    AINS_Config_t ains_cfg;
+    VAD_Config_t vad_cfg;
+    SCENE_Config_t scene_cfg;
+    NFC_Config_t nfc_cfg;
+    FSHIFT_Config_t fshift_cfg;
+    TR_Config_t tr_cfg;
+
+    LIM_Parser(&MCU_AGCO, &lim_cfg);
+    DYNEQ_Parser(&MCU_DPEQ, &MCU_EQ, &dyneq_cfg);
+    AGC_Parser(&MCU_AGC, &agc_cfg);
+    XO_Parser(&MCU_WDRC, &xo_cfg);
+    AINS_Parser(&MCU_AI_NS, &ains_cfg);
+    VAD_Parser(MCU_WDRC.maxdB, &vad_cfg);
+    SCENE_Parser(MCU_WDRC.maxdB, &scene_cfg);
+    NFC_Parser(&MCU_NFC, &nfc_cfg);
+    FSHIFT_Parser(MCU_FSHIFT.Shift_Hz, &fshift_cfg);
+    TR_Parser(MCU_WDRC.maxdB, &tr_cfg);
+
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    LIM_SetConfig(&app_lim, &lim_cfg);
+    DYNEQ_SetConfig(&app_dyneq, &dyneq_cfg);
+    app_agc_cfg = agc_cfg;
+    XO_SetConfig(&app_xo, &xo_cfg);
+    AINS_SetConfig(&app_ains, &ains_cfg);
+    VAD_SetConfig(&app_vad, &vad_cfg);
+    SCENE_SetConfig(&app_scene, &scene_cfg);
+    NFC_SetConfig(&app_nfc, &nfc_cfg);
+    FSHIFT_SetConfig(&app_fshift, &fshift_cfg);
+    TR_SetConfig(&app_tr, &tr_cfg);
+    if (nfc_cfg.cutoff < FB_BINS)
+        app_stage_control |= APP_STAGE_MASK(APP_STAGE_NFC);
+    else
+        app_stage_control &= ~APP_STAGE_MASK(APP_STAGE_NFC);
+    __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
+
+    /* Fill_SmData_Buffer() reloaded the fitted PRE_BQ sections */
+    app_wind_step = 0;
+}
+
+/**
+ * @brief Start or stop an audiometry tone from a BLE command payload
+ * @note  The tone is calibrated against MCU_WDRC.maxdB and plays ahead of
+ *        the limiter. AUD_Parser() refuses levels above the limiter ceiling
+ *        instead of letting the limiter or the AUD_Process() clamp cut them,
+ *        so an accepted level is presented as asked.
+ */
+bool APP_Audio_Audiometry(const uint8_t *cmd)
+{
+    AUD_Presentation_t p;
+
+    if (!AUD_Parser(cmd, MCU_WDRC.maxdB, app_lim.ceiling, &p))
+        return false;
+
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    AUD_Start(&app_aud, &p);
+    app_stage_control |= APP_STAGE_MASK(APP_STAGE_AUD);
+    __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
+    return true;
+}
+
+/**
+ * @brief Load a tinnitus masker preset from a BLE command payload
+ * @note  The masker runs ahead of the limiter, so with MIX_MIC the sum of
+ *        noise and amplified sound still respects the output ceiling.
+ */
+bool APP_Audio_Masker(const uint8_t *preset)
+{
+    TM_Config_t cfg;
+
+    if (!TM_Parser(preset, MCU_WDRC.maxdB, &cfg))
+        return false;
+
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    TM_SetConfig(&app_tm, &cfg);
+    app_stage_control |= APP_STAGE_MASK(APP_STAGE_TM);
+    __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
+    return true;
+}
+
+/**
+ * @brief Switch the APP_STAGE_FITTED stages from a BLE command payload
+ * @note  Bits outside APP_STAGE_FITTED are ignored and keep their state.
+ */
+void APP_Audio_Stages(const uint8_t *cmd)
+{
+    uint32_t mask = (uint32_t)cmd[0] | ((uint32_t)cmd[1] << 8) |
+                    ((uint32_t)cmd[2] << 16) | ((uint32_t)cmd[3] << 24);
+
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    app_stage_control = (app_stage_control & ~APP_STAGE_FITTED) | (mask & APP_STAGE_FITTED);
+    __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
+}
+
+/**
+ * @brief Classify the acoustic scene and morph the program, from the main loop
+ * @note  Runs once per SCENE_PERIOD frames on a snapshot of UPLOAD taken with
+ *        interrupts masked. The audio path only reads the morphed program,
+ *        two halfwords that are written atomically.
+ */
+void APP_Audio_Scene(void)
+{
+    SM_UPLOAD_DATA upload;
+    uint32_t start;
+
+    if (!(app_stage_control & APP_STAGE_MASK(APP_STAGE_SCENE)) ||
+        (app_frames - app_scene_frame) < SCENE_PERIOD)
+        return;
+    app_scene_frame = app_frames;
+
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    upload = SM_Ptr->UPLOAD;
+    __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
+
+    start = Cycle_Count_Get();
+    SCENE_Classify(&app_scene, &upload);
+    SCENE_Dump(&app_scene, &SM_Ptr->UPLOAD);
+    App_Stage_Cycles(APP_STAGE_SCENE, Cycle_Count_Since(start));
+}
+
+/**
+ * @brief Follow the wind detector with the PRE_BQ shelf, from the main loop
+ * @note  The shelf takes the first PRE_BQ slot the fitting leaves free.
+ *        Loading it recompiles the filter block from MCU_FILTER and reloads
+ *        it into the DSP the way a fitting does, so it is done only when
+ *        the detector's target changes, straight to the new step, and at
+ *        most once per WIND_UPDATE frames so the steps of an onset collapse
+ *        into one load. MCU_FILTER itself is never changed. With PRE_BQ off
+ *        or all slots fitted, the detector only reports.
+ */
+void APP_Audio_Wind(void)
+{
+    MCU_Config_FILTER filter;
+    int slot = MCU_FILTER.Pre_Enable_Cnt;
+    int step = app_wind.target;
+
+    if (!(app_stage_control & APP_STAGE_MASK(APP_STAGE_WIND)) ||
+        (app_frames - app_wind_frame) < WIND_UPDATE)
+        return;
+
+    app_wind.no_slot = !(SM_Ptr->Control & MASK16(PRE_BQ)) || slot < 0 || slot >= 3;
+    if (app_wind.no_slot || step == app_wind_step)
+        return;
+    app_wind_frame = app_frames;
+
+    filter = MCU_FILTER;
+    if (step > 0)
+    {
+        WIND_Shelf(step, filter.PreBQs[slot]);
+        filter.Pre_Enable_Cnt = slot + 1;
+    }
+    Filter_Init(&filter, &SM_Ptr->FILTER_ShareMem);
+    J20_UpdateDSP(security_key, 64);
+    app_wind_step = step;
+}
+
+/**
+ * @brief Start a stream into SM_Dec
+ */
+void APP_Audio_StreamOpen(uint32_t rate)
+{
+    Decode_PCM_Data *dec = (Decode_PCM_Data *)RSL20_Buffer.SM_Dec;
+
+    SRC_Parser(rate, &app_src_cfg);
+    SRC_Init(&app_src, &app_src_cfg);
+    app_stream_buf = 0;
+    app_stream_open = true;
+
+    memset(dec, 0, sizeof(*dec));
+    dec->Mix = 1;
+    dec->PCM_Process = NO_PROCESS;
+}
+
+/**
+ * @brief Stop the stream into SM_Dec
+ * @note  Clears the buffer flags with Mix and PCM_Process, so the DSP drops
+ *        what is still queued and goes back to the microphone path alone.
+ */
+void APP_Audio_StreamClose(void)
+{
+    Decode_PCM_Data *dec = (Decode_PCM_Data *)RSL20_Buffer.SM_Dec;
+
+    app_stream_open = false;
+    memset(dec, 0, sizeof(*dec));
+}
+
+/**
+ * @brief Queue stream samples
+ */
+int APP_Audio_StreamWrite(const int *pcm, int n)
+{
+    if (!app_stream_open)
+        return 0;
+    return SRC_Write(&app_src, pcm, n);
+}
+
+/**
+ * @brief Resample the stream into the free SM_Dec buffers
+ * @note  The DSP clears a buffer flag once it has taken that AUDIO_BLOCK, so
+ *        the buffers drain at the DSP clock, and SRC_Read steers the stream
+ *        to it by the FIFO fill.
+ */
+void APP_Audio_StreamPump(void)
+{
+    Decode_PCM_Data *dec = (Decode_PCM_Data *)RSL20_Buffer.SM_Dec;
+    volatile char *busy = dec->Byte;
+    Word32 *data = (Word32 *)dec->Dec_Data;
+
+    if (!app_stream_open)
+        return;
+
+    while (busy[app_stream_buf] == 0)
+    {
+        SRC_Read(&app_src, &data[app_stream_buf * AUDIO_BLOCK], AUDIO_BLOCK);
+        busy[app_stream_buf] = 1;
+        app_stream_buf = (app_stream_buf + 1 < (int)sizeof(dec->Byte)) ? app_stream_buf + 1 : 0;
+    }
+}
+
 /**
  * @brief Enable Audio FSM execution
  */
@@ -135,25 +478,243 @@ void APP_Audio_Stop(void)
 
 /**
  * @brief Update Audio State
+ * @note  Called from DSP0_IRQHandler once the DSP has produced a block; runs
+ *        the enabled CM33 stages in place on that block. The feedback
+ *        canceller sees the block first and the final output last, so with
+ *        the DSP in LOOPBACK it models the full receiver-to-microphone path.
  */
 void APP_Audio_Run(void)
 {
-	int in_Buf[48];
-	for(int i=0; i<48; i++){
+    Word32 *block = App_Audio_Block();
+    uint32_t start;
+    uint32_t fb_cycles = 0;
+    uint32_t fb_analysis = 0;
+    uint32_t afc_cycles = 0;
+    uint32_t fdaf_cycles = 0;
+    uint32_t howl_cycles = 0;
+    int spectral = 0;
+    bool vad = (app_stage_control & APP_STAGE_MASK(APP_STAGE_VAD)) != 0;
+    bool scene = (app_stage_control & APP_STAGE_MASK(APP_STAGE_SCENE)) != 0;
+    Word16 trim;
+
+    app_frames++;
+
+    /* Wind is judged on the raw microphone, ahead of the DSP shelf it drives */
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_WIND))
+    {
+        start = Cycle_Count_Get();
+        WIND_Process(&app_wind, App_Audio_Input(), NULL);
+        WIND_Dump(&app_wind, &SM_Ptr->UPLOAD);
+        App_Stage_Cycles(APP_STAGE_WIND, Cycle_Count_Since(start));
+    }
 
-		in_Buf[i] = 0;
-	}
-	int32_t low_noise_flg;
-	int32_t	ret=0;
-	int i,j,kk;
-	// int Mask[SF_EQ_BandNum];
-	int Envelope[AUDIO_BLOCK];
-	int Gain[AUDIO_BLOCK];
+    /* Decide on the microphone block the DSP consumed, not on its output,
+     * where the WDRC gain would move the floor and the SNR; later stages
+     * only read the result */
+    if (vad)
+    {
+        start = Cycle_Count_Get();
+        VAD_Process(&app_vad, App_Audio_Input(), NULL);
+        VAD_Dump(&app_vad, &SM_Ptr->UPLOAD);
+        App_Stage_Cycles(APP_STAGE_VAD, Cycle_Count_Since(start));
+    }
+    NR_Hold(&app_nr, vad && (app_vad.flags & VAD_SPEECH));
+    trim = vad ? app_vad.ov_trim : MAX_16;
+    if (scene)
+        trim = mult_r(trim, app_scene.active.gain);
+    XO_SetTrim(&app_xo, trim);
+    NR_SetScale(&app_nr, scene ? app_scene.active.ns : MAX_16);
+    AINS_SetScale(&app_ains, scene ? app_scene.active.ns : MAX_16);
+
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_AFC))
+    {
+        start = Cycle_Count_Get();
+        AFC_Process(&app_afc, block);
+        afc_cycles = Cycle_Count_Since(start);
+    }
 
-	int Ref_Buf[AUDIO_BLOCK];
-	int Hp_Buf[AUDIO_BLOCK];
-	int Lp_Buf[AUDIO_BLOCK];
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_TR))
+    {
+        start = Cycle_Count_Get();
+        TR_Process(&app_tr, block);
+        TR_Dump(&app_tr, &SM_Ptr->UPLOAD);
+        App_Stage_Cycles(APP_STAGE_TR, Cycle_Count_Since(start));
+    }
+
+    if (app_stage_control & APP_STAGE_SPECTRAL)
+    {
+        start = Cycle_Count_Get();
+        FB_Analysis(&app_fb, block, &app_spec);
+        fb_analysis = Cycle_Count_Since(start);
+        fb_cycles = fb_analysis;
+
+        /* Feedback is removed before anything else looks at the spectrum */
+        if (app_stage_control & APP_STAGE_MASK(APP_STAGE_FDAF))
+        {
+            start = Cycle_Count_Get();
+            FDAF_Process(&app_fdaf, &app_fb, &app_spec);
+            fdaf_cycles = Cycle_Count_Since(start);
+            spectral++;
+        }
+
+        /* Howls are looked for in what the cancellers left over */
+        if (app_stage_control & APP_STAGE_MASK(APP_STAGE_HOWL))
+        {
+            start = Cycle_Count_Get();
+            HOWL_Detect(&app_howl, &app_fb, &app_spec);
+            howl_cycles = Cycle_Count_Since(start);
+        }
+
+        if (app_stage_control & APP_STAGE_MASK(APP_STAGE_NR))
+        {
+            start = Cycle_Count_Get();
+            NR_Process(&app_nr, &app_fb, &app_spec);
+            NR_Dump(&app_nr, &SM_Ptr->UPLOAD);
+            App_Stage_Cycles(APP_STAGE_NR, Cycle_Count_Since(start));
+            spectral++;
+        }
+
+        if (app_stage_control & APP_STAGE_MASK(APP_STAGE_AINS))
+        {
+            start = Cycle_Count_Get();
+            AINS_Process(&app_ains, &app_fb, &app_spec);
+            App_Stage_Cycles(APP_STAGE_AINS, Cycle_Count_Since(start));
+            spectral++;
+        }
+
+        /* Lowered sounds then get the gain of the band they land in */
+        if (app_stage_control & APP_STAGE_MASK(APP_STAGE_NFC))
+        {
+            start = Cycle_Count_Get();
+            NFC_Process(&app_nfc, &app_fb, &app_spec);
+            App_Stage_Cycles(APP_STAGE_NFC, Cycle_Count_Since(start));
+            spectral++;
+        }
+
+        if (app_stage_control & APP_STAGE_MASK(APP_STAGE_DPEQ))
+        {
+            start = Cycle_Count_Get();
+            DYNEQ_Process(&app_dyneq, &app_fb, &app_spec);
+            App_Stage_Cycles(APP_STAGE_DPEQ, Cycle_Count_Since(start));
+            spectral++;
+        }
+
+        /* The block only goes round the filterbank if a stage changed it */
+        if (app_stage_control & APP_STAGE_SPECTRAL_EDIT)
+        {
+            start = Cycle_Count_Get();
+            FB_Synthesis(&app_fb, &app_spec, block);
+            fb_cycles += Cycle_Count_Since(start);
+        }
+        App_Stage_Cycles(APP_STAGE_FB, fb_cycles);
+    }
+    app_stage_cycles_saved = (spectral > 1) ? (spectral - 1) * fb_cycles : 0;
+    if (spectral > 0 && (app_stage_control & APP_STAGE_MASK(APP_STAGE_HOWL)))
+        app_stage_cycles_saved += fb_analysis;
 
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_XO))
+    {
+        start = Cycle_Count_Get();
+        XO_Split(&app_xo, block, app_xo_band);
+        XO_Gain(&app_xo, app_xo_band);
+        XO_Merge(&app_xo, app_xo_band, block);
+        App_Stage_Cycles(APP_STAGE_XO, Cycle_Count_Since(start));
+    }
+
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_AGC))
+    {
+        start = Cycle_Count_Get();
+        AGC_Process(&app_agc, block);
+        App_Stage_Cycles(APP_STAGE_AGC, Cycle_Count_Since(start));
+    }
+
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_HOWL))
+    {
+        start = Cycle_Count_Get();
+        HOWL_Process(&app_howl, block);
+        HOWL_Dump(&app_howl, &SM_Ptr->UPLOAD);
+        App_Stage_Cycles(APP_STAGE_HOWL, howl_cycles + Cycle_Count_Since(start));
+    }
+
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_TM))
+    {
+        start = Cycle_Count_Get();
+        TM_Process(&app_tm, block);
+        App_Stage_Cycles(APP_STAGE_TM, Cycle_Count_Since(start));
+    }
+
+    /* The shift goes on the signal the cancellers see as their reference */
+    if (SM_Ptr->Control & MASK16(FSHIFT))
+    {
+        start = Cycle_Count_Get();
+        FSHIFT_Process(&app_fshift, block);
+        App_Stage_Cycles(APP_STAGE_FSHIFT, Cycle_Count_Since(start));
+    }
+
+    /* The tone goes in ahead of the limiter, so a tone mixed with the
+     * microphone cannot sum past the MPO; AUD_Process also clamps to the
+     * ceiling for when the limiter stage is off */
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_AUD))
+    {
+        start = Cycle_Count_Get();
+        AUD_Process(&app_aud, block, app_lim.ceiling);
+        App_Stage_Cycles(APP_STAGE_AUD, Cycle_Count_Since(start));
+    }
+
+    /* The limiter sets the final peak level, so the cancellers below must
+     * model the path from its output */
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_LIM))
+    {
+        start = Cycle_Count_Get();
+        LIM_Hardware(&app_lim, limit_errcnt);
+        LIM_Process(&app_lim, block);
+        LIM_Dump(&app_lim, &SM_Ptr->UPLOAD);
+        App_Stage_Cycles(APP_STAGE_LIM, Cycle_Count_Since(start));
+    }
+
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_AFC))
+    {
+        start = Cycle_Count_Get();
+        AFC_Reference(&app_afc, block);
+        App_Stage_Cycles(APP_STAGE_AFC, afc_cycles + Cycle_Count_Since(start));
+    }
+
+    if (app_stage_control & APP_STAGE_MASK(APP_STAGE_FDAF))
+    {
+        start = Cycle_Count_Get();
+        FDAF_Reference(&app_fdaf, block);
+        App_Stage_Cycles(APP_STAGE_FDAF, fdaf_cycles + Cycle_Count_Since(start));
+    }
+}
+
+/**
+ * @brief Output block just written by the DSP
+ * @note  SM_Output is double buffered; the DSP frame counter in SM_Dump[0]
+ *        selects the half it completed last.
+ */
+static Word32 *App_Audio_Block(void)
+{
+    return (Word32 *)&RSL20_Buffer.SM_Output[(RSL20_Buffer.SM_Dump[0] & 1) * AUDIO_BLOCK_SIZE];
+}
+
+/**
+ * @brief DMIC0 block the DSP consumed for that output
+ * @note  SM_Input is the circular DMIC0 DMA buffer, paired half for half
+ *        with SM_Output.
+ */
+static const Word32 *App_Audio_Input(void)
+{
+    return (const Word32 *)&RSL20_Buffer.SM_Input[(RSL20_Buffer.SM_Dump[0] & 1) * AUDIO_BLOCK_SIZE];
+}
+
+/**
+ * @brief Record the cycles a stage used this frame
+ */
+static void App_Stage_Cycles(APP_Stage_t stage, uint32_t cycles)
+{
+    app_stage_cycles[stage] = cycles;
+    if (cycles > app_stage_cycles_max[stage])
+        app_stage_cycles_max[stage] = cycles;
 }
 
 int Index = 0;
@@ -26,6 +26,7 @@
 #include "app_codec.h"
 #include "loader.h"
 #include "osj20.h"
+#include "cycle_count.h"
 
 /* ----------------------------------------------------------------------------
  * Defines
@@ -97,6 +98,51 @@ typedef struct
 static Codec_Control_t codec_control;
 static Codec_Media_Packet_Data_t input_media_packet[CODEC_INPUT_MEDIA_PACKET_COUNT];
 
+typedef struct
+{
+    const overlayManifest * volatile pending;   /* variant waiting to be copied */
+    volatile uint8_t frames;                    /* DSP frame ends since the request */
+    uint16_t held;                              /* the bits to give back */
+    uint32_t last_us;
+} Codec_Overlay_t;
+static Codec_Overlay_t codec_overlay;
+
+/* Region bounds from sections.ld */
+extern uint8_t _PRAM_Overlay_AFC_Offset[];
+extern uint8_t _PRAM_Overlay_AFC_Size[];
+extern uint8_t _PRAM_Overlay_TEST_Offset[];
+extern uint8_t _PRAM_Overlay_TEST_Size[];
+
+const overlayRegion app_overlay_afc =
+{
+    "AFC", (uint32_t)_PRAM_Overlay_AFC_Offset, (uint32_t)_PRAM_Overlay_AFC_Size, MASK16(AFC)
+};
+const overlayRegion app_overlay_test =
+{
+    "TEST", (uint32_t)_PRAM_Overlay_TEST_Offset, (uint32_t)_PRAM_Overlay_TEST_Size,
+    MASK16(TONE_GEN) | MASK16(SOUND_GEN)
+};
+
+/* Known-good image the loader falls back to when a section of the codec
+ * image fails its CRC: a loopback and WDRC build converted like the codec
+ * image. Weak, so without one the DSP is held in reset instead. */
+extern memoryOverview app_dsp_baseline __attribute__((weak));
+
+/* Regions loaded after first audio; the minimum path, loopback and WDRC,
+ * lies outside them */
+static const overlayRegion *const codec_deferred[] = { &app_overlay_afc, &app_overlay_test };
+#define CODEC_DEFERRED_COUNT    (sizeof(codec_deferred) / sizeof(codec_deferred[0]))
+
+typedef struct
+{
+    volatile bool audio_on;                     /* OD output has started */
+    uint16_t deferred;                          /* Control bits of regions not loaded yet */
+    uint16_t held;                              /* of those, the bits to turn on once loaded */
+    uint8_t next;                               /* next entry of codec_deferred */
+    uint32_t max_us;                            /* longest region load */
+} Codec_Boot_t;
+static Codec_Boot_t codec_boot;
+
 
 /* ----------------------------------------------------------------------------
  * Local Function Prototype Definitions
@@ -125,7 +171,66 @@ void App_Codec_Init(void)
  */
 void App_Codec_Load(void)
 {
+    uint16_t deferred = 0;
+    uint16_t held;
+    uint32_t primask = __get_PRIMASK();
+
+    for (uint32_t i = 0; i < CODEC_DEFERRED_COUNT; i++)
+        deferred |= codec_deferred[i]->control;
+
+    /* The DSP starts without the deferred regions, so their features are
+     * off before it leaves reset: cleared here, and again by the loader
+     * just before the release in case the image wrote Control. They come
+     * back per region in App_Codec_Poll. */
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    held = SM_Ptr->Control & deferred;
+    SM_Ptr->Control &= ~deferred;
+    codec_overlay.pending = NULL;
+    codec_overlay.frames = 0;
+    __set_PRIMASK(primask);
+
+    setLoadFallback(&app_dsp_baseline);
+    setLoadDeferred(codec_deferred, CODEC_DEFERRED_COUNT, &SM_Ptr->Control);
    J20_Codec_Load();
+
+    const loadStatus *status = getLoadStatus();
+
+    codec_boot.deferred = deferred;
+    codec_boot.held = held | status->held;
+    codec_boot.next = 0;
+
+    if (status->straddles > 0)
+    {
+        swmLogWarn("DSP load: %lu PRAM sections reach into a deferred region\r\n",
+                   (unsigned long)status->straddles);
+    }
+    if (status->failures > 0)
+    {
+        swmLogWarn("DSP load: %lu sections failed, first %s 0x%06lx; %s\r\n",
+                   (unsigned long)status->failures,
+                   (status->memory == LOAD_MEMORY_PM) ? "PM" : "DM",
+                   (unsigned long)status->vAddress,
+                   status->started ? (status->fallback ? "running fallback image" : "running") :
+                                     "DSP held in reset");
+    }
+
+#if LOAD_TIME_LOG_ENABLED
+    const loadTimeLog *log = getLoadTimeLog();
+
+    swmLogInfo("DSP load: %lu us\r\n", (unsigned long)log->total_us);
+    for (uint32_t i = 0; i < log->PM_count; i++)
+    {
+        swmLogInfo("    PM 0x%06lx %6lu bytes from %6lu %5lu us\r\n", (unsigned long)log->PM[i].vAddress,
+                   (unsigned long)log->PM[i].size, (unsigned long)log->PM[i].packed,
+                   (unsigned long)log->PM[i].us);
+    }
+    for (uint32_t i = 0; i < log->DM_count; i++)
+    {
+        swmLogInfo("    DM 0x%06lx %6lu bytes from %6lu %5lu us\r\n", (unsigned long)log->DM[i].vAddress,
+                   (unsigned long)log->DM[i].size, (unsigned long)log->DM[i].packed,
+                   (unsigned long)log->DM[i].us);
+    }
+#endif /* LOAD_TIME_LOG_ENABLED */
 }
 
 /**
@@ -136,6 +241,137 @@ void App_Codec_Stop(void)
     codec_control.is_codec_active = false;
 }
 
+/**
+ * @brief Swap one PRAM overlay to a variant without reloading the DSP
+ */
+bool App_Codec_SwapOverlay(const char *name)
+{
+    const overlayManifest *overlay = findOverlay(name);
+
+    if (overlay == NULL || codec_overlay.pending != NULL)
+        return false;
+    codec_overlay.pending = overlay;
+    return true;
+}
+
+/**
+ * @brief Keep the features of regions not loaded yet off
+ */
+void App_Codec_GateControl(void)
+{
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    codec_boot.held = SM_Ptr->Control & codec_boot.deferred;
+    SM_Ptr->Control &= ~codec_boot.deferred;
+    __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
+}
+
+/**
+ * @brief Control bits of the regions still to be loaded
+ */
+uint16_t App_Codec_Deferred(void)
+{
+    return codec_boot.deferred;
+}
+
+/**
+ * @brief Time the last overlay copy took in us
+ */
+uint32_t App_Codec_OverlayTime(void)
+{
+    return codec_overlay.last_us;
+}
+
+/**
+ * @brief Longest deferred region load in us
+ */
+uint32_t App_Codec_DeferredTime(void)
+{
+    return codec_boot.max_us;
+}
+
+/**
+ * @brief Hold a pending overlay's features off at DSP frame ends
+ * @note  First frame end: clear the region's Control bits. Second: the DSP
+ *        has run a whole frame without them, so App_Codec_Poll may copy.
+ */
+static void App_Codec_OverlayStep(void)
+{
+    const overlayManifest *overlay = codec_overlay.pending;
+
+    if (overlay == NULL || codec_overlay.frames >= 2)
+        return;
+
+    if (codec_overlay.frames == 0)
+    {
+        codec_overlay.held = SM_Ptr->Control & overlay->region->control;
+        SM_Ptr->Control &= ~overlay->region->control;
+    }
+    codec_overlay.frames++;
+}
+
+/**
+ * @brief Copy a region into PRAM and give its features back
+ * @return Copy time in us, 0 if the region was rejected or failed its CRC
+ * @note  A region that failed its CRC may hold half its code; its features
+ *        stay off.
+ */
+static uint32_t App_Codec_CopyRegion(const overlayRegion *region, const overlayManifest *overlay, uint16_t held)
+{
+    uint32_t start = Cycle_Count_Get();
+    uint32_t us;
+
+    if (!(overlay != NULL ? loadOverlay(overlay, 0) : loadDeferred(region, 0)))
+        return 0;
+    us = Cycle_Count_Since(start) / (SystemCoreClock / 1000000);
+
+    /* A variant also stands in for a region still deferred */
+    __set_PRIMASK(PRIMASK_DISABLE_INTERRUPTS);
+    SM_Ptr->Control |= held | (codec_boot.held & region->control);
+    codec_boot.deferred &= ~region->control;
+    codec_boot.held &= ~region->control;
+    __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
+    return (us > 0) ? us : 1;
+}
+
+/**
+ * @brief Run overlay swaps and deferred region loads from the main loop
+ */
+void App_Codec_Poll(void)
+{
+    const overlayManifest *overlay = codec_overlay.pending;
+
+    if (overlay != NULL)
+    {
+        if (codec_overlay.frames >= 2)
+        {
+            codec_overlay.last_us = App_Codec_CopyRegion(overlay->region, overlay, codec_overlay.held);
+            codec_overlay.frames = 0;
+            codec_overlay.pending = NULL;
+            if (codec_overlay.last_us != 0)
+                swmLogInfo("DSP overlay %s: %lu us\r\n", overlay->name, (unsigned long)codec_overlay.last_us);
+            else
+                swmLogWarn("DSP overlay %s rejected; %s stays off\r\n", overlay->name, overlay->region->name);
+        }
+        return;
+    }
+
+    /* One region per call, so the loop gets back to BLE between them */
+    if (codec_boot.audio_on && codec_boot.next < CODEC_DEFERRED_COUNT)
+    {
+        const overlayRegion *region = codec_deferred[codec_boot.next++];
+
+        if ((codec_boot.deferred & region->control) != 0)
+        {
+            uint32_t us = App_Codec_CopyRegion(region, NULL, 0);
+
+            if (us > codec_boot.max_us)
+                codec_boot.max_us = us;
+        }
+        if (codec_boot.next >= CODEC_DEFERRED_COUNT)
+            APP_Boot_Stamp(APP_BOOT_DSP_FULL);
+    }
+}
+
 
 
 
@@ -189,6 +425,8 @@ void DSP0_IRQHandler(void)
 	dmic_int--;
     NVIC_ClearPendingIRQ(DSP0_IRQn);
 
+    App_Codec_OverlayStep();
+    APP_Audio_Run();
 
 	static bool output_started = false;
 	if ((!output_started)&&(out_samples>6))
@@ -201,6 +439,8 @@ void DSP0_IRQHandler(void)
 	   APP_OD_Start();
 	   memset(&RSL20_Buffer.SM_Output[0],0,SM_BLOCK_SIZE);
 	   output_started  = true;
+	   codec_boot.audio_on = true;
+	   APP_Boot_Stamp(APP_BOOT_AUDIO_OUT);
 	}
 
 }
@@ -21,6 +21,10 @@
 #include <stdio.h>
 #include <app_bt.h>
 #include "mcu_parser.h"
+#include "app_audio.h"
+#include "app_codec.h"
+#include "audiometry.h"
+#include "tinnitus.h"
 
 extern gatt_srv_cb_t app_customss_cbs;
 
@@ -748,7 +752,7 @@ int arr_nsdeep_dbs[32] ={
 
 
 void  Update_SMData_RX(uint8_t* valptr, uint16_t lenData) {
-	if (valptr[0] == 0xAA) {
+	if (valptr[0] == CS_SHORT_CMD) {
 		Update_ShortSMData_RX(valptr,lenData);
 		return ;
 	}
@@ -866,15 +870,50 @@ void  Update_SMData_RX(uint8_t* valptr, uint16_t lenData) {
 	if (lownoise_level>31) lownoise_level =31;
 	MCU_NS_WIENER.nc_common_param[14] = arr_nsdeep_levels[lownoise_level];
 
+	//104: frequency compression cutoff, 100 Hz steps, 0 = off; 105: ratio x10
+	MCU_NFC.Cutoff_Hz = 100.0f * valptr[104];
+	MCU_NFC.Ratio = 0.1f * valptr[105];
 
+	//106: broadband AGC small-signal gain, dB; 107: its peak line, -dBFS
+	MCU_AGC.dB_gain = 1.0f * valptr[106];
+	MCU_AGC.dB_peak = 0.0f - valptr[107];
 
 
-}
 
 
-void  Update_ShortSMData_RX(uint8_t* valptr, uint16_t lenData) {
+}
 
 
+void  Update_ShortSMData_RX(uint8_t* valptr, uint16_t lenData) {
+	switch (valptr[1]) {
+	case CS_SHORT_AUDIOMETRY:
+		if (lenData >= 2 + AUD_CMD_LEN)
+			APP_Audio_Audiometry(&valptr[2]);
+		break;
+	case CS_SHORT_MASKER:
+		if (lenData >= 2 + TM_PRESET_LEN)
+			APP_Audio_Masker(&valptr[2]);
+		break;
+	case CS_SHORT_STAGES:
+		if (lenData >= 2 + APP_STAGE_CMD_LEN)
+			APP_Audio_Stages(&valptr[2]);
+		break;
+	case CS_SHORT_OVERLAY:
+	{
+		char name[CS_OVERLAY_NAME_LEN + 1];
+		uint16_t n = (lenData > 2) ? lenData - 2 : 0;
+
+		if (n > CS_OVERLAY_NAME_LEN)
+			n = CS_OVERLAY_NAME_LEN;
+		memcpy(name, &valptr[2], n);
+		name[n] = '\0';
+		if (!App_Codec_SwapOverlay(name))
+			swmLogWarn("No overlay %s, or a swap is under way\r\n", name);
+		break;
+	}
+	default:
+		break;
+	}
 }
 
 void Readfrom_SmData_Buffer(uint8_t*  valptr) {
@@ -893,6 +932,7 @@ void Readfrom_SmData_Buffer(uint8_t*  valptr) {
 	if(SM_Ptr->Control&MASK16(EQ)) valptr[3] |= 0x8;
 	if(SM_Ptr->Control&MASK16(AFC)) valptr[3] |= 0x4;
 	if(SM_Ptr->Control&MASK16(NC)) valptr[3] |= 0x2;
+	if(SM_Ptr->Control&MASK16(FSHIFT)) valptr[3] |= 0x20;
 
 
 	if(valptr[3] == 0x0) {
@@ -981,6 +1021,14 @@ void Readfrom_SmData_Buffer(uint8_t*  valptr) {
 
    	valptr[103] = lownoise_level;
 
+   //frequency compression
+   valptr[104] = (uint8_t)(MCU_NFC.Cutoff_Hz / 100.0f);
+   valptr[105] = (uint8_t)(MCU_NFC.Ratio * 10.0f);
+
+   //broadband AGC
+   valptr[106] = (uint8_t)(MCU_AGC.dB_gain);
+   valptr[107] = (uint8_t)(0 - MCU_AGC.dB_peak);
+
 
 
    base_offset =110;
@@ -994,9 +1042,14 @@ void Readfrom_SmData_Buffer(uint8_t*  valptr) {
 
 void J20_UPDATE_DSP() {
 	//Update_SMData_RX(app_env_cs.from_air_buffer,CS_VALUE_MAX_LENGTH);
-	if (app_env_cs.rx_changed ==1) {
+	if (app_env_cs.rx_changed ==1 && app_env_cs.from_air_buffer[0] == CS_SHORT_CMD) {
+		//短帧只执行命令，不重新加载验配数据
+		Update_ShortSMData_RX(app_env_cs.from_air_buffer,CS_VALUE_MAX_LENGTH);
+		app_env_cs.rx_changed = 0;
+	} else if (app_env_cs.rx_changed ==1) {
 		Update_SMData_RX(app_env_cs.from_air_buffer,CS_VALUE_MAX_LENGTH);
 		Fill_SmData_Buffer();
+		APP_Audio_Config();
 
 	    uint8_t wdrc_mask = app_env_cs.from_air_buffer[3];
 	    if (wdrc_mask ==0)  SM_Ptr->Control = MASK16(LOOPBACK);
@@ -1021,6 +1074,11 @@ void J20_UPDATE_DSP() {
 	   		 else
 	   			 SM_Ptr->Control &= ~MASK16(NC);
 
+	   		 if (wdrc_mask  & 0x20)  SM_Ptr->Control |= MASK16(FSHIFT);
+	   		 else
+	   			 SM_Ptr->Control &= ~MASK16(FSHIFT);
+
+	   		App_Codec_GateControl();
 
 	   		J20_UpdateDSP(security_key,64);
 
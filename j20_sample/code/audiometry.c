@@ -0,0 +1,220 @@
+/**
+ * @file audiometry.c
+ * @brief In-situ pure-tone audiometry tone generator
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "audiometry.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AUD_PHASOR                  32000   /* phasor magnitude, below Q15 full scale */
+#define AUD_PHASOR_SQ_Q15           31250   /* AUD_PHASOR^2 / 2^15 */
+#define AUD_MAXDB_DEFAULT           120.0   /* MCU_Config_WDRC default */
+#define AUD_WARBLE_DEV              0.05
+
+/* ----------------------------------------------------------------------------
+ * Module Variable Definitions
+ * --------------------------------------------------------------------------*/
+
+static const float aud_freq[AUD_FREQS] =
+{
+    125.0f, 250.0f, 500.0f, 750.0f, 1000.0f, 1500.0f,
+    2000.0f, 3000.0f, 4000.0f, 6000.0f, 8000.0f
+};
+
+/* Reference equivalent threshold SPL for insert earphones, ISO 389-2 */
+static const float aud_retspl[AUD_FREQS] =
+{
+    26.0f, 14.0f, 5.5f, 2.0f, 0.0f, 2.0f,
+    3.0f, 3.5f, 5.5f, 2.0f, 0.0f
+};
+
+/* 0.5 - 0.5*cos(pi*i/AUD_RAMP_BLOCKS) in Q15 */
+static const Word16 aud_ramp[AUD_RAMP_BLOCKS + 1] =
+{
+        0,   140,   558,  1247,  2195,  3386,  4799,  6410,  8192,
+    10114, 12143, 14245, 16383, 18522, 20624, 22653, 24575, 26357,
+    27968, 29381, 30572, 31520, 32209, 32627, 32767
+};
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Packed cos/sin of the per-sample phase step at f Hz
+ */
+static Word32 aud_rotation(double f)
+{
+    double w = 2.0 * M_PI * f / AUDIO_SAMPLE_RATE;
+
+    return pk_pack(sat16(lround(32767.0 * cos(w))), sat16(lround(32767.0 * sin(w))));
+}
+
+/**
+ * @brief Whether the tone is gated on in frame t
+ */
+static bool aud_gate(const AUD_State_t *aud)
+{
+    const AUD_Presentation_t *p = &aud->p;
+
+    if (aud->t >= p->blocks - AUD_RAMP_BLOCKS)
+        return false;
+    if ((p->mode & AUD_TONE_MASK) == AUD_PULSED)
+        return (aud->t % (2 * AUD_PULSE_BLOCKS)) < AUD_PULSE_BLOCKS - AUD_RAMP_BLOCKS;
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile one command payload into a presentation
+ */
+bool AUD_Parser(const uint8_t *cmd, float maxdB, Word32 ceiling, AUD_Presentation_t *p)
+{
+    int f = cmd[0];
+    double full_scale = (maxdB > 0.0f) ? maxdB : AUD_MAXDB_DEFAULT;
+    double dbfs;
+
+    memset(p, 0, sizeof(*p));
+    if (f == AUD_STOP || cmd[3] == 0)
+        return true;
+    if (f >= AUD_FREQS || (cmd[2] & AUD_TONE_MASK) > AUD_WARBLE)
+        return false;
+
+    /* The phasor peaks at AUD_PHASOR, so scale the amplitude up to match */
+    dbfs = aud_retspl[f] + ((int)cmd[1] - AUD_LEVEL_OFFSET) - full_scale;
+    if (dbfs > 20.0 * log10(AUD_PHASOR / 32768.0))
+        return false;
+
+    /* A tone above the MPO would be clipped by AUD_Process, not presented */
+    if (2147483647.0 * pow(10.0, dbfs / 20.0) > (double)ceiling)
+        return false;
+    p->amplitude = (Word32)(2147483647.0 * pow(10.0, dbfs / 20.0) * 32768.0 / AUD_PHASOR);
+
+    p->mode = cmd[2] & (AUD_TONE_MASK | AUD_MIX);
+    p->blocks = (int)lround(cmd[3] * 0.1 * AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SIZE);
+    if ((p->mode & AUD_TONE_MASK) == AUD_WARBLE)
+    {
+        p->rot_lo = aud_rotation(aud_freq[f] * (1.0 - AUD_WARBLE_DEV));
+        p->rot_hi = aud_rotation(aud_freq[f] * (1.0 + AUD_WARBLE_DEV));
+    }
+    else
+    {
+        p->rot_lo = aud_rotation(aud_freq[f]);
+        p->rot_hi = p->rot_lo;
+    }
+    return true;
+}
+
+/**
+ * @brief Reset the generator to idle
+ */
+void AUD_Init(AUD_State_t *aud)
+{
+    memset(aud, 0, sizeof(*aud));
+    aud->phasor = pk_pack(AUD_PHASOR, 0);
+}
+
+/**
+ * @brief Start a presentation, or ramp the current one down if p->blocks is 0
+ * @note  A running tone keeps its phase and envelope, so a new presentation
+ *        or a stop never steps the output.
+ */
+void AUD_Start(AUD_State_t *aud, const AUD_Presentation_t *p)
+{
+    if (p->blocks == 0)
+    {
+        aud->p.blocks = 0;
+        return;
+    }
+
+    aud->p = *p;
+    aud->t = 0;
+    aud->active = true;
+}
+
+/**
+ * @brief Write one block of tone into the output, if a presentation is running
+ */
+void AUD_Process(AUD_State_t *aud, Word32 *block, Word32 ceiling)
+{
+    const AUD_Presentation_t *p = &aud->p;
+    Word32 rot = p->rot_lo;
+    Word32 phasor = aud->phasor;
+    Word32 env;
+    Word32 step;
+    Word32 g;
+
+    if (!aud->active)
+        return;
+
+    /* Envelope ramps linearly across the frame to the next raised-cosine point */
+    if (aud_gate(aud))
+    {
+        if (aud->ramp < AUD_RAMP_BLOCKS)
+            aud->ramp++;
+    }
+    else if (aud->ramp > 0)
+    {
+        aud->ramp--;
+    }
+    env = (Word32)aud->env << 5;
+    step = (Word32)aud_ramp[aud->ramp] - aud->env;
+    aud->env = aud_ramp[aud->ramp];
+
+    /* Warble: triangle sweep between the two steps */
+    if (p->rot_hi != p->rot_lo)
+    {
+        int tri = aud->t % (2 * AUD_WARBLE_BLOCKS);
+        Word16 m = (Word16)(((tri < AUD_WARBLE_BLOCKS) ? tri : (2 * AUD_WARBLE_BLOCKS - tri)) *
+                            MAX_16 / AUD_WARBLE_BLOCKS);
+
+        rot = pk_pack(PK_LO(p->rot_lo) + mult(PK_LO(p->rot_hi) - PK_LO(p->rot_lo), m),
+                      PK_HI(p->rot_lo) + mult(PK_HI(p->rot_hi) - PK_HI(p->rot_lo), m));
+    }
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        Word32 re = (pk_smusd(phasor, rot) + 0x4000) >> 15;
+        Word32 im = (pk_smuadx(phasor, rot) + 0x4000) >> 15;
+        Word32 y;
+
+        phasor = pk_pack(re, im);
+        env += step;
+        y = Mpy_32_16(p->amplitude, mult_r((Word16)im, (Word16)(env >> 5)));
+        if (p->mode & AUD_MIX)
+            y = L_add(block[i], y);
+        /* Safety net: AUD_Parser() keeps the tone itself under the ceiling,
+         * but a mix with the microphone, or a ceiling the limiter has since
+         * trimmed, can still sum past it */
+        if (y > ceiling)
+            y = ceiling;
+        else if (y < -ceiling)
+            y = -ceiling;
+        block[i] = y;
+    }
+
+    /* Pull the magnitude back to AUD_PHASOR: g = (3 - |p|^2/A^2)/2 */
+    g = (3 * 32768 - pk_smuad(phasor, phasor) / AUD_PHASOR_SQ_Q15) >> 1;
+    aud->phasor = pk_pack((PK_LO(phasor) * g) >> 15, (PK_HI(phasor) * g) >> 15);
+
+    aud->t++;
+    if (aud->ramp == 0 && aud->t >= p->blocks - AUD_RAMP_BLOCKS)
+        aud->active = false;
+}
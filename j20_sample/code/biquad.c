@@ -0,0 +1,72 @@
+/**
+ * @file biquad.c
+ * @brief Fixed-point biquad sections for the CM33 stages
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "basic_op.h"
+#include "biquad.h"
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Clear the section history
+ */
+void BQ_Reset(BQ_State_t *st)
+{
+    memset(st, 0, sizeof(*st));
+}
+
+/**
+ * @brief True if the section has no coefficients set
+ */
+bool BQ_IsEmpty(const INT32 *coef)
+{
+    for (int i = 0; i < BQ_COEF_NUM; i++)
+    {
+        if (coef[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Filter n samples, in place allowed
+ * @note  Direct form I with a 64-bit accumulator, so the Q30 coefficients
+ *        need no extra headroom on the full-scale Word32 samples.
+ */
+void BQ_Process(const INT32 *coef, BQ_State_t *st, const Word32 *in, Word32 *out, int n)
+{
+    Word32 x1 = st->x1, x2 = st->x2;
+    Word32 y1 = st->y1, y2 = st->y2;
+
+    for (int i = 0; i < n; i++)
+    {
+        Word32 x0 = in[i];
+        int64_t acc = (int64_t)coef[0] * x0 + (int64_t)coef[1] * x1 + (int64_t)coef[2] * x2
+                    - (int64_t)coef[3] * y1 - (int64_t)coef[4] * y2;
+
+        acc >>= BQ_COEF_Q;
+        if (acc > MAX_32)
+            acc = MAX_32;
+        else if (acc < MIN_32)
+            acc = MIN_32;
+
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = (Word32)acc;
+        out[i] = y1;
+    }
+
+    st->x1 = x1;
+    st->x2 = x2;
+    st->y1 = y1;
+    st->y2 = y2;
+}
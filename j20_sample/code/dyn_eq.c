@@ -0,0 +1,129 @@
+/**
+ * @file dyn_eq.c
+ * @brief Dynamic-parametric EQ (open DPEQ) on the shared filterbank
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "dyn_eq.h"
+#include "level.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+/* Bin log2 power of a full-scale sine centred on the bin, Q8: amplitude
+ * 2^31 times the window coherent gain N/pi, squared */
+#define DYNEQ_LOG_FS                18100
+
+#define DYNEQ_DB_TO_LOG2            (256.0 / (10.0 * 0.30103))  /* power dB to log2 Q8 */
+#define DYNEQ_FRAME_RATE            ((double)AUDIO_SAMPLE_RATE / FB_HOP)
+#define DYNEQ_TIME_MIN              1.0     /* ms */
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the fitting parameters into a fixed-point configuration
+ */
+void DYNEQ_Parser(const MCU_Config_DPEQ *dpeq, const MCU_Config_EQ *eq, DYNEQ_Config_t *cfg)
+{
+    double t = dpeq->Energy_Time;
+    double high = dpeq->Threshold_High;
+    double low = dpeq->Threshold_Low;
+
+    if (t < DYNEQ_TIME_MIN)
+        t = DYNEQ_TIME_MIN;
+    cfg->alpha = sat16(lround(32768.0 * exp(-1000.0 / (t * DYNEQ_FRAME_RATE))));
+
+    if (high > 0.0)
+        high = 0.0;
+    if (low > high)
+        low = high;
+    cfg->static_eq = (low <= DYNEQ_LOW_OFF_DB);
+    cfg->high = DYNEQ_LOG_FS + (Word32)lround(high * DYNEQ_DB_TO_LOG2);
+    cfg->low = DYNEQ_LOG_FS + (Word32)lround(low * DYNEQ_DB_TO_LOG2);
+
+    /* The fitting only writes cuts; anything above 0 dB is held flat */
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        double db = eq->dB_Gain_float[k];
+
+        cfg->eq_gain[k] = (db < 0.0) ? sat16(lround(32768.0 * pow(10.0, db / 20.0))) : MAX_16;
+    }
+}
+
+/**
+ * @brief Reset the energy trackers and apply a configuration
+ */
+void DYNEQ_Init(DYNEQ_State_t *dp, const DYNEQ_Config_t *cfg)
+{
+    memset(dp, 0, sizeof(*dp));
+    dp->cfg = *cfg;
+
+    for (int k = 0; k < FB_BINS; k++)
+        dp->gain[k] = MAX_16;
+}
+
+/**
+ * @brief Apply a new configuration, keeping the energy trackers
+ * @note  Call with the DSP interrupt masked.
+ */
+void DYNEQ_SetConfig(DYNEQ_State_t *dp, const DYNEQ_Config_t *cfg)
+{
+    dp->cfg = *cfg;
+}
+
+/**
+ * @brief Track the bin energies and apply the level-dependent EQ gain
+ */
+void DYNEQ_Process(DYNEQ_State_t *dp, const FB_State_t *fb, FB_Spectrum_t *spec)
+{
+    const DYNEQ_Config_t *cfg = &dp->cfg;
+    const Word32 span = cfg->high - cfg->low;
+    const Word16 coef = (Word16)MIN(32768 - cfg->alpha, MAX_16);
+    Word32 bin[FB_BINS];
+    Word16 l[FB_BINS];
+
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word32 v = FB_GetBin(fb, spec, k);
+        UWord32 p = (UWord32)((Word32)PK_LO(v) * PK_LO(v)) + (UWord32)((Word32)PK_HI(v) * PK_HI(v));
+
+        bin[k] = v;
+        l[k] = sat16(LVL_Log2(p) + spec->exp * 512);
+        if (dp->frames == 0)
+            dp->level[k] = l[k];
+    }
+    LVL_Follow(dp->level, l, FB_BINS, coef, coef);
+
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word32 v = bin[k];
+        Word32 w;
+        Word16 g;
+
+        /* EQ weight, Q15: 0 at the low threshold, 1 at the high one */
+        if (cfg->static_eq || dp->level[k] >= cfg->high)
+            w = MAX_16;
+        else if (dp->level[k] <= cfg->low)
+            w = 0;
+        else
+            w = ((dp->level[k] - cfg->low) << 15) / span;
+
+        g = sub(MAX_16, mult(sub(MAX_16, cfg->eq_gain[k]), (Word16)w));
+        dp->gain[k] = g;
+
+        if (g != MAX_16)
+            FB_SetBin(fb, spec, k, pk_pack(mult_r(PK_LO(v), g), mult_r(PK_HI(v), g)));
+    }
+
+    if (dp->frames < MAX_16)
+        dp->frames++;
+}
@@ -0,0 +1,447 @@
+/**
+ * @file fft_real.c
+ * @brief Fixed-point real FFT/IFFT for 32, 64 and 128 points
+ *
+ * The n-point real transform runs as an n/2-point complex transform on the
+ * even/odd sample pairs followed by a split stage. The complex transform is
+ * decimation in frequency with radix-4 butterflies (plus one radix-2 stage
+ * when log2(n/2) is odd). Each radix-4 butterfly stores its two middle outputs
+ * swapped, which leaves the spectrum in binary bit-reversed order; the split
+ * stage reads and writes through the same bit-reversed positions, so the whole
+ * transform stays in place without a reordering pass. The inverse runs the
+ * exact transposed flow graph (split, then radix-4 decimation in time).
+ *
+ * Block floating point: before every stage the headroom of the block is
+ * compared with the worst-case growth of that stage and the stage input is
+ * shifted down only by the missing bits. The headroom for the next stage is
+ * collected while the outputs are written.
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "basic_op.h"
+#include "fft_real.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * -------------------------------------------------------------------------- */
+
+/* Bits of headroom each stage needs to never saturate */
+#define FFT_NEED_RADIX4             3
+#define FFT_NEED_RADIX2             2
+#define FFT_NEED_SPLIT              2
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/** @brief Magnitude bits of both halves of a packed pair */
+static inline UWord32 pk_bits(Word32 x)
+{
+    Word32 lo = PK_LO(x);
+    Word32 hi = PK_HI(x);
+    return (UWord32)((lo ^ (lo >> 15)) | (hi ^ (hi >> 15)));
+}
+
+/** @brief Spare sign bits of a block from its accumulated magnitude bits */
+static inline int bits_headroom(UWord32 bits)
+{
+    return (bits == 0) ? 15 : (clz32(bits) - 17);
+}
+
+static inline int need_shift(int headroom, int need)
+{
+    return (headroom < need) ? (need - headroom) : 0;
+}
+
+/** @brief x * w, Q15 rounded */
+static inline Word32 cmul(Word32 x, Word32 w)
+{
+    return pk_pack((pk_smusd(x, w) + 0x4000) >> 15, (pk_smuadx(x, w) + 0x4000) >> 15);
+}
+
+/** @brief x * conj(w), Q15 rounded */
+static inline Word32 cmul_conj(Word32 x, Word32 w)
+{
+    return pk_pack((pk_smuad(x, w) + 0x4000) >> 15, (pk_smusdx(w, x) + 0x4000) >> 15);
+}
+
+static UWord32 block_bits(const Word32 *buf, int m)
+{
+    UWord32 bits = 0;
+    for (int i = 0; i < m; i++)
+        bits |= pk_bits(buf[i]);
+    return bits;
+}
+
+/**
+ * @brief Normalize the block so it has exactly 'need' bits of headroom
+ * @return exponent change
+ */
+static int block_normalize(Word32 *buf, int m, int headroom, int need)
+{
+    int s = headroom - need;
+    if (s > 0)
+    {
+        for (int i = 0; i < m; i++)
+            buf[i] = pk_pack(PK_LO(buf[i]) << s, PK_HI(buf[i]) << s);
+    }
+    else if (s < 0)
+    {
+        for (int i = 0; i < m; i++)
+            buf[i] = pk_shr(buf[i], -s);
+    }
+    return -s;
+}
+
+/**
+ * @brief Forward radix-2 DIF stage over sub-transforms of length L
+ */
+static UWord32 fwd_radix2(const FFT_Real_t *fft, Word32 *buf, int L, int s)
+{
+    int q = L >> 1;
+    int stride = fft->n / L;
+    UWord32 bits = 0;
+
+    for (int j = 0; j < q; j++)
+    {
+        Word32 w = fft->twiddle[j * stride];
+        for (int g = j; g < fft->m; g += L)
+        {
+            Word32 *p = &buf[g];
+            Word32 a = p[0], b = p[q];
+            if (s)
+            {
+                a = pk_shr(a, s);
+                b = pk_shr(b, s);
+            }
+            Word32 y0 = pk_add(a, b);
+            Word32 y1 = pk_sub(a, b);
+            if (j)
+                y1 = cmul(y1, w);
+            p[0] = y0;
+            p[q] = y1;
+            bits |= pk_bits(y0) | pk_bits(y1);
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief Forward radix-4 DIF stage over sub-transforms of length L
+ *        (outputs 1 and 2 swapped to keep binary bit-reversed order)
+ */
+static UWord32 fwd_radix4(const FFT_Real_t *fft, Word32 *buf, int L, int s)
+{
+    int q = L >> 2;
+    int stride = fft->n / L;
+    UWord32 bits = 0;
+
+    for (int j = 0; j < q; j++)
+    {
+        Word32 w1 = fft->twiddle[j * stride];
+        Word32 w2 = fft->twiddle[2 * j * stride];
+        Word32 w3 = fft->twiddle[3 * j * stride];
+        for (int g = j; g < fft->m; g += L)
+        {
+            Word32 *p = &buf[g];
+            Word32 a = p[0], b = p[q], c = p[2*q], d = p[3*q];
+            if (s)
+            {
+                a = pk_shr(a, s);
+                b = pk_shr(b, s);
+                c = pk_shr(c, s);
+                d = pk_shr(d, s);
+            }
+            Word32 t0 = pk_add(a, c);
+            Word32 t1 = pk_sub(a, c);
+            Word32 t2 = pk_add(b, d);
+            Word32 t3 = pk_sub(b, d);
+
+            Word32 y0 = pk_add(t0, t2);
+            Word32 y2 = pk_sub(t0, t2);
+            Word32 y1 = pk_sax(t1, t3);         /* t1 - j*t3 */
+            Word32 y3 = pk_asx(t1, t3);         /* t1 + j*t3 */
+            if (j)
+            {
+                y1 = cmul(y1, w1);
+                y2 = cmul(y2, w2);
+                y3 = cmul(y3, w3);
+            }
+            p[0]   = y0;
+            p[q]   = y2;
+            p[2*q] = y1;
+            p[3*q] = y3;
+            bits |= pk_bits(y0) | pk_bits(y1) | pk_bits(y2) | pk_bits(y3);
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief Inverse radix-2 DIT stage, transpose of fwd_radix2
+ */
+static UWord32 inv_radix2(const FFT_Real_t *fft, Word32 *buf, int L, int s)
+{
+    int q = L >> 1;
+    int stride = fft->n / L;
+    UWord32 bits = 0;
+
+    for (int j = 0; j < q; j++)
+    {
+        Word32 w = fft->twiddle[j * stride];
+        for (int g = j; g < fft->m; g += L)
+        {
+            Word32 *p = &buf[g];
+            Word32 y0 = p[0], y1 = p[q];
+            if (s)
+            {
+                y0 = pk_shr(y0, s);
+                y1 = pk_shr(y1, s);
+            }
+            if (j)
+                y1 = cmul_conj(y1, w);
+            Word32 a = pk_add(y0, y1);
+            Word32 b = pk_sub(y0, y1);
+            p[0] = a;
+            p[q] = b;
+            bits |= pk_bits(a) | pk_bits(b);
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief Inverse radix-4 DIT stage, transpose of fwd_radix4
+ */
+static UWord32 inv_radix4(const FFT_Real_t *fft, Word32 *buf, int L, int s)
+{
+    int q = L >> 2;
+    int stride = fft->n / L;
+    UWord32 bits = 0;
+
+    for (int j = 0; j < q; j++)
+    {
+        Word32 w1 = fft->twiddle[j * stride];
+        Word32 w2 = fft->twiddle[2 * j * stride];
+        Word32 w3 = fft->twiddle[3 * j * stride];
+        for (int g = j; g < fft->m; g += L)
+        {
+            Word32 *p = &buf[g];
+            Word32 y0 = p[0], y2 = p[q], y1 = p[2*q], y3 = p[3*q];
+            if (s)
+            {
+                y0 = pk_shr(y0, s);
+                y1 = pk_shr(y1, s);
+                y2 = pk_shr(y2, s);
+                y3 = pk_shr(y3, s);
+            }
+            if (j)
+            {
+                y1 = cmul_conj(y1, w1);
+                y2 = cmul_conj(y2, w2);
+                y3 = cmul_conj(y3, w3);
+            }
+            Word32 u0 = pk_add(y0, y2);
+            Word32 u1 = pk_sub(y0, y2);
+            Word32 u2 = pk_add(y1, y3);
+            Word32 u3 = pk_sub(y1, y3);
+
+            Word32 a = pk_add(u0, u2);
+            Word32 c = pk_sub(u0, u2);
+            Word32 b = pk_asx(u1, u3);          /* u1 + j*u3 */
+            Word32 d = pk_sax(u1, u3);          /* u1 - j*u3 */
+            p[0]   = a;
+            p[q]   = b;
+            p[2*q] = c;
+            p[3*q] = d;
+            bits |= pk_bits(a) | pk_bits(b) | pk_bits(c) | pk_bits(d);
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief Split the complex spectrum Z of the sample pairs into the real
+ *        spectrum X: X[k] = E + T, X[m-k] = conj(E - T) with
+ *        E = (Z[k] + conj Z[m-k])/2 and T = W^k (Z[k] - conj Z[m-k])/2j
+ */
+static void fwd_split(const FFT_Real_t *fft, Word32 *buf, int s)
+{
+    int m = fft->m;
+    Word32 z0 = buf[0];
+    if (s)
+        z0 = pk_shr(z0, s);
+    buf[0] = pk_pack(sat16((Word32)PK_LO(z0) + PK_HI(z0)),
+                     sat16((Word32)PK_LO(z0) - PK_HI(z0)));
+
+    for (int k = 1; k <= (m >> 1); k++)
+    {
+        int pa = fft->bitrev[k];
+        int pb = fft->bitrev[m - k];
+        Word32 a = buf[pa], b = buf[pb];
+        if (s)
+        {
+            a = pk_shr(a, s);
+            b = pk_shr(b, s);
+        }
+        Word32 h_add = pk_hadd(a, b);
+        Word32 h_sub = pk_hsub(a, b);
+        Word32 e = pk_lo_hi(h_add, h_sub);
+        Word32 d = pk_lo_hi(h_sub, h_add);
+        Word32 w = fft->twiddle[k];
+        Word32 t = pk_pack((pk_smuadx(d, w) + 0x4000) >> 15,
+                           (0x4000 - pk_smusd(d, w)) >> 15);
+
+        buf[pb] = pk_lo_hi(pk_sub(e, t), pk_sub(t, e));
+        buf[pa] = pk_add(e, t);
+    }
+}
+
+/**
+ * @brief Transpose of fwd_split: Z[k] = E + j*conj(W^k)*T, Z[m-k] = conj(E - ...)
+ *        with E = (X[k] + conj X[m-k])/2 and T = (X[k] - conj X[m-k])/2
+ */
+static UWord32 inv_split(const FFT_Real_t *fft, Word32 *buf)
+{
+    int m = fft->m;
+    Word32 x0 = buf[0];
+    UWord32 bits;
+
+    buf[0] = pk_pack(((Word32)PK_LO(x0) + PK_HI(x0)) >> 1,
+                     ((Word32)PK_LO(x0) - PK_HI(x0)) >> 1);
+    bits = pk_bits(buf[0]);
+
+    for (int k = 1; k <= (m >> 1); k++)
+    {
+        int pa = fft->bitrev[k];
+        int pb = fft->bitrev[m - k];
+        Word32 a = buf[pa], b = buf[pb];
+        Word32 h_add = pk_hadd(a, b);
+        Word32 h_sub = pk_hsub(a, b);
+        Word32 e = pk_lo_hi(h_add, h_sub);
+        Word32 t = pk_lo_hi(h_sub, h_add);
+        Word32 w = fft->twiddle[k];
+        Word32 p = pk_pack((pk_smusdx(t, w) + 0x4000) >> 15,
+                           (pk_smuad(t, w) + 0x4000) >> 15);
+
+        Word32 zb = pk_lo_hi(pk_sub(e, p), pk_sub(p, e));
+        Word32 za = pk_add(e, p);
+        buf[pb] = zb;
+        buf[pa] = za;
+        bits |= pk_bits(za) | pk_bits(zb);
+    }
+    return bits;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Generate twiddle and bin position tables for an n-point transform
+ */
+bool FFT_Real_Init(FFT_Real_t *fft, int n)
+{
+    if ((n != 32) && (n != 64) && (n != 128))
+        return false;
+
+    fft->n = n;
+    fft->m = n >> 1;
+    fft->log2m = 0;
+    while ((1 << fft->log2m) < fft->m)
+        fft->log2m++;
+
+    for (int k = 0; k < 3 * n / 4; k++)
+    {
+        double phi = 2.0 * M_PI * k / n;
+        Word32 re = (Word32)lround(32768.0 * cos(phi));
+        Word32 im = (Word32)lround(-32768.0 * sin(phi));
+        fft->twiddle[k] = pk_pack(sat16(re), sat16(im));
+    }
+
+    for (int k = 0; k < fft->m; k++)
+    {
+        int r = 0;
+        for (int b = 0; b < fft->log2m; b++)
+            r |= ((k >> b) & 1) << (fft->log2m - 1 - b);
+        fft->bitrev[k] = (unsigned char)r;
+    }
+    return true;
+}
+
+/**
+ * @brief In-place forward real FFT
+ */
+int FFT_Real_Forward(const FFT_Real_t *fft, Word32 *buf)
+{
+    int m = fft->m;
+    int L = m;
+    int exp, s;
+    int headroom = bits_headroom(block_bits(buf, m));
+
+    if (headroom == 15)
+        return 0;
+
+    if (fft->log2m & 1)
+    {
+        exp = block_normalize(buf, m, headroom, FFT_NEED_RADIX2);
+        headroom = bits_headroom(fwd_radix2(fft, buf, L, 0));
+        L >>= 1;
+    }
+    else
+    {
+        exp = block_normalize(buf, m, headroom, FFT_NEED_RADIX4);
+        headroom = FFT_NEED_RADIX4;
+    }
+
+    for (; L >= 4; L >>= 2)
+    {
+        s = need_shift(headroom, FFT_NEED_RADIX4);
+        headroom = bits_headroom(fwd_radix4(fft, buf, L, s));
+        exp += s;
+    }
+
+    s = need_shift(headroom, FFT_NEED_SPLIT);
+    fwd_split(fft, buf, s);
+    return exp + s;
+}
+
+/**
+ * @brief In-place inverse real FFT
+ */
+int FFT_Real_Inverse(const FFT_Real_t *fft, Word32 *buf)
+{
+    int m = fft->m;
+    int L, exp, s;
+    int headroom = bits_headroom(block_bits(buf, m));
+
+    if (headroom == 15)
+        return 0;
+
+    exp = block_normalize(buf, m, headroom, FFT_NEED_SPLIT);
+    headroom = bits_headroom(inv_split(fft, buf));
+
+    for (L = 4; L <= m; L <<= 2)
+    {
+        s = need_shift(headroom, FFT_NEED_RADIX4);
+        headroom = bits_headroom(inv_radix4(fft, buf, L, s));
+        exp += s;
+    }
+
+    if (fft->log2m & 1)
+    {
+        s = need_shift(headroom, FFT_NEED_RADIX2);
+        inv_radix2(fft, buf, m, s);
+        exp += s;
+    }
+
+    return exp - fft->log2m;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file filterbank.c
+ * @brief Weighted overlap-add analysis/synthesis filterbank for the CM33 stages
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "filterbank.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Initialize windows, FFT tables and clear the history
+ */
+void FB_Init(FB_State_t *fb)
+{
+    FFT_Real_Init(&fb->fft, FB_FFT_LEN);
+
+    /* sin(pi*n/N) is the square root of the periodic Hann window, so the
+     * analysis*synthesis product overlap-adds to exactly one at 50% hop */
+    for (int i = 0; i < FB_FFT_LEN; i++)
+        fb->win[i] = sat16(lround(32768.0 * sin(M_PI * i / FB_FFT_LEN)));
+
+    memset(fb->hist, 0, sizeof(fb->hist));
+    memset(fb->ola, 0, sizeof(fb->ola));
+}
+
+/**
+ * @brief Shift in one hop of samples and compute its spectrum
+ */
+void FB_Analysis(FB_State_t *fb, const Word32 *in, FB_Spectrum_t *spec)
+{
+    Word32 frame[FB_FFT_LEN];
+    Word32 peak = 0;
+    int sh;
+
+    memmove(&fb->hist[0], &fb->hist[FB_HOP], FB_HOP * sizeof(Word32));
+    memcpy(&fb->hist[FB_HOP], in, FB_HOP * sizeof(Word32));
+
+    for (int i = 0; i < FB_FFT_LEN; i++)
+    {
+        frame[i] = Mpy_32_16(fb->hist[i], fb->win[i]);
+        peak |= frame[i] ^ (frame[i] >> 31);
+    }
+
+    /* Keep the most significant 16 bits of the loudest windowed sample */
+    sh = norm_l(peak);
+    for (int i = 0; i < FB_HOP; i++)
+    {
+        spec->bin[i] = pk_pack(extract_h(frame[2*i] << sh),
+                               extract_h(frame[2*i + 1] << sh));
+    }
+
+    spec->exp = 16 - sh + FFT_Real_Forward(&fb->fft, spec->bin);
+}
+
+/**
+ * @brief Inverse transform a spectrum and overlap-add one hop of output
+ */
+void FB_Synthesis(FB_State_t *fb, FB_Spectrum_t *spec, Word32 *out)
+{
+    int e = spec->exp + FFT_Real_Inverse(&fb->fft, spec->bin) - 15;
+
+    for (int i = 0; i < FB_HOP; i++)
+    {
+        Word32 v = spec->bin[i];
+        Word32 y0 = (Word32)PK_LO(v) * fb->win[2*i];
+        Word32 y1 = (Word32)PK_HI(v) * fb->win[2*i + 1];
+        Word32 *dst = (i < FB_HOP/2) ? &out[2*i] : &fb->ola[2*i - FB_HOP];
+
+        if (e >= 0)
+        {
+            y0 = L_shl(y0, e);
+            y1 = L_shl(y1, e);
+        }
+        else
+        {
+            y0 = L_shr(y0, -e);
+            y1 = L_shr(y1, -e);
+        }
+
+        if (i < FB_HOP/2)
+        {
+            dst[0] = L_add(fb->ola[2*i], y0);
+            dst[1] = L_add(fb->ola[2*i + 1], y1);
+        }
+        else
+        {
+            dst[0] = y0;
+            dst[1] = y1;
+        }
+    }
+}
+
+/**
+ * @brief Read bin k (0..FB_BINS-1) as a packed Q15 complex value
+ */
+Word32 FB_GetBin(const FB_State_t *fb, const FB_Spectrum_t *spec, int k)
+{
+    if (k == 0)
+        return pk_pack(PK_LO(spec->bin[0]), 0);
+    if (k == FB_BINS - 1)
+        return pk_pack(PK_HI(spec->bin[0]), 0);
+    return spec->bin[FFT_BIN_POS(&fb->fft, k)];
+}
+
+/**
+ * @brief Write bin k (0..FB_BINS-1)
+ */
+void FB_SetBin(const FB_State_t *fb, FB_Spectrum_t *spec, int k, Word32 v)
+{
+    if (k == 0)
+        spec->bin[0] = pk_lo_hi(v, spec->bin[0]);
+    else if (k == FB_BINS - 1)
+        spec->bin[0] = pk_lo_hi(spec->bin[0], v << 16);
+    else
+        spec->bin[FFT_BIN_POS(&fb->fft, k)] = v;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file fshift.c
+ * @brief Small frequency shifter for feedback decorrelation
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "fshift.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define FSHIFT_HEADROOM             2       /* allpass peaks exceed the input */
+#define FSHIFT_BLOCK_SHIFT          5       /* log2(AUDIO_BLOCK_SIZE) */
+
+/* ----------------------------------------------------------------------------
+ * Module Variable Definitions
+ * --------------------------------------------------------------------------*/
+
+/* Squared allpass coefficients, Q31 (O. Niemitalo's 8th-order Hilbert pair) */
+static const Word32 fshift_coef[2][FSHIFT_SECTIONS] =
+{
+    { 1029505520, 1881664887, 2097227354, 2142113341 },     /* I, then one sample delay */
+    { 347373730, 1574167646, 2030123023, 2127295491 }       /* Q */
+};
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief One allpass cascade: y = c (x + y[n-2]) - x[n-2] per section
+ */
+static Word32 fshift_branch(FSHIFT_Allpass_t *ap, const Word32 *coef, Word32 x)
+{
+    for (int s = 0; s < FSHIFT_SECTIONS; s++)
+    {
+        Word32 y = Mpy_32_32(x + ap[s].y2, coef[s]) - ap[s].x2;
+
+        ap[s].x2 = ap[s].x1;
+        ap[s].x1 = x;
+        ap[s].y2 = ap[s].y1;
+        ap[s].y1 = y;
+        x = y;
+    }
+    return x;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the shift in hertz
+ */
+void FSHIFT_Parser(float shift_hz, FSHIFT_Config_t *cfg)
+{
+    double f = shift_hz;
+    double w;
+
+    if (f < FSHIFT_MIN_HZ)
+        f = FSHIFT_MIN_HZ;
+    if (f > FSHIFT_MAX_HZ)
+        f = FSHIFT_MAX_HZ;
+
+    w = 2.0 * M_PI * f * AUDIO_BLOCK_SIZE / AUDIO_SAMPLE_RATE;
+    cfg->rot_re = (Word32)lround(2147483647.0 * cos(w));
+    cfg->rot_im = (Word32)lround(2147483647.0 * sin(w));
+}
+
+/**
+ * @brief Clear the filters, start the oscillator and apply a configuration
+ */
+void FSHIFT_Init(FSHIFT_State_t *fs, const FSHIFT_Config_t *cfg)
+{
+    memset(fs, 0, sizeof(*fs));
+    fs->cfg = *cfg;
+    fs->osc_re = MAX_32;
+}
+
+/**
+ * @brief Apply a new configuration
+ */
+void FSHIFT_SetConfig(FSHIFT_State_t *fs, const FSHIFT_Config_t *cfg)
+{
+    fs->cfg = *cfg;
+}
+
+/**
+ * @brief Shift one block in place
+ * @note  The oscillator moves at most 0.064 rad per block, so interpolating
+ *        between the block ends keeps its ripple below -70 dB.
+ */
+void FSHIFT_Process(FSHIFT_State_t *fs, Word32 *block)
+{
+    const Word32 c0 = fs->osc_re;
+    const Word32 s0 = fs->osc_im;
+    Word32 c1 = Mpy_32_32(c0, fs->cfg.rot_re) - Mpy_32_32(s0, fs->cfg.rot_im);
+    Word32 s1 = Mpy_32_32(c0, fs->cfg.rot_im) + Mpy_32_32(s0, fs->cfg.rot_re);
+    const Word32 dc = (c1 - c0) >> FSHIFT_BLOCK_SHIFT;
+    const Word32 ds = (s1 - s0) >> FSHIFT_BLOCK_SHIFT;
+    Word32 c = c0;
+    Word32 s = s0;
+    Word32 g;
+
+    for (int n = 0; n < AUDIO_BLOCK_SIZE; n++)
+    {
+        Word32 x = block[n] >> FSHIFT_HEADROOM;
+        Word32 i = fs->delay;
+        Word32 q = fshift_branch(fs->ap[1], fshift_coef[1], x);
+
+        fs->delay = fshift_branch(fs->ap[0], fshift_coef[0], x);
+        block[n] = L_shl(Mpy_32_32(i, c) + Mpy_32_32(q, s), FSHIFT_HEADROOM);
+        c += dc;
+        s += ds;
+    }
+
+    /* Hold the oscillator on the unit circle: g = (3 - |p|^2) / 2, Q30 */
+    g = 0x60000000 - (((Mpy_32_32(c1, c1) >> 1) + (Mpy_32_32(s1, s1) >> 1)) >> 1);
+    fs->osc_re = L_shl(Mpy_32_32(c1, g), 1);
+    fs->osc_im = L_shl(Mpy_32_32(s1, g), 1);
+}
@@ -0,0 +1,273 @@
+/**
+ * @file howl.c
+ * @brief Howl detector with an adaptive notch-filter bank
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "howl.h"
+#include "level.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define HOWL_LOG_FS                 18097       /* full-scale tone at a bin centre, log2 power Q8 */
+#define HOWL_DB_TO_LOG              85          /* 1 dB in log2 power Q8 */
+#define HOWL_SIN_MIN                1608        /* sin(pi/64), lowest placement half a bin up, Q15 */
+#define HOWL_K_MAX                  ((Word32)536224227)         /* 2 cos(pi/64), Q28 */
+#define HOWL_HEADROOM               10          /* bits, see below */
+#define HOWL_K_STEP                 ((Word32)1 << 24)           /* largest change per frame */
+#define HOWL_FADE_STEP              (MAX_16 / HOWL_FADE_FRAMES)
+
+/* The pole section 1/(1 + r k z^-1 + r^2 z^-2) has an absolute impulse
+ * response sum of at most 1 / ((1 - r) sin w0), its worst-case gain for
+ * any input. k is kept within the placement range, half a bin from DC and
+ * Nyquist, so at HOWL_R_NARROW that is 815 (502 measured), and a
+ * full-scale input needs HOWL_HEADROOM bits to stay in 32 bits. */
+#if ((1 << HOWL_HEADROOM) * (32768 - HOWL_R_NARROW) * HOWL_SIN_MIN) < (1 << 30)
+#error /* HOWL_HEADROOM is below the worst-case pole section gain */
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief True if bin j is a local peak within HOWL_HARM_TOL of level l
+ */
+static bool howl_peak_near(const Word32 *p, int j, Word32 l)
+{
+    for (int i = j - 1; i <= j + 1; i++)
+    {
+        if (i > 0 && i < FB_BINS - 1 && p[i] >= p[i - 1] && p[i] >= p[i + 1] &&
+            p[i] > l - HOWL_HARM_TOL)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Place a notch at pos, or retrigger the one already there
+ */
+static void howl_place(HOWL_State_t *howl, int pos)
+{
+    HOWL_Notch_t *n = NULL;
+
+    for (int i = 0; i < HOWL_NOTCHES; i++)
+    {
+        HOWL_Notch_t *c = &howl->notch[i];
+        int d = c->pos - pos;
+
+        if (c->active && d <= HOWL_FRAC && d >= -HOWL_FRAC)
+        {
+            c->hold = HOWL_HOLD;
+            c->release = false;
+            c->age = howl->frames;
+            return;
+        }
+    }
+
+    /* A free notch, else the one triggered longest ago */
+    for (int i = 0; i < HOWL_NOTCHES; i++)
+    {
+        HOWL_Notch_t *c = &howl->notch[i];
+
+        if (!c->active)
+        {
+            n = c;
+            break;
+        }
+        if (n == NULL || (howl->frames - c->age) > (howl->frames - n->age))
+            n = c;
+    }
+
+    n->active = true;
+    n->release = false;
+    n->k = (Word32)howl->k_init[pos] << 14;
+    n->r = HOWL_R_WIDE;
+    n->depth = 0;
+    n->pos = pos;
+    n->hold = HOWL_HOLD;
+    n->age = howl->frames;
+    n->s1 = n->s2 = 0;
+    n->fired++;
+}
+
+/**
+ * @brief Run one notch over a block and adapt it once
+ * @note  Direct form II: s = x / D(z), e = N(z) s. The poles amplify by up
+ *        to 1 / ((1 - r) sin w0), so s is kept HOWL_HEADROOM bits down.
+ *        The gradient of e with respect to k is taken as s[n-1].
+ */
+static void howl_notch(HOWL_Notch_t *n, Word32 *block)
+{
+    const Word32 rk = Mpy_32_16(n->k, n->r);
+    const Word32 r2 = (Word32)n->r * n->r;     /* Q30 */
+    int64_t eg = 0;
+    int64_t gg = 0;
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        Word32 x = block[i];
+        int64_t s = (int64_t)(x >> HOWL_HEADROOM) - (((int64_t)rk * n->s1) >> 28) - (((int64_t)r2 * n->s2) >> 30);
+        int64_t e = s + (((int64_t)n->k * n->s1) >> 28) + n->s2;
+        int64_t y;
+
+        s = (s > MAX_32) ? MAX_32 : ((s < MIN_32) ? MIN_32 : s);
+        eg += (e >> 8) * (n->s1 >> 8);
+        gg += (int64_t)(n->s1 >> 8) * (n->s1 >> 8);
+
+        /* Fade between the input and the notch output */
+        y = x + ((((e << HOWL_HEADROOM) - x) * n->depth) >> 15);
+        block[i] = (y > MAX_32) ? MAX_32 : ((y < MIN_32) ? MIN_32 : (Word32)y);
+
+        n->s2 = n->s1;
+        n->s1 = (Word32)s;
+    }
+
+    /* Normalized gradient step: k -= mu * sum(e s1) / sum(s1 s1) */
+    if (gg > 0)
+    {
+        int sh = 0;
+        int64_t dk;
+
+        while ((gg >> sh) > MAX_32)
+            sh++;
+        dk = ((((eg >> sh) << 15) / (gg >> sh)) * HOWL_MU) >> 2;     /* Q30 to Q28 */
+
+        /* Clamped before narrowing: with s1 near zero the ratio can be huge */
+        if (dk > HOWL_K_STEP)
+            dk = HOWL_K_STEP;
+        if (dk < -HOWL_K_STEP)
+            dk = -HOWL_K_STEP;
+        n->k -= (Word32)dk;
+        if (n->k > HOWL_K_MAX)
+            n->k = HOWL_K_MAX;
+        if (n->k < -HOWL_K_MAX)
+            n->k = -HOWL_K_MAX;
+    }
+
+    n->r += (HOWL_R_NARROW - n->r) >> HOWL_R_SHIFT;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Build the placement table and clear all notches
+ */
+void HOWL_Init(HOWL_State_t *howl)
+{
+    memset(howl, 0, sizeof(*howl));
+
+    for (int i = 0; i <= FB_FFT_LEN / 2 * HOWL_FRAC; i++)
+        howl->k_init[i] = sat16(lround(-2.0 * 16384.0 * cos(M_PI * i / (FB_FFT_LEN / 2 * HOWL_FRAC))));
+    howl->min_level = HOWL_LOG_FS + HOWL_MIN_LEVEL * HOWL_DB_TO_LOG;
+}
+
+/**
+ * @brief Look for a howl in one spectrum and place or retrigger notches
+ */
+void HOWL_Detect(HOWL_State_t *howl, const FB_State_t *fb, const FB_Spectrum_t *spec)
+{
+    Word32 p[FB_BINS];
+    Word32 mean = 0;
+
+    howl->frames++;
+
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word32 v = FB_GetBin(fb, spec, k);
+        UWord32 pw = (UWord32)((Word32)PK_LO(v) * PK_LO(v)) + (UWord32)((Word32)PK_HI(v) * PK_HI(v));
+
+        p[k] = LVL_Log2(pw) + spec->exp * 512;
+        mean += p[k];
+    }
+    mean /= FB_BINS;
+
+    for (int k = 1; k < FB_BINS - 1; k++)
+    {
+        bool cand = p[k] > mean + HOWL_PAPR && p[k] > howl->min_level &&
+                    p[k] >= p[k - 1] && p[k] >= p[k + 1];
+
+        /* A peak at half or twice the frequency makes it a harmonic series */
+        if (cand && ((k >= 4 && howl_peak_near(p, (k + 1) / 2, p[k])) ||
+                     (2 * k < FB_BINS - 2 && howl_peak_near(p, 2 * k, p[k]))))
+            cand = false;
+
+        if (!cand)
+        {
+            howl->persist[k] = 0;
+            continue;
+        }
+        if (++howl->persist[k] >= HOWL_PERSIST)
+        {
+            Word32 a = p[k - 1] - p[k];
+            Word32 b = p[k + 1] - p[k];
+            int frac = 0;
+
+            /* Vertex of the parabola through the three log powers */
+            if (a + b < 0)
+                frac = (HOWL_FRAC * (a - b)) / (2 * (a + b));
+            if (frac > HOWL_FRAC / 2)
+                frac = HOWL_FRAC / 2;
+            if (frac < -HOWL_FRAC / 2)
+                frac = -HOWL_FRAC / 2;
+
+            howl_place(howl, k * HOWL_FRAC + frac);
+            howl->persist[k] = 0;
+        }
+    }
+}
+
+/**
+ * @brief Run the active notches over one block in place
+ */
+void HOWL_Process(HOWL_State_t *howl, Word32 *block)
+{
+    for (int i = 0; i < HOWL_NOTCHES; i++)
+    {
+        HOWL_Notch_t *n = &howl->notch[i];
+
+        if (!n->active)
+            continue;
+
+        if (!n->release && --n->hold <= 0)
+            n->release = true;
+        n->depth = n->release ? sub(n->depth, HOWL_FADE_STEP) : add(n->depth, HOWL_FADE_STEP);
+        if (n->depth <= 0)
+        {
+            n->depth = 0;
+            if (n->release)
+            {
+                n->active = false;
+                continue;
+            }
+        }
+
+        howl_notch(n, block);
+    }
+}
+
+/**
+ * @brief Publish the per-notch fire counts in UPLOAD.MISC
+ */
+void HOWL_Dump(const HOWL_State_t *howl, SM_UPLOAD_DATA *upload)
+{
+    UWord32 v = 0;
+
+    for (int i = 0; i < HOWL_NOTCHES; i++)
+        v |= (howl->notch[i].fired & 0xF) << (4 * i);
+    upload->MISC[HOWL_DUMP_MISC] = (short)v;
+}
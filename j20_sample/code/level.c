@@ -0,0 +1,55 @@
+/**
+ * @file level.c
+ * @brief Integer level kernels: envelope followers
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "level.h"
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Attack/release follower over n levels
+ */
+void LVL_Follow(Word16 *env, const Word16 *x, int n, Word16 attack, Word16 release)
+{
+    int i = 0;
+
+#if BASIC_OP_USE_DSP
+    const UWord32 att = (UWord32)pk_pack(attack, attack);
+    const UWord32 rel = (UWord32)pk_pack(release, release);
+
+    for (; i + 1 < n; i += 2)
+    {
+        Word32 e;
+        Word32 v;
+        Word32 d;
+        Word32 c;
+
+        memcpy(&e, &env[i], sizeof(e));
+        memcpy(&v, &x[i], sizeof(v));
+
+        /* SSUB16 sets GE per lane where x >= env, SEL picks the coefficient;
+         * the difference itself is taken saturated, as the scalar loop does */
+        (void)__SSUB16(v, e);
+        c = (Word32)__SEL(att, rel);
+        d = (Word32)__QSUB16(v, e);
+        e = pk_add(e, pk_pack(__SMULBB(d, c) >> 15, __SMULTT(d, c) >> 15));
+        memcpy(&env[i], &e, sizeof(e));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        Word32 d = sat16((Word32)x[i] - env[i]);
+        Word16 c = (d >= 0) ? attack : release;
+
+        env[i] = sat16(env[i] + ((d * c) >> 15));
+    }
+}
@@ -0,0 +1,234 @@
+/**
+ * @file limiter.c
+ * @brief Look-ahead output limiter (open AGC-O) for the CM33 stages
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "limiter.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define LIM_MASK                    (LIM_RING - 1)
+#define LIM_THRESHOLD_MIN           (-15.0)     /* dBFS, MCU_Config_AGCO range */
+#define LIM_RELEASE_MIN             2.0         /* ms */
+#define LIM_RELEASE_MAX             20.0
+
+/* ----------------------------------------------------------------------------
+ * Module Variable Definitions
+ * --------------------------------------------------------------------------*/
+
+/* 10^(-k/40) in Q15, ceiling trim of k half-dB steps */
+static const Word16 lim_trim_gain[LIM_TRIM_STEPS + 1] =
+{
+    32767, 30935, 29205, 27571, 26029, 24573, 23198,
+    21900, 20675, 19519, 18427, 17396, 16423
+};
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief c/p in Q15 for 0 < c < p, never above the exact ratio
+ */
+static Word32 lim_ratio(Word32 c, Word32 p)
+{
+    int sh = norm_l(p);
+    Word32 pn = ((p << sh) >> 15) + 1;  /* rounded up: the quotient rounds down */
+    Word32 cn = (c << sh) >> 15;
+
+    return (cn << 15) / pn;
+}
+
+/**
+ * @brief Clear the delay line, peak deque and gain history
+ */
+static void lim_reset(LIM_State_t *lim)
+{
+    memset(lim->delay, 0, sizeof(lim->delay));
+    lim->dq_head = 0;
+    lim->dq_tail = 0;
+    for (int i = 0; i < LIM_RING; i++)
+        lim->box[i] = LIM_UNITY;
+    lim->box_sum = (lim->cfg.lookahead + 1) * LIM_UNITY;
+    lim->release_gain = (Word32)LIM_UNITY << 15;
+}
+
+/**
+ * @brief Ceiling after the hardware trim
+ */
+static void lim_update_ceiling(LIM_State_t *lim)
+{
+    lim->ceiling = (lim->trim > 0) ? Mpy_32_16(lim->cfg.ceiling, lim_trim_gain[lim->trim])
+                                   : lim->cfg.ceiling;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the fitting parameters into a fixed-point configuration
+ */
+void LIM_Parser(const MCU_Config_AGCO *agco, LIM_Config_t *cfg)
+{
+    double threshold = agco->Threshold;
+    double release = agco->Release_Time;
+    long lookahead = lround(agco->Attack_Time * AUDIO_SAMPLE_RATE / 1000.0);
+
+    if (threshold > 0.0)
+        threshold = 0.0;
+    if (threshold < LIM_THRESHOLD_MIN)
+        threshold = LIM_THRESHOLD_MIN;
+    if (release < LIM_RELEASE_MIN)
+        release = LIM_RELEASE_MIN;
+    if (release > LIM_RELEASE_MAX)
+        release = LIM_RELEASE_MAX;
+
+    /* The attack ramp spans the look-ahead, so longer attack times saturate at 1 ms */
+    if (lookahead < LIM_LOOKAHEAD_MIN)
+        lookahead = LIM_LOOKAHEAD_MIN;
+    if (lookahead > LIM_LOOKAHEAD_MAX)
+        lookahead = LIM_LOOKAHEAD_MAX;
+
+    cfg->ceiling = (Word32)(2147483647.0 * pow(10.0, threshold / 20.0));
+    cfg->lookahead = (int)lookahead;
+    cfg->release = sat16(lround(32768.0 * (1.0 - exp(-1000.0 / (release * AUDIO_SAMPLE_RATE)))));
+}
+
+/**
+ * @brief Reset the limiter and apply a configuration
+ */
+void LIM_Init(LIM_State_t *lim, const LIM_Config_t *cfg)
+{
+    memset(lim, 0, sizeof(*lim));
+    lim->cfg = *cfg;
+    lim->min_gain = MAX_16;
+    lim_update_ceiling(lim);
+    lim_reset(lim);
+}
+
+/**
+ * @brief Apply a new configuration, keeping the state if the look-ahead is unchanged
+ * @note  Call with the DSP interrupt masked.
+ */
+void LIM_SetConfig(LIM_State_t *lim, const LIM_Config_t *cfg)
+{
+    bool restart = (cfg->lookahead != lim->cfg.lookahead);
+
+    lim->cfg = *cfg;
+    lim_update_ceiling(lim);
+    if (restart)
+        lim_reset(lim);
+}
+
+/**
+ * @brief Limit one block in place; the output is delayed by the look-ahead
+ * @note  The gain a sample needs is known for the whole look-ahead before
+ *        the sample is played, and the box filter averages only gains that
+ *        are at or below it, so the output peak never exceeds the ceiling.
+ */
+void LIM_Process(LIM_State_t *lim, Word32 *block)
+{
+    const int la = lim->cfg.lookahead;
+    const Word32 ceiling = lim->ceiling;
+    Word32 min_gain = LIM_UNITY;
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        UWord32 n = lim->n++;
+        int pos = n & LIM_MASK;
+        Word32 x = block[i];
+        Word32 a = (x == MIN_32) ? MAX_32 : ((x < 0) ? -x : x);
+        Word32 t;
+        Word32 g;
+        Word32 y;
+
+        /* Sliding maximum over the last la + 1 samples: expire the front,
+         * then drop entries no larger than the new one from the back */
+        if (lim->dq_tail != lim->dq_head && n - lim->dq_pos[lim->dq_head & LIM_MASK] > (UWord32)la)
+            lim->dq_head++;
+        while (lim->dq_tail != lim->dq_head && lim->dq_peak[(lim->dq_tail - 1) & LIM_MASK] <= a)
+            lim->dq_tail--;
+        lim->dq_peak[lim->dq_tail & LIM_MASK] = a;
+        lim->dq_pos[lim->dq_tail & LIM_MASK] = n;
+        lim->dq_tail++;
+
+        a = lim->dq_peak[lim->dq_head & LIM_MASK];
+        t = (a > ceiling) ? lim_ratio(ceiling, a) : LIM_UNITY;
+
+        /* Instant attack, one-pole release: never above the target */
+        t <<= 15;
+        if (t < lim->release_gain)
+            lim->release_gain = t;
+        else if (t - lim->release_gain < (1 << 15))
+            lim->release_gain = t;
+        else
+            lim->release_gain += Mpy_32_16(t - lim->release_gain, lim->cfg.release);
+
+        /* Box filter over la + 1 gains, each covering the sample leaving now */
+        lim->box_sum -= lim->box[(n - la - 1) & LIM_MASK];
+        lim->box[pos] = lim->release_gain >> 15;
+        lim->box_sum += lim->box[pos];
+        g = lim->box_sum / (la + 1);
+
+        y = lim->delay[(n - la) & LIM_MASK];
+        lim->delay[pos] = x;
+        if (g < LIM_UNITY)
+        {
+            y = (Word32)(((int64_t)y * g) >> 15);
+            if (g < min_gain)
+                min_gain = g;
+        }
+        block[i] = y;
+    }
+
+    lim->min_gain = (Word16)((min_gain < LIM_UNITY) ? min_gain : MAX_16);
+}
+
+/**
+ * @brief Trim the ceiling from the codec limiter event count, once per frame
+ * @note  With the codec limiter set above the software ceiling it should
+ *        never fire; if it does (a DC offset, OD gain above unity), each
+ *        frame with new events lowers the ceiling 0.5 dB and every second
+ *        without one gives 0.5 dB back.
+ */
+void LIM_Hardware(LIM_State_t *lim, uint32_t events)
+{
+    int trim = lim->trim;
+
+    if (events != lim->hw_events)
+    {
+        lim->hw_events = events;
+        lim->trim_hold = 0;
+        if (trim < LIM_TRIM_STEPS)
+            trim++;
+    }
+    else if (trim > 0 && ++lim->trim_hold >= LIM_TRIM_HOLD)
+    {
+        lim->trim_hold = 0;
+        trim--;
+    }
+
+    if (trim != lim->trim)
+    {
+        lim->trim = trim;
+        lim_update_ceiling(lim);
+    }
+}
+
+/**
+ * @brief Write the gain reduction of the last frame to UPLOAD.MISC
+ */
+void LIM_Dump(const LIM_State_t *lim, SM_UPLOAD_DATA *upload)
+{
+    upload->MISC[LIM_DUMP_MISC] = lim->min_gain;
+}
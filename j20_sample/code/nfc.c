@@ -0,0 +1,209 @@
+/**
+ * @file nfc.c
+ * @brief Nonlinear frequency compression on the shared filterbank
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "nfc.h"
+#include "level.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define NFC_BIN_HZ                  ((double)AUDIO_SAMPLE_RATE / FB_FFT_LEN)
+#define NFC_HOP_TURN                32768u      /* phase step of bin 1 per hop, FB_HOP / FB_FFT_LEN turn */
+#define NFC_QUARTER                 16384u
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Angle of re + j im in 1/65536 turn
+ * @note  atan(z) ~ pi/4 z + 0.273 z (1 - z) on the first octant, within 0.25 degree.
+ */
+static uint16_t nfc_angle(Word16 re, Word16 im)
+{
+    Word32 ax = (re < 0) ? -(Word32)re : re;
+    Word32 ay = (im < 0) ? -(Word32)im : im;
+    Word32 z;
+    uint16_t a;
+
+    if (ax == 0 && ay == 0)
+        return 0;
+
+    z = (ay <= ax) ? (ay << 15) / ax : (ax << 15) / ay;
+    a = (uint16_t)((z >> 2) + ((((z * (32768 - z)) >> 15) * 2851) >> 15));
+    if (ay > ax)
+        a = (uint16_t)(NFC_QUARTER - a);
+    if (re < 0)
+        a = (uint16_t)(2 * NFC_QUARTER - a);
+    if (im < 0)
+        a = (uint16_t)(0u - a);
+    return a;
+}
+
+/**
+ * @brief sin of a phase in 1/65536 turn, Q15, interpolated from the table
+ */
+static Word16 nfc_sin(const Word16 *tab, uint16_t ph)
+{
+    int i = ph >> 8;
+    Word32 a = tab[i];
+    Word32 b = tab[(i + 1) & (NFC_SIN_LEN - 1)];
+
+    return (Word16)(a + (((b - a) * (ph & 0xFF)) >> 8));
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the frequency map from the fitting parameters
+ */
+void NFC_Parser(const MCU_Config_NFC *mcu, NFC_Config_t *cfg)
+{
+    double fc = mcu->Cutoff_Hz;
+    double cr = mcu->Ratio;
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->cutoff = FB_BINS;
+    if (fc <= 0.0 || cr <= 1.0)
+        return;
+
+    if (fc < NFC_MIN_HZ)
+        fc = NFC_MIN_HZ;
+    if (fc > NFC_MAX_HZ)
+        fc = NFC_MAX_HZ;
+    if (cr > NFC_MAX_RATIO)
+        cr = NFC_MAX_RATIO;
+
+    cfg->cutoff = (int)ceil(fc / NFC_BIN_HZ);
+    for (int j = cfg->cutoff; j < FB_BINS; j++)
+    {
+        double r = j * NFC_BIN_HZ / fc;
+        long pos = lround(256.0 * fc * pow(r, 1.0 / cr) / NFC_BIN_HZ);
+
+        /* fc sits below the centre of the cutoff bin, so the first inputs
+         * can map under it; NFC_Process only owns the bins from the cutoff */
+        if (pos < cfg->cutoff * 256)
+            pos = cfg->cutoff * 256;
+        cfg->pos[j] = sat16(pos);
+        cfg->slope[j] = sat16(lround(32768.0 * pow(r, 1.0 / cr - 1.0) / cr));
+    }
+}
+
+/**
+ * @brief Build the sine table, clear the phases and apply a configuration
+ */
+void NFC_Init(NFC_State_t *nfc, const NFC_Config_t *cfg)
+{
+    memset(nfc, 0, sizeof(*nfc));
+    for (int i = 0; i < NFC_SIN_LEN; i++)
+        nfc->sin_tab[i] = sat16(lround(32767.0 * sin(2.0 * M_PI * i / NFC_SIN_LEN)));
+    nfc->cfg = *cfg;
+}
+
+/**
+ * @brief Apply a new configuration
+ */
+void NFC_SetConfig(NFC_State_t *nfc, const NFC_Config_t *cfg)
+{
+    nfc->cfg = *cfg;
+}
+
+/**
+ * @brief Compress the bins above the cutoff of one spectrum in place
+ * @note  Sources and destinations overlap, so all sources are read first.
+ */
+void NFC_Process(NFC_State_t *nfc, const FB_State_t *fb, FB_Spectrum_t *spec)
+{
+    const NFC_Config_t *cfg = &nfc->cfg;
+    const int kc = cfg->cutoff;
+    UWord32 pw[FB_BINS];
+    Word32 fo[FB_BINS];                 /* instantaneous output frequency, Q8 bins */
+    uint64_t acc[FB_BINS];
+    int8_t src[FB_BINS];
+
+    if (kc >= FB_BINS)
+        return;
+
+    for (int k = kc; k < FB_BINS; k++)
+    {
+        acc[k] = 0;
+        src[k] = -1;
+    }
+
+    for (int j = kc; j < FB_BINS; j++)
+    {
+        Word32 v = FB_GetBin(fb, spec, j);
+        uint16_t ph = nfc_angle(PK_LO(v), PK_HI(v));
+        /* Deviation from the bin centre: +-1/2 turn is +-1 bin */
+        int16_t dev = (int16_t)(uint16_t)(ph - nfc->phase_in[j] - (uint16_t)(j * NFC_HOP_TURN));
+        int k;
+
+        nfc->phase_in[j] = ph;
+        pw[j] = (UWord32)((Word32)PK_LO(v) * PK_LO(v)) + (UWord32)((Word32)PK_HI(v) * PK_HI(v));
+        fo[j] = cfg->pos[j] + (((Word32)dev * cfg->slope[j]) >> 22);
+
+        k = (cfg->pos[j] + 128) >> 8;
+        acc[k] += pw[j];
+        if (src[k] < 0 || pw[j] > pw[src[k]])
+            src[k] = (int8_t)j;
+    }
+
+    /* Peaks carry the phase vocoder; the bins around a peak are locked to
+     * it with the half-turn step between neighbours of a windowed tone */
+    for (int k = kc; k < FB_BINS; k++)
+    {
+        if (src[k] >= 0 && (k == kc || acc[k] >= acc[k - 1]) && (k == FB_BINS - 1 || acc[k] >= acc[k + 1]))
+            nfc->phase_out[k] = (uint16_t)(nfc->phase_out[k] + (uint16_t)(fo[src[k]] << 7));
+    }
+
+    for (int k = kc; k < FB_BINS; k++)
+    {
+        UWord32 mag;
+        uint16_t ph;
+        int p = k;
+
+        if (src[k] < 0)
+        {
+            FB_SetBin(fb, spec, k, 0);
+            continue;
+        }
+
+        /* Climb to the peak this bin belongs to */
+        for (;;)
+        {
+            int q = p;
+
+            if (p > kc && acc[p - 1] > acc[q])
+                q = p - 1;
+            if (p < FB_BINS - 1 && acc[p + 1] > acc[q])
+                q = p + 1;
+            if (q == p)
+                break;
+            p = q;
+        }
+        ph = nfc->phase_out[k] = (uint16_t)(nfc->phase_out[p] + (uint16_t)((k - p) * NFC_HOP_TURN));
+
+        mag = LVL_Pow2(LVL_Log2_64(acc[k]) >> 1);
+        if (mag > MAX_16)
+            mag = MAX_16;
+
+        FB_SetBin(fb, spec, k, pk_pack(mult_r((Word16)mag, nfc_sin(nfc->sin_tab, (uint16_t)(ph + NFC_QUARTER))),
+                                       mult_r((Word16)mag, nfc_sin(nfc->sin_tab, ph))));
+    }
+}
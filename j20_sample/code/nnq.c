@@ -0,0 +1,202 @@
+/**
+ * @file nnq.c
+ * @brief Small int8/int16 inference runtime for the CM33 stages
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "basic_op.h"
+#include "nnq.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define NNQ_SIG_STEP_SHIFT          9       /* table step 1/8 at Q12 */
+
+/* ----------------------------------------------------------------------------
+ * Module Variable Definitions
+ * --------------------------------------------------------------------------*/
+
+/* 1/(1 + exp(-i/8)) in Q15, i = 0..64 */
+static const Word16 nnq_sigmoid[65] =
+{
+    16384, 17407, 18421, 19420, 20397, 21344, 22255, 23127, 23955, 24737,
+    25471, 26155, 26790, 27377, 27917, 28411, 28862, 29272, 29644, 29979,
+    30282, 30555, 30799, 31018, 31214, 31389, 31545, 31684, 31807, 31917,
+    32015, 32102, 32179, 32247, 32307, 32361, 32408, 32450, 32487, 32520,
+    32549, 32574, 32597, 32617, 32635, 32650, 32664, 32676, 32687, 32696,
+    32705, 32712, 32719, 32725, 32730, 32734, 32738, 32742, 32745, 32747,
+    32750, 32752, 32754, 32756, 32757
+};
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Dot product of one packed row with packed input pairs
+ */
+static Word32 nnq_dot_packed(const UWord32 *w, const Word32 *xp, int cols, Word32 acc)
+{
+    for (int i = 0; i < cols / 4; i++)
+    {
+        UWord32 q = w[i];
+
+        acc = pk_smlad(pk_sxtb16(q), xp[2 * i], acc);
+        acc = pk_smlad(pk_sxtb16_hi(q), xp[2 * i + 1], acc);
+    }
+    return acc;
+}
+
+/**
+ * @brief Dot product of one natural-order row, the reference kernel
+ */
+static Word32 nnq_dot(const int8_t *w, const Word16 *x, int cols, Word32 acc)
+{
+    for (int i = 0; i < cols; i++)
+        acc += (Word32)w[i] * x[i];
+    return acc;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Attach the arena to its static buffer
+ */
+void NNQ_ArenaInit(NNQ_Arena_t *arena, void *buf, size_t size)
+{
+    arena->base = buf;
+    arena->size = size;
+    arena->used = 0;
+}
+
+/**
+ * @brief Take bytes from the arena, NNQ_ALIGN aligned
+ */
+void *NNQ_Alloc(NNQ_Arena_t *arena, size_t bytes)
+{
+    void *p;
+
+    bytes = NNQ_ALIGNED(bytes);
+    if (bytes > arena->size - arena->used)
+        return NULL;
+
+    p = arena->base + arena->used;
+    arena->used += bytes;
+    return p;
+}
+
+/**
+ * @brief Copy a natural-order matrix and its bias into the arena, packed
+ */
+bool NNQ_Pack(NNQ_Arena_t *arena, const NNQ_Mat_t *src, NNQ_Mat_t *dst)
+{
+    int8_t *w = NNQ_Alloc(arena, (size_t)src->rows * src->cols);
+    Word32 *bias = NNQ_Alloc(arena, (size_t)src->rows * sizeof(Word32));
+
+    if (w == NULL || bias == NULL || (src->cols % 4) != 0)
+        return false;
+
+    for (int n = 0; n < src->rows * src->cols; n += 4)
+    {
+        w[n] = src->w[n];
+        w[n + 1] = src->w[n + 2];
+        w[n + 2] = src->w[n + 1];
+        w[n + 3] = src->w[n + 3];
+    }
+    memcpy(bias, src->bias, (size_t)src->rows * sizeof(Word32));
+
+    *dst = *src;
+    dst->w = w;
+    dst->bias = bias;
+    dst->packed = true;
+    return true;
+}
+
+/**
+ * @brief acc = bias + W x, 32-bit accumulators
+ * @note  The packed path reads x as halfword pairs, so x must be word aligned.
+ */
+void NNQ_MatVec(const NNQ_Mat_t *m, const Word16 *x, Word32 *acc)
+{
+    if (m->packed)
+    {
+        const UWord32 *w = (const UWord32 *)m->w;
+
+        for (int r = 0; r < m->rows; r++)
+            acc[r] = nnq_dot_packed(w + r * (m->cols / 4), (const Word32 *)x, m->cols, m->bias[r]);
+    }
+    else
+    {
+        for (int r = 0; r < m->rows; r++)
+            acc[r] = nnq_dot(m->w + r * m->cols, x, m->cols, m->bias[r]);
+    }
+}
+
+/**
+ * @brief Round an accumulator at Q(NNQ_Q + shift) back to a Q12 activation
+ */
+Word16 NNQ_Requant(Word32 acc, int shift)
+{
+    if (shift <= 0)
+        return sat16(acc);
+    return sat16((Word32)(((int64_t)acc + (1 << (shift - 1))) >> shift));
+}
+
+/**
+ * @brief Logistic sigmoid, Q12 in, Q15 out
+ */
+Word16 NNQ_Sigmoid(Word16 x)
+{
+    Word32 a = (x < 0) ? -(Word32)x : x;
+    Word32 i;
+    Word32 y;
+
+    if (a > MAX_16)
+        a = MAX_16;
+    i = a >> NNQ_SIG_STEP_SHIFT;
+    y = nnq_sigmoid[i] + (((nnq_sigmoid[i + 1] - nnq_sigmoid[i]) * (a & ((1 << NNQ_SIG_STEP_SHIFT) - 1)))
+                          >> NNQ_SIG_STEP_SHIFT);
+
+    return (Word16)((x < 0) ? (32768 - y) : y);
+}
+
+/**
+ * @brief Hyperbolic tangent, Q12 in, Q15 out
+ * @note  tanh(x) = 2 sigmoid(2x) - 1; 2x saturates beyond |x| = 4, where
+ *        tanh is within 0.1% of 1.
+ */
+Word16 NNQ_Tanh(Word16 x)
+{
+    return sat16(2 * (Word32)NNQ_Sigmoid(sat16(2 * (Word32)x)) - 32768);
+}
+
+/**
+ * @brief One GRU time step; h (Q12) is updated in place
+ * @note  r = s(Wir x + Whr h), z = s(Wiz x + Whz h),
+ *        n = tanh(Win x + r * (Whn h)), h = n + z * (h - n).
+ */
+void NNQ_GRU_Step(const NNQ_GRU_t *g, const Word16 *x, Word16 *h)
+{
+    const int H = g->hidden;
+
+    NNQ_MatVec(&g->wi, x, g->acc_i);
+    NNQ_MatVec(&g->wh, h, g->acc_h);
+
+    for (int j = 0; j < H; j++)
+    {
+        Word16 r = NNQ_Sigmoid(NNQ_Requant(L_add(g->acc_i[j], g->acc_h[j]), g->shift));
+        Word16 z = NNQ_Sigmoid(NNQ_Requant(L_add(g->acc_i[H + j], g->acc_h[H + j]), g->shift));
+        Word16 n = NNQ_Tanh(NNQ_Requant(L_add(g->acc_i[2 * H + j], Mpy_32_16(g->acc_h[2 * H + j], r)),
+                                        g->shift));
+        Word16 n12 = (Word16)((n + (1 << (14 - NNQ_Q))) >> (15 - NNQ_Q));
+
+        h[j] = sat16(n12 + mult_r(z, sat16((Word32)h[j] - n12)));
+    }
+}
@@ -0,0 +1,239 @@
+/**
+ * @file nr_wiener.c
+ * @brief Wiener noise reduction with a minimum-statistics noise tracker
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "basic_op.h"
+#include "nr_wiener.h"
+#include "level.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define NR_LOG_MIN                  (-(8 << 8))     /* posterior SNR clamp, log2 Q8 */
+#define NR_LOG_MAX                  (20 << 8)
+#define NR_XI_MAX                   (1 << 20)       /* a-priori SNR clamp, 36 dB in Q8 */
+#define NR_VOX_SNR                  256             /* mean posterior SNR for VOX, 3 dB */
+
+/* Offset from mean bin log power to a Q31 per-sample power: the window
+ * energy (sum w^2 = N/2, 2^5) and the 2^31 full scale of a Word32 sample */
+#define NR_LOG_TO_Q31               ((5 + 31) << 8)
+
+/* ----------------------------------------------------------------------------
+ * Module Variable Definitions
+ * --------------------------------------------------------------------------*/
+
+/* 10^(-d/20) in Q15 for a max depth of d = 0..15 dB */
+static const Word16 nr_depth_floor[NR_MAX_DEPTH_DB + 1] =
+{
+    32767, 29205, 26029, 23198, 20675, 18427, 16423, 14637,
+    13045, 11627, 10362,  9235,  8231,  7336,  6538,  5827
+};
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Wiener gain xi/(1+xi) in Q15 for xi in Q8
+ */
+static Word16 nr_wiener_gain(Word32 xi)
+{
+    Word32 d = xi + 256;
+    int sh = norm_l(d) - 16;
+
+    /* Bring the denominator to 15 bits so the quotient keeps full precision */
+    if (sh >= 0)
+        return (Word16)(((xi << sh) << 15) / (d << sh));
+    return (Word16)(((xi >> -sh) << 15) / (d >> -sh));
+}
+
+/**
+ * @brief Gain floor of bin k from the normal or low-noise depth table
+ */
+static Word16 nr_floor(const SM_CONFIG_NC *cfg, bool low_noise, int k)
+{
+    const unsigned char *depth = low_noise ? cfg->low_noise_max_depth_dB : cfg->normal_max_depth_dB;
+    int d = (signed char)depth[(k > 0) ? (k - 1) : 0];
+
+    /* MCU_Config_NC keeps the depth as a negative dB value */
+    if (d < 0)
+        d = -d;
+    if (d > NR_MAX_DEPTH_DB)
+        d = NR_MAX_DEPTH_DB;
+    return nr_depth_floor[d];
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Reset the tracker and bind the parameter block
+ */
+void NR_Init(NR_State_t *nr, const SM_CONFIG_NC *cfg)
+{
+    memset(nr, 0, sizeof(*nr));
+    nr->cfg = cfg;
+
+    for (int k = 0; k < FB_BINS; k++)
+        nr->gain[k] = MAX_16;
+    nr->scale = MAX_16;
+}
+
+/**
+ * @brief Update the noise estimate and apply the Wiener gain to one spectrum
+ */
+void NR_Process(NR_State_t *nr, const FB_State_t *fb, FB_Spectrum_t *spec)
+{
+    const SM_CONFIG_NC *cfg = nr->cfg;
+    Word16 post[FB_BINS];
+    Word32 sum_noise = 0;
+    Word32 sum_post = 0;
+    Word32 sum_power = 0;
+    Word32 level;
+    bool end_of_subwin;
+
+    /* Bin log power and its smoothing */
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word32 v = FB_GetBin(fb, spec, k);
+        UWord32 p = (UWord32)((Word32)PK_LO(v) * PK_LO(v)) + (UWord32)((Word32)PK_HI(v) * PK_HI(v));
+        Word16 l = sat16(LVL_Log2(p) + spec->exp * 512);
+
+        if (nr->frames == 0)
+        {
+            nr->smooth[k] = l;
+            nr->sub_min[k] = l;
+            nr->ring_min[k] = l;
+            for (int w = 0; w < NR_MS_SUBWIN; w++)
+                nr->win_min[w][k] = l;
+        }
+        post[k] = l;
+    }
+    LVL_Follow(nr->smooth, post, FB_BINS, 32768 - NR_SMOOTH_ALPHA, 32768 - NR_SMOOTH_ALPHA);
+
+    /* Running minimum */
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word16 l = post[k];
+
+        if (!nr->hold && nr->smooth[k] < nr->sub_min[k])
+            nr->sub_min[k] = nr->smooth[k];
+
+        nr->noise[k] = sat16(((nr->sub_min[k] < nr->ring_min[k]) ? nr->sub_min[k] : nr->ring_min[k]) + NR_MS_BIAS);
+
+        sum_power += l;
+        sum_noise += nr->noise[k];
+        sum_post += l - nr->noise[k];
+    }
+
+    if (nr->frames < MAX_16)
+        nr->frames++;
+
+    /* Retire the finished sub-window; the ring minimum only changes here.
+     * A hold stops the sub-window clock, so speech never ages noise out */
+    end_of_subwin = !nr->hold && (++nr->subwin_cnt >= NR_MS_SUBWIN_LEN);
+    if (end_of_subwin)
+    {
+        memcpy(nr->win_min[nr->subwin_idx], nr->sub_min, sizeof(nr->sub_min));
+        nr->subwin_idx = (nr->subwin_idx + 1) % NR_MS_SUBWIN;
+        nr->subwin_cnt = 0;
+
+        for (int k = 0; k < FB_BINS; k++)
+        {
+            Word16 m = nr->win_min[0][k];
+            for (int w = 1; w < NR_MS_SUBWIN; w++)
+            {
+                if (nr->win_min[w][k] < m)
+                    m = nr->win_min[w][k];
+            }
+            nr->ring_min[k] = m;
+            nr->sub_min[k] = nr->smooth[k];
+        }
+    }
+
+    /* Low-noise and VOX decisions against the fitting levels (0 = off) */
+    level = cfg->nc_common_param[NR_PARAM_LOW_NOISE_LEVEL];
+    nr->low_noise = (level > 0) && (sum_noise / FB_BINS - NR_LOG_TO_Q31 < LVL_Log2((UWord32)level));
+
+    level = cfg->nc_common_param[NR_PARAM_VOX_LEVEL];
+    nr->vox = (level > 0) && (sum_power / FB_BINS - NR_LOG_TO_Q31 >= LVL_Log2((UWord32)level))
+              && (sum_post / FB_BINS > NR_VOX_SNR);
+
+    /* Decision-directed a-priori SNR and Wiener gain */
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word32 gamma = (Word32)post[k] - nr->noise[k];
+        Word32 ml;
+        Word32 xi;
+        Word16 g;
+        Word16 floor_g;
+        Word32 v;
+
+        if (gamma < NR_LOG_MIN)
+            gamma = NR_LOG_MIN;
+        if (gamma > NR_LOG_MAX)
+            gamma = NR_LOG_MAX;
+        gamma = (Word32)LVL_Pow2(gamma - NR_LOG_MIN);
+
+        ml = (gamma > 256) ? (gamma - 256) : 0;
+        xi = Mpy_32_16(nr->prev_snr[k], NR_DD_ALPHA) + Mpy_32_16(ml, 32768 - NR_DD_ALPHA);
+        if (xi > NR_XI_MAX)
+            xi = NR_XI_MAX;
+
+        g = nr_wiener_gain(xi);
+        floor_g = nr_floor(cfg, nr->low_noise, k);
+        if (g < floor_g)
+            g = floor_g;
+        if (nr->scale != MAX_16)
+            g = sub(MAX_16, mult(nr->scale, sub(MAX_16, g)));
+
+        nr->xi[k] = xi;
+        nr->gain[k] = g;
+        nr->prev_snr[k] = Mpy_32_16(gamma, mult(g, g));
+
+        v = FB_GetBin(fb, spec, k);
+        FB_SetBin(fb, spec, k, pk_pack(mult_r(PK_LO(v), g), mult_r(PK_HI(v), g)));
+    }
+}
+
+/**
+ * @brief Freeze the noise estimate, e.g. while the VAD reports speech
+ */
+void NR_Hold(NR_State_t *nr, bool hold)
+{
+    nr->hold = hold;
+}
+
+/**
+ * @brief Scale the attenuation, e.g. by the scene program
+ */
+void NR_SetScale(NR_State_t *nr, Word16 scale)
+{
+    nr->scale = scale;
+}
+
+/**
+ * @brief Write flags, gains and SNRs to NC_Dump
+ */
+void NR_Dump(const NR_State_t *nr, SM_UPLOAD_DATA *upload)
+{
+    upload->NC_Dump[NR_DUMP_LOW_NOISE] = nr->low_noise;
+    upload->NC_Dump[NR_DUMP_VOX] = nr->vox;
+
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        /* Amplitude SNR sqrt(xi) in Q5, the scale the W_DBFS log in app.c expects */
+        Word32 y = ((LVL_Log2((UWord32)nr->xi[k]) - (8 << 8)) >> 1) + (5 << 8);
+
+        upload->NC_Dump[NR_DUMP_GAIN + k] = nr->gain[k];
+        upload->NC_Dump[NR_DUMP_SNR + k] = sat16((Word32)LVL_Pow2((y > 0) ? y : 0));
+    }
+}
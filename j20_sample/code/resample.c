@@ -0,0 +1,201 @@
+/**
+ * @file resample.c
+ * @brief Polyphase sample-rate converter for streamed sources
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "resample.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define SRC_FRAC_MASK               ((1u << SRC_FRAC_BITS) - 1)
+#define SRC_PHASE_SHIFT             (SRC_FRAC_BITS - 5)         /* log2(SRC_PHASES) */
+#define SRC_FIFO_MASK               (SRC_FIFO - 1)
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Modified Bessel function of the first kind, order 0
+ */
+static double src_bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (int k = 1; k < 32; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < 1e-12 * sum)
+            break;
+    }
+    return sum;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Design the filter for an input rate
+ */
+void SRC_Parser(uint32_t rate, SRC_Config_t *cfg)
+{
+    double ratio;
+    double fc;
+    double half;
+    double norm = src_bessel_i0(SRC_BETA);
+
+    if (rate < SRC_MIN_RATE)
+        rate = SRC_MIN_RATE;
+    if (rate > SRC_MAX_RATE)
+        rate = SRC_MAX_RATE;
+
+    ratio = (double)rate / SRC_OUT_RATE;
+    fc = SRC_CUTOFF * ((ratio > 1.0) ? 1.0 / ratio : 1.0);
+    half = ceil(SRC_ZEROS * ((ratio > 1.0) ? ratio : 1.0));
+    if (half > SRC_MAX_TAPS / 2)
+        half = SRC_MAX_TAPS / 2;
+
+    cfg->rate = rate;
+    cfg->step = (UWord32)lround(ratio * (1u << SRC_FRAC_BITS));
+    cfg->taps = 2 * (int)half;
+
+    /* Row p is the filter at fraction p / SRC_PHASES; row SRC_PHASES closes
+     * the interpolation of the last one */
+    memset(cfg->coef, 0, sizeof(cfg->coef));
+    for (int p = 0; p <= SRC_PHASES; p++)
+    {
+        for (int k = 0; k < cfg->taps; k++)
+        {
+            double t = (double)p / SRC_PHASES + half - 1 - k;
+            double u = t / half;
+            double h = fc;
+
+            if (fabs(u) >= 1.0)
+                continue;
+            if (t != 0.0)
+                h = sin(M_PI * fc * t) / (M_PI * t);
+            h *= src_bessel_i0(SRC_BETA * sqrt(1.0 - u * u)) / norm;
+            cfg->coef[p][k] = sat16(lround(32768.0 * h));
+        }
+    }
+}
+
+/**
+ * @brief Empty the FIFO and start on a configuration
+ */
+void SRC_Init(SRC_State_t *src, const SRC_Config_t *cfg)
+{
+    memset(src, 0, sizeof(*src));
+    src->cfg = cfg;
+    src->step = cfg->step;
+}
+
+/**
+ * @brief Queue input samples
+ */
+int SRC_Write(SRC_State_t *src, const Word32 *pcm, int n)
+{
+    int space = SRC_FIFO - SRC_Fill(src);
+
+    if (n > space)
+    {
+        src->overruns += n - space;
+        n = space;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t w = (src->wr + i) & SRC_FIFO_MASK;
+
+        src->fifo[w] = pcm[i];
+        src->fifo[w + SRC_FIFO] = pcm[i];
+    }
+    src->wr += n;
+    return n;
+}
+
+/**
+ * @brief Produce n output samples, zeros where the FIFO runs short
+ */
+void SRC_Read(SRC_State_t *src, Word32 *out, int n)
+{
+    const SRC_Config_t *cfg = src->cfg;
+    const int taps = cfg->taps;
+    Word32 err;
+    Word32 drift;
+    Word32 limit;
+
+    if (!src->primed && SRC_Fill(src) >= SRC_FIFO / 2)
+    {
+        src->primed = true;
+        src->fill = (SRC_FIFO / 2) << 8;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        const Word32 *x = &src->fifo[src->rd & SRC_FIFO_MASK];
+        const Word16 *c0;
+        const Word16 *c1;
+        int64_t a0 = 0;
+        int64_t a1 = 0;
+        int64_t y;
+
+        if (!src->primed || SRC_Fill(src) < taps)
+        {
+            src->underruns += src->primed;
+            src->primed = false;
+            out[i] = 0;
+            continue;
+        }
+
+        c0 = cfg->coef[src->frac >> SRC_PHASE_SHIFT];
+        c1 = c0 + SRC_MAX_TAPS;
+        for (int k = 0; k < taps; k++)
+        {
+            a0 += (int64_t)x[k] * c0[k];
+            a1 += (int64_t)x[k] * c1[k];
+        }
+        a0 >>= 15;
+        a1 >>= 15;
+        y = a0 + (((a1 - a0) * (Word32)((src->frac >> (SRC_PHASE_SHIFT - 15)) & 0x7FFF)) >> 15);
+        out[i] = (Word32)((y > MAX_32) ? MAX_32 : ((y < MIN_32) ? MIN_32 : y));
+
+        src->frac += src->step;
+        src->rd += src->frac >> SRC_FRAC_BITS;
+        src->frac &= SRC_FRAC_MASK;
+    }
+
+    /* Steer the step by the fill: a fuller FIFO reads faster */
+    src->fill += ((SRC_Fill(src) << 8) - src->fill) >> SRC_FILL_SHIFT;
+    err = (src->fill >> 8) - SRC_FIFO / 2;
+    limit = (Word32)(cfg->step >> SRC_MAX_DRIFT);
+    drift = err * (Word32)(cfg->step >> SRC_DRIFT_SHIFT);
+    if (drift > limit)
+        drift = limit;
+    if (drift < -limit)
+        drift = -limit;
+    src->step = cfg->step + drift;
+}
+
+/**
+ * @brief Number of queued input samples
+ */
+int SRC_Fill(const SRC_State_t *src)
+{
+    return (int)(src->wr - src->rd);
+}
@@ -0,0 +1,183 @@
+/**
+ * @file scene.c
+ * @brief Acoustic scene classifier for automatic program switching
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "nr_wiener.h"
+#include "vad.h"
+#include "scene.h"
+#include "level.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define SCENE_PERIOD_MS             (1000.0 * SCENE_PERIOD * AUDIO_BLOCK_SIZE / AUDIO_SAMPLE_RATE)
+#define SCENE_SNR_ONE               32      /* unity amplitude SNR in NC_Dump, Q5 */
+#define SCENE_LOG_OFFSET            (31 << 8)   /* band powers down to -93 dBFS */
+
+/* ----------------------------------------------------------------------------
+ * Module Variable Definitions
+ * --------------------------------------------------------------------------*/
+
+const SCENE_Program_t scene_program[SCENE_NUM] =
+{
+    [SCENE_QUIET]           = { 23198, 32767 },     /* -3 dB, keep microphone noise down */
+    [SCENE_SPEECH]          = { 32767, 16384 },     /* full gain, light noise reduction */
+    [SCENE_SPEECH_IN_NOISE] = { 32767, 32767 },     /* full noise reduction */
+    [SCENE_NOISE]           = { 23198, 32767 },     /* -3 dB comfort */
+    [SCENE_MUSIC]           = { 32767, 0 }          /* no noise reduction on tones */
+};
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief One-pole smoothing of a feature
+ */
+static void scene_smooth(float *f, float x)
+{
+    *f += SCENE_SMOOTH * (x - *f);
+}
+
+/**
+ * @brief Fixed decision tree over the smoothed features
+ */
+static SCENE_t scene_decide(const SCENE_Features_t *f)
+{
+    if (f->level < SCENE_QUIET_DB || f->low_noise > SCENE_LOW_NOISE)
+        return SCENE_QUIET;
+    if (f->voice > SCENE_VOICE)
+        return (f->snr < SCENE_CLEAN_SNR) ? SCENE_SPEECH_IN_NOISE : SCENE_SPEECH;
+    return (f->fluct > SCENE_MUSIC_FLUCT) ? SCENE_MUSIC : SCENE_NOISE;
+}
+
+/**
+ * @brief Move one morphed value a step towards its target
+ */
+static Word16 scene_morph(Word16 cur, Word16 target, Word16 coef)
+{
+    Word16 step = mult_r(coef, sub(target, cur));
+
+    return (step != 0) ? add(cur, step) : target;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the level calibration and the morph time
+ */
+void SCENE_Parser(float maxdB, SCENE_Config_t *cfg)
+{
+    cfg->full_scale = (maxdB > 0.0f) ? maxdB : 120.0f;
+    cfg->morph = sat16(lround(32768.0 * (1.0 - exp(-SCENE_PERIOD_MS / SCENE_MORPH_MS))));
+}
+
+/**
+ * @brief Start in the quiet scene with its program applied
+ */
+void SCENE_Init(SCENE_State_t *scene, const SCENE_Config_t *cfg)
+{
+    memset(scene, 0, sizeof(*scene));
+    scene->cfg = *cfg;
+    scene->scene = SCENE_QUIET;
+    scene->candidate = SCENE_QUIET;
+    scene->active = scene_program[SCENE_QUIET];
+}
+
+/**
+ * @brief Apply a new configuration
+ */
+void SCENE_SetConfig(SCENE_State_t *scene, const SCENE_Config_t *cfg)
+{
+    scene->cfg = *cfg;
+}
+
+/**
+ * @brief Update the features from one UPLOAD snapshot and decide
+ */
+bool SCENE_Classify(SCENE_State_t *scene, const SM_UPLOAD_DATA *upload)
+{
+    SCENE_Features_t *f = &scene->feat;
+    const SCENE_Program_t *target;
+    uint64_t power = 0;
+    float snr = 0.0f;
+    float level;
+    bool voice;
+    SCENE_t c;
+
+    /* Band levels are dBFS in Q7; their powers add up to the broadband level */
+    for (int b = 0; b < 8; b++)
+    {
+        Word32 l = LVL_DbToLog2(2 * upload->RMS_dBSPL[b]) + SCENE_LOG_OFFSET;
+
+        if (l > 0)
+            power += LVL_Pow2(MIN(l, (32 << 8) - 1));
+    }
+    level = LVL_Log2ToDb(LVL_Log2_64(power) - SCENE_LOG_OFFSET) / 256.0f + scene->cfg.full_scale;
+
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        short v = upload->NC_Dump[NR_DUMP_SNR + k];
+
+        if (v > SCENE_SNR_ONE)
+            snr += (LVL_AmpDb((UWord32)v) - LVL_AmpDb(SCENE_SNR_ONE)) / 256.0f;
+    }
+    snr /= FB_BINS;
+
+    voice = (upload->NC_Dump[NR_DUMP_VOX] != 0) || (upload->MISC[VAD_DUMP_MISC] & VAD_SPEECH);
+
+    if (scene->decisions == 0)
+    {
+        f->level = level;
+        f->snr = snr;
+        scene->last_level = level;
+    }
+    scene->decisions++;
+
+    scene_smooth(&f->level, level);
+    scene_smooth(&f->fluct, fabsf(level - scene->last_level));
+    scene_smooth(&f->snr, snr);
+    scene_smooth(&f->voice, voice ? 1.0f : 0.0f);
+    scene_smooth(&f->low_noise, upload->NC_Dump[NR_DUMP_LOW_NOISE] ? 1.0f : 0.0f);
+    scene->last_level = level;
+
+    /* Hysteresis: the candidate must win SCENE_CONFIRM decisions in a row */
+    c = scene_decide(f);
+    if (c != scene->candidate)
+    {
+        scene->candidate = c;
+        scene->confirm = 0;
+    }
+    if (scene->confirm < SCENE_CONFIRM)
+        scene->confirm++;
+
+    target = &scene_program[scene->scene];
+    scene->active.gain = scene_morph(scene->active.gain, target->gain, scene->cfg.morph);
+    scene->active.ns = scene_morph(scene->active.ns, target->ns, scene->cfg.morph);
+
+    if (c != scene->scene && scene->confirm >= SCENE_CONFIRM)
+    {
+        scene->scene = c;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Publish the scene in UPLOAD.MISC
+ */
+void SCENE_Dump(const SCENE_State_t *scene, SM_UPLOAD_DATA *upload)
+{
+    upload->MISC[SCENE_DUMP_MISC] = (short)((scene->confirm << 8) | (scene->candidate << 4) | scene->scene);
+}
@@ -0,0 +1,264 @@
+/**
+ * @file tinnitus.c
+ * @brief Shaped-noise tinnitus masker
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "tinnitus.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define TM_Q30                      1073741824.0
+#define TM_INPUT_RMS                (1073741824.0 / 1.7320508075688772)  /* uniform over +/-2^30 */
+#define TM_FRAME_RATE               ((double)AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SIZE)
+#define TM_PINK_LOW                 60.0    /* Hz, first pole */
+#define TM_PINK_HIGH                12000.0 /* Hz, last zero */
+#define TM_PINK_PAIRS               4
+#define TM_PITCH_MIN                200.0
+#define TM_PITCH_MAX                (0.4 * AUDIO_SAMPLE_RATE)
+#define TM_WIDTH_MAX                40      /* 0.1 octave steps */
+#define TM_RESPONSE_POINTS          256
+#define TM_PHASOR                   32000
+#define TM_PHASOR_SQ_Q15            31250   /* TM_PHASOR^2 / 2^15 */
+#define TM_LFSR_SEED                0x2502A5A5u
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Store one section normalized by a0 in Q30
+ */
+static void tm_section(INT32 *c, double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    c[0] = (INT32)lround(TM_Q30 * b0 / a0);
+    c[1] = (INT32)lround(TM_Q30 * b1 / a0);
+    c[2] = (INT32)lround(TM_Q30 * b2 / a0);
+    c[3] = (INT32)lround(TM_Q30 * a1 / a0);
+    c[4] = (INT32)lround(TM_Q30 * a2 / a0);
+}
+
+/**
+ * @brief Two sections of pole/zero pairs, half a pair spacing apart
+ * @note  Each pair steps the gain down by half its spacing in dB, which
+ *        averages to -3 dB/octave. The gain is 1 at DC and falls from there.
+ */
+static void tm_pink(TM_Config_t *cfg)
+{
+    double r = pow(TM_PINK_HIGH / TM_PINK_LOW, 1.0 / (TM_PINK_PAIRS - 0.5));
+    double p[TM_PINK_PAIRS];
+    double z[TM_PINK_PAIRS];
+    double dc = 1.0;
+
+    for (int k = 0; k < TM_PINK_PAIRS; k++)
+    {
+        double f = TM_PINK_LOW * pow(r, k);
+
+        p[k] = exp(-2.0 * M_PI * f / AUDIO_SAMPLE_RATE);
+        z[k] = exp(-2.0 * M_PI * f * sqrt(r) / AUDIO_SAMPLE_RATE);
+        dc *= (1.0 - z[k]) / (1.0 - p[k]);
+    }
+
+    tm_section(cfg->bq[0], 1.0 / dc, -(z[0] + z[1]) / dc, z[0] * z[1] / dc,
+               1.0, -(p[0] + p[1]), p[0] * p[1]);
+    tm_section(cfg->bq[1], 1.0, -(z[2] + z[3]), z[2] * z[3], 1.0, -(p[2] + p[3]), p[2] * p[3]);
+    cfg->sections = 2;
+}
+
+/**
+ * @brief Mean power gain of the quantized sections over 0..fs/2
+ */
+static double tm_power(const TM_Config_t *cfg)
+{
+    double sum = 0.0;
+
+    for (int n = 0; n < TM_RESPONSE_POINTS; n++)
+    {
+        double w = M_PI * (n + 0.5) / TM_RESPONSE_POINTS;
+        double c1 = cos(w), s1 = -sin(w);
+        double c2 = cos(2.0 * w), s2 = -sin(2.0 * w);
+        double h = 1.0;
+
+        for (int k = 0; k < cfg->sections; k++)
+        {
+            const INT32 *c = cfg->bq[k];
+            double nr = c[0] + c[1] * c1 + c[2] * c2, ni = c[1] * s1 + c[2] * s2;
+            double dr = TM_Q30 + c[3] * c1 + c[4] * c2, di = c[3] * s1 + c[4] * s2;
+
+            h *= (nr * nr + ni * ni) / (dr * dr + di * di);
+        }
+        sum += h;
+    }
+
+    return sum / TM_RESPONSE_POINTS;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Design the colouring filter and gains for one preset
+ */
+bool TM_Parser(const uint8_t *preset, float maxdB, TM_Config_t *cfg)
+{
+    double pitch = preset[2] * 100.0;
+    double width = ((preset[3] == 0) ? 10 : ((preset[3] > TM_WIDTH_MAX) ? TM_WIDTH_MAX : preset[3])) * 0.1;
+    double dbfs = preset[1] - ((maxdB > 0.0f) ? maxdB : 120.0);
+    double w0;
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->color = preset[0];
+    if (cfg->color == TM_OFF)
+        return true;
+    if (cfg->color > TM_BAND || dbfs > TM_LEVEL_MAX_DB)
+        return false;
+    if ((cfg->color == TM_NOTCHED || cfg->color == TM_BAND) &&
+        (pitch < TM_PITCH_MIN || pitch > TM_PITCH_MAX))
+        return false;
+
+    if (cfg->color == TM_PINK || cfg->color == TM_NOTCHED)
+        tm_pink(cfg);
+
+    if (cfg->color == TM_NOTCHED)
+    {
+        double alpha;
+
+        w0 = 2.0 * M_PI * pitch / AUDIO_SAMPLE_RATE;
+        alpha = sin(w0) * sinh(0.5 * M_LN2 * width * w0 / sin(w0));
+        tm_section(cfg->bq[cfg->sections++], 1.0, -2.0 * cos(w0), 1.0, 1.0 + alpha, -2.0 * cos(w0), 1.0 - alpha);
+    }
+
+    /* Second-order Butterworth high-pass and low-pass at the band edges */
+    if (cfg->color == TM_BAND)
+    {
+        double lo = pitch * pow(2.0, -0.5 * width);
+        double hi = pitch * pow(2.0, 0.5 * width);
+
+        w0 = 2.0 * M_PI * lo / AUDIO_SAMPLE_RATE;
+        tm_section(cfg->bq[cfg->sections++], 0.5 * (1.0 + cos(w0)), -(1.0 + cos(w0)), 0.5 * (1.0 + cos(w0)),
+                   1.0 + M_SQRT1_2 * sin(w0), -2.0 * cos(w0), 1.0 - M_SQRT1_2 * sin(w0));
+        if (hi < 0.45 * AUDIO_SAMPLE_RATE)
+        {
+            w0 = 2.0 * M_PI * hi / AUDIO_SAMPLE_RATE;
+            tm_section(cfg->bq[cfg->sections++], 0.5 * (1.0 - cos(w0)), 1.0 - cos(w0), 0.5 * (1.0 - cos(w0)),
+                       1.0 + M_SQRT1_2 * sin(w0), -2.0 * cos(w0), 1.0 - M_SQRT1_2 * sin(w0));
+        }
+    }
+
+    cfg->gain = (Word32)lround((1 << TM_GAIN_Q) * M_SQRT1_2 * 2147483648.0 * pow(10.0, dbfs / 20.0) /
+                               (TM_INPUT_RMS * sqrt(tm_power(cfg))));
+    cfg->mix = (preset[6] == MIX_MIC) ? MIX_MIC : NO_MIX_MIC;
+
+    if (preset[4] != 0 && preset[5] != 0)
+    {
+        w0 = 2.0 * M_PI * preset[4] * 0.1 / TM_FRAME_RATE;
+        cfg->am_rot = pk_pack(sat16(lround(32767.0 * cos(w0))), sat16(lround(32767.0 * sin(w0))));
+        cfg->am_depth = sat16(lround(32767.0 * ((preset[5] > 100) ? 100 : preset[5]) / 100.0));
+    }
+    return true;
+}
+
+/**
+ * @brief Reset the masker to silent
+ */
+void TM_Init(TM_State_t *tm)
+{
+    memset(tm, 0, sizeof(*tm));
+    tm->lfsr = TM_LFSR_SEED;
+    tm->am_phasor = pk_pack(TM_PHASOR, 0);
+}
+
+/**
+ * @brief Apply a preset; a zero gain fades the masker out
+ * @note  A stop keeps the current filters until the fade has finished.
+ */
+void TM_SetConfig(TM_State_t *tm, const TM_Config_t *cfg)
+{
+    if (cfg->gain == 0)
+    {
+        tm->cfg.gain = 0;
+        return;
+    }
+
+    if (!tm->active || cfg->color != tm->cfg.color)
+    {
+        for (int k = 0; k < TM_SECTIONS; k++)
+            BQ_Reset(&tm->bq[k]);
+    }
+    tm->cfg = *cfg;
+    tm->active = true;
+}
+
+/**
+ * @brief Generate one block of noise into the output, if the masker is on
+ */
+void TM_Process(TM_State_t *tm, Word32 *block)
+{
+    const TM_Config_t *cfg = &tm->cfg;
+    Word32 noise[AUDIO_BLOCK_SIZE];
+    UWord32 s = tm->lfsr;
+    Word32 g = tm->frame_gain;
+    Word32 target;
+    Word32 step;
+
+    if (!tm->active)
+        return;
+
+    /* xorshift32: each step gives 32 new bits, one sample per half word */
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i += 2)
+    {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        noise[i] = (Word32)(s << 16) >> 1;
+        noise[i + 1] = (Word32)(s & 0xFFFF0000u) >> 1;
+    }
+    tm->lfsr = s;
+
+    for (int k = 0; k < cfg->sections; k++)
+        BQ_Process(cfg->bq[k], &tm->bq[k], noise, noise, AUDIO_BLOCK_SIZE);
+
+    step = (cfg->gain - tm->gain) >> TM_SMOOTH_SHIFT;
+    tm->gain = (step != 0) ? tm->gain + step : cfg->gain;
+    target = tm->gain;
+
+    /* Modulation: 1 - depth*(1 - cos)/2, from a phasor stepped once per frame */
+    if (cfg->am_depth != 0)
+    {
+        Word32 p = tm->am_phasor;
+        Word32 re = (pk_smusd(p, cfg->am_rot) + 0x4000) >> 15;
+        Word32 im = (pk_smuadx(p, cfg->am_rot) + 0x4000) >> 15;
+        Word32 n = (3 * 32768 - pk_smuad(pk_pack(re, im), pk_pack(re, im)) / TM_PHASOR_SQ_Q15) >> 1;
+
+        tm->am_phasor = pk_pack((re * n) >> 15, (im * n) >> 15);
+        target = Mpy_32_16(target, (Word16)(MAX_16 - (TM_PHASOR - re) * cfg->am_depth / (2 * TM_PHASOR)));
+    }
+
+    step = (target - g) / AUDIO_BLOCK_SIZE;
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        int64_t y;
+
+        g += step;
+        y = ((int64_t)noise[i] * g) >> TM_GAIN_Q;
+        y = (y > MAX_32) ? MAX_32 : ((y < MIN_32) ? MIN_32 : y);
+        block[i] = (cfg->mix == MIX_MIC) ? L_add(block[i], (Word32)y) : (Word32)y;
+    }
+    tm->frame_gain = target;
+
+    if (target == 0 && cfg->gain == 0)
+        tm->active = false;
+}
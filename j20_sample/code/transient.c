@@ -0,0 +1,168 @@
+/**
+ * @file transient.c
+ * @brief Transient and impulse noise suppressor
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "transient.h"
+#include "level.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define TR_LOG_FS                   (30 << 8)   /* full-scale peak one bit down */
+#define TR_LOG_PER_DB               (256.0 / 6.0206)
+#define TR_STEP_3DB                 128         /* 3 dB in log2 amplitude Q8 */
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the band split and the thresholds
+ */
+void TR_Parser(float maxdB, TR_Config_t *cfg)
+{
+    double full_scale = (maxdB > 0.0f) ? maxdB : 120.0;
+    const double split_hz[TR_BANDS - 1] = { TR_SPLIT_LO_HZ, TR_SPLIT_HI_HZ };
+
+    for (int b = 0; b < TR_BANDS - 1; b++)
+        cfg->split[b] = sat16(lround(32768.0 * (1.0 - exp(-2.0 * M_PI * split_hz[b] / AUDIO_SAMPLE_RATE))));
+    cfg->ratio = (Word32)lround(TR_RATIO_DB * TR_LOG_PER_DB);
+    cfg->max = (Word32)lround(TR_MAX_DB * TR_LOG_PER_DB);
+    cfg->floor = TR_LOG_FS + (Word32)lround((TR_FLOOR_DB - full_scale) * TR_LOG_PER_DB);
+}
+
+/**
+ * @brief Reset the envelopes, gains and counters and apply a configuration
+ */
+void TR_Init(TR_State_t *tr, const TR_Config_t *cfg)
+{
+    memset(tr, 0, sizeof(*tr));
+    tr->cfg = *cfg;
+    for (int b = 0; b < TR_BANDS; b++)
+        tr->gain[b] = MAX_16;
+}
+
+/**
+ * @brief Apply a new configuration
+ */
+void TR_SetConfig(TR_State_t *tr, const TR_Config_t *cfg)
+{
+    tr->cfg = *cfg;
+}
+
+/**
+ * @brief Suppress transients in one block in place, delaying it by TR_LOOKAHEAD
+ */
+void TR_Process(TR_State_t *tr, Word32 *block)
+{
+    const TR_Config_t *cfg = &tr->cfg;
+    Word32 depth = 0;
+
+    for (int s = 0; s < AUDIO_BLOCK_SIZE; s += TR_SUB)
+    {
+        Word32 d[TR_SUB][TR_BANDS];
+        Word16 g0[TR_BANDS];
+        Word16 step[TR_BANDS];
+
+        /* Split, follow the envelopes and swap through the look-ahead line */
+        for (int n = 0; n < TR_SUB; n++)
+        {
+            Word32 x = block[s + n] >> 1;
+            Word32 band[TR_BANDS];
+
+            tr->lp[0] += Mpy_32_16(x - tr->lp[0], cfg->split[0]);
+            tr->lp[1] += Mpy_32_16(x - tr->lp[1], cfg->split[1]);
+            band[0] = tr->lp[0];
+            band[1] = tr->lp[1] - tr->lp[0];
+            band[2] = x - tr->lp[1];
+
+            for (int b = 0; b < TR_BANDS; b++)
+            {
+                Word32 a = L_abs(band[b]);
+                Word32 f = tr->fast[b] - (tr->fast[b] >> TR_FAST_SHIFT);
+
+                tr->fast[b] = (a > f) ? a : f;
+                tr->slow[b] += (tr->fast[b] - tr->slow[b]) >> (tr->active[b] ? TR_HOLD_SHIFT : TR_SLOW_SHIFT);
+
+                d[n][b] = tr->line[b][tr->pos];
+                tr->line[b][tr->pos] = band[b];
+            }
+            tr->pos = (tr->pos + 1 < TR_LOOKAHEAD) ? tr->pos + 1 : 0;
+        }
+
+        /* Pull each band back to TR_RATIO_DB over its slow envelope */
+        for (int b = 0; b < TR_BANDS; b++)
+        {
+            Word32 lf = LVL_Log2((UWord32)tr->fast[b]);
+            Word32 red = lf - LVL_Log2((UWord32)tr->slow[b] + 1) - cfg->ratio;
+            bool hit = red > 0 && lf > cfg->floor;
+            Word16 g = tr->gain[b];
+            Word16 target = MAX_16;
+
+            if (hit)
+            {
+                if (red > cfg->max)
+                    red = cfg->max;
+                target = (Word16)MIN(LVL_Pow2((15 << 8) - red), (UWord32)MAX_16);
+                if (!tr->active[b])
+                    tr->events[b]++;
+            }
+            tr->active[b] = hit;
+
+            g0[b] = g;
+            g = (target < g) ? target : (Word16)(g + ((target - g) >> TR_REL_SHIFT));
+            tr->gain[b] = g;
+            step[b] = (Word16)((g - g0[b]) / TR_SUB);
+
+            if (g < MAX_16)
+            {
+                Word32 r = (15 << 8) - LVL_Log2((UWord32)g);
+
+                if (r > depth)
+                    depth = r;
+            }
+        }
+
+        /* Ramp to the new gains over the delayed samples and merge */
+        for (int n = 0; n < TR_SUB; n++)
+        {
+            Word32 y = 0;
+
+            for (int b = 0; b < TR_BANDS; b++)
+            {
+                Word16 g = (n == TR_SUB - 1) ? tr->gain[b] : (Word16)(g0[b] + step[b] * (n + 1));
+
+                y += Mpy_32_16(d[n][b], g);
+            }
+            block[s + n] = L_shl(y, 1);
+        }
+    }
+    tr->depth = depth;
+}
+
+/**
+ * @brief Publish the event counters and the reduction in UPLOAD.MISC
+ */
+void TR_Dump(const TR_State_t *tr, SM_UPLOAD_DATA *upload)
+{
+    UWord32 v = 0;
+    Word32 steps = tr->depth / TR_STEP_3DB;
+
+    for (int b = 0; b < TR_BANDS; b++)
+        v |= (tr->events[b] & 0xF) << (4 * b);
+    v |= (UWord32)MIN(steps, 15) << 12;
+    upload->MISC[TR_DUMP_MISC] = (short)v;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file vad.c
+ * @brief Voice and own-voice activity detector
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "vad.h"
+#include "level.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define VAD_LOG_FS_SINE             (45 << 8)   /* full-scale sine, (x >> 8)^2 mean */
+#define VAD_LOG_BLOCK               (5 << 8)    /* log2(AUDIO_BLOCK_SIZE) */
+#define VAD_FAST_SHIFT              3           /* 8 frames */
+#define VAD_SLOW_SHIFT              8           /* 256 frames */
+#define VAD_MOD_SHIFT               6
+#define VAD_TRIM_ATTACK             1638        /* 20 ms, Q15 */
+#define VAD_TRIM_RELEASE            164         /* 200 ms */
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Mean power of one block's energy sum, log2 Q8
+ */
+static Word32 vad_level(uint64_t e)
+{
+    return LVL_Log2_64(e) - VAD_LOG_BLOCK;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the band edges and the own-voice level
+ */
+void VAD_Parser(float maxdB, VAD_Config_t *cfg)
+{
+    double full_scale = (maxdB > 0.0f) ? maxdB : 120.0;
+
+    cfg->lo_coef = sat16(lround(32768.0 * (1.0 - exp(-2.0 * M_PI * VAD_LO_HZ / AUDIO_SAMPLE_RATE))));
+    cfg->hi_coef = sat16(lround(32768.0 * (1.0 - exp(-2.0 * M_PI * VAD_HI_HZ / AUDIO_SAMPLE_RATE))));
+    cfg->ov_level = VAD_LOG_FS_SINE + (Word32)lround((VAD_OV_LEVEL_DB - full_scale) * 256.0 / 3.0103);
+    cfg->ov_ild = 0;
+    cfg->ov_trim = sat16(lround(32768.0 * pow(10.0, -VAD_OV_REDUCE_DB / 20.0)));
+}
+
+/**
+ * @brief Reset the trackers and apply a configuration
+ */
+void VAD_Init(VAD_State_t *vad, const VAD_Config_t *cfg)
+{
+    memset(vad, 0, sizeof(*vad));
+    vad->cfg = *cfg;
+    vad->ov_trim = MAX_16;
+}
+
+/**
+ * @brief Apply a new configuration
+ */
+void VAD_SetConfig(VAD_State_t *vad, const VAD_Config_t *cfg)
+{
+    vad->cfg = *cfg;
+}
+
+/**
+ * @brief Update the decisions from one block
+ */
+void VAD_Process(VAD_State_t *vad, const Word32 *block, const Word32 *mic2)
+{
+    const VAD_Config_t *cfg = &vad->cfg;
+    Word32 lp_lo = vad->lp_lo;
+    Word32 lp_hi = vad->lp_hi;
+    uint64_t e = 0, e_lo = 0, e_hi = 0;
+    Word32 l, l4, d;
+    Word16 target, step;
+    bool speech, own;
+
+    /* Full band, below VAD_LO_HZ and above VAD_HI_HZ */
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        Word32 x = block[i] >> 8;
+        Word32 hp;
+
+        lp_lo += Mpy_32_16(x - lp_lo, cfg->lo_coef);
+        lp_hi += Mpy_32_16(x - lp_hi, cfg->hi_coef);
+        hp = x - lp_hi;
+
+        e += (uint64_t)((int64_t)x * x);
+        e_lo += (uint64_t)((int64_t)lp_lo * lp_lo);
+        e_hi += (uint64_t)((int64_t)hp * hp);
+    }
+    vad->lp_lo = lp_lo;
+    vad->lp_hi = lp_hi;
+
+    l = vad_level(e);
+    l4 = l << 4;
+    if (vad->frames == 0)
+    {
+        vad->floor = l4;
+        vad->fast = l4;
+        vad->slow = l4;
+    }
+    if (vad->frames < MAX_16)
+        vad->frames++;
+
+    /* Floor follows dips at once and rises slowly */
+    vad->floor = (l4 < vad->floor) ? l4 : (vad->floor + VAD_FLOOR_RISE);
+    vad->fast += (l4 - vad->fast) >> VAD_FAST_SHIFT;
+    vad->slow += (l4 - vad->slow) >> VAD_SLOW_SHIFT;
+    d = vad->fast - vad->slow;
+    vad->mod += (((d < 0) ? -d : d) - vad->mod) >> VAD_MOD_SHIFT;
+    vad->snr = (l4 - vad->floor) >> 4;
+
+    speech = (vad->snr > VAD_SNR_MIN) && ((vad->mod >> 4) > VAD_MOD_MIN);
+    own = speech && (l > cfg->ov_level) && (vad_level(e_lo) - vad_level(e_hi) > VAD_OV_TILT);
+
+    if (own && mic2 != NULL)
+    {
+        uint64_t e2 = 0;
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        {
+            Word32 x = mic2[i] >> 8;
+
+            e2 += (uint64_t)((int64_t)x * x);
+        }
+        d = l - vad_level(e2) - cfg->ov_ild;
+        own = (d < VAD_ILD_TOL) && (d > -VAD_ILD_TOL);
+    }
+
+    vad->speech_hang = speech ? VAD_HANG : ((vad->speech_hang > 0) ? vad->speech_hang - 1 : 0);
+    vad->own_hang = own ? VAD_HANG : ((vad->own_hang > 0) ? vad->own_hang - 1 : 0);
+    vad->flags = ((vad->speech_hang > 0) ? VAD_SPEECH : 0) | ((vad->own_hang > 0) ? VAD_OWN_VOICE : 0);
+
+    /* Own-voice trim: fast down, slow back up */
+    target = (vad->flags & VAD_OWN_VOICE) ? cfg->ov_trim : MAX_16;
+    step = mult_r((target < vad->ov_trim) ? VAD_TRIM_ATTACK : VAD_TRIM_RELEASE, sub(target, vad->ov_trim));
+    vad->ov_trim = (step != 0) ? add(vad->ov_trim, step) : target;
+}
+
+/**
+ * @brief Publish the flags and SNR in UPLOAD.MISC
+ */
+void VAD_Dump(const VAD_State_t *vad, SM_UPLOAD_DATA *upload)
+{
+    /* log2 power Q8 to dB: x 3.0103 / 256 */
+    Word32 db = (vad->snr * 771) >> 16;
+
+    if (db < 0)
+        db = 0;
+    if (db > 127)
+        db = 127;
+    upload->MISC[VAD_DUMP_MISC] = (short)((db << 8) | vad->flags);
+}
@@ -0,0 +1,172 @@
+/**
+ * @file wind.c
+ * @brief Wind noise detector driving a low-shelf in a PRE_BQ slot
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "basic_op.h"
+#include "wind.h"
+#include "level.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define WIND_LOG_FS_SINE            (45 << 8)   /* full-scale sine, (x >> 8)^2 mean */
+#define WIND_LOG_BLOCK              (5 << 8)    /* log2(AUDIO_BLOCK_SIZE) */
+#define WIND_LOG_PER_DB             (256.0 / 3.0103)
+#define WIND_SHIFT                  4           /* energy smoothing, 16 frames */
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the band edges and thresholds
+ */
+void WIND_Parser(WIND_Config_t *cfg)
+{
+    cfg->lo_coef = sat16(lround(32768.0 * (1.0 - exp(-2.0 * M_PI * WIND_LO_HZ / AUDIO_SAMPLE_RATE))));
+    cfg->hi_coef = sat16(lround(32768.0 * (1.0 - exp(-2.0 * M_PI * WIND_HI_HZ / AUDIO_SAMPLE_RATE))));
+    cfg->level = WIND_LOG_FS_SINE + (Word32)lround(WIND_LEVEL_DB * WIND_LOG_PER_DB);
+    cfg->slope = (Word32)lround(WIND_SLOPE_DB * WIND_LOG_PER_DB);
+    cfg->step = (Word32)lround(WIND_STEP_DB * WIND_LOG_PER_DB);
+    cfg->coh = (Word32)lround(256.0 * log2(WIND_COH * WIND_COH));
+}
+
+/**
+ * @brief Reset the detector and apply a configuration
+ */
+void WIND_Init(WIND_State_t *wind, const WIND_Config_t *cfg)
+{
+    memset(wind, 0, sizeof(*wind));
+    wind->cfg = *cfg;
+}
+
+/**
+ * @brief Update the decision from one input block
+ */
+void WIND_Process(WIND_State_t *wind, const Word32 *mic, const Word32 *mic2)
+{
+    const WIND_Config_t *cfg = &wind->cfg;
+    Word32 lp_lo = wind->lp_lo;
+    Word32 lp_hi = wind->lp_hi;
+    Word32 lo[AUDIO_BLOCK_SIZE];        /* low band, for the cross products */
+    uint64_t e_lo = 0, e_hi = 0;
+    bool wind_now;
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        Word32 x = mic[i] >> 8;
+        Word32 hp;
+
+        lp_lo += Mpy_32_16(x - lp_lo, cfg->lo_coef);
+        lp_hi += Mpy_32_16(x - lp_hi, cfg->hi_coef);
+        hp = x - lp_hi;
+        lo[i] = lp_lo;
+
+        e_lo += (uint64_t)((int64_t)lp_lo * lp_lo);
+        e_hi += (uint64_t)((int64_t)hp * hp);
+    }
+    wind->lp_lo = lp_lo;
+    wind->lp_hi = lp_hi;
+
+    /* A frame is shorter than a low-band period, so the sums are smoothed */
+    wind->xx += ((int64_t)(e_lo >> 8) - wind->xx) >> WIND_SHIFT;
+    wind->hh += ((int64_t)(e_hi >> 8) - wind->hh) >> WIND_SHIFT;
+    wind->l_lo = LVL_Log2_64((uint64_t)wind->xx) + (8 << 8) - WIND_LOG_BLOCK;
+    wind->l_hi = LVL_Log2_64((uint64_t)wind->hh) + (8 << 8) - WIND_LOG_BLOCK;
+    wind_now = (wind->l_lo > cfg->level) && (wind->l_lo - wind->l_hi > cfg->slope);
+
+    /* Second microphone: sound correlates at low frequencies, wind does not */
+    if (mic2 != NULL)
+    {
+        Word32 lp_lo2 = wind->lp_lo2;
+        int64_t yy = 0, xy = 0;
+        Word32 c;
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        {
+            lp_lo2 += Mpy_32_16((mic2[i] >> 8) - lp_lo2, cfg->lo_coef);
+            yy += ((int64_t)lp_lo2 * lp_lo2) >> 8;
+            xy += ((int64_t)lo[i] * lp_lo2) >> 8;
+        }
+        wind->lp_lo2 = lp_lo2;
+
+        wind->yy += (yy - wind->yy) >> WIND_SHIFT;
+        wind->xy += (xy - wind->xy) >> WIND_SHIFT;
+
+        /* rho^2 = xy^2 / (xx yy), compared in the log domain */
+        c = 2 * LVL_Log2_64((uint64_t)((wind->xy < 0) ? -wind->xy : wind->xy))
+            - LVL_Log2_64((uint64_t)wind->xx) - LVL_Log2_64((uint64_t)wind->yy);
+        if (wind->xy > 0 && c > cfg->coh)
+            wind_now = false;
+    }
+
+    wind->run = wind_now ? (wind->run + 1) : 0;
+    if (wind->run >= WIND_ATTACK)
+        wind->hang = WIND_HANG;
+    else if (wind->hang > 0)
+        wind->hang--;
+
+    if (wind->hang > 0)
+    {
+        int t = 1 + (wind->l_lo - cfg->level) / cfg->step;
+
+        wind->flags |= WIND_DETECT;
+        /* Grow at once, shrink only when the wind is gone */
+        if (wind_now && t > wind->target)
+            wind->target = (t > WIND_STEPS) ? WIND_STEPS : t;
+    }
+    else
+    {
+        wind->flags &= ~WIND_DETECT;
+        wind->target = 0;
+    }
+}
+
+/**
+ * @brief Design the PRE_BQ low shelf for an attenuation step
+ * @note  RBJ low shelf, slope 1.
+ */
+void WIND_Shelf(int step, double sos[6])
+{
+    double A = pow(10.0, -WIND_STEP_DB * step / 40.0);
+    double w = 2.0 * M_PI * WIND_SHELF_HZ / AUDIO_SAMPLE_RATE;
+    double c = cos(w);
+    double alpha = sin(w) / 2.0 * sqrt(2.0);
+    double sa = 2.0 * sqrt(A) * alpha;
+    double a0 = (A + 1.0) + (A - 1.0) * c + sa;
+
+    sos[0] = A * ((A + 1.0) - (A - 1.0) * c + sa) / a0;
+    sos[1] = 2.0 * A * ((A - 1.0) - (A + 1.0) * c) / a0;
+    sos[2] = A * ((A + 1.0) - (A - 1.0) * c - sa) / a0;
+    sos[3] = 1.0;
+    sos[4] = -2.0 * ((A - 1.0) + (A + 1.0) * c) / a0;
+    sos[5] = ((A + 1.0) + (A - 1.0) * c - sa) / a0;
+}
+
+/**
+ * @brief Publish the state in UPLOAD.MISC
+ */
+void WIND_Dump(const WIND_State_t *wind, SM_UPLOAD_DATA *upload)
+{
+    /* log2 power Q8 to dB: x 3.0103 / 256 */
+    Word32 db = ((wind->l_lo - wind->l_hi) * 771) >> 16;
+
+    if (db < 0)
+        db = 0;
+    if (db > 127)
+        db = 127;
+    upload->MISC[WIND_DUMP_MISC] = (short)((db << 8) | (wind->target << 4) | wind->flags |
+                                           (wind->no_slot ? WIND_NO_SLOT : 0));
+}
@@ -0,0 +1,249 @@
+/**
+ * @file xover.c
+ * @brief Power-complementary crossover filterbank for 4..16 WDRC bands
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include "basic_op.h"
+#include "xover.h"
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define XO_Q30                      1073741824.0
+#define XO_FREQ_MAX                 (0.45 * AUDIO_SAMPLE_RATE)
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief c * v for a Q30 coefficient
+ */
+static inline Word32 xo_mpy(Word32 c, Word32 v)
+{
+    return (Word32)(((int64_t)c * v) >> 30);
+}
+
+/**
+ * @brief First-order allpass (a + z^-1)/(1 + a z^-1) over one block
+ * @note  s[0] is the last input, s[1] the last output.
+ */
+static void xo_allpass1(Word32 a, Word32 *s, const Word32 *in, Word32 *out)
+{
+    Word32 x1 = s[0];
+    Word32 y1 = s[1];
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        Word32 x = in[i];
+
+        y1 = xo_mpy(a, x - y1) + x1;
+        x1 = x;
+        out[i] = y1;
+    }
+
+    s[0] = x1;
+    s[1] = y1;
+}
+
+/**
+ * @brief Second-order allpass (d2 + d1 z^-1 + z^-2)/(1 + d1 z^-1 + d2 z^-2)
+ * @note  s[] holds x1, x2, y1, y2.
+ */
+static void xo_allpass2(Word32 d1, Word32 d2, Word32 *s, const Word32 *in, Word32 *out)
+{
+    Word32 x1 = s[0];
+    Word32 x2 = s[1];
+    Word32 y1 = s[2];
+    Word32 y2 = s[3];
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    {
+        Word32 x = in[i];
+        Word32 y = xo_mpy(d2, x - y2) + xo_mpy(d1, x1 - y1) + x2;
+
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        out[i] = y;
+    }
+
+    s[0] = x1;
+    s[1] = x2;
+    s[2] = y1;
+    s[3] = y2;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Design the crossovers for BandNum bands from CrossOverFreq
+ */
+void XO_Parser(const MCU_Config_WDRC *Cfg, XO_Config_t *xo)
+{
+    int bands = Cfg->BandNum;
+    double freq[XO_MAX_BANDS - 1];
+    bool valid = true;
+
+    if (bands < XO_MIN_BANDS)
+        bands = XO_MIN_BANDS;
+    if (bands > XO_MAX_BANDS)
+        bands = XO_MAX_BANDS;
+
+    for (int k = 0; k < bands - 1; k++)
+    {
+        freq[k] = Cfg->CrossOverFreq[k];
+        if (freq[k] <= 0.0 || freq[k] > XO_FREQ_MAX || (k > 0 && freq[k] <= freq[k - 1]))
+            valid = false;
+    }
+
+    if (!valid)
+    {
+        for (int k = 0; k < bands - 1; k++)
+            freq[k] = XO_FREQ_LOW * pow(XO_FREQ_HIGH / XO_FREQ_LOW, (double)k / (bands - 2));
+    }
+
+    /* Third-order Butterworth by the bilinear transform: the real pole goes
+     * to A0, the complex pair to A1 */
+    for (int k = 0; k < bands - 1; k++)
+    {
+        double K = tan(M_PI * freq[k] / AUDIO_SAMPLE_RATE);
+        double re = 1.0 - 0.5 * K;                  /* 1 + K*s, s = -1/2 + j*sqrt(3)/2 */
+        double im = 0.5 * sqrt(3.0) * K;
+        double den = (1.0 + 0.5 * K) * (1.0 + 0.5 * K) + im * im;  /* |1 - K*s|^2 */
+
+        xo->a0[k] = (Word32)lround(-XO_Q30 * (1.0 - K) / (1.0 + K));
+        xo->d1[k] = (Word32)lround(-2.0 * XO_Q30 * (re * (1.0 + 0.5 * K) - im * im) / den);
+        xo->d2[k] = (Word32)lround(XO_Q30 * (re * re + im * im) / den);
+    }
+
+    for (int b = 0; b < bands; b++)
+    {
+        double g = Cfg->tkgain[b];
+
+        if (g < 0.0)
+            g = 0.0;
+        if (g > XO_GAIN_MAX_DB)
+            g = XO_GAIN_MAX_DB;
+        xo->gain[b] = (Word32)lround(65536.0 * pow(10.0, g / 20.0));
+    }
+
+    xo->bands = bands;
+}
+
+/**
+ * @brief Clear the filter states and apply a configuration
+ */
+void XO_Init(XO_State_t *xo, const XO_Config_t *cfg)
+{
+    memset(xo, 0, sizeof(*xo));
+    xo->cfg = *cfg;
+    xo->trim = MAX_16;
+}
+
+/**
+ * @brief Apply a new configuration; the states restart if the band count changes
+ * @note  Call with the DSP interrupt masked.
+ */
+void XO_SetConfig(XO_State_t *xo, const XO_Config_t *cfg)
+{
+    if (cfg->bands != xo->cfg.bands)
+        memset(xo->sec, 0, sizeof(xo->sec));
+    xo->cfg = *cfg;
+}
+
+/**
+ * @brief Scale all band gains, e.g. down during own voice
+ */
+void XO_SetTrim(XO_State_t *xo, Word16 trim)
+{
+    xo->trim = trim;
+}
+
+/**
+ * @brief Split one block into cfg.bands bands, low to high
+ */
+void XO_Split(XO_State_t *xo, const Word32 *in, Word32 band[][AUDIO_BLOCK_SIZE])
+{
+    const XO_Config_t *cfg = &xo->cfg;
+    const int last = cfg->bands - 1;
+    Word32 *rest = band[last];
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        rest[i] = in[i] >> XO_HEADROOM;
+
+    /* Crossover k leaves LP in band k and carries HP on in the last band */
+    for (int k = 0; k < last; k++)
+    {
+        Word32 *lo = band[k];
+        Word32 a1[AUDIO_BLOCK_SIZE];
+
+        xo_allpass1(cfg->a0[k], xo->sec[k].a0, rest, lo);
+        xo_allpass2(cfg->d1[k], cfg->d2[k], xo->sec[k].a1, rest, a1);
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        {
+            Word32 p = lo[i] >> 1;
+            Word32 q = a1[i] >> 1;
+
+            lo[i] = p + q;
+            rest[i] = p - q;
+        }
+    }
+}
+
+/**
+ * @brief Scale each band by its gain, one multiply per band per sample
+ * @note  The split headroom leaves room for about 18 dB of gain on a
+ *        full-scale band; beyond that the band saturates.
+ */
+void XO_Gain(const XO_State_t *xo, Word32 band[][AUDIO_BLOCK_SIZE])
+{
+    for (int b = 0; b < xo->cfg.bands; b++)
+    {
+        const Word32 g = Mpy_32_16(xo->cfg.gain[b], xo->trim);
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        {
+            int64_t y = ((int64_t)band[b][i] * g) >> 16;
+
+            band[b][i] = (y > MAX_32) ? MAX_32 : ((y < MIN_32) ? MIN_32 : (Word32)y);
+        }
+    }
+}
+
+/**
+ * @brief Sum the bands back into one block; the bands are used as scratch
+ */
+void XO_Merge(XO_State_t *xo, Word32 band[][AUDIO_BLOCK_SIZE], Word32 *out)
+{
+    const XO_Config_t *cfg = &xo->cfg;
+    const int last = cfg->bands - 1;
+    Word32 *acc = band[0];
+
+    /* Band k needs the A0 of every crossover above its own */
+    for (int k = 1; k < last; k++)
+    {
+        xo_allpass1(cfg->a0[k], xo->sec[k].comp, acc, acc);
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+            acc[i] = L_add(acc[i], band[k][i]);
+    }
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        out[i] = L_shl(L_add(acc[i], band[last][i]), XO_HEADROOM);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file afc_fdaf.h
+ * @brief Subband frequency-domain adaptive feedback canceller (Pre-FDAF)
+ *
+ * Works on the shared filterbank spectrum: the microphone spectrum comes
+ * from the pipeline analysis that also feeds NR, only the loudspeaker
+ * reference gets an analysis of its own. Each bin has FDAF_TAPS complex
+ * taps across consecutive reference frames. Configured from SM_CONFIG_FBC:
+ *   - Pre_Adaptive_Filter      on/off
+ *   - Pre_Delay                reference delay in samples, 0..63
+ *   - Normalized_Adapt_Speed   per band step 2^-(speed + FDAF_MU_SHIFT), 0 fastest
+ *   - Idle_Speed               step used while a bin's reference is below the bias
+ *   - Power_NormalizationBias  normalization floor, 6 dB steps below full scale
+ *   - LeakNorm                 tap leakage per frame, 0 = none, 15 = fastest
+ * Bin k (1..32) uses band k-1; DC uses band 0.
+ */
+
+#ifndef INCLUDE_AFC_FDAF_H_
+#define INCLUDE_AFC_FDAF_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include "osj20.h"
+#include "filterbank.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define FDAF_TAPS                   3
+#define FDAF_MAX_DELAY              64
+#define FDAF_MU_SHIFT               3
+#define FDAF_SPEED_MAX              15
+
+typedef struct
+{
+    const SM_CONFIG_FBC *cfg;
+    FB_State_t ref_fb;                  /* reference analysis */
+    Word32 ref_delay[FDAF_MAX_DELAY + FB_HOP];
+
+    Word32 x[FDAF_TAPS][FB_BINS];       /* reference bins, newest frame first, packed Q15 */
+    int x_exp[FDAF_TAPS];
+    Word32 w_re[FDAF_TAPS][FB_BINS];    /* taps, Q24 */
+    Word32 w_im[FDAF_TAPS][FB_BINS];
+    Word32 power[FB_BINS];              /* smoothed reference log2 power, Q8 */
+} FDAF_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Reset the canceller and bind the parameter block
+ */
+void FDAF_Init(FDAF_State_t *fdaf, const SM_CONFIG_FBC *cfg);
+
+/**
+ * @brief Subtract the feedback estimate from the microphone spectrum and adapt
+ */
+void FDAF_Process(FDAF_State_t *fdaf, const FB_State_t *fb, FB_Spectrum_t *spec);
+
+/**
+ * @brief Analyze the block sent to the loudspeaker for the next frame
+ */
+void FDAF_Reference(FDAF_State_t *fdaf, const Word32 *out);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_AFC_FDAF_H_ */
@@ -0,0 +1,108 @@
+/**
+ * @file afc_nlms.h
+ * @brief Time-domain partitioned block-NLMS feedback canceller
+ *
+ * Open counterpart of the DSP library time-domain FBC, configured from the
+ * same SM_CONFIG_FBC block:
+ *   - EcTaps            adaptive filter length
+ *   - MuDivNumTaps      step size mu/L, Q15
+ *   - DerivedQshift     coefficient headroom from the reference-to-echo ratio;
+ *                       coefficients are held in Q(15 + DerivedQshift)
+ *   - ConvergenceSpeed  extra right shift of every update (slowdown)
+ *   - Hp_BQs/Lp_BQs     crossover; when both are set only the high band is
+ *                       cancelled and the low band passes straight through
+ *
+ * Each frame filters the whole block but updates only one of
+ * AFC_PARTITIONS tap partitions, using the block-averaged gradient. An
+ * optional prediction-error prefilter, estimated from the error signal,
+ * whitens both adaptation inputs to reduce the bias from tonal input.
+ */
+
+#ifndef INCLUDE_AFC_NLMS_H_
+#define INCLUDE_AFC_NLMS_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osj20.h"
+#include "biquad.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AFC_BLOCK                   AUDIO_BLOCK_SIZE
+#define AFC_MAX_TAPS                64
+#define AFC_MAX_DELAY               (2*AFC_BLOCK)
+#define AFC_PARTITIONS              4
+#define AFC_PEM_MAX_ORDER           4
+
+/* Reference history: newest loudspeaker sample last */
+#define AFC_HIST                    (AFC_MAX_TAPS + AFC_MAX_DELAY + AFC_BLOCK)
+
+typedef struct
+{
+    const SM_CONFIG_FBC *cfg;
+    int taps;                           /* even, <= AFC_MAX_TAPS */
+    int delay;                          /* bulk delay, AFC_BLOCK..AFC_MAX_DELAY */
+    int qshift;
+    int part;                           /* partition updated next frame */
+    int pem_order;                      /* 0 = no prefilter */
+    bool split;                         /* crossover configured */
+
+    Word32 w[AFC_MAX_TAPS];             /* master taps, Q(31 + qshift) */
+    Word16 wr[AFC_MAX_TAPS];            /* filtering copy, reversed, Q(15 + qshift) */
+    Word16 x[AFC_HIST];                 /* loudspeaker reference */
+    Word16 xw[AFC_HIST];                /* prefiltered reference */
+    int64_t ref_energy;                 /* smoothed block energy of xw */
+
+    Word16 a[AFC_PEM_MAX_ORDER];        /* prefilter A(z) - 1, Q12 */
+    int64_t corr[AFC_PEM_MAX_ORDER + 1];
+    Word16 e_hist[AFC_PEM_MAX_ORDER];   /* last error samples, newest first */
+
+    BQ_State_t hp_mic;
+    BQ_State_t lp_mic;
+    BQ_State_t hp_ref;
+} AFC_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Reset the canceller
+ * @param delay      loudspeaker-to-microphone bulk delay in samples
+ * @param pem_order  prediction-error prefilter order, 0..AFC_PEM_MAX_ORDER
+ */
+bool AFC_Init(AFC_State_t *afc, const SM_CONFIG_FBC *cfg, int delay, int pem_order);
+
+/**
+ * @brief Cancel the feedback estimate from one microphone block, in place
+ */
+void AFC_Process(AFC_State_t *afc, Word32 *block);
+
+/**
+ * @brief Append the block sent to the loudspeaker to the reference history
+ */
+void AFC_Reference(AFC_State_t *afc, const Word32 *out);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_AFC_NLMS_H_ */
@@ -0,0 +1,81 @@
+/**
+ * @file agc.h
+ * @brief Table-driven broadband AGC for the CM33 stages
+ *
+ * A peak envelope follower feeds an integer log2 (count leading zeros plus
+ * one mantissa bit), which indexes the 65-point SM_CONFIG_AGC.drc_Table at
+ * envelopes 2^k and 1.5*2^k; the remaining mantissa bits interpolate between
+ * neighbouring points. The runtime has no transcendental math; the curve is
+ * compiled on the MCU from MCU_Config_AGC:
+ *   - dB_gain      small-signal gain, 0..AGC_GAIN_MAX_DB
+ *   - dB_peak      output peak line in dBFS; the output is compressed from
+ *                  AGC_KNEE_DB below it so that a full-scale input lands on
+ *                  it, and clipped to it as a last resort
+ * SM_CONFIG_AGC fields as written by AGC_Parser():
+ *   - point        AGC_TABLE_POINTS once compiled, 0 leaves the stage in bypass
+ *   - drcgaininv   not used by the CM33 stage, left 0
+ *   - drcpeakline  peak line as a Word32 amplitude
+ *   - drc_Table[j] gain at envelope 2^(j/2), times 1.5 for odd j, Q16
+ */
+
+#ifndef INCLUDE_AGC_H_
+#define INCLUDE_AGC_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AGC_TABLE_POINTS            65
+#define AGC_GAIN_MAX_DB             40.0
+#define AGC_KNEE_DB                 10.0
+#define AGC_RELEASE_SHIFT           12      /* envelope release 2^12 samples, 131 ms */
+
+typedef struct
+{
+    const SM_CONFIG_AGC *cfg;
+    UWord32 env;                        /* peak envelope, Word32 amplitude */
+} AGC_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile dB_gain/dB_peak into the interpolated gain table
+ * @note  Runs on the MCU in floating point.
+ */
+void AGC_Parser(const MCU_Config_AGC *Cfg, SM_CONFIG_AGC *AGC_Cfg);
+
+/**
+ * @brief Reset the envelope and bind the parameter block
+ */
+void AGC_Init(AGC_State_t *agc, const SM_CONFIG_AGC *cfg);
+
+/**
+ * @brief Apply the table gain to one block in place
+ */
+void AGC_Process(AGC_State_t *agc, Word32 *block);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_AGC_H_ */
@@ -0,0 +1,181 @@
+/**
+ * @file ai_ns.h
+ * @brief GRU mask estimator for speech enhancement on the shared filterbank
+ *
+ * Open engine for the "AI speech enhancement" behind SM_CONFIG_AI_NS. Each
+ * frame the log2 powers of filterbank bins 1..32 are normalized per band and
+ * fed to a single GRU layer (AINS_HIDDEN units); a dense layer with sigmoid
+ * output then gives one suppression mask per band. Bin 0 follows band 0.
+ * MCU_Config_AI_NS shapes how the mask is applied:
+ *   - NS_LEVEL     mask strength, 0 = off .. 1 = full (valptr[93] / 10)
+ *   - ATTACK       gain smoothing when the gain falls, ms
+ *   - RELEASE      gain smoothing when the gain rises, ms
+ * The mask never attenuates below AINS_MASK_FLOOR.
+ *
+ * The model is a const AINS_Model_t in MRAM, read once by AINS_Load(): the
+ * dimensions are checked against this build, and the matrices are packed
+ * into the state's arena (sized here at build time) for the dual-MAC
+ * kernels. The default ains_model symbol is weak and empty, so until a
+ * trained model is linked the stage reports itself unloaded and passes
+ * the spectrum through.
+ *
+ * With AINS_REFERENCE set, AINS_Reference() runs the arena copy against the
+ * natural-order MRAM copy through the scalar kernels and counts any frame
+ * where the two differ; AINS_MACS gives the multiply-adds per frame.
+ */
+
+#ifndef INCLUDE_AI_NS_H_
+#define INCLUDE_AI_NS_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osj20.h"
+#include "filterbank.h"
+#include "nnq.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#ifndef AINS_REFERENCE
+#define AINS_REFERENCE              0
+#endif
+
+#define AINS_BANDS                  (FB_BINS - 1)
+#define AINS_HIDDEN                 24
+#define AINS_GATES                  (3 * AINS_HIDDEN)
+
+#define AINS_MODEL_MAGIC            0x534E4941u     /* "AINS" */
+#define AINS_MODEL_VERSION          1
+
+#define AINS_MASK_FLOOR             3277    /* -20 dB, Q15 */
+#define AINS_ATTACK_MS              5.0
+#define AINS_RELEASE_MS             50.0
+
+#define AINS_MACS                   (AINS_GATES * AINS_BANDS + AINS_GATES * AINS_HIDDEN + \
+                                     AINS_BANDS * AINS_HIDDEN)
+
+/* Packed weights and biases plus the per-frame scratch */
+#define AINS_ARENA_SIZE             (NNQ_ALIGNED(AINS_GATES * AINS_BANDS) +          \
+                                     NNQ_ALIGNED(AINS_GATES * AINS_HIDDEN) +         \
+                                     NNQ_ALIGNED(AINS_BANDS * AINS_HIDDEN) +         \
+                                     4 * (4 * AINS_GATES + 2 * AINS_BANDS) +         \
+                                     NNQ_ALIGNED(2 * AINS_BANDS) +                   \
+                                     NNQ_ALIGNED(2 * AINS_HIDDEN))
+
+/* Model image as stored in MRAM; matrices are row-major int8 */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t bands;
+    uint16_t hidden;
+    int16_t gru_shift;                  /* GRU weight scale, value = w * 2^-shift */
+    int16_t out_shift;
+    int16_t reserved;
+    Word16 in_mean[AINS_BANDS];         /* log2 band power, Q8 */
+    Word16 in_scale[AINS_BANDS];        /* Q15 */
+    Word32 gru_bi[AINS_GATES];          /* Q(NNQ_Q + gru_shift) */
+    Word32 gru_bh[AINS_GATES];
+    Word32 out_b[AINS_BANDS];           /* Q(NNQ_Q + out_shift) */
+    int8_t gru_wi[AINS_GATES * AINS_BANDS];
+    int8_t gru_wh[AINS_GATES * AINS_HIDDEN];
+    int8_t out_w[AINS_BANDS * AINS_HIDDEN];
+} AINS_Model_t;
+
+/* Fixed-point parameters compiled from MCU_Config_AI_NS */
+typedef struct
+{
+    Word16 strength;                    /* Q15 */
+    Word16 attack;                      /* smoothing coefficients, Q15 */
+    Word16 release;
+} AINS_Config_t;
+
+typedef struct
+{
+    AINS_Config_t cfg;
+    bool loaded;
+    const AINS_Model_t *model;
+    NNQ_Arena_t arena;
+    UWord32 arena_buf[AINS_ARENA_SIZE / 4];
+    NNQ_GRU_t gru;
+    NNQ_Mat_t out;
+    Word32 *acc_out;
+    Word16 *x;                          /* features, Q12 */
+    Word16 *h;                          /* GRU state, Q12 */
+    Word16 mask[AINS_BANDS];            /* Q15 */
+    Word16 gain[FB_BINS];               /* applied gain, Q15 */
+    Word16 scale;                       /* strength scale, Q15, see AINS_SetScale() */
+} AINS_State_t;
+
+/* Trained model; the weak default is empty */
+extern const AINS_Model_t ains_model;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile NS_LEVEL, ATTACK and RELEASE
+ * @note  Runs on the MCU in floating point.
+ */
+void AINS_Parser(const MCU_Config_AI_NS *Cfg, AINS_Config_t *cfg);
+
+/**
+ * @brief Reset the gains to unity and apply a configuration
+ */
+void AINS_Init(AINS_State_t *ains, const AINS_Config_t *cfg);
+
+/**
+ * @brief Check a model against this build and pack it into the arena
+ * @return false if the model is missing or does not match
+ */
+bool AINS_Load(AINS_State_t *ains, const AINS_Model_t *model);
+
+/**
+ * @brief Apply a new configuration
+ * @note  Call with the DSP interrupt masked.
+ */
+void AINS_SetConfig(AINS_State_t *ains, const AINS_Config_t *cfg);
+
+/**
+ * @brief Scale the fitted strength, e.g. by the scene program
+ */
+void AINS_SetScale(AINS_State_t *ains, Word16 scale);
+
+/**
+ * @brief Estimate the mask from one spectrum and apply it in place
+ */
+void AINS_Process(AINS_State_t *ains, const FB_State_t *fb, FB_Spectrum_t *spec);
+
+#if AINS_REFERENCE
+/**
+ * @brief Run frames of pseudo-random features through the packed and the
+ *        reference network side by side
+ * @return Number of frames whose masks or states differ
+ * @note  Uses the loaded state's scratch; run with the stage disabled.
+ */
+int AINS_Reference(AINS_State_t *ains, int frames);
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_AI_NS_H_ */
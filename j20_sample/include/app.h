@@ -50,6 +50,31 @@ extern "C"
 //48M 运行，如果是0,为16M
 #define	APP_CPU_AT_FULL_SPEED			1
 
+/* Staged boot: the audio path is loaded and started before the BLE stack and
+ * the deferred DSP regions. First audio is due this long after main(). */
+#define APP_BOOT_AUDIO_TARGET_US        100000
+
+/* Flag that drives a GPIO high from main() until first audio, so a scope
+ * triggered on the reset line measures the whole time to first audio,
+ * including the ROM and startup code app_boot_us cannot see */
+#define APP_BOOT_GPIO_ENABLED           0
+#if APP_BOOT_GPIO_ENABLED
+    /* The GPIO that is used for timing the boot */
+    #define APP_BOOT_GPIO               1
+#endif /* APP_BOOT_GPIO_ENABLED */
+
+typedef enum
+{
+    APP_BOOT_MAIN = 0,              /* main() entered, cycle counter started */
+    APP_BOOT_DEVICE = 1,            /* clocks, trims and trace up */
+    APP_BOOT_DSP = 2,               /* audio path configured, DSP loaded without the deferred regions */
+    APP_BOOT_AUDIO_START = 3,       /* DMIC running */
+    APP_BOOT_AUDIO_OUT = 4,         /* OD output started: first audio */
+    APP_BOOT_BLE = 5,               /* BLE stack and services configured */
+    APP_BOOT_DSP_FULL = 6,          /* every deferred region loaded from the main loop */
+    APP_BOOT_NUM
+} APP_Boot_t;
+
 /* ----------------------------------------------------------------------------
  * Globals
  * --------------------------------------------------------------------------*/
@@ -60,11 +85,17 @@ extern uint32_t asrc_update_error_count;
 extern uint32_t pcm_underrun_count;
 extern uint32_t pcm_overrun_count;
 
+/* Codec output limiter events, counted in AUDIO_IRQHandler */
+extern uint32_t limit_errcnt;
+
 /* State Machine flags */
 extern uint8_t asrc_update_flag;
 
 extern volatile uint16_t app_audio_int;
 
+/* Time of each boot stage in us since main(), 0 until it is reached */
+extern uint32_t app_boot_us[APP_BOOT_NUM];
+
 /* ---------------------------------------------------------------------------
  * Function prototype definitions
  * --------------------------------------------------------------------------*/
@@ -89,6 +120,22 @@ void APP_ClearDMAChannels(void);
  */
 void APP_DisableAudioPath(void);
 
+/**
+ * @brief Record that a boot stage was reached; safe from interrupts
+ * @note  APP_BOOT_MAIN starts the clock. Each interval is converted at the
+ *        core clock in use when it ends, and the startup code before main()
+ *        is not counted.
+ */
+void APP_Boot_Stamp(APP_Boot_t stage);
+
+/**
+ * @brief Print the time to first audio once it is stamped, and the boot
+ *        stages once every stage is
+ * @note  Call from the main loop; each prints once. Nothing is printed before
+ *        first audio, so the trace UART does not delay the audio path.
+ */
+void APP_Boot_Report(void);
+
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
  * ------------------------------------------------------------------------- */
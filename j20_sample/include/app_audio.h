@@ -65,6 +65,70 @@ extern "C"
 
 /* Audio buffers */
 
+/* Open processing stages run on the CM33 over each DSP output block, from
+ * DSP0_IRQHandler. A stage replaces the matching DSP library module, so that
+ * module should be off in SM_Ptr->Control while the stage is enabled here. */
+typedef enum
+{
+    APP_STAGE_FB = 0,               /* shared filterbank, on with any spectral stage */
+    APP_STAGE_NR = 1,               /* Wiener noise reduction (replaces NC) */
+    APP_STAGE_AFC = 2,              /* time-domain feedback canceller (replaces AFC), needs LOOPBACK */
+    APP_STAGE_FDAF = 3,             /* subband feedback canceller (Pre-FDAF), needs LOOPBACK */
+    APP_STAGE_LIM = 4,              /* look-ahead output limiter (replaces AGCO), runs last */
+    APP_STAGE_DPEQ = 5,             /* dynamic EQ (replaces DPEQ and EQ) */
+    APP_STAGE_AGC = 6,              /* table-driven broadband AGC */
+    APP_STAGE_XO = 7,               /* crossover band gain, 4..16 bands (replaces WDRC linear gain) */
+    APP_STAGE_AUD = 8,              /* audiometry tone, before the limiter; enabled by APP_Audio_Audiometry() */
+    APP_STAGE_TM = 9,               /* tinnitus masker, before the limiter; enabled by APP_Audio_Masker() */
+    APP_STAGE_AINS = 10,            /* GRU speech enhancement (AI_NS), needs a linked ains_model */
+    APP_STAGE_VAD = 11,             /* voice/own-voice detector, runs first; holds NR, trims XO */
+    APP_STAGE_SCENE = 12,           /* scene classifier, runs from the main loop via APP_Audio_Scene() */
+    APP_STAGE_HOWL = 13,            /* howl detector on the spectrum, notches before the masker */
+    APP_STAGE_WIND = 14,            /* wind detector on the microphone, shelf in a free PRE_BQ slot */
+    APP_STAGE_NFC = 15,             /* frequency compression before the EQ; set by the fitting (MCU_NFC) */
+    APP_STAGE_FSHIFT = 16,          /* output frequency shifter before the limiter; FSHIFT Control bit */
+    APP_STAGE_TR = 17,              /* transient suppressor after AFC, ahead of the band gain */
+    APP_STAGE_NUM
+} APP_Stage_t;
+
+#define APP_STAGE_MASK(stage)       (1u << (stage))
+#define APP_STAGE_SPECTRAL          (APP_STAGE_MASK(APP_STAGE_NR) | APP_STAGE_MASK(APP_STAGE_FDAF) | \
+                                     APP_STAGE_MASK(APP_STAGE_DPEQ) | APP_STAGE_MASK(APP_STAGE_AINS) | \
+                                     APP_STAGE_MASK(APP_STAGE_HOWL) | APP_STAGE_MASK(APP_STAGE_NFC))
+
+/* Spectral stages that change the spectrum and need the synthesis; HOWL only
+ * reads it, so on its own it runs the analysis alone */
+#define APP_STAGE_SPECTRAL_EDIT     (APP_STAGE_SPECTRAL & ~APP_STAGE_MASK(APP_STAGE_HOWL))
+
+/* Feedback canceller bulk delay in samples and prediction-error prefilter
+ * order; tools/host_bench/afc_bench measures the step response and ASG at
+ * each order */
+#define APP_AFC_DELAY               AUDIO_BLOCK_SIZE
+#define APP_AFC_PEM_ORDER           2
+
+/* Stages the fitting software switches with CS_SHORT_STAGES. FB follows the
+ * spectral stages, FSHIFT its Control bit, AUD, TM and NFC their own
+ * commands and fitting data. */
+#define APP_STAGE_FITTED            (((1u << APP_STAGE_NUM) - 1) & \
+                                     ~(APP_STAGE_MASK(APP_STAGE_FB) | APP_STAGE_MASK(APP_STAGE_AUD) | \
+                                       APP_STAGE_MASK(APP_STAGE_TM) | APP_STAGE_MASK(APP_STAGE_NFC) | \
+                                       APP_STAGE_MASK(APP_STAGE_FSHIFT)))
+#define APP_STAGE_CMD_LEN           4       /* APP_STAGE_FITTED bits, little endian */
+
+/* Enabled stages, one APP_STAGE_MASK bit each. All are off at boot; the
+ * APP_STAGE_FITTED ones are set by APP_Audio_Stages() from the BLE short
+ * command CS_SHORT_STAGES, the others as noted in APP_Stage_t. */
+extern volatile uint32_t app_stage_control;
+
+/* Core cycles spent per frame in each stage, last and peak */
+extern uint32_t app_stage_cycles[APP_STAGE_NUM];
+extern uint32_t app_stage_cycles_max[APP_STAGE_NUM];
+
+/* Cycles the shared filterbank saved last frame: one analysis/synthesis
+ * pair for every spectral stage beyond the first, and the analysis HOWL
+ * shares with them. tools/host_bench/fb_bench checks this estimate against
+ * chains run with a filterbank per stage. */
+extern uint32_t app_stage_cycles_saved;
 
 /* ---------------------------------------------------------------------------
  * Function prototype definitions
@@ -75,6 +139,63 @@ extern "C"
  */
 void APP_Audio_Init(void);
 
+/**
+ * @brief Recompile the stage parameters that come from the MCU_* fitting data
+ * @note  Called after Fill_SmData_Buffer() whenever the fitting changes.
+ */
+void APP_Audio_Config(void);
+
+/**
+ * @brief Start or stop an audiometry tone from a BLE command payload
+ * @return false if the payload is out of range or above the output limit
+ */
+bool APP_Audio_Audiometry(const uint8_t *cmd);
+
+/**
+ * @brief Load a tinnitus masker preset from a BLE command payload
+ * @return false if the preset is out of range or too loud
+ */
+bool APP_Audio_Masker(const uint8_t *preset);
+
+/**
+ * @brief Switch the APP_STAGE_FITTED stages from a BLE command payload
+ * @note  Turn the DSP library module a stage replaces off in SM_Ptr->Control
+ *        in the same fitting session.
+ */
+void APP_Audio_Stages(const uint8_t *cmd);
+
+/**
+ * @brief Classify the acoustic scene and morph the program, from the main loop
+ */
+void APP_Audio_Scene(void);
+
+/**
+ * @brief Follow the wind detector with the PRE_BQ shelf, from the main loop
+ */
+void APP_Audio_Wind(void);
+
+/**
+ * @brief Start a stream into SM_Dec at any rate from SRC_MIN_RATE to SRC_MAX_RATE
+ * @note  Mixed with the microphone path and not processed by the DSP.
+ */
+void APP_Audio_StreamOpen(uint32_t rate);
+
+/**
+ * @brief Stop the stream and give SM_Dec back to the microphone path
+ */
+void APP_Audio_StreamClose(void);
+
+/**
+ * @brief Queue stream samples at the stream rate, from the main loop
+ * @return Number of samples taken; retry the rest after APP_Audio_StreamPump()
+ */
+int APP_Audio_StreamWrite(const int *pcm, int n);
+
+/**
+ * @brief Resample the stream into the free SM_Dec buffers, from the main loop
+ */
+void APP_Audio_StreamPump(void);
+
 /**
  * @brief Start audio path
  */
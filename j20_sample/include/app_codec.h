@@ -30,6 +30,9 @@ extern "C"
  * Include files
  * --------------------------------------------------------------------------*/
 
+#include <stdbool.h>
+#include "loader.h"
+
 /* ----------------------------------------------------------------------------
  * Defines
  * ------------------------------------------------------------------------- */
@@ -45,6 +48,9 @@ void App_Codec_Init(void);
 
 /**
  * @brief Load codecs
+ * @note  The AFC and TEST regions are left out; App_Codec_Poll loads them
+ *        once the output has started, and their features stay off until
+ *        then.
  */
 void App_Codec_Load(void);
 
@@ -67,6 +73,54 @@ void App_Codec_SetDecoderVolumeGain(int16_t gain);
  */
 void App_Codec_Reconfig(void);
 
+/* PRAM overlay regions of DSP core 0, for the manifests of their variants */
+extern const overlayRegion app_overlay_afc;
+extern const overlayRegion app_overlay_test;
+
+/**
+ * @brief Swap one PRAM overlay to a variant without reloading the DSP
+ * @param name  Manifest name, e.g. "AFC_B"
+ * @return false if there is no such manifest or a swap is under way
+ * @note  The region's Control bits are cleared at the next DSP frame end;
+ *        after the one after, App_Codec_Poll copies the variant, so its
+ *        features sit out at least one frame while the rest of the DSP keeps
+ *        running. If the variant is rejected or fails its CRC, they stay off.
+ */
+bool App_Codec_SwapOverlay(const char *name);
+
+/**
+ * @brief Run overlay swaps and deferred region loads
+ * @note  Call from the main loop. An 8K region copy takes a large part of
+ *        a DSP frame (1.024 ms), more than DSP0_IRQHandler can spare next to
+ *        APP_Audio_Run, so the copies run here, one region per call, while
+ *        the region's features are held off.
+ */
+void App_Codec_Poll(void);
+
+/**
+ * @brief Keep the features of DSP regions not loaded yet off
+ * @note  Call after writing SM_Ptr->Control. The deferred bits set then are
+ *        turned on once their region is in PRAM.
+ */
+void App_Codec_GateControl(void);
+
+/**
+ * @brief Control bits of the deferred DSP regions still to be loaded; bits
+ *        of a region that failed its CRC stay set
+ */
+uint16_t App_Codec_Deferred(void);
+
+/**
+ * @brief Time the last overlay copy took in us; 0 if its manifest was
+ *        rejected or failed its CRC
+ */
+uint32_t App_Codec_OverlayTime(void);
+
+/**
+ * @brief Longest deferred region load at boot in us
+ */
+uint32_t App_Codec_DeferredTime(void);
+
 
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
@@ -83,6 +83,16 @@ extern "C"
 
 #define CUSTOMSS_NOTIF_TIMEOUT_S            10
 
+/* Short RX frames: CS_SHORT_CMD, command ID, payload. They act at once and
+ * do not reload the fitting or rewrite SM_Ptr->Control. */
+#define CS_SHORT_CMD                    0xAA
+#define CS_SHORT_AUDIOMETRY             0x01    /* audiometry.h payload */
+#define CS_SHORT_MASKER                 0x02    /* tinnitus.h preset */
+#define CS_SHORT_STAGES                 0x03    /* APP_STAGE_FITTED mask, app_audio.h */
+#define CS_SHORT_OVERLAY                0x04    /* overlay variant name, app_codec.h */
+
+#define CS_OVERLAY_NAME_LEN             16      /* longest variant name, without the NUL */
+
 /* Uncomment to use indications in the RX_VALUE_LONG characteristic */
 /* #define RX_VALUE_LONG_INDICATION */
 
@@ -229,6 +239,8 @@ void AppCustomSS_NotifOnTimeout(co_timer_periodic_t* p_timer);
 
 void AppCustomSS_ButtonNotifOnTimeout(co_timer_t* p_timer);
 
+void Update_ShortSMData_RX(uint8_t* valptr, uint16_t lenData);
+
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
  * ------------------------------------------------------------------------- */
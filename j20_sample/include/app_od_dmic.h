@@ -64,6 +64,9 @@ extern "C"
 #define APP_DMIC0_GAIN              0x800
 #define APP_OD_GAIN              	0x880
 
+/* Codec output limiter. The CM33 look-ahead limiter (APP_STAGE_LIM) keeps
+ * peaks under its own ceiling; if this limiter is enabled as a backstop, set
+ * it above that ceiling: each limit_errcnt event trims the software ceiling */
 #define APP_OUTPUT_LIMITER          OUTPUT_LIMITER_OFF
 
 /* DMIC/OD configuration: Decimated Sample Rate = 4 MHz / 128 = 31.25 kHz */
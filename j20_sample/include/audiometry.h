@@ -0,0 +1,128 @@
+/**
+ * @file audiometry.h
+ * @brief In-situ pure-tone audiometry tone generator
+ *
+ * Presents steady, pulsed or warble tones at the standard audiometric
+ * frequencies through the device receiver, so thresholds can be measured
+ * in situ during a fitting. The tone comes from a packed 16-bit quadrature
+ * oscillator: one dual multiply-add pair per sample, with the phasor
+ * magnitude renormalized once per block. Onsets and offsets follow a
+ * raised-cosine ramp of AUD_RAMP_BLOCKS frames (24.6 ms).
+ *
+ * Levels are in dB HL: the output in dBFS is the insert-earphone reference
+ * threshold (RETSPL) at the frequency, plus the level, minus the dB SPL that
+ * full scale produces (MCU_WDRC.maxdB).
+ *
+ * One BLE write starts or stops a presentation; the payload follows the
+ * short-frame header (0xAA, CS_SHORT_AUDIOMETRY):
+ *   [0]  frequency index into the table below, AUD_STOP ends the tone
+ *   [1]  level in dB HL plus 10 (0 = -10 dB HL)
+ *   [2]  bits 0-1: AUD_STEADY, AUD_PULSED or AUD_WARBLE
+ *        bit 2: AUD_MIX, add the tone to the processed microphone signal
+ *        instead of replacing it
+ *   [3]  duration in 100 ms steps, 0 ends the tone
+ *
+ * The tone goes in ahead of the output limiter. AUD_Parser() refuses a level
+ * whose peak would exceed the limiter ceiling, so a presented tone is never
+ * clipped; every sample written, mixed or not, is still clamped to the
+ * ceiling, so the output cannot exceed the MPO even with the limiter off.
+ */
+
+#ifndef INCLUDE_AUDIOMETRY_H_
+#define INCLUDE_AUDIOMETRY_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+/* 125, 250, 500, 750, 1000, 1500, 2000, 3000, 4000, 6000, 8000 Hz */
+#define AUD_FREQS                   11
+#define AUD_STOP                    0xFF
+
+#define AUD_STEADY                  0
+#define AUD_PULSED                  1
+#define AUD_WARBLE                  2
+#define AUD_TONE_MASK               0x03
+#define AUD_MIX                     0x04
+
+#define AUD_CMD_LEN                 4
+#define AUD_LEVEL_OFFSET            10      /* dB HL of payload level 0 */
+#define AUD_RAMP_BLOCKS             24
+#define AUD_PULSE_BLOCKS            195     /* 200 ms on, 200 ms off */
+#define AUD_WARBLE_BLOCKS           195     /* 5 Hz triangle, +/-5% */
+
+/* A presentation compiled on the MCU from one command */
+typedef struct
+{
+    int mode;                           /* AUD_STEADY/PULSED/WARBLE | AUD_MIX */
+    Word32 amplitude;                   /* peak, Word32 full scale */
+    Word32 rot_lo;                      /* packed cos/sin of the step, Q15 */
+    Word32 rot_hi;                      /* upper warble step, rot_lo otherwise */
+    int blocks;                         /* duration in frames, 0 stops */
+} AUD_Presentation_t;
+
+typedef struct
+{
+    AUD_Presentation_t p;
+    bool active;
+    int t;                              /* frames since the start */
+    int ramp;                           /* ramp position, 0..AUD_RAMP_BLOCKS */
+    Word16 env;                         /* envelope at the end of the last frame, Q15 */
+    Word32 phasor;                      /* packed cos/sin, Q15 */
+} AUD_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile one command payload into a presentation
+ * @param ceiling  limiter ceiling, LIM_State_t.ceiling; louder tones are refused
+ * @return false if the payload is out of range or the tone would peak above
+ *         the ceiling
+ * @note  Runs on the MCU in floating point.
+ */
+bool AUD_Parser(const uint8_t *cmd, float maxdB, Word32 ceiling, AUD_Presentation_t *p);
+
+/**
+ * @brief Reset the generator to idle
+ */
+void AUD_Init(AUD_State_t *aud);
+
+/**
+ * @brief Start a presentation, or ramp the current one down if p->blocks is 0
+ * @note  Call with the DSP interrupt masked.
+ */
+void AUD_Start(AUD_State_t *aud, const AUD_Presentation_t *p);
+
+/**
+ * @brief Write one block of tone into the output, if a presentation is running
+ * @param ceiling  peak the output is clamped to, LIM_State_t.ceiling
+ */
+void AUD_Process(AUD_State_t *aud, Word32 *block, Word32 ceiling);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_AUDIOMETRY_H_ */
@@ -0,0 +1,387 @@
+/**
+ * @file basic_op.h
+ * @brief Fixed-point basic operators for the CM33 signal processing stages
+ *
+ * ETSI-style saturating operators (the same vocabulary the LPDSP32 library
+ * uses in SM_CONFIG_* comments, e.g. mult_r) plus packed Q15 pair operators.
+ * When the ARMv8-M DSP extension is available they map onto the CMSIS
+ * intrinsics, otherwise an equivalent portable C version is used so the
+ * stages also build and run on a host.
+ */
+
+#ifndef INCLUDE_BASIC_OP_H_
+#define INCLUDE_BASIC_OP_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include "osj20.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include <hw.h>
+#define BASIC_OP_USE_DSP            1
+#else
+#define BASIC_OP_USE_DSP            0
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Scalar operators
+ * --------------------------------------------------------------------------*/
+
+/** @brief Saturate a 32-bit value to 16 bits */
+static inline Word16 sat16(Word32 x)
+{
+#if BASIC_OP_USE_DSP
+    return (Word16)__SSAT(x, 16);
+#else
+    return (Word16)((x > MAX_16) ? MAX_16 : ((x < MIN_16) ? MIN_16 : x));
+#endif
+}
+
+static inline Word16 add(Word16 a, Word16 b)
+{
+    return sat16((Word32)a + b);
+}
+
+static inline Word16 sub(Word16 a, Word16 b)
+{
+    return sat16((Word32)a - b);
+}
+
+static inline Word16 abs_s(Word16 a)
+{
+    return (a == MIN_16) ? MAX_16 : (Word16)((a < 0) ? -a : a);
+}
+
+static inline Word16 negate(Word16 a)
+{
+    return (a == MIN_16) ? MAX_16 : (Word16)-a;
+}
+
+/** @brief Q15 x Q15 -> Q15, truncated */
+static inline Word16 mult(Word16 a, Word16 b)
+{
+    return sat16(((Word32)a * b) >> 15);
+}
+
+/** @brief Q15 x Q15 -> Q15, rounded */
+static inline Word16 mult_r(Word16 a, Word16 b)
+{
+    return sat16(((Word32)a * b + 0x4000) >> 15);
+}
+
+static inline Word16 shr(Word16 a, int n)
+{
+    return (Word16)((n >= 15) ? (a >> 15) : (a >> n));
+}
+
+static inline Word16 shl(Word16 a, int n)
+{
+    return sat16((Word32)a << ((n > 16) ? 16 : n));
+}
+
+static inline Word32 L_add(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return __QADD(a, b);
+#else
+    int64_t r = (int64_t)a + b;
+    return (Word32)((r > MAX_32) ? MAX_32 : ((r < MIN_32) ? MIN_32 : r));
+#endif
+}
+
+static inline Word32 L_sub(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return __QSUB(a, b);
+#else
+    int64_t r = (int64_t)a - b;
+    return (Word32)((r > MAX_32) ? MAX_32 : ((r < MIN_32) ? MIN_32 : r));
+#endif
+}
+
+static inline Word32 L_abs(Word32 a)
+{
+    return (a == MIN_32) ? MAX_32 : ((a < 0) ? -a : a);
+}
+
+static inline Word32 L_negate(Word32 a)
+{
+    return (a == MIN_32) ? MAX_32 : -a;
+}
+
+/** @brief Q15 x Q15 -> Q31 */
+static inline Word32 L_mult(Word16 a, Word16 b)
+{
+    Word32 p = (Word32)a * b;
+    return (p == 0x40000000) ? MAX_32 : (p << 1);
+}
+
+static inline Word32 L_mac(Word32 acc, Word16 a, Word16 b)
+{
+    return L_add(acc, L_mult(a, b));
+}
+
+static inline Word32 L_msu(Word32 acc, Word16 a, Word16 b)
+{
+    return L_sub(acc, L_mult(a, b));
+}
+
+static inline Word32 L_shr(Word32 a, int n)
+{
+    return (n >= 31) ? (a >> 31) : (a >> n);
+}
+
+/** @brief Saturating left shift, n >= 0 */
+static inline Word32 L_shl(Word32 a, int n)
+{
+    if (n >= 31)
+        return (a == 0) ? 0 : ((a > 0) ? MAX_32 : MIN_32);
+    if (a > (MAX_32 >> n))
+        return MAX_32;
+    if (a < (MIN_32 >> n))
+        return MIN_32;
+    return (Word32)((UWord32)a << n);
+}
+
+static inline Word16 extract_h(Word32 a)
+{
+    return (Word16)(a >> 16);
+}
+
+static inline Word16 extract_l(Word32 a)
+{
+    return (Word16)a;
+}
+
+static inline Word16 round_fx(Word32 a)
+{
+    return extract_h(L_add(a, 0x8000));
+}
+
+/** @brief Count leading zeros of a 32-bit word (32 for zero) */
+static inline int clz32(UWord32 x)
+{
+#if BASIC_OP_USE_DSP
+    return __CLZ(x);
+#else
+    return (x == 0) ? 32 : __builtin_clz(x);
+#endif
+}
+
+/**
+ * @brief Number of left shifts needed to normalize a 32-bit value
+ *        (0 for zero, as in the ETSI reference)
+ */
+static inline int norm_l(Word32 a)
+{
+    if (a == 0)
+        return 0;
+    return clz32((UWord32)(a ^ (a >> 31))) - 1;
+}
+
+/** @brief Number of left shifts needed to normalize a 16-bit value */
+static inline int norm_s(Word16 a)
+{
+    if (a == 0)
+        return 0;
+    return norm_l((Word32)a) - 16;
+}
+
+/** @brief Q31 x Q15 -> Q31 */
+static inline Word32 Mpy_32_16(Word32 a, Word16 b)
+{
+    return (Word32)(((int64_t)a * b) >> 15);
+}
+
+/** @brief Q31 x Q31 -> Q31 */
+static inline Word32 Mpy_32_32(Word32 a, Word32 b)
+{
+    return (Word32)(((int64_t)a * b) >> 31);
+}
+
+/* ----------------------------------------------------------------------------
+ * Packed Q15 pair operators
+ *
+ * A Word32 holds two Q15 values, the low halfword first. For complex data the
+ * low halfword is the real part and the high halfword the imaginary part.
+ * --------------------------------------------------------------------------*/
+
+#define PK_LO(x)            ((Word16)(x))
+#define PK_HI(x)            ((Word16)((Word32)(x) >> 16))
+
+/** @brief Pack two Q15 values into one word */
+static inline Word32 pk_pack(Word32 lo, Word32 hi)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__PKHBT(lo, hi, 16);
+#else
+    return (Word32)(((UWord32)lo & 0xFFFFu) | ((UWord32)hi << 16));
+#endif
+}
+
+/** @brief Low halfword of a, high halfword of b */
+static inline Word32 pk_lo_hi(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__PKHBT(a, b, 0);
+#else
+    return (Word32)(((UWord32)a & 0xFFFFu) | ((UWord32)b & 0xFFFF0000u));
+#endif
+}
+
+/** @brief Pairwise arithmetic right shift */
+static inline Word32 pk_shr(Word32 x, int n)
+{
+    return pk_pack(PK_LO(x) >> n, PK_HI(x) >> n);
+}
+
+/** @brief Saturating pairwise add */
+static inline Word32 pk_add(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__QADD16(a, b);
+#else
+    return pk_pack(sat16((Word32)PK_LO(a) + PK_LO(b)), sat16((Word32)PK_HI(a) + PK_HI(b)));
+#endif
+}
+
+/** @brief Saturating pairwise subtract */
+static inline Word32 pk_sub(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__QSUB16(a, b);
+#else
+    return pk_pack(sat16((Word32)PK_LO(a) - PK_LO(b)), sat16((Word32)PK_HI(a) - PK_HI(b)));
+#endif
+}
+
+/** @brief Halving pairwise add */
+static inline Word32 pk_hadd(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SHADD16(a, b);
+#else
+    return pk_pack(((Word32)PK_LO(a) + PK_LO(b)) >> 1, ((Word32)PK_HI(a) + PK_HI(b)) >> 1);
+#endif
+}
+
+/** @brief Halving pairwise subtract */
+static inline Word32 pk_hsub(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SHSUB16(a, b);
+#else
+    return pk_pack(((Word32)PK_LO(a) - PK_LO(b)) >> 1, ((Word32)PK_HI(a) - PK_HI(b)) >> 1);
+#endif
+}
+
+/** @brief lo = a.lo - b.hi, hi = a.hi + b.lo (a + j*b for complex data) */
+static inline Word32 pk_asx(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__QASX(a, b);
+#else
+    return pk_pack(sat16((Word32)PK_LO(a) - PK_HI(b)), sat16((Word32)PK_HI(a) + PK_LO(b)));
+#endif
+}
+
+/** @brief lo = a.lo + b.hi, hi = a.hi - b.lo (a - j*b for complex data) */
+static inline Word32 pk_sax(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__QSAX(a, b);
+#else
+    return pk_pack(sat16((Word32)PK_LO(a) + PK_HI(b)), sat16((Word32)PK_HI(a) - PK_LO(b)));
+#endif
+}
+
+/** @brief a.lo*b.lo + a.hi*b.hi */
+static inline Word32 pk_smuad(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SMUAD(a, b);
+#else
+    return (Word32)PK_LO(a) * PK_LO(b) + (Word32)PK_HI(a) * PK_HI(b);
+#endif
+}
+
+/** @brief a.lo*b.lo - a.hi*b.hi */
+static inline Word32 pk_smusd(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SMUSD(a, b);
+#else
+    return (Word32)PK_LO(a) * PK_LO(b) - (Word32)PK_HI(a) * PK_HI(b);
+#endif
+}
+
+/** @brief a.lo*b.hi + a.hi*b.lo */
+static inline Word32 pk_smuadx(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SMUADX(a, b);
+#else
+    return (Word32)PK_LO(a) * PK_HI(b) + (Word32)PK_HI(a) * PK_LO(b);
+#endif
+}
+
+/** @brief a.lo*b.hi - a.hi*b.lo */
+static inline Word32 pk_smusdx(Word32 a, Word32 b)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SMUSDX(a, b);
+#else
+    return (Word32)PK_LO(a) * PK_HI(b) - (Word32)PK_HI(a) * PK_LO(b);
+#endif
+}
+
+/** @brief acc + a.lo*b.lo + a.hi*b.hi */
+static inline Word32 pk_smlad(Word32 a, Word32 b, Word32 acc)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SMLAD(a, b, acc);
+#else
+    return acc + pk_smuad(a, b);
+#endif
+}
+
+/** @brief Sign-extend bytes 0 and 2 of x into the low and high halfwords */
+static inline Word32 pk_sxtb16(UWord32 x)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SXTB16(x);
+#else
+    return pk_pack((int8_t)x, (int8_t)(x >> 16));
+#endif
+}
+
+/** @brief Sign-extend bytes 1 and 3 of x into the low and high halfwords */
+static inline Word32 pk_sxtb16_hi(UWord32 x)
+{
+#if BASIC_OP_USE_DSP
+    return (Word32)__SXTB16(__ROR(x, 8));
+#else
+    return pk_pack((int8_t)(x >> 8), (int8_t)(x >> 24));
+#endif
+}
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_BASIC_OP_H_ */
@@ -0,0 +1,69 @@
+/**
+ * @file biquad.h
+ * @brief Fixed-point biquad sections for the CM33 stages
+ *
+ * Coefficients use the five-word INT32 layout of the shared memory filter
+ * blocks (e.g. SM_CONFIG_FBC Hp_BQs/Lp_BQs): b0, b1, b2, a1, a2 in Q30, with
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2].
+ * An all-zero section means "not configured".
+ */
+
+#ifndef INCLUDE_BIQUAD_H_
+#define INCLUDE_BIQUAD_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define BQ_COEF_NUM                 5
+#define BQ_COEF_Q                   30
+
+typedef struct
+{
+    Word32 x1, x2;
+    Word32 y1, y2;
+} BQ_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Clear the section history
+ */
+void BQ_Reset(BQ_State_t *st);
+
+/**
+ * @brief True if the section has no coefficients set
+ */
+bool BQ_IsEmpty(const INT32 *coef);
+
+/**
+ * @brief Filter n samples, in place allowed
+ */
+void BQ_Process(const INT32 *coef, BQ_State_t *st, const Word32 *in, Word32 *out, int n);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_BIQUAD_H_ */
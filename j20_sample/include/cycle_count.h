@@ -0,0 +1,61 @@
+/**
+ * @file cycle_count.h
+ * @brief Core cycle counter helpers for profiling the CM33 audio stages
+ *
+ * Uses the DWT cycle counter, which runs at the core clock and wraps every
+ * 2^32 cycles; differences taken with unsigned arithmetic stay correct
+ * across a wrap.
+ */
+
+#ifndef INCLUDE_CYCLE_COUNT_H_
+#define INCLUDE_CYCLE_COUNT_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <hw.h>
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Enable the trace block and start the cycle counter
+ * @note  A running count is left alone, so the boot stamps taken from the
+ *        first call stay valid when later modules call it again.
+ */
+static inline void Cycle_Count_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t Cycle_Count_Get(void)
+{
+    return DWT->CYCCNT;
+}
+
+/** @brief Cycles elapsed since a previous Cycle_Count_Get() */
+static inline uint32_t Cycle_Count_Since(uint32_t start)
+{
+    return DWT->CYCCNT - start;
+}
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_CYCLE_COUNT_H_ */
@@ -0,0 +1,97 @@
+/**
+ * @file dyn_eq.h
+ * @brief Dynamic-parametric EQ (open DPEQ) on the shared filterbank
+ *
+ * Open replacement for the DSP library DPEQ module; the DYNEQ_ prefix keeps
+ * clear of the library's DPEQ_Init. It applies the fitted EQ curve
+ * (MCU_EQ.dB_Gain_float, one entry per filterbank bin like
+ * SM_CONFIG_EQ.Fix_Gain) in proportion to the level of each bin. A per-bin
+ * energy tracker with the Energy_Time time constant gives the level: below
+ * Threshold_Low the bin is left flat, at and above Threshold_High it gets
+ * the full EQ gain, and in between the linear gain is interpolated with the
+ * level in dB. A Threshold_Low at or below DYNEQ_LOW_OFF_DB disables the low
+ * threshold, which makes the stage a plain static EQ. Levels are in dBFS for
+ * a full-scale sine centred on the bin.
+ *
+ * Cost per frame is one log2, one division and one complex scale per bin.
+ * tools/host_bench/dyneq_bench checks the band gains and times the stage on
+ * the host; app_stage_cycles_max[APP_STAGE_DPEQ] gives the CM33 cycles.
+ */
+
+#ifndef INCLUDE_DYN_EQ_H_
+#define INCLUDE_DYN_EQ_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include "osj20.h"
+#include "filterbank.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define DYNEQ_LOW_OFF_DB            (-120.0)    /* Update_SMData_RX uses -1024 for "none" */
+
+/* Fixed-point parameters compiled from MCU_Config_DPEQ and MCU_Config_EQ */
+typedef struct
+{
+    Word16 alpha;                       /* energy smoothing per frame, Q15 */
+    bool static_eq;                     /* no low threshold: always full EQ */
+    Word32 low;                         /* bin log2 power at Threshold_Low, Q8 */
+    Word32 high;                        /* bin log2 power at Threshold_High, Q8 */
+    Word16 eq_gain[FB_BINS];            /* full EQ gain, Q15, cuts only */
+} DYNEQ_Config_t;
+
+typedef struct
+{
+    DYNEQ_Config_t cfg;
+    int frames;                         /* frames seen, saturates */
+    Word16 level[FB_BINS];              /* smoothed bin log2 power, Q8 */
+    Word16 gain[FB_BINS];               /* applied gain, Q15 */
+} DYNEQ_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the fitting parameters into a fixed-point configuration
+ * @note  Runs on the MCU in floating point.
+ */
+void DYNEQ_Parser(const MCU_Config_DPEQ *dpeq, const MCU_Config_EQ *eq, DYNEQ_Config_t *cfg);
+
+/**
+ * @brief Reset the energy trackers and apply a configuration
+ */
+void DYNEQ_Init(DYNEQ_State_t *dp, const DYNEQ_Config_t *cfg);
+
+/**
+ * @brief Apply a new configuration, keeping the energy trackers
+ */
+void DYNEQ_SetConfig(DYNEQ_State_t *dp, const DYNEQ_Config_t *cfg);
+
+/**
+ * @brief Track the bin energies and apply the level-dependent EQ gain
+ */
+void DYNEQ_Process(DYNEQ_State_t *dp, const FB_State_t *fb, FB_Spectrum_t *spec);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_DYN_EQ_H_ */
@@ -0,0 +1,84 @@
+/**
+ * @file fft_real.h
+ * @brief Fixed-point real FFT/IFFT for 32, 64 and 128 points
+ *
+ * The transforms work in place on a Word32 buffer of n/2 packed Q15 pairs.
+ * On input to FFT_Real_Forward, element i holds the real samples 2i (low
+ * halfword) and 2i+1 (high halfword). On output it holds complex bins in
+ * bit-reversed order: bin k (1..n/2-1) lives at FFT_BIN_POS(fft, k) and
+ * element 0 packs the purely real DC (low) and Nyquist (high) bins.
+ * FFT_Real_Inverse takes that layout back to time samples, so no
+ * bit-reversal pass is ever run.
+ *
+ * Both directions use block floating point: the returned exponent e means
+ * the true value is buffer * 2^e. Forward is unscaled (X[k] = sum x[n]W^nk),
+ * inverse includes the 1/n factor.
+ */
+
+#ifndef INCLUDE_FFT_REAL_H_
+#define INCLUDE_FFT_REAL_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define FFT_MAX_N                   128
+
+/** @brief Buffer position of bin k (1 <= k < n/2) */
+#define FFT_BIN_POS(fft, k)         ((fft)->bitrev[(k)])
+
+typedef struct
+{
+    int n;                              /* real length: 32, 64 or 128 */
+    int m;                              /* complex length n/2 */
+    int log2m;
+    Word32 twiddle[3*FFT_MAX_N/4];      /* W_n^k = cos - j*sin, packed Q15 */
+    unsigned char bitrev[FFT_MAX_N/2];
+} FFT_Real_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Generate twiddle and bin position tables for an n-point transform
+ * @return false if n is not 32, 64 or 128
+ */
+bool FFT_Real_Init(FFT_Real_t *fft, int n);
+
+/**
+ * @brief In-place forward real FFT
+ * @return block exponent of the spectrum
+ */
+int FFT_Real_Forward(const FFT_Real_t *fft, Word32 *buf);
+
+/**
+ * @brief In-place inverse real FFT
+ * @return block exponent of the time samples
+ */
+int FFT_Real_Inverse(const FFT_Real_t *fft, Word32 *buf);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_FFT_REAL_H_ */
@@ -0,0 +1,90 @@
+/**
+ * @file filterbank.h
+ * @brief Weighted overlap-add analysis/synthesis filterbank for the CM33 stages
+ *
+ * 64-point real FFT with a hop of one audio block (32 samples) and
+ * square-root Hann analysis and synthesis windows, giving 33 bins with
+ * perfect reconstruction. Spectra keep the fft_real.h layout (bit-reversed,
+ * DC and Nyquist packed in element 0); use FB_GetBin/FB_SetBin to address
+ * bins in natural order.
+ */
+
+#ifndef INCLUDE_FILTERBANK_H_
+#define INCLUDE_FILTERBANK_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include "osj20.h"
+#include "fft_real.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define FB_FFT_LEN                  64
+#define FB_HOP                      (FB_FFT_LEN/2)
+#define FB_BINS                     (FB_FFT_LEN/2 + 1)
+
+typedef struct
+{
+    Word32 bin[FB_FFT_LEN/2];           /* packed Q15 complex bins */
+    int exp;                            /* true value = bin * 2^exp, in input sample units */
+} FB_Spectrum_t;
+
+typedef struct
+{
+    FFT_Real_t fft;
+    Word16 win[FB_FFT_LEN];             /* square-root Hann, Q15 */
+    Word32 hist[FB_FFT_LEN];            /* analysis input history */
+    Word32 ola[FB_HOP];                 /* synthesis overlap */
+} FB_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Initialize windows, FFT tables and clear the history
+ */
+void FB_Init(FB_State_t *fb);
+
+/**
+ * @brief Shift in one hop of samples and compute its spectrum
+ */
+void FB_Analysis(FB_State_t *fb, const Word32 *in, FB_Spectrum_t *spec);
+
+/**
+ * @brief Inverse transform a spectrum and overlap-add one hop of output
+ * @note  The spectrum buffer is used as scratch and is destroyed.
+ */
+void FB_Synthesis(FB_State_t *fb, FB_Spectrum_t *spec, Word32 *out);
+
+/**
+ * @brief Read bin k (0..FB_BINS-1) as a packed Q15 complex value
+ */
+Word32 FB_GetBin(const FB_State_t *fb, const FB_Spectrum_t *spec, int k);
+
+/**
+ * @brief Write bin k (0..FB_BINS-1); the imaginary part of DC and Nyquist is dropped
+ */
+void FB_SetBin(const FB_State_t *fb, FB_Spectrum_t *spec, int k, Word32 v);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_FILTERBANK_H_ */
@@ -0,0 +1,105 @@
+/**
+ * @file fshift.h
+ * @brief Small frequency shifter for feedback decorrelation
+ *
+ * Moves the whole output up by a few hertz so the signal that comes back
+ * through the feedback path no longer matches the one going out. This
+ * breaks the loop phase condition of a howl and decorrelates the canceller
+ * reference from tonal input, so the NLMS and FDAF cancellers converge with
+ * less bias.
+ *
+ * The analytic signal comes from a pair of allpass cascades, four
+ * second-order sections in z^-2 each, whose outputs stay 90 degrees apart
+ * within 0.7 degree from 100 Hz to 15 kHz, keeping the image of the shift
+ * 44 dB down. Q lags I, so the upper sideband is
+ *   y = I cos(w n) + Q sin(w n)
+ * The oscillator is advanced once per block in Q31 and interpolated over
+ * the samples. Every sample costs the same: eight allpass multiplies and
+ * two mixer multiplies, with no branches on the signal.
+ *
+ * The stage runs on the final output ahead of the limiter, and is switched
+ * by the FSHIFT bit of SM_Ptr->Control.
+ */
+
+#ifndef INCLUDE_FSHIFT_H_
+#define INCLUDE_FSHIFT_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define FSHIFT_SECTIONS             4       /* allpass sections per branch */
+#define FSHIFT_MIN_HZ               1.0
+#define FSHIFT_MAX_HZ               10.0
+
+/* Fixed-point parameters compiled on the MCU */
+typedef struct
+{
+    Word32 rot_re;                      /* oscillator rotation per block, Q31 */
+    Word32 rot_im;
+} FSHIFT_Config_t;
+
+typedef struct
+{
+    Word32 x1, x2;                      /* input history */
+    Word32 y1, y2;                      /* output history */
+} FSHIFT_Allpass_t;
+
+typedef struct
+{
+    FSHIFT_Config_t cfg;
+    FSHIFT_Allpass_t ap[2][FSHIFT_SECTIONS];
+    Word32 delay;                       /* one-sample delay of the I branch */
+    Word32 osc_re;                      /* oscillator at the block start, Q31 */
+    Word32 osc_im;
+} FSHIFT_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the shift in hertz, clamped to FSHIFT_MIN_HZ..FSHIFT_MAX_HZ
+ * @note  Runs on the MCU in floating point.
+ */
+void FSHIFT_Parser(float shift_hz, FSHIFT_Config_t *cfg);
+
+/**
+ * @brief Clear the filters, start the oscillator and apply a configuration
+ */
+void FSHIFT_Init(FSHIFT_State_t *fs, const FSHIFT_Config_t *cfg);
+
+/**
+ * @brief Apply a new configuration
+ * @note  Call with the DSP interrupt masked.
+ */
+void FSHIFT_SetConfig(FSHIFT_State_t *fs, const FSHIFT_Config_t *cfg);
+
+/**
+ * @brief Shift one block in place
+ */
+void FSHIFT_Process(FSHIFT_State_t *fs, Word32 *block);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_FSHIFT_H_ */
@@ -0,0 +1,126 @@
+/**
+ * @file howl.h
+ * @brief Howl detector with an adaptive notch-filter bank
+ *
+ * The fast safety net behind the feedback cancellers. Detection runs on the
+ * shared filterbank spectrum, after FDAF, with three tests per bin:
+ *   - peak to average: the bin is HOWL_PAPR above the mean of all bins,
+ *     a local maximum and above HOWL_MIN_LEVEL
+ *   - persistence: it passes for HOWL_PERSIST frames in a row
+ *   - harmonicity: no other peak within HOWL_HARM_TOL of it sits at half
+ *     or twice its frequency, as it would for a voice or an instrument
+ * A detection drops a notch at the bin, refined to 1/HOWL_FRAC bin by
+ * quadratic interpolation of the log power. The notch is a constrained
+ * second-order adaptive notch filter,
+ *   H(z) = (1 + k z^-1 + z^-2) / (1 + r k z^-1 + r^2 z^-2),
+ * that starts wide (HOWL_R_WIDE) to capture the tone, then narrows to
+ * HOWL_R_NARROW while k follows the whistle by block-normalized gradient
+ * descent. Notches fade in and out over HOWL_FADE_FRAMES and are released
+ * HOWL_HOLD frames after the last detection; with all notches in use the
+ * oldest is replaced.
+ *
+ * HOWL_Process() returns at once with no notch active, so the notches cost
+ * cycles only during a howl. Detection only reads the spectrum, so with no
+ * other spectral stage on the block skips the filterbank synthesis and its
+ * hop of delay. Each notch counts how often it fired; the counts are
+ * published modulo 16 in UPLOAD.MISC[HOWL_DUMP_MISC], one nibble per notch,
+ * notch 0 in bits 0-3.
+ */
+
+#ifndef INCLUDE_HOWL_H_
+#define INCLUDE_HOWL_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osj20.h"
+#include "filterbank.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define HOWL_DUMP_MISC              7       /* UPLOAD.MISC entry */
+
+#define HOWL_NOTCHES                4
+#define HOWL_FRAC                   8       /* notch placement steps per bin */
+
+#define HOWL_PAPR                   850     /* 10 dB over the mean, log2 power Q8 */
+#define HOWL_MIN_LEVEL              (-60)   /* dB re a full-scale tone */
+#define HOWL_HARM_TOL               1020    /* 12 dB */
+#define HOWL_PERSIST                49      /* 50 ms */
+#define HOWL_HOLD                   1953    /* 2 s */
+
+#define HOWL_R_WIDE                 29491   /* 0.90, about 1 kHz wide, Q15 */
+#define HOWL_R_NARROW               31949   /* 0.975, about 250 Hz wide */
+#define HOWL_R_SHIFT                4       /* narrowing time constant, 16 frames */
+#define HOWL_MU                     3277    /* 0.1, gradient step per frame, Q15 */
+#define HOWL_FADE_FRAMES            32
+
+typedef struct
+{
+    bool active;
+    bool release;
+    Word32 k;                           /* -2 cos(w0), Q28 */
+    Word16 r;                           /* pole radius, Q15 */
+    Word16 depth;                       /* fade, Q15 */
+    int pos;                            /* placement, 1/HOWL_FRAC bins */
+    int hold;                           /* frames until release */
+    uint32_t age;                       /* frame of the last trigger */
+    Word32 s1, s2;                      /* pole section history, HOWL_HEADROOM bits down */
+    uint32_t fired;
+} HOWL_Notch_t;
+
+typedef struct
+{
+    Word16 k_init[FB_FFT_LEN / 2 * HOWL_FRAC + 1];  /* -2 cos(w), Q14 */
+    Word32 min_level;                   /* HOWL_MIN_LEVEL, log2 bin power Q8 */
+    Word16 persist[FB_BINS];
+    uint32_t frames;
+    HOWL_Notch_t notch[HOWL_NOTCHES];
+} HOWL_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Build the placement table and clear all notches
+ */
+void HOWL_Init(HOWL_State_t *howl);
+
+/**
+ * @brief Look for a howl in one spectrum and place or retrigger notches
+ */
+void HOWL_Detect(HOWL_State_t *howl, const FB_State_t *fb, const FB_Spectrum_t *spec);
+
+/**
+ * @brief Run the active notches over one block in place
+ */
+void HOWL_Process(HOWL_State_t *howl, Word32 *block);
+
+/**
+ * @brief Publish the per-notch fire counts in UPLOAD.MISC
+ */
+void HOWL_Dump(const HOWL_State_t *howl, SM_UPLOAD_DATA *upload);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_HOWL_H_ */
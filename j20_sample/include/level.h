@@ -0,0 +1,169 @@
+/**
+ * @file level.h
+ * @brief Integer level kernels: log2, dB, pow2, reciprocal square root and
+ *        envelope followers
+ *
+ * Shared by the stages that work on levels, so they no longer carry their
+ * own copies or call libm on the audio path. Levels are log2 in Q8: 256 per
+ * octave of power, i.e. 3.01 dB per 256 for a power and 6.02 dB per 256 for
+ * an amplitude.
+ *
+ * LVL_Log2 normalizes with a leading-zero count and corrects the mantissa
+ * with one quadratic, log2(1 + f) ~ f + 0.3431 f (1 - f), good to 0.011
+ * octave after rounding to Q8 (0.035 dB of power). LVL_Pow2 is its inverse with the same
+ * polynomial. LVL_Rsqrt starts from the two and takes one Newton step.
+ *
+ * LVL_Follow runs an attack/release follower over an array of Q8 levels, two
+ * per word with the DSP extension, picking the coefficient of each lane with
+ * the GE flags of the subtraction.
+ */
+
+#ifndef INCLUDE_LEVEL_H_
+#define INCLUDE_LEVEL_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include "osj20.h"
+#include "basic_op.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define LVL_ONE                     256     /* one octave of power in Q8 */
+#define LVL_DB_PER_LOG2             24660   /* 3.0103 dB, Q13 */
+#define LVL_LOG2_PER_DB             21771   /* 1 / 3.0103, Q16 */
+#define LVL_POLY                    22486u  /* 0.3431, Q16 */
+
+/* ----------------------------------------------------------------------------
+ * Scalar kernels
+ * --------------------------------------------------------------------------*/
+
+/** @brief log2(x) in Q8, 0 for x <= 1 */
+static inline Word32 LVL_Log2(UWord32 x)
+{
+    int n;
+    UWord32 f;
+
+    if (x <= 1)
+        return 0;
+
+    n = clz32(x);
+    f = ((x << n) << 1) >> 16;
+    f += (((f * (65536u - f)) >> 16) * LVL_POLY) >> 16;
+    return ((31 - n) << 8) + (Word32)((f + 128) >> 8);
+}
+
+/** @brief log2(x) in Q8 of a 64-bit value, 0 for x <= 1 */
+static inline Word32 LVL_Log2_64(uint64_t x)
+{
+    UWord32 hi = (UWord32)(x >> 32);
+    int sh = (hi != 0) ? (32 - clz32(hi)) : 0;
+
+    return LVL_Log2((UWord32)(x >> sh)) + (sh << 8);
+}
+
+/** @brief 2^(f/256) in Q16 for 0 <= f < 256 */
+static inline UWord32 LVL_Pow2Frac(Word32 f)
+{
+    UWord32 q = (UWord32)f << 8;
+
+    return 65536u + q - ((((q * (65536u - q)) >> 16) * LVL_POLY) >> 16);
+}
+
+/** @brief 2^(y/256) rounded to an integer, 0 <= y < 32*256 */
+static inline UWord32 LVL_Pow2(Word32 y)
+{
+    int i = y >> 8;
+    UWord32 m = LVL_Pow2Frac(y & 0xFF);
+
+    if (i >= 16)
+        return m << (i - 16);
+    return (m + (1u << (15 - i))) >> (16 - i);
+}
+
+/** @brief Level in log2 Q8 to dB in Q8 (power: 10 log10) */
+static inline Word32 LVL_Log2ToDb(Word32 l)
+{
+    return (l * LVL_DB_PER_LOG2) >> 13;
+}
+
+/** @brief dB in Q8 (power) to a level in log2 Q8 */
+static inline Word32 LVL_DbToLog2(Word32 db)
+{
+    return (db * LVL_LOG2_PER_DB) >> 16;
+}
+
+/** @brief 10 log10(p) in Q8 */
+static inline Word32 LVL_PowerDb(UWord32 p)
+{
+    return LVL_Log2ToDb(LVL_Log2(p));
+}
+
+/** @brief 20 log10(a) in Q8 */
+static inline Word32 LVL_AmpDb(UWord32 a)
+{
+    return 2 * LVL_Log2ToDb(LVL_Log2(a));
+}
+
+/**
+ * @brief Amplitude gain for db in Q8 (20 log10), Q16
+ * @note  Valid from -96 dB to +90 dB.
+ */
+static inline UWord32 LVL_DbToGain(Word32 db)
+{
+    return LVL_Pow2((16 << 8) + (LVL_DbToLog2(db) >> 1));
+}
+
+/**
+ * @brief 1/sqrt(x) in Q31 for x >= 1
+ * @note  Within 1e-4 after the Newton step; x = 1 gives 2^31 - 1.
+ */
+static inline UWord32 LVL_Rsqrt(UWord32 x)
+{
+    uint64_t r;
+    uint64_t e;
+
+    if (x <= 1)
+        return MAX_32;
+
+    /* 2^31 / sqrt(x) from the log, then r (3 - x r^2) / 2 */
+    r = LVL_Pow2((31 << 8) - (LVL_Log2(x) >> 1));
+    e = ((uint64_t)x * r * r) >> 32;
+    r = (r * ((3ull << 30) - e)) >> 31;
+    return (r > MAX_32) ? MAX_32 : (UWord32)r;
+}
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Attack/release follower over n levels
+ * @note  env[i] += (x[i] - env[i]) * c, with c = attack where x[i] rises
+ *        above env[i] and release otherwise, Q15. The difference saturates
+ *        to 16 bits in both paths, so env[i] moves towards x[i] without
+ *        passing it over the whole Word16 range.
+ */
+void LVL_Follow(Word16 *env, const Word16 *x, int n, Word16 attack, Word16 release);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_LEVEL_H_ */
@@ -0,0 +1,122 @@
+/**
+ * @file limiter.h
+ * @brief Look-ahead output limiter (open AGC-O) for the CM33 stages
+ *
+ * Open replacement for the DSP library AGC-O module. The input is delayed by
+ * a look-ahead of 0.5-1 ms while a sliding maximum over the same span gives
+ * the gain each sample needs to stay under the ceiling. That gain passes a
+ * release filter and a box filter as long as the look-ahead, so the gain is
+ * already down when a peak leaves the delay line: no sample exceeds the
+ * ceiling and there is no attack overshoot to pump against.
+ *
+ * The ceiling is MCU_AGCO.Threshold in dBFS, i.e. relative to the maxdB the
+ * WDRC maps to full scale. When the codec output limiter is enabled, its
+ * events pull the ceiling down in 0.5 dB steps until they stop.
+ */
+
+#ifndef INCLUDE_LIMITER_H_
+#define INCLUDE_LIMITER_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define LIM_RING                    32      /* delay line length, power of two */
+#define LIM_LOOKAHEAD_MIN           16      /* 0.51 ms */
+#define LIM_LOOKAHEAD_MAX           (LIM_RING - 1)  /* 0.99 ms */
+#define LIM_UNITY                   32768   /* gain 1.0, Q15 */
+
+/* Hardware limiter coordination: ceiling trim steps and recovery hold */
+#define LIM_TRIM_STEPS              12      /* 0.5 dB each, 6 dB max */
+#define LIM_TRIM_HOLD               (AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SIZE)  /* frames, 1 s */
+
+/* UPLOAD.MISC entry carrying the smallest gain of the last frame, Q15 */
+#define LIM_DUMP_MISC               4
+
+/* Fixed-point parameters compiled from MCU_Config_AGCO */
+typedef struct
+{
+    Word32 ceiling;                     /* peak ceiling, Word32 full scale */
+    int lookahead;                      /* samples, LIM_LOOKAHEAD_MIN..MAX */
+    Word16 release;                     /* release coefficient per sample, Q15 */
+} LIM_Config_t;
+
+typedef struct
+{
+    LIM_Config_t cfg;
+    Word32 ceiling;                     /* cfg.ceiling after the hardware trim */
+    UWord32 n;                          /* sample counter */
+    Word32 delay[LIM_RING];
+    Word32 dq_peak[LIM_RING];           /* sliding maximum, decreasing deque */
+    UWord32 dq_pos[LIM_RING];
+    UWord32 dq_head;
+    UWord32 dq_tail;
+    Word32 box[LIM_RING];               /* released gain history, Q15 */
+    Word32 box_sum;
+    Word32 release_gain;                /* Q30 */
+    Word16 min_gain;                    /* smallest gain of the last frame, Q15 */
+    int trim;                           /* ceiling trim, LIM_TRIM_STEPS units */
+    int trim_hold;                      /* frames without a hardware event */
+    uint32_t hw_events;                 /* last limit_errcnt seen */
+} LIM_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the fitting parameters into a fixed-point configuration
+ * @note  Runs on the MCU in floating point; Attack_Time sets the look-ahead.
+ */
+void LIM_Parser(const MCU_Config_AGCO *agco, LIM_Config_t *cfg);
+
+/**
+ * @brief Reset the limiter and apply a configuration
+ */
+void LIM_Init(LIM_State_t *lim, const LIM_Config_t *cfg);
+
+/**
+ * @brief Apply a new configuration, keeping the state if the look-ahead is unchanged
+ */
+void LIM_SetConfig(LIM_State_t *lim, const LIM_Config_t *cfg);
+
+/**
+ * @brief Limit one block in place; the output is delayed by the look-ahead
+ */
+void LIM_Process(LIM_State_t *lim, Word32 *block);
+
+/**
+ * @brief Trim the ceiling from the codec limiter event count, once per frame
+ */
+void LIM_Hardware(LIM_State_t *lim, uint32_t events);
+
+/**
+ * @brief Write the gain reduction of the last frame to UPLOAD.MISC
+ */
+void LIM_Dump(const LIM_State_t *lim, SM_UPLOAD_DATA *upload);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_LIMITER_H_ */
@@ -20,6 +20,9 @@ extern MCU_Config_DTMF MCU_DTMF;
 extern MCU_Config_VOLUME MCU_VOLUME;
 extern MCU_Config_NC MCU_NS_WIENER;
 extern MCU_Config_AGCO MCU_AGCO;
+extern MCU_Config_AGC MCU_AGC;
+extern MCU_Config_NFC MCU_NFC;
+extern MCU_Config_FSHIFT MCU_FSHIFT;
 extern MCU_Config_VERSION MCU_VERSION;
 
 void EQ_Parser(MCU_Config_EQ* Cfg,SM_CONFIG_EQ* EQ_Cfg);
@@ -0,0 +1,102 @@
+/**
+ * @file nfc.h
+ * @brief Nonlinear frequency compression on the shared filterbank
+ *
+ * Frequency lowering for steeply sloping high-frequency losses. Bins below
+ * the cutoff fc pass unchanged; above it, input frequency fi is moved to
+ *   fo = fc * (fi / fc)^(1 / ratio),
+ * so the band from fc to Nyquist is squeezed into the range the wearer can
+ * still hear. The power of every input bin lands in the output bin nearest
+ * its fo, which keeps the level of the compressed band.
+ *
+ * Phase is handled as in a phase vocoder: the phase step of each input bin
+ * between two frames gives its instantaneous frequency, which is mapped
+ * through the same curve, and each output bin advances its own phase by the
+ * mapped frequency of its strongest source. A tone therefore leaves the
+ * stage as one tone at its compressed frequency rather than as a buzz at
+ * the frame rate.
+ *
+ * The parameters come from the fitting, MCU_NFC; a cutoff of 0 turns the
+ * stage off.
+ */
+
+#ifndef INCLUDE_NFC_H_
+#define INCLUDE_NFC_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include "osj20.h"
+#include "filterbank.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define NFC_MIN_HZ                  1000.0
+#define NFC_MAX_HZ                  8000.0
+#define NFC_MAX_RATIO               4.0
+#define NFC_SIN_LEN                 256     /* sine table, one turn */
+
+/* Fixed-point parameters compiled on the MCU */
+typedef struct
+{
+    int cutoff;                         /* first compressed bin, FB_BINS when off */
+    Word16 pos[FB_BINS];                /* output frequency of input bin j, Q8 bins */
+    Word16 slope[FB_BINS];              /* dfo/dfi at input bin j, Q15 */
+} NFC_Config_t;
+
+typedef struct
+{
+    NFC_Config_t cfg;
+    uint16_t phase_in[FB_BINS];         /* last input phase, 1/65536 turn */
+    uint16_t phase_out[FB_BINS];        /* synthesized output phase */
+    Word16 sin_tab[NFC_SIN_LEN];        /* Q15 */
+} NFC_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the frequency map from the fitting parameters
+ * @note  Runs on the MCU in floating point. Cutoff and ratio are clamped to
+ *        NFC_MIN_HZ..NFC_MAX_HZ and 1..NFC_MAX_RATIO.
+ */
+void NFC_Parser(const MCU_Config_NFC *mcu, NFC_Config_t *cfg);
+
+/**
+ * @brief Build the sine table, clear the phases and apply a configuration
+ */
+void NFC_Init(NFC_State_t *nfc, const NFC_Config_t *cfg);
+
+/**
+ * @brief Apply a new configuration
+ * @note  Call with the DSP interrupt masked.
+ */
+void NFC_SetConfig(NFC_State_t *nfc, const NFC_Config_t *cfg);
+
+/**
+ * @brief Compress the bins above the cutoff of one spectrum in place
+ */
+void NFC_Process(NFC_State_t *nfc, const FB_State_t *fb, FB_Spectrum_t *spec);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_NFC_H_ */
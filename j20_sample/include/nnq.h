@@ -0,0 +1,131 @@
+/**
+ * @file nnq.h
+ * @brief Small int8/int16 inference runtime for the CM33 stages
+ *
+ * Weights are int8 with a power-of-two scale per layer (value = w * 2^-shift),
+ * biases are int32 at the accumulator scale, and activations are int16 in
+ * Q12 (NNQ_Q). A matrix-vector product accumulates in 32 bits; no rounding
+ * happens until the result is brought back to Q12, so any summation order
+ * gives the same bits.
+ *
+ * Models stay in MRAM in natural row-major order. NNQ_Pack() copies a matrix
+ * into the arena with each group of four weights stored as w0 w2 w1 w3, so
+ * one word load and two byte unpacks (pk_sxtb16) feed two dual multiply-adds
+ * against the packed input pairs. The unpacked MRAM copy runs through the
+ * plain scalar kernel, which serves as the bit-exact reference.
+ *
+ * The arena is a bump allocator over a caller-provided buffer, sized at build
+ * time by the model; there is no free.
+ */
+
+#ifndef INCLUDE_NNQ_H_
+#define INCLUDE_NNQ_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define NNQ_Q                       12      /* activation format */
+#define NNQ_ALIGN                   4
+#define NNQ_ALIGNED(n)              (((n) + NNQ_ALIGN - 1) & ~(size_t)(NNQ_ALIGN - 1))
+
+typedef struct
+{
+    uint8_t *base;
+    size_t size;
+    size_t used;
+} NNQ_Arena_t;
+
+/* rows x cols int8 matrix; cols must be a multiple of 4 */
+typedef struct
+{
+    int rows;
+    int cols;
+    const int8_t *w;
+    const Word32 *bias;                 /* rows entries, Q(NNQ_Q + shift) */
+    bool packed;                        /* w0 w2 w1 w3 order, see NNQ_Pack() */
+} NNQ_Mat_t;
+
+/* GRU layer, gates in r, z, n order (3*hidden rows each for wi and wh) */
+typedef struct
+{
+    int hidden;
+    int shift;                          /* weight scale of both matrices */
+    NNQ_Mat_t wi;                       /* 3*hidden x inputs */
+    NNQ_Mat_t wh;                       /* 3*hidden x hidden */
+    Word32 *acc_i;                      /* 3*hidden scratch */
+    Word32 *acc_h;
+} NNQ_GRU_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Attach the arena to its static buffer
+ */
+void NNQ_ArenaInit(NNQ_Arena_t *arena, void *buf, size_t size);
+
+/**
+ * @brief Take bytes from the arena, NNQ_ALIGN aligned
+ * @return NULL if the arena is exhausted
+ */
+void *NNQ_Alloc(NNQ_Arena_t *arena, size_t bytes);
+
+/**
+ * @brief Copy a natural-order matrix and its bias into the arena, packed
+ * @return false if the arena is exhausted
+ */
+bool NNQ_Pack(NNQ_Arena_t *arena, const NNQ_Mat_t *src, NNQ_Mat_t *dst);
+
+/**
+ * @brief acc = bias + W x, 32-bit accumulators
+ */
+void NNQ_MatVec(const NNQ_Mat_t *m, const Word16 *x, Word32 *acc);
+
+/**
+ * @brief Round an accumulator at Q(NNQ_Q + shift) back to a Q12 activation
+ */
+Word16 NNQ_Requant(Word32 acc, int shift);
+
+/**
+ * @brief Logistic sigmoid, Q12 in, Q15 out
+ */
+Word16 NNQ_Sigmoid(Word16 x);
+
+/**
+ * @brief Hyperbolic tangent, Q12 in, Q15 out
+ */
+Word16 NNQ_Tanh(Word16 x);
+
+/**
+ * @brief One GRU time step; h (Q12) is updated in place
+ */
+void NNQ_GRU_Step(const NNQ_GRU_t *g, const Word16 *x, Word16 *h);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_NNQ_H_ */
@@ -0,0 +1,113 @@
+/**
+ * @file nr_wiener.h
+ * @brief Wiener noise reduction with a minimum-statistics noise tracker
+ *
+ * Open replacement for the DSP library NC module, run on the CM33 filterbank
+ * spectrum. It is driven by the same SM_CONFIG_NC block the fitting tool
+ * writes (max depth per band, VOX and low-noise levels) and reports the same
+ * NC_Dump layout: low-noise flag, VOX flag, 33 gains and 33 SNRs.
+ *
+ * All per-bin statistics are kept in the log2 domain (Q8) so the tracker
+ * covers the whole 32-bit sample range without per-bin exponents.
+ */
+
+#ifndef INCLUDE_NR_WIENER_H_
+#define INCLUDE_NR_WIENER_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include "osj20.h"
+#include "filterbank.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+/* nc_common_param[] entries used by this stage (written by Update_SMData_RX) */
+#define NR_PARAM_VOX_LEVEL          6       /* speech level, Q31 power (arr_nsdeep_levels) */
+#define NR_PARAM_LOW_NOISE_LEVEL    14      /* low-noise level, Q31 power (arr_nsdeep_levels) */
+
+/* Minimum statistics: NR_MS_SUBWIN windows of NR_MS_SUBWIN_LEN frames, ~1.5 s */
+#define NR_MS_SUBWIN                8
+#define NR_MS_SUBWIN_LEN            183
+
+#define NR_SMOOTH_ALPHA             29491   /* 0.90, log power smoothing, Q15 */
+#define NR_DD_ALPHA                 32440   /* 0.99, decision-directed weight, Q15 */
+#define NR_MS_BIAS                  384     /* 1.5 (4.5 dB) minimum bias, log2 Q8 */
+#define NR_MAX_DEPTH_DB             15
+
+/* NC_Dump layout, as documented in SM_UPLOAD_DATA */
+#define NR_DUMP_LOW_NOISE           0
+#define NR_DUMP_VOX                 1
+#define NR_DUMP_GAIN                2
+#define NR_DUMP_SNR                 (NR_DUMP_GAIN + FB_BINS)
+
+typedef struct
+{
+    const SM_CONFIG_NC *cfg;
+    int frames;                         /* frames seen, saturates */
+    int subwin_cnt;                     /* frames in the current sub-window */
+    int subwin_idx;                     /* oldest entry of win_min */
+    Word16 smooth[FB_BINS];             /* smoothed log2 power, Q8 */
+    Word16 sub_min[FB_BINS];            /* running minimum of the current sub-window */
+    Word16 win_min[NR_MS_SUBWIN][FB_BINS];
+    Word16 ring_min[FB_BINS];           /* minimum over win_min, refreshed per sub-window */
+    Word16 noise[FB_BINS];              /* noise log2 power, Q8 */
+    Word32 prev_snr[FB_BINS];           /* G^2 * posterior SNR of the last frame, Q8 */
+    Word32 xi[FB_BINS];                 /* a-priori SNR, Q8 */
+    Word16 gain[FB_BINS];               /* applied gain, Q15 */
+    bool low_noise;
+    bool vox;
+    bool hold;                          /* noise estimate frozen, see NR_Hold() */
+    Word16 scale;                       /* depth scale, Q15, see NR_SetScale() */
+} NR_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Reset the tracker and bind the parameter block
+ */
+void NR_Init(NR_State_t *nr, const SM_CONFIG_NC *cfg);
+
+/**
+ * @brief Update the noise estimate and apply the Wiener gain to one spectrum
+ */
+void NR_Process(NR_State_t *nr, const FB_State_t *fb, FB_Spectrum_t *spec);
+
+/**
+ * @brief Freeze the noise estimate, e.g. while the VAD reports speech
+ */
+void NR_Hold(NR_State_t *nr, bool hold);
+
+/**
+ * @brief Scale the attenuation, e.g. by the scene program
+ */
+void NR_SetScale(NR_State_t *nr, Word16 scale);
+
+/**
+ * @brief Write flags, gains and SNRs to NC_Dump
+ */
+void NR_Dump(const NR_State_t *nr, SM_UPLOAD_DATA *upload);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_NR_WIENER_H_ */
@@ -56,7 +56,8 @@ typedef enum
 	DPEQ = 9,
 	AGCO = 10,
 	TONE_GEN = 12,
-	SOUND_GEN = 13
+	SOUND_GEN = 13,
+	FSHIFT = 14						//CM33 frequency shifter (fshift.h), not read by the DSP
 
 }Control_Bit;
 
@@ -368,6 +369,15 @@ typedef struct {
 	float dB_peak;
 } MCU_Config_AGC;
 
+typedef struct {
+	float Cutoff_Hz;				//0: off
+	float Ratio;					//1~4
+} MCU_Config_NFC;
+
+typedef struct {
+	float Shift_Hz;					//1~10
+} MCU_Config_FSHIFT;
+
 typedef struct {
 	float ADC_GAIN;
 	float DAC_GAIN;
@@ -479,6 +489,7 @@ typedef struct
 } MCU_Config_VERSION;
 
 #define AUDIO_BLOCK_SIZE  (32)
+#define AUDIO_SAMPLE_RATE (31250)		// DMIC/OD rate, 4 MHz / 128
 
 
 #define SM_BLOCK_SIZE   (32*2*2)
@@ -0,0 +1,132 @@
+/**
+ * @file resample.h
+ * @brief Polyphase sample-rate converter for streamed sources
+ *
+ * Converts a stream at any rate from SRC_MIN_RATE to SRC_MAX_RATE (prompts
+ * at 8 or 16 kHz, BLE audio at 16, 24, 44.1 or 48 kHz, test files) to the
+ * SM_Dec rate, SRC_OUT_RATE. The DSP takes one AUDIO_BLOCK from SM_Dec per
+ * frame, so SM_Dec runs at half the pipeline rate.
+ *
+ * The interpolation filter is a Kaiser-windowed sinc with SRC_PHASES phases
+ * per input sample. An output sample is the dot product with the two phases
+ * around its position, linearly interpolated, so any ratio works with the
+ * same table. The filter spans SRC_ZEROS samples of the slower side on
+ * either side, up to SRC_MAX_TAPS. When the input is faster than the output,
+ * the cutoff follows the output Nyquist frequency. From 16 kHz the input
+ * band above the output Nyquist, 7.8 to 8 kHz, lies in the transition band
+ * and folds back only about 23 dB down. tools/host_bench/resample_bench
+ * gives the image rejection and cost for each rate.
+ *
+ * The source writes into a FIFO at its own clock and the reader pulls at
+ * the DSP clock. The smoothed FIFO fill steers the step, by at most
+ * SRC_MAX_DRIFT, so the fill settles near half the FIFO without the two
+ * clocks having to match; each 100 ppm of clock mismatch moves the fill by
+ * about 26 samples. Output starts, and restarts after an underrun, once the
+ * FIFO is half full.
+ *
+ * SRC_Write and SRC_Read must be called from the same context.
+ */
+
+#ifndef INCLUDE_RESAMPLE_H_
+#define INCLUDE_RESAMPLE_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define SRC_OUT_RATE                (AUDIO_SAMPLE_RATE * AUDIO_BLOCK / AUDIO_BLOCK_SIZE)
+#define SRC_MIN_RATE                8000
+#define SRC_MAX_RATE                48000
+
+#define SRC_PHASES                  32      /* filter phases per input sample */
+#define SRC_ZEROS                   10      /* filter half length, slower-side samples */
+#define SRC_MAX_TAPS                64      /* 48 kHz needs 62 */
+#define SRC_CUTOFF                  0.9     /* of the lower Nyquist frequency */
+#define SRC_BETA                    7.0     /* Kaiser window, about 70 dB */
+
+#define SRC_FRAC_BITS               24      /* step and position fraction */
+#define SRC_FIFO                    512     /* input samples, a power of two */
+#define SRC_FILL_SHIFT              6       /* fill smoothing, per SRC_Read */
+#define SRC_DRIFT_SHIFT             18      /* step change per sample of fill error */
+#define SRC_MAX_DRIFT               9       /* step change limit, 2^-9 (0.2 %) */
+
+/* Fixed-point parameters compiled on the MCU */
+typedef struct
+{
+    uint32_t rate;                      /* input rate, Hz */
+    UWord32 step;                       /* input samples per output, Q24 */
+    int taps;
+    Word16 coef[SRC_PHASES + 1][SRC_MAX_TAPS];  /* Q15 */
+} SRC_Config_t;
+
+typedef struct
+{
+    const SRC_Config_t *cfg;            /* coefficient table, kept by the caller */
+    Word32 fifo[2 * SRC_FIFO];          /* mirrored, so a dot product never wraps */
+    uint32_t wr;                        /* samples written */
+    uint32_t rd;                        /* first input sample under the filter */
+    UWord32 frac;                       /* position past rd, Q24 */
+    Word32 fill;                        /* smoothed fill, Q8 samples */
+    UWord32 step;                       /* drift-corrected step */
+    bool primed;                        /* FIFO has reached half once */
+    uint32_t underruns;                 /* output samples with the FIFO short */
+    uint32_t overruns;                  /* input samples dropped on a full FIFO */
+} SRC_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Design the filter for an input rate, clamped to SRC_MIN_RATE..SRC_MAX_RATE
+ * @note  Runs on the MCU in floating point.
+ */
+void SRC_Parser(uint32_t rate, SRC_Config_t *cfg);
+
+/**
+ * @brief Empty the FIFO and start on a configuration
+ * @note  The state refers to cfg, which must outlive it.
+ */
+void SRC_Init(SRC_State_t *src, const SRC_Config_t *cfg);
+
+/**
+ * @brief Queue input samples
+ * @return Number of samples taken; the rest did not fit
+ */
+int SRC_Write(SRC_State_t *src, const Word32 *pcm, int n);
+
+/**
+ * @brief Produce n output samples, zeros where the FIFO runs short
+ */
+void SRC_Read(SRC_State_t *src, Word32 *out, int n);
+
+/**
+ * @brief Number of queued input samples
+ */
+int SRC_Fill(const SRC_State_t *src);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_RESAMPLE_H_ */
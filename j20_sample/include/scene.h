@@ -0,0 +1,150 @@
+/**
+ * @file scene.h
+ * @brief Acoustic scene classifier for automatic program switching
+ *
+ * Runs from the main loop every SCENE_PERIOD frames (about 100 ms) on a
+ * snapshot of SM_UPLOAD_DATA, so it needs nothing from the audio path but
+ * the figures the stages already publish:
+ *   - RMS_dBSPL[]: broadband level, and its change from one decision to
+ *     the next, high for music and speech, low for steady noise
+ *   - NC_Dump SNRs: mean a-priori SNR over the bins, which separates clean
+ *     speech from speech in noise
+ *   - NC_Dump VOX and low-noise flags, or the VAD speech flag in
+ *     UPLOAD.MISC[VAD_DUMP_MISC] when the NR VOX level is not fitted
+ * All features are smoothed over about one second, then a fixed decision
+ * tree picks quiet, speech, speech in noise, noise or music. A new scene
+ * must win SCENE_CONFIRM decisions in a row (3 s) before it is taken.
+ *
+ * Each scene has a program in scene_program[]: a broadband gain and a
+ * noise-reduction strength scale. The active values morph towards the
+ * program of the current scene with a SCENE_MORPH_MS time constant, so a
+ * switch is never heard as a step. The scene is published in
+ * UPLOAD.MISC[SCENE_DUMP_MISC]:
+ *   bits 0-3   current scene
+ *   bits 4-7   candidate scene
+ *   bits 8-15  decisions the candidate has won
+ */
+
+#ifndef INCLUDE_SCENE_H_
+#define INCLUDE_SCENE_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define SCENE_DUMP_MISC             6       /* UPLOAD.MISC entry */
+
+#define SCENE_PERIOD                98      /* frames between decisions, ~100 ms */
+#define SCENE_CONFIRM               30      /* decisions before a switch, 3 s */
+#define SCENE_SMOOTH                0.1f    /* feature smoothing per decision, ~1 s */
+#define SCENE_MORPH_MS              2000.0
+
+#define SCENE_QUIET_DB              45.0f   /* below this broadband level, dB SPL */
+#define SCENE_LOW_NOISE             0.5f    /* or the NR low-noise flag this often */
+#define SCENE_VOICE                 0.4f    /* voice flag fraction for speech */
+#define SCENE_CLEAN_SNR             8.0f    /* mean bin SNR of clean speech, dB */
+#define SCENE_MUSIC_FLUCT           0.5f    /* level change per decision for music, dB */
+
+typedef enum
+{
+    SCENE_QUIET = 0,
+    SCENE_SPEECH = 1,
+    SCENE_SPEECH_IN_NOISE = 2,
+    SCENE_NOISE = 3,
+    SCENE_MUSIC = 4,
+    SCENE_NUM
+} SCENE_t;
+
+/* Parameters morphed per scene */
+typedef struct
+{
+    Word16 gain;                        /* broadband gain, Q15 */
+    Word16 ns;                          /* noise-reduction strength scale, Q15 */
+} SCENE_Program_t;
+
+typedef struct
+{
+    float full_scale;                   /* dB SPL at 0 dBFS, MCU_WDRC.maxdB */
+    Word16 morph;                       /* morph coefficient per decision, Q15 */
+} SCENE_Config_t;
+
+/* Smoothed features */
+typedef struct
+{
+    float level;                        /* broadband level, dB SPL */
+    float fluct;                        /* level change per decision, dB */
+    float snr;                          /* mean bin SNR, dB */
+    float voice;                        /* voice flag fraction */
+    float low_noise;                    /* low-noise flag fraction */
+} SCENE_Features_t;
+
+typedef struct
+{
+    SCENE_Config_t cfg;
+    SCENE_Features_t feat;
+    float last_level;
+    int decisions;
+    SCENE_t scene;
+    SCENE_t candidate;
+    int confirm;
+    SCENE_Program_t active;             /* morphed values, read by the audio path */
+} SCENE_State_t;
+
+/* Program per scene */
+extern const SCENE_Program_t scene_program[SCENE_NUM];
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the level calibration and the morph time
+ * @note  Runs on the MCU in floating point; maxdB is MCU_WDRC.maxdB.
+ */
+void SCENE_Parser(float maxdB, SCENE_Config_t *cfg);
+
+/**
+ * @brief Start in the quiet scene with its program applied
+ */
+void SCENE_Init(SCENE_State_t *scene, const SCENE_Config_t *cfg);
+
+/**
+ * @brief Apply a new configuration
+ */
+void SCENE_SetConfig(SCENE_State_t *scene, const SCENE_Config_t *cfg);
+
+/**
+ * @brief Update the features from one UPLOAD snapshot and decide
+ * @return true when the scene changed
+ */
+bool SCENE_Classify(SCENE_State_t *scene, const SM_UPLOAD_DATA *upload);
+
+/**
+ * @brief Publish the scene in UPLOAD.MISC
+ */
+void SCENE_Dump(const SCENE_State_t *scene, SM_UPLOAD_DATA *upload);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_SCENE_H_ */
@@ -0,0 +1,123 @@
+/**
+ * @file tinnitus.h
+ * @brief Shaped-noise tinnitus masker
+ *
+ * Extends the WHITE_NOISE event of the SM_CONFIG_SG sound generator with
+ * spectral shaping and slow amplitude modulation, for all-day tinnitus
+ * sound therapy next to the amplification path. White noise comes from a
+ * 32-bit xorshift LFSR, which yields two 16-bit samples per three shift/xor
+ * steps. Up to TM_SECTIONS biquads then colour it:
+ *   - TM_WHITE     no filtering
+ *   - TM_PINK      -3 dB/octave from four pole/zero pairs in two sections
+ *   - TM_NOTCHED   pink with a notch at the tinnitus pitch
+ *   - TM_BAND      band-limited around the tinnitus pitch
+ * The level and the modulation are one gain per frame, interpolated across
+ * the frame; level changes and stops fade with a 33 ms time constant.
+ *
+ * One BLE write loads a preset; the payload follows the short-frame header
+ * (0xAA, CS_SHORT_MASKER):
+ *   [0]  colour, TM_OFF fades the masker out
+ *   [1]  level in dB SPL, as the RMS of a sine with the same SPL
+ *   [2]  tinnitus pitch in 100 Hz steps
+ *   [3]  notch or band width in 0.1 octave steps, 0 = one octave
+ *   [4]  modulation rate in 0.1 Hz steps, 0 = none
+ *   [5]  modulation depth in percent
+ *   [6]  Sound_Mix_Mode: MIX_MIC adds the noise to the processed microphone
+ *        signal, NO_MIX_MIC replaces it
+ */
+
+#ifndef INCLUDE_TINNITUS_H_
+#define INCLUDE_TINNITUS_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osj20.h"
+#include "biquad.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define TM_OFF                      0
+#define TM_WHITE                    1
+#define TM_PINK                     2
+#define TM_NOTCHED                  3
+#define TM_BAND                     4
+
+#define TM_PRESET_LEN               7
+#define TM_SECTIONS                 3
+#define TM_LEVEL_MAX_DB             (-12.0) /* RMS re a full-scale sine, leaves noise crest room */
+#define TM_GAIN_Q                   24
+#define TM_SMOOTH_SHIFT             5       /* level fade, 2^5 frames */
+
+/* Fixed-point parameters compiled on the MCU from one preset */
+typedef struct
+{
+    int color;
+    int mix;                            /* Sound_Mix_Mode */
+    int sections;                       /* biquads in use */
+    INT32 bq[TM_SECTIONS][BQ_COEF_NUM];
+    Word32 gain;                        /* output gain, Q24; 0 fades out */
+    Word32 am_rot;                      /* packed cos/sin of the per-frame step, Q15 */
+    Word16 am_depth;                    /* Q15 */
+} TM_Config_t;
+
+typedef struct
+{
+    TM_Config_t cfg;
+    bool active;
+    UWord32 lfsr;
+    BQ_State_t bq[TM_SECTIONS];
+    Word32 gain;                        /* smoothed cfg.gain, Q24 */
+    Word32 frame_gain;                  /* gain with modulation at the end of the last frame */
+    Word32 am_phasor;                   /* packed cos/sin, Q15 */
+} TM_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Design the colouring filter and gains for one preset
+ * @return false if the preset is out of range or above TM_LEVEL_MAX_DB
+ * @note  Runs on the MCU in floating point.
+ */
+bool TM_Parser(const uint8_t *preset, float maxdB, TM_Config_t *cfg);
+
+/**
+ * @brief Reset the masker to silent
+ */
+void TM_Init(TM_State_t *tm);
+
+/**
+ * @brief Apply a preset; a zero gain fades the masker out
+ * @note  Call with the DSP interrupt masked.
+ */
+void TM_SetConfig(TM_State_t *tm, const TM_Config_t *cfg);
+
+/**
+ * @brief Generate one block of noise into the output, if the masker is on
+ */
+void TM_Process(TM_State_t *tm, Word32 *block);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_TINNITUS_H_ */
@@ -0,0 +1,134 @@
+/**
+ * @file transient.h
+ * @brief Transient and impulse noise suppressor
+ *
+ * Catches dish clatter, door slams and clicks before the band gain, which
+ * would otherwise amplify them with the compressor's slower time constants.
+ * The block is split into TR_BANDS complementary bands by one-pole low-pass
+ * filters at TR_SPLIT_LO_HZ and TR_SPLIT_HI_HZ, so the bands add back to the
+ * input exactly. Each band runs two envelopes on every sample:
+ *   - fast: peak hold with a 1 ms release (TR_FAST_SHIFT)
+ *   - slow: a 4 ms follower of the fast one (TR_SLOW_SHIFT)
+ * A sound that rises within a millisecond leaves the slow envelope behind;
+ * speech and music onsets take several milliseconds and do not. Where the
+ * fast envelope exceeds the slow one by more than TR_RATIO_DB, and is above
+ * TR_FLOOR_DB SPL, the band is pulled back to that ratio, by at most
+ * TR_MAX_DB. While a band is pulled back its slow envelope slows down to
+ * TR_HOLD_SHIFT, so the ringing of a clatter stays under control, while a
+ * sound that stays loud is let through after some tens of milliseconds.
+ *
+ * Gains are updated every TR_SUB samples (0.26 ms), ramped over the next
+ * TR_SUB and released with a TR_REL_SHIFT time constant. The audio is
+ * delayed by TR_LOOKAHEAD samples (0.5 ms), so the gain is down before the
+ * impulse leaves the stage.
+ *
+ * Each band counts the transients it caught. The counts go to
+ * UPLOAD.MISC[TR_DUMP_MISC] modulo 16, one nibble per band with the low
+ * band in bits 0-3. Bits 12-15 carry the deepest current reduction in
+ * 3 dB steps.
+ */
+
+#ifndef INCLUDE_TRANSIENT_H_
+#define INCLUDE_TRANSIENT_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define TR_DUMP_MISC                9       /* UPLOAD.MISC entry */
+
+#define TR_BANDS                    3
+#define TR_SPLIT_LO_HZ              500.0
+#define TR_SPLIT_HI_HZ              3000.0
+
+#define TR_SUB                      8       /* samples per gain update */
+#define TR_LOOKAHEAD                16      /* samples, 0.5 ms */
+#define TR_FAST_SHIFT               5       /* 32 samples, 1 ms */
+#define TR_SLOW_SHIFT               7       /* 128 samples, 4 ms */
+#define TR_HOLD_SHIFT               10      /* 1024 samples, 33 ms */
+#define TR_REL_SHIFT                4       /* 16 updates, 4 ms */
+
+#define TR_RATIO_DB                 12.0
+#define TR_MAX_DB                   15.0
+#define TR_FLOOR_DB                 70.0    /* dB SPL peak */
+
+/* Fixed-point parameters compiled on the MCU */
+typedef struct
+{
+    Word16 split[TR_BANDS - 1];         /* one-pole low-pass coefficients, Q15 */
+    Word32 ratio;                       /* TR_RATIO_DB, log2 amplitude Q8 */
+    Word32 max;                         /* TR_MAX_DB */
+    Word32 floor;                       /* TR_FLOOR_DB */
+} TR_Config_t;
+
+typedef struct
+{
+    TR_Config_t cfg;
+    Word32 lp[TR_BANDS - 1];
+    Word32 fast[TR_BANDS];              /* envelopes, amplitude one bit down */
+    Word32 slow[TR_BANDS];
+    Word16 gain[TR_BANDS];              /* Q15 */
+    Word32 line[TR_BANDS][TR_LOOKAHEAD];
+    int pos;
+    bool active[TR_BANDS];
+    uint32_t events[TR_BANDS];
+    Word32 depth;                       /* deepest reduction last block, log2 Q8 */
+} TR_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the band split and the thresholds
+ * @param maxdB  dB SPL of a full-scale sine, from MCU_WDRC
+ * @note  Runs on the MCU in floating point.
+ */
+void TR_Parser(float maxdB, TR_Config_t *cfg);
+
+/**
+ * @brief Reset the envelopes, gains and counters and apply a configuration
+ */
+void TR_Init(TR_State_t *tr, const TR_Config_t *cfg);
+
+/**
+ * @brief Apply a new configuration
+ * @note  Call with the DSP interrupt masked.
+ */
+void TR_SetConfig(TR_State_t *tr, const TR_Config_t *cfg);
+
+/**
+ * @brief Suppress transients in one block in place, delaying it by TR_LOOKAHEAD
+ */
+void TR_Process(TR_State_t *tr, Word32 *block);
+
+/**
+ * @brief Publish the event counters and the reduction in UPLOAD.MISC
+ */
+void TR_Dump(const TR_State_t *tr, SM_UPLOAD_DATA *upload);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_TRANSIENT_H_ */
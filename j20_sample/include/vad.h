@@ -0,0 +1,132 @@
+/**
+ * @file vad.h
+ * @brief Voice and own-voice activity detector
+ *
+ * Runs once per block in the time domain, ahead of the CM33 stages, from
+ * three cues:
+ *   - level over a tracked noise floor (fast down, VAD_FLOOR_RISE up)
+ *   - modulation depth: the smoothed distance between a fast (8 ms) and a
+ *     slow (260 ms) follower of the log level, high for syllabic speech and
+ *     low for steady noise
+ *   - spectral tilt: the low band (below VAD_LO_HZ) over the high band
+ *     (above VAD_HI_HZ), raised for the wearer's own voice by bone
+ *     conduction and the short mouth-to-microphone path
+ * Speech needs the SNR and the modulation; own voice additionally needs the
+ * own-voice level and tilt and, when a second microphone block is given,
+ * an inter-microphone level difference within VAD_ILD_TOL of the calibrated
+ * own-voice value. Both decisions hold for VAD_HANG frames.
+ *
+ * Subscribers read VAD_State_t.flags and ov_trim: the noise reduction holds
+ * its noise estimate during speech, and the crossover band gain is trimmed
+ * by ov_trim, which ramps to -VAD_OV_REDUCE_DB during own voice. The flags
+ * and the SNR are published in UPLOAD.MISC[VAD_DUMP_MISC]:
+ *   bits 0-7   VAD_SPEECH | VAD_OWN_VOICE
+ *   bits 8-15  SNR in dB, 0..127
+ */
+
+#ifndef INCLUDE_VAD_H_
+#define INCLUDE_VAD_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define VAD_SPEECH                  0x01
+#define VAD_OWN_VOICE               0x02
+
+#define VAD_DUMP_MISC               5       /* UPLOAD.MISC entry */
+
+#define VAD_LO_HZ                   1000.0
+#define VAD_HI_HZ                   2000.0
+#define VAD_SNR_MIN                 512     /* 6 dB, log2 power Q8 */
+#define VAD_MOD_MIN                 192     /* 2.3 dB */
+#define VAD_FLOOR_RISE              4       /* Q12 per frame, about 3 dB/s */
+#define VAD_HANG                    98      /* 100 ms */
+#define VAD_OV_LEVEL_DB             70.0    /* own voice at the microphone, dB SPL */
+#define VAD_OV_TILT                 1024    /* 12 dB more low band than high band */
+#define VAD_ILD_TOL                 256     /* 3 dB */
+#define VAD_OV_REDUCE_DB            6.0
+
+/* Fixed-point parameters compiled on the MCU */
+typedef struct
+{
+    Word16 lo_coef;                     /* one-pole low-pass coefficients, Q15 */
+    Word16 hi_coef;
+    Word32 ov_level;                    /* own-voice level, log2 power Q8 */
+    Word32 ov_ild;                      /* own-voice mic1 - mic2 level, log2 Q8 */
+    Word16 ov_trim;                     /* gain during own voice, Q15 */
+} VAD_Config_t;
+
+typedef struct
+{
+    VAD_Config_t cfg;
+    Word32 lp_lo;                       /* low-pass states */
+    Word32 lp_hi;
+    Word32 floor;                       /* noise floor, log2 power Q12 */
+    Word32 fast;                        /* level followers, Q12 */
+    Word32 slow;
+    Word32 mod;                         /* modulation depth, Q12 */
+    Word32 snr;                         /* last SNR, log2 Q8 */
+    int frames;
+    int speech_hang;
+    int own_hang;
+    int flags;
+    Word16 ov_trim;                     /* published own-voice gain, Q15 */
+} VAD_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the band edges and the own-voice level
+ * @note  Runs on the MCU in floating point; maxdB is MCU_WDRC.maxdB.
+ */
+void VAD_Parser(float maxdB, VAD_Config_t *cfg);
+
+/**
+ * @brief Reset the trackers and apply a configuration
+ */
+void VAD_Init(VAD_State_t *vad, const VAD_Config_t *cfg);
+
+/**
+ * @brief Apply a new configuration
+ * @note  Call with the DSP interrupt masked.
+ */
+void VAD_SetConfig(VAD_State_t *vad, const VAD_Config_t *cfg);
+
+/**
+ * @brief Update the decisions from one block
+ * @param mic2  second microphone block, or NULL with one microphone
+ */
+void VAD_Process(VAD_State_t *vad, const Word32 *block, const Word32 *mic2);
+
+/**
+ * @brief Publish the flags and SNR in UPLOAD.MISC
+ */
+void VAD_Dump(const VAD_State_t *vad, SM_UPLOAD_DATA *upload);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_VAD_H_ */
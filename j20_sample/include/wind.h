@@ -0,0 +1,141 @@
+/**
+ * @file wind.h
+ * @brief Wind noise detector driving a low-shelf in a PRE_BQ slot
+ *
+ * Detection runs every frame on the DMIC0 input the DSP just consumed, with
+ * two one-pole filters and three energy sums, so it can stay on:
+ *   - low-band level: below WIND_LO_HZ, over WIND_LEVEL_DB re full scale
+ *   - spectral slope: the low band WIND_SLOPE_DB over the band above
+ *     WIND_HI_HZ; wind falls much faster with frequency than speech
+ *   - coherence, when a second microphone block is given: wind is
+ *     turbulence at each port and so uncorrelated between microphones,
+ *     while sound at these wavelengths reaches both alike. A low band
+ *     correlation over WIND_COH vetoes the detection. With one microphone,
+ *     loud sustained bass such as mains hum is taken for wind.
+ * Wind must hold for WIND_ATTACK frames and is released WIND_HANG frames
+ * after it stops. While it lasts, the target attenuation grows one
+ * WIND_STEP_DB step for every WIND_STEP_DB the low band is above the
+ * threshold, up to WIND_STEPS steps.
+ *
+ * The attenuation is applied by the DSP, ahead of its WDRC, through the
+ * first PRE_BQ slot the fitting leaves free. The section is a low shelf at
+ * WIND_SHELF_HZ designed on the MCU by WIND_Shelf(); the application
+ * reloads it from the main loop only when the target step changes, at most
+ * once per WIND_UPDATE frames. State in
+ * UPLOAD.MISC[WIND_DUMP_MISC]:
+ *   bit 0      wind detected
+ *   bit 1      no free PRE_BQ slot
+ *   bits 4-7   target step
+ *   bits 8-15  low-band over high-band slope in dB, 0..127
+ */
+
+#ifndef INCLUDE_WIND_H_
+#define INCLUDE_WIND_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define WIND_DETECT                 0x01
+#define WIND_NO_SLOT                0x02
+
+#define WIND_DUMP_MISC              8       /* UPLOAD.MISC entry */
+
+#define WIND_LO_HZ                  300.0
+#define WIND_HI_HZ                  2000.0
+#define WIND_LEVEL_DB               (-50.0) /* low band re a full-scale sine */
+#define WIND_SLOPE_DB               20.0
+#define WIND_COH                    0.5
+#define WIND_ATTACK                 20      /* 20 ms */
+#define WIND_HANG                   488     /* 500 ms */
+
+#define WIND_STEPS                  3
+#define WIND_STEP_DB                6.0
+#define WIND_SHELF_HZ               400.0
+#define WIND_UPDATE                 195     /* frames between shelf loads, 200 ms */
+
+/* Fixed-point parameters compiled on the MCU */
+typedef struct
+{
+    Word16 lo_coef;                     /* one-pole low-pass coefficients, Q15 */
+    Word16 hi_coef;
+    Word32 level;                       /* low-band threshold, log2 power Q8 */
+    Word32 slope;                       /* log2 Q8 */
+    Word32 step;                        /* WIND_STEP_DB, log2 Q8 */
+    Word32 coh;                         /* log2 of WIND_COH^2, Q8 */
+} WIND_Config_t;
+
+typedef struct
+{
+    WIND_Config_t cfg;
+    Word32 lp_lo;                       /* one-pole states */
+    Word32 lp_hi;
+    Word32 lp_lo2;
+    int64_t xx, hh;                     /* smoothed band energies */
+    int64_t yy, xy;                     /* smoothed mic2 and cross products */
+    Word32 l_lo;                        /* last levels, log2 power Q8 */
+    Word32 l_hi;
+    int run;                            /* frames in a row with wind */
+    int hang;
+    int flags;
+    int target;                         /* attenuation steps wanted */
+    bool no_slot;                       /* set from the main loop */
+} WIND_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the band edges and thresholds
+ * @note  Runs on the MCU in floating point.
+ */
+void WIND_Parser(WIND_Config_t *cfg);
+
+/**
+ * @brief Reset the detector and apply a configuration
+ */
+void WIND_Init(WIND_State_t *wind, const WIND_Config_t *cfg);
+
+/**
+ * @brief Update the decision from one input block
+ * @param mic2  second microphone block, or NULL with one microphone
+ */
+void WIND_Process(WIND_State_t *wind, const Word32 *mic, const Word32 *mic2);
+
+/**
+ * @brief Design the PRE_BQ low shelf for an attenuation step
+ * @param sos   b0 b1 b2 a0 a1 a2, the MCU_Config_FILTER layout, a0 = 1
+ * @note  Runs on the MCU in floating point; step 0 is a unity section.
+ */
+void WIND_Shelf(int step, double sos[6]);
+
+/**
+ * @brief Publish the state in UPLOAD.MISC
+ */
+void WIND_Dump(const WIND_State_t *wind, SM_UPLOAD_DATA *upload);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_WIND_H_ */
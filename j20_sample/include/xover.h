@@ -0,0 +1,122 @@
+/**
+ * @file xover.h
+ * @brief Power-complementary crossover filterbank for 4..16 WDRC bands
+ *
+ * Each crossover is a third-order Butterworth pair built from two allpass
+ * branches, LP = (A0 + A1)/2 and HP = (A0 - A1)/2, so |LP|^2 + |HP|^2 = 1
+ * and LP + HP = A0. The crossovers are cascaded from the lowest frequency
+ * up: crossover k takes band k-1 from its low side and passes the high
+ * side on. The merge sums the bands in Horner form, running the partial
+ * sum through a copy of each A0 on the way, which makes the output the
+ * product of all A0: flat magnitude and one allpass per crossover.
+ *
+ * Split and merge both cost a fixed number of multiplies per crossover,
+ * so the total scales linearly with MCU_WDRC.BandNum. Coefficients are
+ * designed on the MCU from MCU_WDRC.CrossOverFreq; missing or unordered
+ * frequencies fall back to a log spacing over XO_FREQ_LOW..XO_FREQ_HIGH.
+ * XO_Gain() applies the linear WDRC gain (tkgain) per band between the two.
+ */
+
+#ifndef INCLUDE_XOVER_H_
+#define INCLUDE_XOVER_H_
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include "osj20.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define XO_MIN_BANDS                4
+#define XO_MAX_BANDS                16
+#define XO_HEADROOM                 3       /* bits kept free for allpass peaks */
+#define XO_FREQ_LOW                 250.0   /* Hz, default spacing */
+#define XO_FREQ_HIGH                8000.0
+#define XO_GAIN_MAX_DB              40.0
+
+/* Fixed-point parameters compiled from MCU_Config_WDRC */
+typedef struct
+{
+    int bands;
+    Word32 a0[XO_MAX_BANDS - 1];        /* first-order allpass, Q30 */
+    Word32 d1[XO_MAX_BANDS - 1];        /* second-order allpass, Q30 */
+    Word32 d2[XO_MAX_BANDS - 1];
+    Word32 gain[XO_MAX_BANDS];          /* band gain, Q16 */
+} XO_Config_t;
+
+/* Allpass states: first-order x1,y1 and second-order x1,x2,y1,y2 */
+typedef struct
+{
+    Word32 a0[2];
+    Word32 a1[4];
+    Word32 comp[2];                     /* merge compensation, a copy of A0 */
+} XO_Section_t;
+
+typedef struct
+{
+    XO_Config_t cfg;
+    XO_Section_t sec[XO_MAX_BANDS - 1];
+    Word16 trim;                        /* broadband trim on the band gains, Q15 */
+} XO_State_t;
+
+/* ---------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Design the crossovers for BandNum bands from CrossOverFreq
+ * @note  Runs on the MCU in floating point.
+ */
+void XO_Parser(const MCU_Config_WDRC *Cfg, XO_Config_t *xo);
+
+/**
+ * @brief Clear the filter states and apply a configuration
+ */
+void XO_Init(XO_State_t *xo, const XO_Config_t *cfg);
+
+/**
+ * @brief Apply a new configuration; the states restart if the band count changes
+ */
+void XO_SetConfig(XO_State_t *xo, const XO_Config_t *cfg);
+
+/**
+ * @brief Scale all band gains, e.g. down during own voice
+ */
+void XO_SetTrim(XO_State_t *xo, Word16 trim);
+
+/**
+ * @brief Split one block into cfg.bands bands, low to high
+ * @note  Band samples carry XO_HEADROOM bits of headroom.
+ */
+void XO_Split(XO_State_t *xo, const Word32 *in, Word32 band[][AUDIO_BLOCK_SIZE]);
+
+/**
+ * @brief Scale each band by its gain, one multiply per band per sample
+ */
+void XO_Gain(const XO_State_t *xo, Word32 band[][AUDIO_BLOCK_SIZE]);
+
+/**
+ * @brief Sum the bands back into one block; the bands are used as scratch
+ */
+void XO_Merge(XO_State_t *xo, Word32 band[][AUDIO_BLOCK_SIZE], Word32 *out);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif /* INCLUDE_XOVER_H_ */
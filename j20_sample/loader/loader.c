@@ -15,41 +15,531 @@
  * @endparblock
  */
 
+#include <stdbool.h>
 #include <string.h>
 #include <hw.h>
 #include "loader.h"
+#include "cycle_count.h"
+
+#if LOAD_DMA_ENABLED
+/* Memory to memory in 32-bit words, polled for completion */
+#define LOAD_DMA_CFG                (DMA_LITTLE_ENDIAN               | \
+                                     DEST_TRANS_LENGTH_SEL           | \
+                                     DMA_PRIORITY_0                  | \
+                                     DMA_SRC_ALWAYS_ON               | \
+                                     DMA_DEST_ALWAYS_ON              | \
+                                     WORD_SIZE_32BITS_TO_32BITS      | \
+                                     DMA_SRC_ADDR_INCR_1             | \
+                                     DMA_DEST_ADDR_INCR_1            | \
+                                     DMA_SRC_ADDR_LSB_TOGGLE_DISABLE | \
+                                     DMA_CNT_INT_DISABLE             | \
+                                     DMA_COMPLETE_INT_DISABLE)
+#endif /* LOAD_DMA_ENABLED */
+
+/* Bytes decoded between writes out of the window; the window holds these
+ * and the LOAD_LZ_MAX_OFFSET bytes matches may reach back to */
+#define LOAD_LZ_FLUSH               (LOAD_LZ_WINDOW - LOAD_LZ_MAX_OFFSET)
+#define LOAD_LZ_MASK                (LOAD_LZ_WINDOW - 1)
+
+/* The CRC-CCITT of the file system; bytes go in in memory order */
+#define LOAD_CRC_CONFIG             (CRC_LITTLE_ENDIAN | CRC_BIT_ORDER_STANDARD)
+
+/* One list of sections being copied */
+typedef struct
+{
+    const memoryDescription *entry;     /* section in progress, NULL between */
+    uint32_t next;                      /* index of the next section */
+    uint8_t *dst;
+    const uint8_t *src;
+    uint32_t size;                      /* bytes left to queue */
+    uint32_t start;                     /* cycle count at the first byte */
+    uint32_t packed;                    /* bytes of the section in MRAM */
+    const loadSectionHeader *header;    /* section with a header, or NULL */
+    bool running;                       /* a DMA transfer is in flight */
+} loadJob;
+
+/* Output of a compressed section on its way through the window */
+typedef struct
+{
+    uint8_t *dst;                       /* where the next flush goes */
+    uint32_t skip;                      /* leading bytes still to drop */
+    uint32_t head;                      /* bytes decoded */
+    uint32_t flushed;                   /* bytes written out of the window */
+} loadLZOutput;
+
+static uint8_t lzWindow[LOAD_LZ_WINDOW];
+
+static loadStatus status;
+static memoryOverview *fallbackImage;
+
+/* Regions left out of loadDSPMemory, and the image they are still due from */
+static const overlayRegion *const *deferredRegions;
+static uint32_t deferredCount;
+static memoryOverview *deferredImage;
+static volatile uint16_t *deferredControl;
+
+#if LOAD_TIME_LOG_ENABLED
+static loadTimeLog timeLog;
+#endif /* LOAD_TIME_LOG_ENABLED */
+
+/* Overlay manifests collected by sections.ld */
+extern const overlayManifest __dsp_overlay_start__[];
+extern const overlayManifest __dsp_overlay_end__[];
 
 /**
- * @brief       This loads a single PRAM descriptor into the LPDSP32 PRAM
- * @param[in]   descriptor  The descriptor for the memory area to be
- *                          copied.
+ * @brief       Copies a block byte-wise up to the first aligned destination
+ *              word, then in 32-bit words, then the tail byte-wise
+ * @param[in]   dst     Destination in CM33 space
+ * @param[in]   src     Source
+ * @param[in]   size    Number of bytes
  */
-void loadSinglePRAMEntry(memoryDescription *descriptor, uint8_t core)
+static void copyWords(uint8_t *dst, const uint8_t *src, uint32_t size)
 {
-	uint32_t memSize = (descriptor->memSize * CM33_PM_LOADED_WORD_IN_BYTE / LPDSP_PM_WORD_IN_BYTE);
-	if (core == 0) {
-		memcpy((void *) (DSP0_PM_BASE + ((descriptor->vAddress * 2) & 0xFFFF)),
-			   descriptor->buffer, memSize);
-	}
-	else if (core == 1) {
-		// DSP1_PM_BASE points to the DSP1 program memory area which
-		// takes into account the different configuration of the program
-		// memory for Core 1 (2) this allows us to simply copy in the buffer.
-		memcpy((void *) (DSP1_PM_BASE + ((descriptor->vAddress * 2) & 0xFFFF)),
-			   descriptor->buffer, memSize);
-	}
+    while (size && ((uintptr_t)dst & 0x3))
+    {
+        *dst++ = *src++;
+        size--;
+    }
+
+    if (((uintptr_t)src & 0x3) == 0)
+    {
+        uint32_t *d = (uint32_t *)dst;
+        const uint32_t *s = (const uint32_t *)src;
+        uint32_t n = size >> 2;
+
+        for (; n >= 4; n -= 4)
+        {
+            d[0] = s[0];
+            d[1] = s[1];
+            d[2] = s[2];
+            d[3] = s[3];
+            d += 4;
+            s += 4;
+        }
+        while (n--)
+        {
+            *d++ = *s++;
+        }
+        dst = (uint8_t *)d;
+        src = (const uint8_t *)s;
+        size &= 0x3;
+    }
+
+    while (size)
+    {
+        *dst++ = *src++;
+        size--;
+    }
 }
 
 /**
- * @brief       Loads the LPDSP32 PRAM with all the program sections.
- * @param[in]   pram    A memory overview object which provides a list of
- *                      memory sections which need to be copied
+ * @brief       Feeds bytes to the CRC block without copying them
  */
-static void loadDSPPRAM(memoryOverviewEntry *pram, uint8_t core)
+static void crcBytes(const uint8_t *src, uint32_t size)
 {
-    for (unsigned int i = 0; i < pram->count; i++)
+    while (size--)
+    {
+        CRC->ADD_8 = *src++;
+    }
+}
+
+/**
+ * @brief       copyWords, feeding every byte to the CRC block on the way
+ * @param[in]   dst     Destination in CM33 space
+ * @param[in]   src     Source
+ * @param[in]   size    Number of bytes
+ */
+static void copyWordsCRC(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+    while (size && ((uintptr_t)dst & 0x3))
+    {
+        CRC->ADD_8 = *src;
+        *dst++ = *src++;
+        size--;
+    }
+
+    if (((uintptr_t)src & 0x3) == 0)
+    {
+        uint32_t *d = (uint32_t *)dst;
+        const uint32_t *s = (const uint32_t *)src;
+        uint32_t n = size >> 2;
+
+        while (n--)
+        {
+            uint32_t w = *s++;
+
+            CRC->ADD_32 = w;
+            *d++ = w;
+        }
+        dst = (uint8_t *)d;
+        src = (const uint8_t *)s;
+        size &= 0x3;
+    }
+
+    while (size)
     {
-        loadSinglePRAMEntry(&pram->entries[i], core);
+        CRC->ADD_8 = *src;
+        *dst++ = *src++;
+        size--;
+    }
+}
+
+/**
+ * @brief       Recognizes a section with a header, compressed or stored
+ * @param[in]   buffer  The buffer of the section's descriptor
+ * @param[in]   size    Bytes of the buffer before packing
+ * @return      The header, or NULL for a raw section
+ */
+static const loadSectionHeader *sectionHeader(const void *buffer, uint32_t size)
+{
+    const loadSectionHeader *header = buffer;
+
+    if (size == 0 || ((uintptr_t)buffer & 0x3) != 0)
+    {
+        return NULL;
+    }
+    if (header->rawSize != size)
+    {
+        return NULL;
+    }
+    if (header->magic == LOAD_RAW_MAGIC && header->packedSize == size)
+    {
+        return header;
+    }
+    return (header->magic == LOAD_LZ_MAGIC) ? header : NULL;
+}
+
+/**
+ * @brief       Writes the window out up to the last byte decoded
+ * @note        Flushes start on a multiple of LOAD_LZ_FLUSH, so the range
+ *              never wraps.
+ */
+static void flushWindow(loadLZOutput *out)
+{
+    const uint8_t *src = &lzWindow[out->flushed & LOAD_LZ_MASK];
+    uint32_t n = out->head - out->flushed;
+
+    out->flushed = out->head;
+    if (n <= out->skip)
+    {
+        crcBytes(src, n);
+        out->skip -= n;
+        return;
+    }
+    crcBytes(src, out->skip);
+    src += out->skip;
+    n -= out->skip;
+    out->skip = 0;
+    copyWordsCRC(out->dst, src, n);
+    out->dst += n;
+}
+
+/**
+ * @brief       Appends n literal bytes to the window
+ */
+static void putLiterals(loadLZOutput *out, const uint8_t *src, uint32_t n)
+{
+    while (n)
+    {
+        uint32_t k = LOAD_LZ_FLUSH - (out->head - out->flushed);
+
+        if (k > n)
+        {
+            k = n;
+        }
+        memcpy(&lzWindow[out->head & LOAD_LZ_MASK], src, k);
+        out->head += k;
+        src += k;
+        n -= k;
+        if (out->head - out->flushed == LOAD_LZ_FLUSH)
+        {
+            flushWindow(out);
+        }
+    }
+}
+
+/**
+ * @brief       Appends n bytes copied from offset bytes back
+ * @note        A match closer than its length overlaps its own output and
+ *              is copied forward byte by byte, or filled for offset 1.
+ */
+static void putMatch(loadLZOutput *out, uint32_t offset, uint32_t n)
+{
+    while (n)
+    {
+        uint32_t from = out->head - offset;
+        uint32_t k = LOAD_LZ_FLUSH - (out->head - out->flushed);
+        uint32_t wrap = LOAD_LZ_WINDOW - (from & LOAD_LZ_MASK);
+        uint8_t *d = &lzWindow[out->head & LOAD_LZ_MASK];
+        const uint8_t *s = &lzWindow[from & LOAD_LZ_MASK];
+
+        if (k > n)
+        {
+            k = n;
+        }
+        if (k > wrap)
+        {
+            k = wrap;
+        }
+        out->head += k;
+        n -= k;
+        if (offset >= k && k >= 16)
+        {
+            memcpy(d, s, k);
+        }
+        else if (offset == 1)
+        {
+            memset(d, *s, k);
+        }
+        else
+        {
+            while (k--)
+            {
+                *d++ = *s++;
+            }
+        }
+        if (out->head - out->flushed == LOAD_LZ_FLUSH)
+        {
+            flushWindow(out);
+        }
+    }
+}
+
+/**
+ * @brief       Reads the extra length bytes of an LZ4 sequence
+ * @return      The sum, or a length no section holds past the end
+ */
+static uint32_t readLength(const uint8_t **src, const uint8_t *end)
+{
+    uint32_t n = 0;
+    uint8_t b;
+
+    do
+    {
+        if (*src >= end)
+        {
+            return 0x7FFFFFFF;
+        }
+        b = *(*src)++;
+        n += b;
+    } while (b == 255);
+    return n;
+}
+
+/**
+ * @brief       Unpacks a compressed section straight into PRAM or DRAM
+ * @param[in]   dst     Destination in CM33 space
+ * @param[in]   header  The compressed section
+ * @param[in]   skip    Leading bytes of the raw buffer that are not loaded
+ * @return      true if the whole raw buffer came out
+ * @note        Each sequence is checked against the section, the packed
+ *              data and the window; a corrupt section stops at the first
+ *              bad one. The raw bytes, skipped ones included, go to the CRC
+ *              block as they leave the window.
+ */
+static bool unpackSection(uint8_t *dst, const loadSectionHeader *header, uint32_t skip)
+{
+    const uint8_t *src = (const uint8_t *)(header + 1);
+    const uint8_t *end = src + header->packedSize;
+    loadLZOutput out = { dst, skip, 0, 0 };
+
+    while (src < end)
+    {
+        uint32_t token = *src++;
+        uint32_t n = token >> 4;
+        uint32_t offset;
+
+        if (n == 15)
+        {
+            n += readLength(&src, end);
+        }
+        if (n > (uint32_t)(end - src) || n > header->rawSize - out.head)
+        {
+            break;
+        }
+        putLiterals(&out, src, n);
+        src += n;
+
+        /* The last sequence has literals only */
+        if (end - src < 2)
+        {
+            break;
+        }
+        offset = src[0] | ((uint32_t)src[1] << 8);
+        src += 2;
+        n = (token & 15) + 4;
+        if ((token & 15) == 15)
+        {
+            n += readLength(&src, end);
+        }
+        if (offset == 0 || offset > LOAD_LZ_MAX_OFFSET || offset > out.head ||
+            n > header->rawSize - out.head)
+        {
+            break;
+        }
+        putMatch(&out, offset, n);
+    }
+    flushWindow(&out);
+    return out.head == header->rawSize;
+}
+
+/**
+ * @brief       Copies or unpacks a section with a header, checking its CRC
+ *              in the same pass
+ * @param[in]   dst     Destination in CM33 space
+ * @param[in]   header  The section
+ * @param[in]   skip    Leading bytes of the raw buffer that are not loaded
+ * @return      true if the CRC of the raw buffer matches the header
+ */
+static bool loadSection(uint8_t *dst, const loadSectionHeader *header, uint32_t skip)
+{
+    const uint8_t *src = (const uint8_t *)(header + 1);
+    bool complete = true;
+
+    SYS_CRC_CONFIG(LOAD_CRC_CONFIG);
+    CRC->VALUE = CRC_CCITT_INIT_VALUE;
+    if (header->magic == LOAD_LZ_MAGIC)
+    {
+        complete = unpackSection(dst, header, skip);
+    }
+    else
+    {
+        crcBytes(src, skip);
+        copyWordsCRC(dst, src + skip, header->rawSize - skip);
+    }
+    return complete && (uint16_t)CRC->FINAL == (uint16_t)header->crc;
+}
+
+/**
+ * @brief       Records a section that failed its CRC
+ * @param[in]   memory  LOAD_MEMORY_PM or LOAD_MEMORY_DM
+ */
+static void reportFailure(uint8_t memory, const memoryDescription *entry)
+{
+    if (status.failures++ == 0)
+    {
+        status.vAddress = entry->vAddress;
+        status.memory = memory;
+    }
+}
+
+#if LOAD_TIME_LOG_ENABLED
+/**
+ * @brief       Records the time a section took
+ */
+static void logSection(loadTimeEntry *list, uint32_t *count, const loadJob *job, uint32_t size)
+{
+    if (*count < LOAD_TIME_LOG_MAX_SECTIONS)
+    {
+        list[*count].vAddress = job->entry->vAddress;
+        list[*count].size = size;
+        list[*count].packed = job->packed;
+        list[*count].us = Cycle_Count_Since(job->start) / (SystemCoreClock / 1000000);
+        (*count)++;
+    }
+}
+#endif /* LOAD_TIME_LOG_ENABLED */
+
+/**
+ * @brief       Maps a PRAM descriptor to its CM33 address
+ * @return      The CM33 address, or NULL for an unknown core
+ */
+static uint8_t *mapPRAM(const memoryDescription *descriptor, uint8_t core)
+{
+    uint32_t offset = (descriptor->vAddress * 2) & 0xFFFF;
+
+    if (core == 0)
+    {
+        return (uint8_t *)(DSP0_PM_BASE + offset);
+    }
+    else if (core == 1)
+    {
+        // DSP1_PM_BASE points to the DSP1 program memory area which
+        // takes into account the different configuration of the program
+        // memory for Core 1 (2) this allows us to simply copy in the buffer.
+        return (uint8_t *)(DSP1_PM_BASE + offset);
+    }
+    return NULL;
+}
+
+/**
+ * @brief       Number of bytes a PRAM descriptor loads
+ */
+static uint32_t sizePRAM(const memoryDescription *descriptor)
+{
+    return descriptor->memSize * CM33_PM_LOADED_WORD_IN_BYTE / LPDSP_PM_WORD_IN_BYTE;
+}
+
+/**
+ * @brief       Checks whether a PRAM descriptor lies wholly inside a region
+ */
+static bool inRegion(const overlayRegion *region, const memoryDescription *descriptor)
+{
+    uint32_t offset = (descriptor->vAddress * 2) & 0xFFFF;
+    uint32_t size = sizePRAM(descriptor);
+
+    return offset >= region->offset && size <= region->size &&
+           offset - region->offset <= region->size - size;
+}
+
+/**
+ * @brief       Checks whether a PRAM descriptor shares any byte with a region
+ */
+static bool overlapsRegion(const overlayRegion *region, const memoryDescription *descriptor)
+{
+    uint32_t offset = (descriptor->vAddress * 2) & 0xFFFF;
+    uint32_t size = sizePRAM(descriptor);
+
+    return size > 0 && offset < region->offset + region->size && region->offset < offset + size;
+}
+
+/**
+ * @brief       Checks whether a PRAM descriptor is left for loadDeferred()
+ */
+static bool isDeferred(const memoryDescription *descriptor)
+{
+    for (uint32_t i = 0; i < deferredCount; i++)
+    {
+        if (inRegion(deferredRegions[i], descriptor))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief       Loads a single PRAM descriptor
+ * @return      false if the section failed its CRC
+ */
+static bool loadPRAMEntry(const memoryDescription *descriptor, uint8_t core)
+{
+    uint8_t *dst = mapPRAM(descriptor, core);
+    uint32_t size = sizePRAM(descriptor);
+    const loadSectionHeader *header = sectionHeader(descriptor->buffer, size);
+
+    if (dst == NULL)
+    {
+        return true;
+    }
+    if (header == NULL)
+    {
+        copyWords(dst, descriptor->buffer, size);
+        return true;
+    }
+    return loadSection(dst, header, 0);
+}
+
+/**
+ * @brief       This loads a single PRAM descriptor into the LPDSP32 PRAM
+ * @param[in]   descriptor  The descriptor for the memory area to be
+ *                          copied.
+ */
+void loadSinglePRAMEntry(memoryDescription *descriptor, uint8_t core)
+{
+    if (!loadPRAMEntry(descriptor, core))
+    {
+        reportFailure(LOAD_MEMORY_PM, descriptor);
     }
 }
 
@@ -85,29 +575,26 @@ static uint32_t mapToCM33Space(uint32_t vAddress)
 }
 
 /**
- * @brief       Helper method to copy a single block of DRAM to the LPDSP32
+ * @brief       Sets up the copy of a single block of DRAM
+ * @param[in]   job     The job to point at the block
  * @param[in]   dram    A memory descriptor defining the block of memory to
  *                      be copied
  */
-static void initializeDSPDRAM(memoryDescription *dram)
+static void beginDSPDRAM(loadJob *job, const memoryDescription *dram)
 {
-    uint32_t size;
-    uint32_t dspAddress;
+    uint32_t dspAddress = mapToCM33Space(dram->vAddress);
 
-    size = dram->fileSize;
-    dspAddress = mapToCM33Space(dram->vAddress);
-
-    if (size > 0)
+    /* If the dspAddress is not word aligned, skip the initial bytes added
+     * as padding by the elfConverter script */
+    job->entry = dram;
+    job->dst = (uint8_t *)dspAddress;
+    job->src = (const uint8_t *)dram->buffer + (dspAddress & 0x3);
+    job->size = dram->fileSize;
+    job->packed = dram->fileSize;
+    job->header = sectionHeader(dram->buffer, dram->fileSize + (dspAddress & 0x3));
+    if (job->header != NULL)
     {
-        /* If the dspAddress is not word aligned, skip the initial bytes added
-         * as padding by the elfConverter script */
-        unsigned char *src = dram->buffer + (dspAddress & 0x3);
-        unsigned char *dst = (unsigned char *)dspAddress;
-        while (size)
-        {
-            *dst++ = *src++;
-            size--;
-        }
+        job->packed = sizeof(loadSectionHeader) + job->header->packedSize;
     }
 }
 
@@ -118,8 +605,217 @@ static void initializeDSPDRAM(memoryDescription *dram)
  */
 void loadDSPDRAM(memoryOverviewEntry *dma_cntx, memoryOverviewEntry *dmb_cntx)
 {
-    for (int i = 0; i < dma_cntx->count; i++) initializeDSPDRAM(&dma_cntx->entries[i]);
-    for (int i = 0; i < dmb_cntx->count; i++) initializeDSPDRAM(&dmb_cntx->entries[i]);
+    memoryOverviewEntry *list[2] = { dma_cntx, dmb_cntx };
+    loadJob job;
+
+    for (int l = 0; l < 2; l++)
+    {
+        for (unsigned int i = 0; i < list[l]->count; i++)
+        {
+            beginDSPDRAM(&job, &list[l]->entries[i]);
+            if (job.header != NULL)
+            {
+                if (!loadSection(job.dst, job.header, (uintptr_t)job.dst & 0x3))
+                {
+                    reportFailure(LOAD_MEMORY_DM, job.entry);
+                }
+            }
+            else
+            {
+                copyWords(job.dst, job.src, job.size);
+            }
+        }
+    }
+}
+
+/**
+ * @brief       Queues the next part of the PRAM section in progress
+ * @note        With the DMA, up to LOAD_DMA_MAX_WORDS words go to the
+ *              channel; without it, the CM33 copies the rest of the section.
+ */
+static void startPRAMCopy(loadJob *job)
+{
+#if LOAD_DMA_ENABLED
+    uint32_t words = job->size >> 2;
+
+    if (words > LOAD_DMA_MAX_WORDS)
+    {
+        words = LOAD_DMA_MAX_WORDS;
+    }
+    Sys_DMA_ChannelConfig(LOAD_DMA, LOAD_DMA_CFG, words, 0,
+                          (uint32_t)job->src, (uint32_t)job->dst);
+    Sys_DMA_Mode_Enable(LOAD_DMA, DMA_ENABLE);
+    job->running = true;
+    job->dst += words << 2;
+    job->src += words << 2;
+    job->size -= words << 2;
+#else
+    copyWords(job->dst, job->src, job->size);
+    job->size = 0;
+#endif /* LOAD_DMA_ENABLED */
+}
+
+/**
+ * @brief       Checks whether the PRAM transfer in flight has completed
+ */
+static bool donePRAMCopy(loadJob *job)
+{
+#if LOAD_DMA_ENABLED
+    if (job->running)
+    {
+        if ((LOAD_DMA->STATUS & DMA_COMPLETE_INT_TRUE) != DMA_COMPLETE_INT_TRUE)
+        {
+            return false;
+        }
+        LOAD_DMA->STATUS = DMA_COMPLETE_INT_CLEAR;
+        Sys_DMA_Mode_Enable(LOAD_DMA, DMA_DISABLE);
+        job->running = false;
+    }
+#else
+    (void)job;
+#endif /* LOAD_DMA_ENABLED */
+    return true;
+}
+
+/**
+ * @brief       Advances the PRAM load by one step
+ * @param[in]   job     PRAM progress
+ * @param[in]   pram    A memory overview object which provides a list of
+ *                      memory sections which need to be copied
+ * @return      false once every section is in PRAM
+ */
+static bool stepDSPPRAM(loadJob *job, memoryOverviewEntry *pram, uint8_t core)
+{
+    if (!donePRAMCopy(job))
+    {
+        return true;
+    }
+
+    if (job->size > 0)
+    {
+        startPRAMCopy(job);
+        return true;
+    }
+
+    if (job->entry != NULL)
+    {
+#if LOAD_TIME_LOG_ENABLED
+        logSection(timeLog.PM, &timeLog.PM_count, job, sizePRAM(job->entry));
+#endif /* LOAD_TIME_LOG_ENABLED */
+        job->entry = NULL;
+    }
+
+    while (job->next < pram->count)
+    {
+        const memoryDescription *entry = &pram->entries[job->next++];
+        uint32_t size = sizePRAM(entry);
+        uint8_t *dst = mapPRAM(entry, core);
+        const uint8_t *src = entry->buffer;
+
+        if (dst == NULL || size == 0 || isDeferred(entry))
+        {
+            continue;
+        }
+
+        job->entry = entry;
+        job->start = Cycle_Count_Get();
+        job->packed = size;
+        job->header = sectionHeader(src, size);
+        if (job->header != NULL)
+        {
+            /* Checking the CRC keeps the CM33 on the copy; the DMA has
+             * nothing to do */
+            if (!loadSection(dst, job->header, 0))
+            {
+                reportFailure(LOAD_MEMORY_PM, entry);
+            }
+            job->packed = sizeof(loadSectionHeader) + job->header->packedSize;
+            job->size = 0;
+            return true;
+        }
+#if LOAD_DMA_ENABLED
+        {
+            /* The CM33 copies the unaligned head and tail, the DMA the
+             * words in between */
+            uint32_t head = (0 - (uintptr_t)dst) & 0x3;
+            uint32_t tail;
+
+            if (head > size)
+            {
+                head = size;
+            }
+            copyWords(dst, src, head);
+            dst += head;
+            src += head;
+            size -= head;
+
+            tail = ((uintptr_t)src & 0x3) ? size : (size & 0x3);
+            copyWords(dst + size - tail, src + size - tail, tail);
+            size -= tail;
+        }
+#endif /* LOAD_DMA_ENABLED */
+        job->dst = dst;
+        job->src = src;
+        job->size = size;
+        if (size > 0)
+        {
+            startPRAMCopy(job);
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief       Advances the DRAM load by up to LOAD_CPU_CHUNK bytes
+ * @param[in]   job     DRAM progress, numbering DMA sections before DMB
+ * @return      false once every section is in DRAM
+ */
+static bool stepDSPDRAM(loadJob *job, memoryOverviewEntry *dma_cntx, memoryOverviewEntry *dmb_cntx)
+{
+    uint32_t n;
+
+    if (job->entry != NULL && job->size == 0)
+    {
+#if LOAD_TIME_LOG_ENABLED
+        logSection(timeLog.DM, &timeLog.DM_count, job, job->entry->fileSize);
+#endif /* LOAD_TIME_LOG_ENABLED */
+        job->entry = NULL;
+    }
+
+    if (job->entry == NULL)
+    {
+        if (job->next >= dma_cntx->count + dmb_cntx->count)
+        {
+            return false;
+        }
+        if (job->next < dma_cntx->count)
+        {
+            beginDSPDRAM(job, &dma_cntx->entries[job->next]);
+        }
+        else
+        {
+            beginDSPDRAM(job, &dmb_cntx->entries[job->next - dma_cntx->count]);
+        }
+        job->next++;
+        job->start = Cycle_Count_Get();
+        if (job->header != NULL)
+        {
+            if (!loadSection(job->dst, job->header, (uintptr_t)job->dst & 0x3))
+            {
+                reportFailure(LOAD_MEMORY_DM, job->entry);
+            }
+            job->size = 0;
+            return true;
+        }
+    }
+
+    n = (job->size < LOAD_CPU_CHUNK) ? job->size : LOAD_CPU_CHUNK;
+    copyWords(job->dst, job->src, n);
+    job->dst += n;
+    job->src += n;
+    job->size -= n;
+    return true;
 }
 
 /**
@@ -131,30 +827,257 @@ void resetLoopCache(void)
     SYSCTRL->CM33_LOOP_CACHE_CFG = 1;
 }
 
+/**
+ * @brief       Copies every section of an image
+ * @return      false if a section failed its CRC; the load stops there
+ */
+static bool loadImage(memoryOverview *overview, uint8_t core)
+{
+    loadJob pm = { 0 };
+    loadJob dm = { 0 };
+    bool pending;
+
+    deferredImage = overview;
+#if LOAD_TIME_LOG_ENABLED
+    memset(&timeLog, 0, sizeof(timeLog));
+#endif /* LOAD_TIME_LOG_ENABLED */
+
+    /* A resident section reaching into a deferred region would start
+     * half-loaded, or be overwritten by a variant; reject the image */
+    for (uint32_t i = 0; i < overview->PM_cntx.count; i++)
+    {
+        const memoryDescription *entry = &overview->PM_cntx.entries[i];
+
+        for (uint32_t r = 0; r < deferredCount; r++)
+        {
+            if (overlapsRegion(deferredRegions[r], entry) && !inRegion(deferredRegions[r], entry))
+            {
+                status.straddles++;
+                reportFailure(LOAD_MEMORY_PM, entry);
+                break;
+            }
+        }
+    }
+    if (status.failures > 0)
+    {
+        return false;
+    }
+#if LOAD_DMA_ENABLED
+    Sys_DMA_Mode_Enable(LOAD_DMA, DMA_DISABLE);
+    LOAD_DMA->STATUS = DMA_COMPLETE_INT_CLEAR;
+#endif /* LOAD_DMA_ENABLED */
+
+    do
+    {
+        pending = stepDSPPRAM(&pm, &overview->PM_cntx, core);
+        pending |= stepDSPDRAM(&dm, &overview->DMA_cntx, &overview->DMB_cntx);
+    } while (pending && status.failures == 0);
+
+    /* Leave the channel idle for the next image */
+    while (!donePRAMCopy(&pm))
+    {
+    }
+    return status.failures == 0;
+}
+
 /**
  * @brief       Generic loader that can be used to load simple programs
  *              from flash to the LPDSP32 PRAM and DRAM
  * @param[in]   overview    An overview object that contains the
  *                          specifications for all the PRAM and DRAM
  *                          sections to be copied.
+ * @note        The PRAM sections go through the DMA channel while the CM33
+ *              copies the DRAM sections, in LOAD_CPU_CHUNK pieces so the
+ *              channel is refilled promptly. Sections with a header are
+ *              copied or unpacked by the CM33 in one go, through the CRC
+ *              block. If one fails, the fallback image is loaded instead;
+ *              if that fails too, the DSP stays in reset. PRAM sections in
+ *              a deferred region are left for loadDeferred().
  */
 void loadDSPMemory(memoryOverview *overview, uint8_t core)
 {
+    bool ok;
+#if LOAD_TIME_LOG_ENABLED
+    uint32_t start;
+#endif /* LOAD_TIME_LOG_ENABLED */
+
     /* Set the TEST_GPIO_TIME_MRAM_MEMCPY to high */
 #if (LOAD_TIME_LOG_GPIO_ENABLED == 1)
     Sys_GPIO_Set_High(LOAD_TIME_LOG_GPIO);
 #endif /* LOAD_TIME_LOG_GPIO_ENABLED */
-    loadDSPPRAM(&overview->PM_cntx, core);
-    loadDSPDRAM(&overview->DMA_cntx, &overview->DMB_cntx);
+#if LOAD_TIME_LOG_ENABLED
+    Cycle_Count_Init();
+    start = Cycle_Count_Get();
+#endif /* LOAD_TIME_LOG_ENABLED */
+    memset(&status, 0, sizeof(status));
+
+    ok = loadImage(overview, core);
+    if (!ok && fallbackImage != NULL && fallbackImage != overview)
+    {
+        loadStatus failed = status;
+
+        status.failures = 0;
+        ok = loadImage(fallbackImage, core);
+        failed.failures += status.failures;
+        failed.straddles += status.straddles;
+        status = failed;
+        status.fallback = true;
+    }
+
+#if LOAD_TIME_LOG_ENABLED
+    timeLog.total_us = Cycle_Count_Since(start) / (SystemCoreClock / 1000000);
+#endif /* LOAD_TIME_LOG_ENABLED */
+
+    /* The image may have written Control; the deferred features stay off
+     * until loadDeferred() */
+    if (ok && deferredControl != NULL)
+    {
+        uint16_t bits = 0;
+
+        for (uint32_t i = 0; i < deferredCount; i++)
+        {
+            bits |= deferredRegions[i]->control;
+        }
+        status.held = *deferredControl & bits;
+        *deferredControl &= ~bits;
+    }
 
     /* Run LPDSP32 */
     resetLoopCache();
-    if (core == 0)
+    status.started = ok;
+    if (ok && core == 0)
     	DSP->CTRL[0] = DSP_RESET;
-    else if (core == 1)
+    else if (ok && core == 1)
     	DSP->CTRL[1] = DSP_RESET;
     /* Set the TEST_GPIO_TIME_MRAM_MEMCPY to low */
 #if (LOAD_TIME_LOG_GPIO_ENABLED == 1)
     Sys_GPIO_Set_Low(LOAD_TIME_LOG_GPIO);
 #endif /* LOAD_TIME_LOG_GPIO_ENABLED */
 }
+
+/**
+ * @brief       Outcome of the last loadDSPMemory
+ */
+const loadStatus *getLoadStatus(void)
+{
+    return &status;
+}
+
+/**
+ * @brief       Sets the image loadDSPMemory falls back to
+ * @param[in]   overview    A known-good image, or NULL for none
+ */
+void setLoadFallback(memoryOverview *overview)
+{
+    fallbackImage = overview;
+}
+
+/**
+ * @brief       Sets the regions loadDSPMemory leaves for loadDeferred()
+ * @param[in]   regions     The regions, or NULL for none
+ * @param[in]   count       Number of regions
+ * @param[in]   control     The Control word holding the regions' feature
+ *                          bits, or NULL
+ */
+void setLoadDeferred(const overlayRegion *const *regions, uint32_t count, volatile uint16_t *control)
+{
+    deferredRegions = regions;
+    deferredCount = (regions != NULL) ? count : 0;
+    deferredControl = control;
+}
+
+/**
+ * @brief       Loads the sections of the last image in one deferred region
+ * @param[in]   region  The region to fill
+ * @return      false if a section fails its CRC
+ * @note        The sections are copied or unpacked in one go; the DSP must
+ *              not run code from the region meanwhile.
+ */
+bool loadDeferred(const overlayRegion *region, uint8_t core)
+{
+    const memoryOverviewEntry *pram;
+
+    if (deferredImage == NULL)
+    {
+        return true;
+    }
+
+    pram = &deferredImage->PM_cntx;
+    for (unsigned int i = 0; i < pram->count; i++)
+    {
+        const memoryDescription *entry = &pram->entries[i];
+
+        if (sizePRAM(entry) > 0 && inRegion(region, entry) && !loadPRAMEntry(entry, core))
+        {
+            return false;
+        }
+    }
+
+    /* Drop loops the DSP cached before the region was filled */
+    resetLoopCache();
+    return true;
+}
+
+/**
+ * @brief       Section times of the last loadDSPMemory
+ */
+const loadTimeLog *getLoadTimeLog(void)
+{
+#if LOAD_TIME_LOG_ENABLED
+    return &timeLog;
+#else
+    return NULL;
+#endif /* LOAD_TIME_LOG_ENABLED */
+}
+
+/**
+ * @brief       Finds an overlay manifest by variant name
+ * @param[in]   name    The variant, e.g. "AFC_B"
+ * @return      The manifest, or NULL if no manifest has that name
+ */
+const overlayManifest *findOverlay(const char *name)
+{
+    for (const overlayManifest *m = __dsp_overlay_start__; m < __dsp_overlay_end__; m++)
+    {
+        if (strcmp(m->name, name) == 0)
+        {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief       Copies one overlay variant into its PRAM region
+ * @param[in]   overlay     The variant to load
+ * @return      false if a section falls outside the region, in which
+ *              case nothing is copied, or fails its CRC
+ * @note        Only the region is written, so the swap takes as long as
+ *              copying the variant. The DSP must not run code from the
+ *              region meanwhile.
+ */
+bool loadOverlay(const overlayManifest *overlay, uint8_t core)
+{
+    const overlayRegion *region = overlay->region;
+    const memoryOverviewEntry *sections = &overlay->sections;
+
+    for (unsigned int i = 0; i < sections->count; i++)
+    {
+        if (!inRegion(region, &sections->entries[i]))
+        {
+            return false;
+        }
+    }
+
+    for (unsigned int i = 0; i < sections->count; i++)
+    {
+        if (!loadPRAMEntry(&sections->entries[i], core))
+        {
+            return false;
+        }
+    }
+
+    /* Drop loops the DSP cached from the previous variant */
+    resetLoopCache();
+    return true;
+}
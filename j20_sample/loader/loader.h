@@ -18,6 +18,7 @@
 #ifndef LOADER_H_
 #define LOADER_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /* ----------------------------------------------------------------------------
@@ -43,6 +44,35 @@ extern "C"
     #define LOAD_TIME_LOG_GPIO          1
 #endif /* LOAD_TIME_LOG_GPIO_ENABLED */
 
+/* Flag that controls whether a DMA channel copies PRAM while the CM33 copies
+ * DRAM. The channel must be idle while loading; the audio path uses DMA2 and
+ * DMA3. */
+#define LOAD_DMA_ENABLED                1
+#if LOAD_DMA_ENABLED
+    /* The DMA channel used by the loader */
+    #define LOAD_DMA                    DMA0
+    /* Words per DMA transfer */
+    #define LOAD_DMA_MAX_WORDS          4096
+#endif /* LOAD_DMA_ENABLED */
+
+/* Bytes of DRAM the CM33 copies between checks on the DMA */
+#define LOAD_CPU_CHUNK                  512
+
+/* Flag that controls whether the loader records the time spent per section
+ * with the DWT cycle counter */
+#define LOAD_TIME_LOG_ENABLED           1
+#define LOAD_TIME_LOG_MAX_SECTIONS      16
+
+/* A compressed section is an LZ4 block behind a loadSectionHeader, made by
+ * tools/dsp_pack. Match offsets stay within LOAD_LZ_MAX_OFFSET, so the
+ * loader unpacks through a window of LOAD_LZ_WINDOW bytes and never reads
+ * PRAM or DRAM back. A stored section carries the raw bytes behind the same
+ * header. Either way the header holds the CRC the loader checks. */
+#define LOAD_LZ_MAGIC                   0x5A30324AUL    /* "J20Z" */
+#define LOAD_RAW_MAGIC                  0x5230324AUL    /* "J20R" */
+#define LOAD_LZ_WINDOW                  4096
+#define LOAD_LZ_MAX_OFFSET              (LOAD_LZ_WINDOW / 2)
+
 typedef struct
 {
     void *buffer;
@@ -51,6 +81,16 @@ typedef struct
     uint32_t vAddress;
 } memoryDescription;
 
+/* Replaces the contents of a section's buffer; the descriptor sizes stay
+ * those of the raw section */
+typedef struct
+{
+    uint32_t magic;         /* LOAD_LZ_MAGIC or LOAD_RAW_MAGIC */
+    uint32_t rawSize;       /* bytes of the buffer before packing */
+    uint32_t packedSize;    /* bytes that follow: the LZ4 block, or rawSize */
+    uint32_t crc;           /* CRC-CCITT of the raw bytes in the low half */
+} loadSectionHeader;
+
 typedef struct
 {
     memoryDescription *entries;
@@ -64,6 +104,58 @@ typedef struct
     memoryOverviewEntry DMB_cntx;
 } memoryOverview;
 
+typedef struct
+{
+    uint32_t vAddress;
+    uint32_t size;      /* bytes copied */
+    uint32_t packed;    /* bytes read from MRAM, header included */
+    uint32_t us;        /* from the first byte to the last */
+} loadTimeEntry;
+
+typedef struct
+{
+    loadTimeEntry PM[LOAD_TIME_LOG_MAX_SECTIONS];
+    loadTimeEntry DM[LOAD_TIME_LOG_MAX_SECTIONS];   /* DMA then DMB */
+    uint32_t PM_count;
+    uint32_t DM_count;
+    uint32_t total_us;  /* whole of the last loadDSPMemory */
+} loadTimeLog;
+
+#define LOAD_MEMORY_PM                  0
+#define LOAD_MEMORY_DM                  1
+
+/* Outcome of the last loadDSPMemory */
+typedef struct
+{
+    uint32_t failures;  /* sections whose CRC did not match, or that straddle */
+    uint32_t vAddress;  /* the first of them */
+    uint32_t straddles; /* PRAM sections partly inside a deferred region */
+    uint16_t held;      /* deferred Control bits cleared at the release */
+    uint8_t memory;     /* its memory, LOAD_MEMORY_PM or LOAD_MEMORY_DM */
+    bool fallback;      /* the fallback image was loaded instead */
+    bool started;       /* the DSP was released from reset */
+} loadStatus;
+
+/* A PRAM overlay region, declared in sections.ld */
+typedef struct
+{
+    const char *name;
+    uint32_t offset;    /* bytes into the core's PRAM */
+    uint32_t size;
+    uint16_t control;   /* SM_Ptr->Control bits of the features it holds */
+} overlayRegion;
+
+/* One variant of a region: the PRAM sections, raw or packed, that fill it.
+ * Define manifests with LOAD_OVERLAY_MANIFEST so findOverlay() sees them. */
+typedef struct
+{
+    const char *name;
+    const overlayRegion *region;
+    memoryOverviewEntry sections;
+} overlayManifest;
+
+#define LOAD_OVERLAY_MANIFEST   __attribute__((section(".dsp_overlay"), used, aligned(4)))
+
 /* Normally when loading the LPDSP32 we can just use this routine, added core
  * 0 or 1 for RSL20 LPDSP32 support */
 void loadDSPMemory(memoryOverview *overview, uint8_t core);
@@ -79,6 +171,41 @@ void loadSinglePRAMEntry(memoryDescription *descriptor, uint8_t core);
 
 void loadDSPDRAM(memoryOverviewEntry *dma_cntx, memoryOverviewEntry *dmb_cntx);
 
+/* Outcome of the last loadDSPMemory. A section with a header is checked
+ * against its CRC as it is copied; the load stops at the first that fails,
+ * loads the fallback image if one is set, and leaves the DSP in reset if
+ * that fails too. Sections without a header are not checked. */
+const loadStatus *getLoadStatus(void);
+
+/* Sets the known-good image loadDSPMemory falls back to, or NULL for none */
+void setLoadFallback(memoryOverview *overview);
+
+/* Sets the regions whose PRAM sections loadDSPMemory leaves out, so the DSP
+ * starts before they are in. Their features must stay off until
+ * loadDeferred() has filled the region: just before the DSP leaves reset,
+ * their bits are cleared in *control (NULL: not touched) and kept in
+ * loadStatus.held. An image with a section only partly inside a region is
+ * rejected like one that fails its CRC. NULL, 0 loads everything. */
+void setLoadDeferred(const overlayRegion *const *regions, uint32_t count, volatile uint16_t *control);
+
+/* Loads the sections of the last image that lie in one deferred region and
+ * resets the loop cache. Returns false if a section fails its CRC. The DSP
+ * must not run code from the region meanwhile. */
+bool loadDeferred(const overlayRegion *region, uint8_t core);
+
+/* Section times of the last loadDSPMemory, kept when LOAD_TIME_LOG_ENABLED.
+ * Sections beyond LOAD_TIME_LOG_MAX_SECTIONS are loaded but not logged. */
+const loadTimeLog *getLoadTimeLog(void);
+
+/* Finds an overlay manifest by variant name, NULL if there is none */
+const overlayManifest *findOverlay(const char *name);
+
+/* Copies one overlay variant into its region and resets the loop cache.
+ * Returns false, leaving PRAM untouched, if a section falls outside the
+ * region, and false with the region partly written if a section fails its
+ * CRC. The DSP must not run code from the region meanwhile. */
+bool loadOverlay(const overlayManifest *overlay, uint8_t core);
+
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
  * ------------------------------------------------------------------------- */
@@ -0,0 +1,339 @@
+/**
+ * @file dsp_pack.c
+ * @brief Host tool that packs an LPDSP32 section for the compressed loader
+ *
+ * Compresses one section buffer, as the elfConverter script writes it, into
+ * a loadSectionHeader followed by an LZ4 block whose matches reach back at
+ * most LOAD_LZ_MAX_OFFSET bytes, so loadDSPMemory can unpack it through its
+ * small window. Any LZ4 block decoder reads the output. A section that does
+ * not get smaller, or any section with -s, is stored raw behind the header
+ * instead. The header carries the CRC-CCITT of the raw bytes, which the
+ * loader checks as it copies. The descriptor keeps its sizes; only its
+ * buffer changes to the packed array.
+ *
+ * Usage:
+ *     dsp_pack [-s] [-n name] input.bin output.c   C array, 4-byte aligned
+ *     dsp_pack [-s] input.bin output.bin           raw packed bytes
+ *
+ * Build on the host:
+ *     cc -O2 -I j20_sample/loader -o dsp_pack tools/dsp_pack/dsp_pack.c
+ *
+ * The output is decoded again and compared before it is written, and the
+ * compression ratio is printed.
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "loader.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define PACK_MIN_MATCH              4
+#define PACK_LAST_LITERALS          5       /* LZ4: the block ends in literals */
+#define PACK_MF_LIMIT               12      /* LZ4: no match starts this close to the end */
+#define PACK_HASH_BITS              14
+#define PACK_DEPTH                  256     /* chain entries tried per position */
+
+/* ----------------------------------------------------------------------------
+ * Local Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief CRC-CCITT as the CRC block computes it: polynomial 0x1021, initial
+ *        value 0xFFFF, bits MSB first, no final XOR
+ */
+static uint16_t pack_crc(const uint8_t *p, size_t n)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (n--)
+    {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (int b = 0; b < 8; b++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+static uint32_t pack_hash(const uint8_t *p)
+{
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+
+    return (v * 2654435761u) >> (32 - PACK_HASH_BITS);
+}
+
+static size_t pack_length(uint8_t *out, size_t n)
+{
+    size_t o = 0;
+
+    for (; n >= 255; n -= 255)
+        out[o++] = 255;
+    out[o++] = (uint8_t)n;
+    return o;
+}
+
+static size_t pack_sequence(uint8_t *out, const uint8_t *lit, size_t nlit, size_t off, size_t len)
+{
+    size_t o = 1;
+    size_t m = (len > 0) ? len - PACK_MIN_MATCH : 0;
+
+    out[0] = (uint8_t)(((nlit < 15) ? nlit : 15) << 4);
+    if (nlit >= 15)
+        o += pack_length(&out[o], nlit - 15);
+    memcpy(&out[o], lit, nlit);
+    o += nlit;
+    if (len == 0)
+        return o;
+
+    out[0] |= (uint8_t)((m < 15) ? m : 15);
+    out[o++] = (uint8_t)off;
+    out[o++] = (uint8_t)(off >> 8);
+    if (m >= 15)
+        o += pack_length(&out[o], m - 15);
+    return o;
+}
+
+/**
+ * @brief Longest match for position i within the window
+ */
+static size_t pack_find(const uint8_t *in, size_t i, size_t limit,
+                        const int32_t *head, const int32_t *chain, size_t *off)
+{
+    size_t best = 0;
+    int depth = PACK_DEPTH;
+
+    for (int32_t p = head[pack_hash(&in[i])]; p >= 0 && depth-- > 0; p = chain[p])
+    {
+        size_t n = 0;
+
+        if (i - (size_t)p > LOAD_LZ_MAX_OFFSET)
+            break;
+        while (i + n < limit && in[p + n] == in[i + n])
+            n++;
+        if (n > best)
+        {
+            best = n;
+            *off = i - (size_t)p;
+        }
+    }
+    return (best >= PACK_MIN_MATCH) ? best : 0;
+}
+
+/**
+ * @brief LZ4 block with offsets up to LOAD_LZ_MAX_OFFSET, greedy with one
+ *        step of lazy evaluation
+ */
+static size_t pack_block(const uint8_t *in, size_t n, uint8_t *out)
+{
+    static int32_t head[1 << PACK_HASH_BITS];
+    int32_t *chain = malloc((n + 1) * sizeof(int32_t));
+    size_t limit = (n > PACK_LAST_LITERALS) ? n - PACK_LAST_LITERALS : 0;
+    size_t end = (n > PACK_MF_LIMIT) ? n - PACK_MF_LIMIT : 0;
+    size_t anchor = 0;
+    size_t added = 0;
+    size_t o = 0;
+    size_t i = 0;
+
+    memset(head, 0xFF, sizeof(head));
+    while (i < end)
+    {
+        size_t off = 0;
+        size_t off1 = 0;
+        size_t len;
+        size_t len1;
+
+        for (; added < i; added++)
+        {
+            uint32_t h = pack_hash(&in[added]);
+
+            chain[added] = head[h];
+            head[h] = (int32_t)added;
+        }
+
+        len = pack_find(in, i, limit, head, chain, &off);
+        if (len == 0)
+        {
+            i++;
+            continue;
+        }
+
+        /* Take the next position instead if it matches longer */
+        chain[i] = head[pack_hash(&in[i])];
+        head[pack_hash(&in[i])] = (int32_t)i;
+        added = i + 1;
+        len1 = (i + 1 < end) ? pack_find(in, i + 1, limit, head, chain, &off1) : 0;
+        if (len1 > len)
+        {
+            i++;
+            len = len1;
+            off = off1;
+        }
+
+        o += pack_sequence(&out[o], &in[anchor], i - anchor, off, len);
+        i += len;
+        anchor = i;
+    }
+    o += pack_sequence(&out[o], &in[anchor], n - anchor, 0, 0);
+    free(chain);
+    return o;
+}
+
+/**
+ * @brief Plain LZ4 block decoder, to check the packed output
+ */
+static size_t unpack_block(const uint8_t *in, size_t n, uint8_t *out, size_t cap)
+{
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < n)
+    {
+        uint8_t token = in[i++];
+        size_t len = token >> 4;
+        size_t off;
+        uint8_t b;
+
+        if (len == 15)
+            do { b = in[i++]; len += b; } while (b == 255 && i < n);
+        if (o + len > cap || i + len > n)
+            return 0;
+        memcpy(&out[o], &in[i], len);
+        o += len;
+        i += len;
+        if (i >= n)
+            break;
+
+        off = in[i] | (in[i + 1] << 8);
+        i += 2;
+        len = (token & 15) + PACK_MIN_MATCH;
+        if ((token & 15) == 15)
+            do { b = in[i++]; len += b; } while (b == 255 && i < n);
+        if (off == 0 || off > o || off > LOAD_LZ_MAX_OFFSET || o + len > cap)
+            return 0;
+        for (; len > 0; len--, o++)
+            out[o] = out[o - off];
+    }
+    return o;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    const char *name = "dsp_section_lz";
+    const char *in_path;
+    const char *out_path;
+    const char *ext;
+    FILE *f;
+    uint8_t *raw;
+    uint8_t *packed;
+    uint8_t *check;
+    long raw_size;
+    size_t size;
+    int stored = 0;
+    int a = 1;
+
+    for (; a < argc && argv[a][0] == '-'; a++)
+    {
+        if (strcmp(argv[a], "-s") == 0)
+            stored = 1;
+        else if (strcmp(argv[a], "-n") == 0 && a + 1 < argc)
+            name = argv[++a];
+        else
+            break;
+    }
+    if (argc - a != 2)
+    {
+        fprintf(stderr, "usage: %s [-s] [-n name] input.bin output.{c,bin}\n", argv[0]);
+        return 2;
+    }
+    in_path = argv[a];
+    out_path = argv[a + 1];
+
+    f = fopen(in_path, "rb");
+    if (f == NULL)
+    {
+        perror(in_path);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    raw_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    raw = malloc((size_t)raw_size + 1);
+    if (fread(raw, 1, (size_t)raw_size, f) != (size_t)raw_size)
+    {
+        perror(in_path);
+        return 1;
+    }
+    fclose(f);
+
+    /* Worst case: all literals, one length byte per 255 */
+    packed = malloc(sizeof(loadSectionHeader) + (size_t)raw_size + (size_t)raw_size / 255 + 16);
+    check = malloc((size_t)raw_size + 1);
+    size = stored ? 0 : pack_block(raw, (size_t)raw_size, packed + sizeof(loadSectionHeader));
+    if (!stored &&
+        (unpack_block(packed + sizeof(loadSectionHeader), size, check, (size_t)raw_size) != (size_t)raw_size ||
+         memcmp(raw, check, (size_t)raw_size) != 0))
+    {
+        fprintf(stderr, "%s: packed data does not decode back\n", in_path);
+        return 1;
+    }
+    if (stored || size >= (size_t)raw_size)
+    {
+        stored = 1;
+        size = (size_t)raw_size;
+        memcpy(packed + sizeof(loadSectionHeader), raw, size);
+    }
+    put32(packed, stored ? LOAD_RAW_MAGIC : LOAD_LZ_MAGIC);
+    put32(packed + 4, (uint32_t)raw_size);
+    put32(packed + 8, (uint32_t)size);
+    put32(packed + 12, pack_crc(raw, (size_t)raw_size));
+    size += sizeof(loadSectionHeader);
+
+    f = fopen(out_path, "wb");
+    if (f == NULL)
+    {
+        perror(out_path);
+        return 1;
+    }
+    ext = strrchr(out_path, '.');
+    if (ext != NULL && (strcmp(ext, ".c") == 0 || strcmp(ext, ".h") == 0))
+    {
+        fprintf(f, "/* Packed by dsp_pack from %s: %ld -> %zu bytes */\n", in_path, raw_size, size);
+        fprintf(f, "#include <stdint.h>\n\n");
+        fprintf(f, "const uint8_t %s[%zu] __attribute__((aligned(4))) =\n{", name, size);
+        for (size_t i = 0; i < size; i++)
+            fprintf(f, "%s0x%02x,", (i % 12) ? " " : "\n    ", packed[i]);
+        fprintf(f, "\n};\n");
+    }
+    else
+    {
+        fwrite(packed, 1, size, f);
+    }
+    fclose(f);
+
+    printf("%s: %ld -> %zu bytes (%.1f %%)%s, CRC 0x%04x\n", in_path, raw_size, size,
+           (raw_size > 0) ? 100.0 * (double)size / (double)raw_size : 0.0,
+           stored ? " stored" : "", pack_crc(raw, (size_t)raw_size));
+    free(raw);
+    free(packed);
+    free(check);
+    return 0;
+}
@@ -0,0 +1,393 @@
+/**
+ * @file afc_bench.c
+ * @brief Feedback-path step response of the feedback cancellers
+ *
+ * Closed-loop hearing aid on the host: a coloured AR(2) source plus the
+ * loudspeaker output through the feedback path reach the microphone, the
+ * canceller removes what it can, and the forward path sends the rest to the
+ * loudspeaker with AFC_BENCH_GAIN of gain and AFC_BENCH_FWD_DELAY samples of
+ * delay. The gain is above the maximum stable gain (MSG) of both paths, so
+ * the loop only holds with the canceller. The path starts as path A; at
+ * AFC_BENCH_STEP it becomes path B, 6 dB louder with its peak moved, as when
+ * a hand comes up to the ear. Run for
+ *   - the time-domain NLMS canceller (afc_nlms.c) at every prediction-error
+ *     prefilter order 0..AFC_PEM_MAX_ORDER, the AFC_Init argument the
+ *     application sets with APP_AFC_PEM_ORDER. Orders below
+ *     AFC_BENCH_PEM_MIN are printed, not checked: without enough of the
+ *     prefilter the coloured source biases the taps.
+ *   - the subband canceller (afc_fdaf.c) on the pipeline filterbank, with
+ *     Pre_Delay at the path delay less the filterbank hop
+ *
+ * Every AFC_BENCH_PROBE the added stable gain (ASG) is measured open loop:
+ * a copy of the canceller, its taps held, is driven with periodic white
+ * noise through the current path, and the residual path R is the spectrum
+ * of the error over the spectrum of the noise, one period each. Then
+ *   ASG = 20 log10(max |F| / max |R|)
+ * from AFC_BENCH_BAND_LO up, where the paths carry the feedback; the
+ * full-band figure is printed as well. The checks are the ASG on path A
+ * before the step, the time from the step until the ASG on path B stays at
+ * AFC_BENCH_TARGET, the ASG at the end, and no clipping over the last
+ * second. A canceller switched off must come out at 0 dB, which checks the
+ * measurement itself. The host time per frame of each canceller, Process
+ * and Reference, follows; the CM33 figures are
+ * app_stage_cycles_max[APP_STAGE_AFC] and [APP_STAGE_FDAF] on the target.
+ *
+ * Usage: afc_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "basic_op.h"
+#include "afc_nlms.h"
+#include "afc_fdaf.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AFC_BENCH_SECONDS           8
+#define AFC_BENCH_FRAMES            (AFC_BENCH_SECONDS * AUDIO_SAMPLE_RATE / AFC_BLOCK)
+#define AFC_BENCH_STEP              3.0         /* s, path A to path B */
+#define AFC_BENCH_PROBE             0.05        /* s between ASG measurements */
+#define AFC_BENCH_PATH_LEN          24
+#define AFC_BENCH_PATH_DELAY        40          /* samples, loudspeaker to microphone */
+#define AFC_BENCH_FWD_DELAY         64          /* samples, forward path */
+#define AFC_BENCH_GAIN              15.0        /* dB, forward path */
+#define AFC_BENCH_SOURCE            0.01        /* AR(2) source scale */
+#define AFC_BENCH_PERIOD            512         /* probe noise period */
+#define AFC_BENCH_BAND_LO           1000.0      /* Hz, lowest ASG bin */
+#define AFC_BENCH_PEM_MIN           2
+#define AFC_BENCH_TARGET            10.0        /* dB, ASG */
+#define AFC_BENCH_TIME_MAX          1.0         /* s, from the step to the target */
+#define AFC_BENCH_OFF_TOL           0.5         /* dB, ASG with the canceller off */
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static double path_a[AFC_BENCH_PATH_LEN], path_b[AFC_BENCH_PATH_LEN];
+static double probe[AFC_BENCH_PERIOD];
+static SM_CONFIG_FBC cfg;
+static AFC_State_t afc, afc_probe;
+static FDAF_State_t fdaf, fdaf_probe;
+static FB_State_t fb, fb_probe;
+static double err[AFC_BENCH_FRAMES * AFC_BLOCK], out[AFC_BENCH_FRAMES * AFC_BLOCK];
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Gaussian-ish noise of unit variance
+ */
+static double afc_gauss(void)
+{
+    double s = 0.0;
+
+    for (int i = 0; i < 12; i++)
+        s += (double)rand() / RAND_MAX;
+    return s - 6.0;
+}
+
+/**
+ * @brief Run one block through the canceller: AFC_Process, or the filterbank
+ *        around FDAF_Process
+ * @param pem  prefilter order of the NLMS canceller, -1 for the FDAF
+ */
+static void afc_process(int pem, AFC_State_t *a, FDAF_State_t *fd, FB_State_t *f, Word32 *block)
+{
+    FB_Spectrum_t spec;
+
+    if (pem >= 0)
+    {
+        AFC_Process(a, block);
+        return;
+    }
+    FB_Analysis(f, block, &spec);
+    FDAF_Process(fd, f, &spec);
+    FB_Synthesis(f, &spec, block);
+}
+
+/**
+ * @brief Pass the loudspeaker block to the canceller
+ */
+static void afc_reference(int pem, AFC_State_t *a, FDAF_State_t *fd, const Word32 *block)
+{
+    if (pem >= 0)
+        AFC_Reference(a, block);
+    else
+        FDAF_Reference(fd, block);
+}
+
+/**
+ * @brief Magnitude response of a feedback path on DFT bin k of the probe
+ */
+static double afc_path_mag(const double *path, int k)
+{
+    double re = 0.0, im = 0.0;
+
+    for (int j = 0; j < AFC_BENCH_PATH_LEN; j++)
+    {
+        re += path[j] * cos(2.0 * M_PI * k * (j + AFC_BENCH_PATH_DELAY) / AFC_BENCH_PERIOD);
+        im -= path[j] * sin(2.0 * M_PI * k * (j + AFC_BENCH_PATH_DELAY) / AFC_BENCH_PERIOD);
+    }
+    return sqrt(re * re + im * im);
+}
+
+/**
+ * @brief MSG in dB of a bare feedback path with a flat forward path
+ */
+static double afc_msg(const double *path)
+{
+    double m = 0.0;
+
+    for (int k = 1; k < AFC_BENCH_PERIOD / 2; k++)
+        m = fmax(m, afc_path_mag(path, k));
+    return -20.0 * log10(m);
+}
+
+/**
+ * @brief ASG in dB of the canceller in its present state against a path
+ * @param full  if not NULL, set to the ASG over the whole band
+ * @note  The probe runs on copies, so the closed loop carries on untouched.
+ *        The taps of the copy are put back after every block, so they stay
+ *        those of the moment of the probe.
+ */
+static double afc_asg(int pem, const double *path, double *full)
+{
+    const int lo = (int)ceil(AFC_BENCH_BAND_LO * AFC_BENCH_PERIOD / BENCH_FS);
+    static double e[AFC_BENCH_PERIOD];
+    double f_band = 0.0, r_band = 0.0, f_all = 0.0, r_all = 0.0;
+
+    if (pem >= 0)
+        afc_probe = afc;
+    else
+    {
+        fdaf_probe = fdaf;
+        FB_Init(&fb_probe);
+    }
+
+    /* One period to flush the histories, one period measured */
+    for (int t = 0; t < 2 * AFC_BENCH_PERIOD; t += AFC_BLOCK)
+    {
+        Word32 block[AFC_BLOCK];
+
+        for (int n = 0; n < AFC_BLOCK; n++)
+        {
+            double m = 0.0;
+
+            for (int j = 0; j < AFC_BENCH_PATH_LEN; j++)
+                m += path[j] * probe[(t + n - AFC_BENCH_PATH_DELAY - j + AFC_BENCH_PERIOD) % AFC_BENCH_PERIOD];
+            block[n] = (Word32)(m * BENCH_Q31);
+        }
+        afc_process(pem, &afc_probe, &fdaf_probe, &fb_probe, block);
+        if (pem >= 0)
+        {
+            memcpy(afc_probe.w, afc.w, sizeof(afc.w));
+            memcpy(afc_probe.wr, afc.wr, sizeof(afc.wr));
+        }
+        else
+        {
+            memcpy(fdaf_probe.w_re, fdaf.w_re, sizeof(fdaf.w_re));
+            memcpy(fdaf_probe.w_im, fdaf.w_im, sizeof(fdaf.w_im));
+        }
+        if (t >= AFC_BENCH_PERIOD)
+            for (int n = 0; n < AFC_BLOCK; n++)
+                e[t + n - AFC_BENCH_PERIOD] = block[n] / BENCH_Q31;
+
+        for (int n = 0; n < AFC_BLOCK; n++)
+            block[n] = (Word32)(probe[(t + n) % AFC_BENCH_PERIOD] * BENCH_Q31);
+        afc_reference(pem, &afc_probe, &fdaf_probe, block);
+    }
+
+    /* |R| = |E| / |U| on every bin */
+    for (int k = 1; k < AFC_BENCH_PERIOD / 2; k++)
+    {
+        double e_re = 0.0, e_im = 0.0, u_re = 0.0, u_im = 0.0;
+        double f = afc_path_mag(path, k);
+        double r;
+
+        for (int n = 0; n < AFC_BENCH_PERIOD; n++)
+        {
+            double c = cos(2.0 * M_PI * k * n / AFC_BENCH_PERIOD);
+            double s = sin(2.0 * M_PI * k * n / AFC_BENCH_PERIOD);
+
+            e_re += e[n] * c;
+            e_im -= e[n] * s;
+            u_re += probe[n] * c;
+            u_im -= probe[n] * s;
+        }
+        r = sqrt((e_re * e_re + e_im * e_im) / (u_re * u_re + u_im * u_im));
+        f_all = fmax(f_all, f);
+        r_all = fmax(r_all, r);
+        if (k >= lo)
+        {
+            f_band = fmax(f_band, f);
+            r_band = fmax(r_band, r);
+        }
+    }
+    if (full)
+        *full = 20.0 * log10(f_all / r_all);
+    return 20.0 * log10(f_band / r_band);
+}
+
+/**
+ * @brief Reset the canceller under test
+ */
+static void afc_reset(int pem)
+{
+    if (pem >= 0)
+        AFC_Init(&afc, &cfg, AFC_BLOCK, pem);
+    else
+    {
+        FDAF_Init(&fdaf, &cfg);
+        FB_Init(&fb);
+    }
+}
+
+/**
+ * @brief Closed loop through the path step
+ * @param before  ASG on path A just before the step
+ * @param settle  seconds from the step until the ASG stays at the target
+ * @param after   ASG at the end
+ * @param full    full-band ASG at the end
+ * @param clips   clipped loudspeaker samples over the last second
+ * @param us      host time per frame of the canceller
+ */
+static void afc_run(int pem, double *before, double *settle, double *after, double *full, int *clips, double *us)
+{
+    const double g = pow(10.0, AFC_BENCH_GAIN / 20.0);
+    const int step = (int)(AFC_BENCH_STEP * BENCH_FS) / AFC_BLOCK;
+    const int every = (int)(AFC_BENCH_PROBE * BENCH_FS) / AFC_BLOCK;
+    double s1 = 0.0, s2 = 0.0;
+    uint64_t t = 0;
+
+    srand(28);
+    afc_reset(pem);
+    memset(err, 0, sizeof(err));
+    memset(out, 0, sizeof(out));
+    *settle = 0.0;
+    *clips = 0;
+
+    for (int f = 0; f < AFC_BENCH_FRAMES; f++)
+    {
+        const double *path = (f < step) ? path_a : path_b;
+        Word32 block[AFC_BLOCK];
+        uint64_t t0;
+
+        for (int n = 0; n < AFC_BLOCK; n++)
+        {
+            int i = f * AFC_BLOCK + n;
+            double s = afc_gauss() + 1.6 * s1 - 0.8 * s2;
+            double m = AFC_BENCH_SOURCE * s;
+
+            s2 = s1;
+            s1 = s;
+            for (int j = 0; j < AFC_BENCH_PATH_LEN && i - AFC_BENCH_PATH_DELAY - j >= 0; j++)
+                m += path[j] * out[i - AFC_BENCH_PATH_DELAY - j];
+            block[n] = (Word32)(fmax(-1.0, fmin(1.0, m)) * BENCH_Q31);
+        }
+
+        t0 = bench_ns();
+        afc_process(pem, &afc, &fdaf, &fb, block);
+        t += bench_ns() - t0;
+
+        /* Forward path: gain and delay, the loudspeaker clips at full scale */
+        for (int n = 0; n < AFC_BLOCK; n++)
+        {
+            int i = f * AFC_BLOCK + n;
+            double o = (i >= AFC_BENCH_FWD_DELAY) ? g * err[i - AFC_BENCH_FWD_DELAY] : 0.0;
+
+            err[i] = block[n] / BENCH_Q31;
+            out[i] = fmax(-1.0, fmin(1.0, o));
+            block[n] = (Word32)(out[i] * BENCH_Q31);
+            if (fabs(o) >= 1.0 && f >= AFC_BENCH_FRAMES - (int)BENCH_FS / AFC_BLOCK)
+                (*clips)++;
+        }
+
+        t0 = bench_ns();
+        afc_reference(pem, &afc, &fdaf, block);
+        t += bench_ns() - t0;
+
+        if (f == step - 1)
+            *before = afc_asg(pem, path_a, NULL);
+        else if (f >= step && (f + 1 - step) % every == 0 && afc_asg(pem, path_b, NULL) < AFC_BENCH_TARGET)
+            *settle = (f + 1 - step) * AFC_BLOCK / BENCH_FS;
+    }
+    *after = afc_asg(pem, path_b, full);
+    *us = (double)t / AFC_BENCH_FRAMES / 1000.0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    double asg;
+    int fails = 0;
+
+    for (int j = 0; j < AFC_BENCH_PATH_LEN; j++)
+    {
+        path_a[j] = 0.08 * exp(-j / 5.0) * cos(2.0 * M_PI * j * 0.22);
+        path_b[j] = 0.16 * exp(-j / 5.0) * cos(2.0 * M_PI * j * 0.15);
+    }
+    srand(1);
+    for (int n = 0; n < AFC_BENCH_PERIOD; n++)
+        probe[n] = 0.1 * afc_gauss();
+    printf("path A: MSG %.1f dB, path B: MSG %.1f dB, forward gain %.1f dB\n",
+           afc_msg(path_a), afc_msg(path_b), AFC_BENCH_GAIN);
+
+    /* NLMS: 64 taps, mu 0.5 slowed by 2^-4, 2 bits of headroom for path B */
+    cfg.EcTaps = AFC_MAX_TAPS;
+    cfg.MuDivNumTaps = (Word32)(0.5 / AFC_MAX_TAPS * 32768);
+    cfg.DerivedQshift = 2;
+    cfg.ConvergenceSpeed = 4;
+    /* FDAF: the path delay less the hop of the microphone analysis */
+    cfg.Pre_Delay = AFC_BENCH_PATH_DELAY - FB_HOP;
+    for (int b = 0; b < 32; b++)
+        cfg.Normalized_Adapt_Speed[b] = 4;
+    cfg.Idle_Speed = 8;
+    cfg.Power_NormalizationBias = 12;
+
+    /* The measurement against a canceller that does nothing */
+    afc_reset(0);
+    asg = afc_asg(0, path_a, NULL);
+    BENCH_CHECK(fails, fabs(asg) <= AFC_BENCH_OFF_TOL, "NLMS off:  ASG %.1f dB", asg);
+    afc_reset(-1);
+    asg = afc_asg(-1, path_a, NULL);
+    BENCH_CHECK(fails, fabs(asg) <= AFC_BENCH_OFF_TOL, "FDAF off:  ASG %.1f dB", asg);
+
+    for (int pem = -1; pem <= AFC_PEM_MAX_ORDER; pem++)
+    {
+        double before = 0.0, settle, after, full, us;
+        char name[16];
+        int clips;
+
+        cfg.TFBC_Enable = (pem >= 0);
+        cfg.Pre_Adaptive_Filter = (pem < 0);
+        afc_run(pem, &before, &settle, &after, &full, &clips, &us);
+        if (pem >= 0)
+            snprintf(name, sizeof(name), "NLMS PEM %d", pem);
+        else
+            snprintf(name, sizeof(name), "FDAF");
+
+        if (pem >= 0 && pem < AFC_BENCH_PEM_MIN)
+            printf("      %-10s ASG %4.1f dB on A, on B >= %.0f dB from %.2f s after the step, %4.1f dB at the end "
+                   "(not checked)\n", name, before, AFC_BENCH_TARGET, settle, after);
+        else
+            BENCH_CHECK(fails, before >= AFC_BENCH_TARGET && settle <= AFC_BENCH_TIME_MAX
+                        && after >= AFC_BENCH_TARGET && clips == 0,
+                        "%-10s ASG %4.1f dB on A, on B >= %.0f dB from %.2f s after the step, %4.1f dB at the end "
+                        "(full band %4.1f dB), %d clipped, host %.2f us/frame",
+                        name, before, AFC_BENCH_TARGET, settle, after, full, clips, us);
+    }
+
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file ains_bench.c
+ * @brief Host driver for AINS_Reference and the GRU runtime (ai_ns.c, nnq.c)
+ *
+ * Built with AINS_REFERENCE set. A pseudo-random model in the MRAM layout
+ * is loaded, and AINS_Reference() runs the packed dual-MAC network against
+ * the natural-order scalar one; any frame where they differ fails. Also
+ * checked: the empty weak model is refused, NS_LEVEL 0 passes the spectrum
+ * through bit for bit, and the sigmoid and tanh tables stay within
+ * AINS_BENCH_ACT_TOL of the exact functions. The time per AINS_Process
+ * frame follows.
+ *
+ * Usage: ains_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "basic_op.h"
+#include "ai_ns.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AINS_BENCH_FRAMES           10000
+#define AINS_BENCH_ACT_TOL          0.001
+#define AINS_BENCH_TIMED            100000
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static AINS_Model_t model;
+static AINS_State_t ains;
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Fill the model with random weights of a plausible scale
+ */
+static void ains_random_model(AINS_Model_t *m)
+{
+    m->magic = AINS_MODEL_MAGIC;
+    m->version = AINS_MODEL_VERSION;
+    m->bands = AINS_BANDS;
+    m->hidden = AINS_HIDDEN;
+    m->gru_shift = 6;
+    m->out_shift = 6;
+    for (size_t i = 0; i < sizeof(m->gru_wi); i++)
+        m->gru_wi[i] = (int8_t)(rand() % 255 - 127);
+    for (size_t i = 0; i < sizeof(m->gru_wh); i++)
+        m->gru_wh[i] = (int8_t)(rand() % 255 - 127);
+    for (size_t i = 0; i < sizeof(m->out_w); i++)
+        m->out_w[i] = (int8_t)(rand() % 255 - 127);
+    for (int i = 0; i < AINS_GATES; i++)
+    {
+        m->gru_bi[i] = (rand() % 8192 - 4096) << 6;
+        m->gru_bh[i] = (rand() % 8192 - 4096) << 6;
+    }
+    for (int i = 0; i < AINS_BANDS; i++)
+    {
+        m->out_b[i] = (rand() % 8192 - 4096) << 6;
+        m->in_mean[i] = 20 * 256;
+        m->in_scale[i] = 16384;
+    }
+}
+
+/**
+ * @brief Largest error of an activation table over the Q12 input range
+ */
+static double ains_act_error(Word16 (*fn)(Word16), int tanh_fn)
+{
+    double e = 0.0;
+
+    for (int x = -32768; x < 32768; x++)
+    {
+        double y = fn((Word16)x) / 32768.0;
+        double r = tanh_fn ? tanh(x / 4096.0) : 1.0 / (1.0 + exp(-x / 4096.0));
+
+        if (fabs(y - r) > e)
+            e = fabs(y - r);
+    }
+    return e;
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    MCU_Config_AI_NS mcu = { 1.0f, AINS_ATTACK_MS, AINS_RELEASE_MS };
+    AINS_Config_t cfg;
+    FB_State_t fb;
+    FB_Spectrum_t spec, s;
+    Word32 block[FB_HOP];
+    double e;
+    uint64_t t;
+    int bad, same;
+    int fails = 0;
+
+    srand(1);
+    AINS_Parser(&mcu, &cfg);
+    AINS_Init(&ains, &cfg);
+    BENCH_CHECK(fails, !AINS_Load(&ains, &ains_model), "empty weak model refused");
+
+    ains_random_model(&model);
+    BENCH_CHECK(fails, AINS_Load(&ains, &model) && ains.arena.used <= AINS_ARENA_SIZE,
+                "random model loaded, arena %zu of %d bytes", ains.arena.used, (int)AINS_ARENA_SIZE);
+
+    bad = AINS_Reference(&ains, AINS_BENCH_FRAMES);
+    BENCH_CHECK(fails, bad == 0, "packed vs reference network: %d of %d frames differ", bad, AINS_BENCH_FRAMES);
+
+    e = ains_act_error(NNQ_Sigmoid, 0);
+    BENCH_CHECK(fails, e <= AINS_BENCH_ACT_TOL, "sigmoid table max error %.5f", e);
+    e = ains_act_error(NNQ_Tanh, 1);
+    BENCH_CHECK(fails, e <= AINS_BENCH_ACT_TOL, "tanh table max error %.5f", e);
+
+    FB_Init(&fb);
+    for (int i = 0; i < FB_HOP; i++)
+        block[i] = (rand() - RAND_MAX / 2) * 4;
+    FB_Analysis(&fb, block, &spec);
+
+    t = bench_ns();
+    for (int r = 0; r < AINS_BENCH_TIMED; r++)
+    {
+        s = spec;
+        AINS_Process(&ains, &fb, &s);
+    }
+    t = bench_ns() - t;
+
+    mcu.NS_LEVEL = 0.0f;
+    AINS_Parser(&mcu, &cfg);
+    AINS_Init(&ains, &cfg);
+    AINS_Load(&ains, &model);
+    s = spec;
+    AINS_Process(&ains, &fb, &s);
+    same = memcmp(s.bin, spec.bin, sizeof(spec.bin)) == 0;
+    BENCH_CHECK(fails, same, "NS_LEVEL 0 passes the spectrum through");
+
+    printf("%d MACs, %.2f us/frame (host)\n", AINS_MACS, (double)t / AINS_BENCH_TIMED / 1000.0);
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file aud_bench.c
+ * @brief Host harness for the audiometry tone generator (audiometry.c)
+ *
+ * Checks each audiometric frequency at 60 dB HL against the ISO 389-2
+ * insert-earphone RETSPL, the 10 dB level steps, that the parser refuses a
+ * level above the limiter ceiling and presents the one below it unclipped,
+ * and that a tone mixed into a full-scale microphone signal never leaves the
+ * ceiling it is given.
+ * Host time per sample is printed for comparing revisions; the CM33 figure
+ * is app_stage_cycles_max[APP_STAGE_AUD] / AUDIO_BLOCK_SIZE on the target.
+ *
+ * Usage: aud_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include "bench.h"
+#include "basic_op.h"
+#include "audiometry.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define AUD_BENCH_MAXDB             120.0f      /* MCU_WDRC.maxdB */
+#define AUD_BENCH_HL                60
+#define AUD_BENCH_SECONDS           2
+#define AUD_BENCH_LEVEL_TOL         0.2         /* dB */
+#define AUD_BENCH_FREQ_TOL          0.01        /* relative */
+#define AUD_BENCH_BLOCKS            (AUD_BENCH_SECONDS * 10 * 98)
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static const double freqs[AUD_FREQS] = { 125, 250, 500, 750, 1000, 1500, 2000, 3000, 4000, 6000, 8000 };
+static const double retspl[AUD_FREQS] = { 26.0, 14.0, 5.5, 2.0, 0.0, 2.0, 3.0, 3.5, 5.5, 2.0, 0.0 };
+
+static Word32 out[AUD_BENCH_BLOCKS * AUDIO_BLOCK_SIZE];
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Run one steady presentation into out[]
+ * @return Frames written, or -1 if the parser rejected it
+ */
+static int aud_run(int f, int hl, int mode, const Word32 *mic, Word32 ceiling)
+{
+    uint8_t cmd[AUD_CMD_LEN] = { (uint8_t)f, (uint8_t)(hl + AUD_LEVEL_OFFSET), (uint8_t)mode, AUD_BENCH_SECONDS * 10 };
+    AUD_Presentation_t p;
+    AUD_State_t aud;
+    int n = 0;
+
+    if (!AUD_Parser(cmd, AUD_BENCH_MAXDB, ceiling, &p))
+        return -1;
+    AUD_Init(&aud);
+    AUD_Start(&aud, &p);
+    while (aud.active && n < AUD_BENCH_BLOCKS)
+    {
+        Word32 *block = out + n * AUDIO_BLOCK_SIZE;
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+            block[i] = mic ? mic[i] : 0;
+        AUD_Process(&aud, block, ceiling);
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief RMS level in dBFS (sine peak at 0 dBFS) and frequency of the steady part
+ */
+static void aud_measure(int frames, double *dbfs, double *freq)
+{
+    int a = (AUD_RAMP_BLOCKS + 8) * AUDIO_BLOCK_SIZE;
+    int b = (frames - AUD_RAMP_BLOCKS - 8) * AUDIO_BLOCK_SIZE;
+    double s = 0.0;
+    int zc = 0;
+
+    for (int i = a; i < b; i++)
+    {
+        double x = out[i] / BENCH_Q31;
+
+        s += x * x;
+        if (i > a && (out[i - 1] < 0) != (out[i] < 0))
+            zc++;
+    }
+    *dbfs = 20.0 * log10(sqrt(2.0 * s / (b - a)));
+    *freq = zc / 2.0 / ((b - a) / BENCH_FS);
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    Word32 mic[AUDIO_BLOCK_SIZE];
+    Word32 ceiling = (Word32)(BENCH_Q31 * 0.5);     /* -6 dBFS */
+    Word32 peak = 0;
+    double ref = 0.0;
+    uint64_t t;
+    int fails = 0;
+    int n;
+
+    for (int f = 0; f < AUD_FREQS; f++)
+    {
+        double dbfs, freq;
+        double expect = retspl[f] + AUD_BENCH_HL - AUD_BENCH_MAXDB;
+
+        n = aud_run(f, AUD_BENCH_HL, AUD_STEADY, NULL, MAX_32);
+        aud_measure(n, &dbfs, &freq);
+        BENCH_CHECK(fails, fabs(dbfs - expect) <= AUD_BENCH_LEVEL_TOL && fabs(freq / freqs[f] - 1.0) <= AUD_BENCH_FREQ_TOL,
+                    "%5.0f Hz %d dB HL: %6.2f dBFS (expect %6.2f), %7.1f Hz", freqs[f], AUD_BENCH_HL, dbfs, expect, freq);
+    }
+
+    for (int hl = 0; hl <= 90; hl += 10)
+    {
+        double dbfs, freq;
+
+        n = aud_run(4, hl, AUD_STEADY, NULL, MAX_32);
+        if (n < 0)
+        {
+            printf("      1000 Hz %d dB HL: above full scale, rejected\n", hl);
+            continue;
+        }
+        aud_measure(n, &dbfs, &freq);
+        if (hl > 0)
+            BENCH_CHECK(fails, fabs(dbfs - ref - 10.0) <= AUD_BENCH_LEVEL_TOL,
+                        "1000 Hz %2d dB HL: step %5.2f dB", hl, dbfs - ref);
+        ref = dbfs;
+    }
+
+    /* Against a -6 dBFS ceiling: -10 dBFS is presented whole, -5 dBFS refused */
+    {
+        double dbfs = 0.0, freq;
+        int above;
+
+        n = aud_run(4, 110, AUD_STEADY, NULL, ceiling);
+        if (n > 0)
+            aud_measure(n, &dbfs, &freq);
+        BENCH_CHECK(fails, n > 0 && fabs(dbfs + 10.0) <= AUD_BENCH_LEVEL_TOL,
+                    "1000 Hz 110 dB HL under a -6 dBFS ceiling: %6.2f dBFS", dbfs);
+        above = aud_run(4, 115, AUD_STEADY, NULL, ceiling);
+        BENCH_CHECK(fails, above < 0, "1000 Hz 115 dB HL above a -6 dBFS ceiling: %s",
+                    above < 0 ? "refused" : "accepted");
+    }
+
+    /* Full-scale square wave microphone, loudest tone, mixed */
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        mic[i] = (i & 8) ? MAX_32 : -MAX_32;
+    n = aud_run(4, 80, AUD_STEADY | AUD_MIX, mic, ceiling);
+    for (int i = 0; i < n * AUDIO_BLOCK_SIZE; i++)
+    {
+        Word32 a = out[i] < 0 ? -out[i] : out[i];
+
+        if (a > peak)
+            peak = a;
+    }
+    BENCH_CHECK(fails, n > 0 && peak <= ceiling, "mixed into full scale: peak %.2f dBFS, ceiling %.2f dBFS",
+                20.0 * log10(peak / BENCH_Q31), 20.0 * log10(ceiling / BENCH_Q31));
+
+    t = bench_ns();
+    n = aud_run(4, AUD_BENCH_HL, AUD_WARBLE | AUD_MIX, mic, ceiling);
+    t = bench_ns() - t;
+    printf("warble, mixed: %.2f ns/sample (host)\n", (double)t / (n * AUDIO_BLOCK_SIZE));
+
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file bench.h
+ * @brief Shared helpers for the host harnesses of the CM33 audio stages
+ *
+ * The harnesses build the stage sources from j20_sample/code unchanged with
+ * the host compiler. Host times are for comparing revisions of a stage on
+ * one machine; they are not CM33 cycle counts, which come from
+ * App_Stage_Cycles on the target.
+ */
+
+#ifndef TOOLS_HOST_BENCH_BENCH_H_
+#define TOOLS_HOST_BENCH_BENCH_H_
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI                        3.14159265358979323846
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define BENCH_FS                    31250.0     /* AUDIO_SAMPLE_RATE */
+#define BENCH_Q31                   2147483647.0
+
+/* ----------------------------------------------------------------------------
+ * Helpers
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static inline uint64_t bench_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Power of x[0..n-1] at frequency f under a Hann window
+ */
+static inline double bench_tone_power(const double *x, int n, double f)
+{
+    double re = 0.0, im = 0.0;
+
+    for (int i = 0; i < n; i++)
+    {
+        double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / n);
+
+        re += w * x[i] * cos(2.0 * M_PI * f * i / BENCH_FS);
+        im += w * x[i] * sin(2.0 * M_PI * f * i / BENCH_FS);
+    }
+    return re * re + im * im;
+}
+
+/**
+ * @brief RMS of x[0..n-1]
+ */
+static inline double bench_rms(const double *x, int n)
+{
+    double s = 0.0;
+
+    for (int i = 0; i < n; i++)
+        s += x[i] * x[i];
+    return sqrt(s / n);
+}
+
+/**
+ * @brief Print a check line and count failures
+ */
+#define BENCH_CHECK(fails, ok, ...)                         \
+    do {                                                    \
+        printf("%s  ", (ok) ? "ok  " : "FAIL");             \
+        printf(__VA_ARGS__);                                \
+        printf("\n");                                       \
+        if (!(ok))                                          \
+            (fails)++;                                      \
+    } while (0)
+
+#endif /* TOOLS_HOST_BENCH_BENCH_H_ */
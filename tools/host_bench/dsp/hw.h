@@ -0,0 +1,182 @@
+/**
+ * @file hw.h
+ * @brief Host models of the Cortex-M33 DSP extension intrinsics
+ *
+ * Lets a harness build a stage source a second time with
+ * __ARM_FEATURE_DSP=1, so the packed path of basic_op.h and the stages can
+ * be compared bit for bit against the scalar fallback on the host. Only the
+ * intrinsics the tree uses are modelled. The GE flags written by __SSUB16
+ * and read by __SEL are a file-scope variable, as the APSR is on target.
+ */
+
+#ifndef TOOLS_HOST_BENCH_DSP_HW_H_
+#define TOOLS_HOST_BENCH_DSP_HW_H_
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/* ----------------------------------------------------------------------------
+ * Local helpers
+ * --------------------------------------------------------------------------*/
+
+static uint32_t hw_ge;                  /* APSR.GE, one bit per byte */
+
+static inline int32_t hw_lo(uint32_t x)
+{
+    return (int16_t)(x & 0xFFFFu);
+}
+
+static inline int32_t hw_hi(uint32_t x)
+{
+    return (int16_t)(x >> 16);
+}
+
+static inline int64_t hw_sat(int64_t x, int bits)
+{
+    const int64_t max = ((int64_t)1 << (bits - 1)) - 1;
+
+    return (x > max) ? max : ((x < -max - 1) ? -max - 1 : x);
+}
+
+static inline uint32_t hw_pair(int32_t lo, int32_t hi)
+{
+    return ((uint32_t)lo & 0xFFFFu) | ((uint32_t)hi << 16);
+}
+
+/* ----------------------------------------------------------------------------
+ * Saturating and bit operations
+ * --------------------------------------------------------------------------*/
+
+#define __SSAT(x, n)                ((int32_t)hw_sat((int32_t)(x), (n)))
+
+static inline int32_t __QADD(int32_t a, int32_t b)
+{
+    return (int32_t)hw_sat((int64_t)a + b, 32);
+}
+
+static inline int32_t __QSUB(int32_t a, int32_t b)
+{
+    return (int32_t)hw_sat((int64_t)a - b, 32);
+}
+
+static inline uint32_t __CLZ(uint32_t x)
+{
+    return (x == 0) ? 32 : (uint32_t)__builtin_clz(x);
+}
+
+static inline uint32_t __ROR(uint32_t x, uint32_t n)
+{
+    n &= 31;
+    return (n == 0) ? x : ((x >> n) | (x << (32 - n)));
+}
+
+#define __PKHBT(a, b, sh)                                                   \
+    (((uint32_t)(a) & 0xFFFFu) | (((uint32_t)(b) << (sh)) & 0xFFFF0000u))
+
+/* ----------------------------------------------------------------------------
+ * Packed halfword operations
+ * --------------------------------------------------------------------------*/
+
+static inline uint32_t __QADD16(uint32_t a, uint32_t b)
+{
+    return hw_pair((int32_t)hw_sat(hw_lo(a) + hw_lo(b), 16),
+                   (int32_t)hw_sat(hw_hi(a) + hw_hi(b), 16));
+}
+
+static inline uint32_t __QSUB16(uint32_t a, uint32_t b)
+{
+    return hw_pair((int32_t)hw_sat(hw_lo(a) - hw_lo(b), 16),
+                   (int32_t)hw_sat(hw_hi(a) - hw_hi(b), 16));
+}
+
+static inline uint32_t __SHADD16(uint32_t a, uint32_t b)
+{
+    return hw_pair((hw_lo(a) + hw_lo(b)) >> 1, (hw_hi(a) + hw_hi(b)) >> 1);
+}
+
+static inline uint32_t __SHSUB16(uint32_t a, uint32_t b)
+{
+    return hw_pair((hw_lo(a) - hw_lo(b)) >> 1, (hw_hi(a) - hw_hi(b)) >> 1);
+}
+
+static inline uint32_t __QASX(uint32_t a, uint32_t b)
+{
+    return hw_pair((int32_t)hw_sat(hw_lo(a) - hw_hi(b), 16),
+                   (int32_t)hw_sat(hw_hi(a) + hw_lo(b), 16));
+}
+
+static inline uint32_t __QSAX(uint32_t a, uint32_t b)
+{
+    return hw_pair((int32_t)hw_sat(hw_lo(a) + hw_hi(b), 16),
+                   (int32_t)hw_sat(hw_hi(a) - hw_lo(b), 16));
+}
+
+/** @brief Wrapping halfword subtract; sets GE for each lane with a >= b */
+static inline uint32_t __SSUB16(uint32_t a, uint32_t b)
+{
+    int32_t lo = hw_lo(a) - hw_lo(b);
+    int32_t hi = hw_hi(a) - hw_hi(b);
+
+    hw_ge = ((lo >= 0) ? 0x3u : 0) | ((hi >= 0) ? 0xCu : 0);
+    return hw_pair(lo, hi);
+}
+
+/** @brief Each byte from a where its GE flag is set, from b otherwise */
+static inline uint32_t __SEL(uint32_t a, uint32_t b)
+{
+    uint32_t m = 0;
+
+    for (int i = 0; i < 4; i++)
+        if (hw_ge & (1u << i))
+            m |= 0xFFu << (8 * i);
+    return (a & m) | (b & ~m);
+}
+
+static inline uint32_t __SXTB16(uint32_t x)
+{
+    return hw_pair((int8_t)(x & 0xFFu), (int8_t)((x >> 16) & 0xFFu));
+}
+
+/* ----------------------------------------------------------------------------
+ * Halfword multiplies
+ * --------------------------------------------------------------------------*/
+
+static inline int32_t __SMULBB(int32_t a, int32_t b)
+{
+    return hw_lo((uint32_t)a) * hw_lo((uint32_t)b);
+}
+
+static inline int32_t __SMULTT(int32_t a, int32_t b)
+{
+    return hw_hi((uint32_t)a) * hw_hi((uint32_t)b);
+}
+
+static inline uint32_t __SMUAD(uint32_t a, uint32_t b)
+{
+    return (uint32_t)((int64_t)hw_lo(a) * hw_lo(b) + (int64_t)hw_hi(a) * hw_hi(b));
+}
+
+static inline uint32_t __SMUSD(uint32_t a, uint32_t b)
+{
+    return (uint32_t)((int64_t)hw_lo(a) * hw_lo(b) - (int64_t)hw_hi(a) * hw_hi(b));
+}
+
+static inline uint32_t __SMUADX(uint32_t a, uint32_t b)
+{
+    return (uint32_t)((int64_t)hw_lo(a) * hw_hi(b) + (int64_t)hw_hi(a) * hw_lo(b));
+}
+
+static inline uint32_t __SMUSDX(uint32_t a, uint32_t b)
+{
+    return (uint32_t)((int64_t)hw_lo(a) * hw_hi(b) - (int64_t)hw_hi(a) * hw_lo(b));
+}
+
+static inline uint32_t __SMLAD(uint32_t a, uint32_t b, uint32_t acc)
+{
+    return __SMUAD(a, b) + acc;
+}
+
+#endif /* TOOLS_HOST_BENCH_DSP_HW_H_ */
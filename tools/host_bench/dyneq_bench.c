@@ -0,0 +1,192 @@
+/**
+ * @file dyneq_bench.c
+ * @brief Host harness for the dynamic-parametric EQ (dyn_eq.c)
+ *
+ * A -12 dB EQ cut on every bin, Threshold_Low -50 dBFS, Threshold_High
+ * -20 dBFS. Steady tones centred on a bin run through FB_Analysis,
+ * DYNEQ_Process and FB_Synthesis; the checks are:
+ *   - the tracked level of the bin against the tone level
+ *   - below the low threshold the tone passes flat, above the high one it
+ *     gets the full cut, both measured on the output
+ *   - in between, the bin gain follows the linear interpolation with the
+ *     level in dB that dyn_eq.h describes
+ *   - with no low threshold the stage is a static EQ at any level
+ *   - after a 40 dB step the tracked level covers 63% of the step in
+ *     Energy_Time
+ * The host time per DYNEQ_Process frame follows; the CM33 figure is
+ * app_stage_cycles_max[APP_STAGE_DPEQ] on the target.
+ *
+ * Usage: dyneq_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include "bench.h"
+#include "basic_op.h"
+#include "dyn_eq.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define DYNEQ_BENCH_LEN             16384       /* samples per case */
+#define DYNEQ_BENCH_TAIL            4096        /* steady part that is analysed */
+#define DYNEQ_BENCH_BIN             8           /* 3906 Hz */
+#define DYNEQ_BENCH_CUT             (-12.0)     /* dB */
+#define DYNEQ_BENCH_HIGH            (-20.0)     /* dBFS */
+#define DYNEQ_BENCH_LOW             (-50.0)     /* dBFS */
+#define DYNEQ_BENCH_TIME            20.0        /* ms, Energy_Time */
+#define DYNEQ_BENCH_LEVEL_TOL       1.0         /* dB, tracked level */
+#define DYNEQ_BENCH_GAIN_TOL        0.3         /* dB, bin and output gain */
+#define DYNEQ_BENCH_TIME_TOL        0.2         /* relative */
+#define DYNEQ_BENCH_TIMED           100000
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static DYNEQ_State_t dp;
+static FB_State_t fb;
+static double in[DYNEQ_BENCH_LEN], out[DYNEQ_BENCH_LEN];
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Compile the bench EQ with the given low threshold and reset the stage
+ */
+static void dyneq_setup(double low)
+{
+    MCU_Config_DPEQ dpeq = { DYNEQ_BENCH_TIME, DYNEQ_BENCH_HIGH, low };
+    MCU_Config_EQ eq = { { 0 } };
+    DYNEQ_Config_t cfg;
+
+    for (int k = 0; k < FB_BINS; k++)
+        eq.dB_Gain_float[k] = (float)DYNEQ_BENCH_CUT;
+    DYNEQ_Parser(&dpeq, &eq, &cfg);
+    DYNEQ_Init(&dp, &cfg);
+    FB_Init(&fb);
+}
+
+/**
+ * @brief Run a steady tone on the bench bin at a level in dBFS
+ * @return Output against input level of the tone in dB
+ */
+static double dyneq_run(double level)
+{
+    const double f0 = DYNEQ_BENCH_BIN * BENCH_FS / FB_FFT_LEN;
+    const double a = pow(10.0, level / 20.0);
+    const int tail = DYNEQ_BENCH_LEN - DYNEQ_BENCH_TAIL;
+
+    for (int f = 0; f < DYNEQ_BENCH_LEN / FB_HOP; f++)
+    {
+        Word32 block[FB_HOP];
+        FB_Spectrum_t spec;
+
+        for (int i = 0; i < FB_HOP; i++)
+        {
+            in[f * FB_HOP + i] = a * sin(2.0 * M_PI * f0 * (f * FB_HOP + i) / BENCH_FS);
+            block[i] = (Word32)(in[f * FB_HOP + i] * BENCH_Q31);
+        }
+        FB_Analysis(&fb, block, &spec);
+        DYNEQ_Process(&dp, &fb, &spec);
+        FB_Synthesis(&fb, &spec, block);
+        for (int i = 0; i < FB_HOP; i++)
+            out[f * FB_HOP + i] = block[i] / BENCH_Q31;
+    }
+    return 10.0 * log10(bench_tone_power(out + tail, DYNEQ_BENCH_TAIL, f0)
+                        / bench_tone_power(in + tail, DYNEQ_BENCH_TAIL, f0));
+}
+
+/**
+ * @brief Tracked level of the bench bin in dBFS
+ */
+static double dyneq_level(void)
+{
+    /* DYNEQ_LOG_FS of dyn_eq.c: a full-scale sine centred on the bin */
+    return (dp.level[DYNEQ_BENCH_BIN] - 18100) / 256.0 * 10.0 * log10(2.0);
+}
+
+/**
+ * @brief Bin gain of the bench bin in dB
+ */
+static double dyneq_gain(void)
+{
+    return 20.0 * log10(dp.gain[DYNEQ_BENCH_BIN] / 32768.0);
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    static const double levels[] = { -60.0, -50.0, -40.0, -35.0, -30.0, -10.0 };
+    const double cut = pow(10.0, DYNEQ_BENCH_CUT / 20.0);
+    double from, g, tau = 0.0;
+    FB_Spectrum_t spec, s;
+    Word32 block[FB_HOP];
+    uint64_t t;
+    int fails = 0;
+
+    for (size_t j = 0; j < sizeof(levels) / sizeof(levels[0]); j++)
+    {
+        double l = levels[j];
+        double w = (l <= DYNEQ_BENCH_LOW) ? 0.0 : (l >= DYNEQ_BENCH_HIGH) ? 1.0
+                 : (l - DYNEQ_BENCH_LOW) / (DYNEQ_BENCH_HIGH - DYNEQ_BENCH_LOW);
+        double expect = 20.0 * log10(1.0 - (1.0 - cut) * w);
+
+        dyneq_setup(DYNEQ_BENCH_LOW);
+        g = dyneq_run(l);
+        BENCH_CHECK(fails, fabs(dyneq_level() - l) <= DYNEQ_BENCH_LEVEL_TOL,
+                    "%5.1f dBFS: tracked level %6.2f dBFS", l, dyneq_level());
+        if (w == 0.0 || w == 1.0)
+            BENCH_CHECK(fails, fabs(g - expect) <= DYNEQ_BENCH_GAIN_TOL,
+                        "%5.1f dBFS: output %6.2f dB (expect %6.2f)", l, g, expect);
+        else
+            BENCH_CHECK(fails, fabs(dyneq_gain() - expect) <= DYNEQ_BENCH_GAIN_TOL,
+                        "%5.1f dBFS: bin gain %6.2f dB (expect %6.2f)", l, dyneq_gain(), expect);
+    }
+
+    /* No low threshold: the full cut at any level */
+    dyneq_setup(-1024.0);
+    g = dyneq_run(-60.0);
+    BENCH_CHECK(fails, fabs(g - DYNEQ_BENCH_CUT) <= DYNEQ_BENCH_GAIN_TOL, "static EQ at -60 dBFS: output %6.2f dB", g);
+
+    /* 40 dB step: frames until the level covers 63% of it, in dB */
+    dyneq_setup(DYNEQ_BENCH_LOW);
+    dyneq_run(-60.0);
+    from = dyneq_level();
+    for (int f = 0; f < DYNEQ_BENCH_LEN / FB_HOP && tau == 0.0; f++)
+    {
+        for (int i = 0; i < FB_HOP; i++)
+            block[i] = (Word32)(0.1 * sin(2.0 * M_PI * DYNEQ_BENCH_BIN * (f * FB_HOP + i) / FB_FFT_LEN) * BENCH_Q31);
+        FB_Analysis(&fb, block, &spec);
+        DYNEQ_Process(&dp, &fb, &spec);
+        if (dyneq_level() - from >= 0.632 * 40.0)
+            tau = (f + 1) * FB_HOP / BENCH_FS * 1000.0;
+    }
+    BENCH_CHECK(fails, fabs(tau / DYNEQ_BENCH_TIME - 1.0) <= DYNEQ_BENCH_TIME_TOL,
+                "40 dB step: 63%% in %.1f ms (Energy_Time %.0f ms)", tau, DYNEQ_BENCH_TIME);
+
+    /* Time per frame with the bench bin between the thresholds */
+    dyneq_setup(DYNEQ_BENCH_LOW);
+    dyneq_run(-35.0);
+    for (int i = 0; i < FB_HOP; i++)
+        block[i] = (Word32)(0.0178 * sin(2.0 * M_PI * DYNEQ_BENCH_BIN * i / FB_FFT_LEN) * BENCH_Q31);
+    FB_Analysis(&fb, block, &spec);
+    t = bench_ns();
+    for (int r = 0; r < DYNEQ_BENCH_TIMED; r++)
+    {
+        s = spec;
+        DYNEQ_Process(&dp, &fb, &s);
+    }
+    t = bench_ns() - t;
+
+    printf("host time: %.2f us/frame\n", (double)t / DYNEQ_BENCH_TIMED / 1000.0);
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
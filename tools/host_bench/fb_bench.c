@@ -0,0 +1,186 @@
+/**
+ * @file fb_bench.c
+ * @brief Shared filterbank against one filterbank per spectral stage
+ *
+ * Runs N = 1..FB_BENCH_STAGES spectral stages (NR_Process, DYNEQ_Process,
+ * NFC_Process, in the order of APP_Audio_Run) on the same input two ways:
+ *   shared    one FB_Analysis, the N stages on its spectrum, one
+ *             FB_Synthesis, as APP_Audio_Run does
+ *   separate  each stage with an analysis and synthesis of its own, the
+ *             output of one feeding the next
+ * and prints the host time per frame of each, the difference, and the
+ * (N - 1) analysis/synthesis pairs APP_Audio_Run reports in
+ * app_stage_cycles_saved for the same case. The stage work is the same both
+ * ways, so the difference should come to that estimate; host timing is
+ * noisy, so the check only asks for FB_BENCH_SAVED_MIN of it. Each time is
+ * the best of FB_BENCH_REPEAT runs.
+ *
+ * Usage: fb_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "basic_op.h"
+#include "filterbank.h"
+#include "nr_wiener.h"
+#include "dyn_eq.h"
+#include "nfc.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define FB_BENCH_STAGES             3
+#define FB_BENCH_FRAMES             20000
+#define FB_BENCH_REPEAT             9
+#define FB_BENCH_SAVED_MIN          0.5         /* of the estimate */
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static FB_State_t fb[FB_BENCH_STAGES];
+static FB_Spectrum_t spec;
+static SM_CONFIG_NC nc;
+static NR_State_t nr;
+static DYNEQ_Config_t dyneq_cfg;
+static DYNEQ_State_t dyneq;
+static NFC_Config_t nfc_cfg;
+static NFC_State_t nfc;
+static Word32 input[FB_BENCH_FRAMES][FB_HOP];
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Reset the filterbanks and the stages
+ */
+static void fb_bench_reset(void)
+{
+    for (int s = 0; s < FB_BENCH_STAGES; s++)
+        FB_Init(&fb[s]);
+    NR_Init(&nr, &nc);
+    DYNEQ_Init(&dyneq, &dyneq_cfg);
+    NFC_Init(&nfc, &nfc_cfg);
+}
+
+/**
+ * @brief Run spectral stage s on a spectrum of filterbank f
+ */
+static void fb_bench_stage(int s, const FB_State_t *f, FB_Spectrum_t *sp)
+{
+    if (s == 0)
+        NR_Process(&nr, f, sp);
+    else if (s == 1)
+        DYNEQ_Process(&dyneq, f, sp);
+    else
+        NFC_Process(&nfc, f, sp);
+}
+
+/**
+ * @brief Host time per frame of n stages, shared or separate filterbanks, best of the repeats
+ */
+static double fb_bench_run(int n, int shared)
+{
+    double best = 1e30;
+
+    for (int r = 0; r < FB_BENCH_REPEAT; r++)
+    {
+        Word32 block[FB_HOP];
+        uint64_t t;
+
+        fb_bench_reset();
+        t = bench_ns();
+        for (int f = 0; f < FB_BENCH_FRAMES; f++)
+        {
+            for (int i = 0; i < FB_HOP; i++)
+                block[i] = input[f][i];
+            if (shared)
+            {
+                FB_Analysis(&fb[0], block, &spec);
+                for (int s = 0; s < n; s++)
+                    fb_bench_stage(s, &fb[0], &spec);
+                FB_Synthesis(&fb[0], &spec, block);
+            }
+            else
+            {
+                for (int s = 0; s < n; s++)
+                {
+                    FB_Analysis(&fb[s], block, &spec);
+                    fb_bench_stage(s, &fb[s], &spec);
+                    FB_Synthesis(&fb[s], &spec, block);
+                }
+            }
+        }
+        t = bench_ns() - t;
+        best = fmin(best, (double)t / FB_BENCH_FRAMES);
+    }
+    return best / 1000.0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    MCU_Config_DPEQ dpeq = { 6.0, -20.0, -50.0 };
+    MCU_Config_EQ eq = { { 0 } };
+    MCU_Config_NFC mcu_nfc = { 2000.0f, 2.0f };
+    double pair = 1e30;
+    int fails = 0;
+
+    srand(29);
+    for (int f = 0; f < FB_BENCH_FRAMES; f++)
+        for (int i = 0; i < FB_HOP; i++)
+            input[f][i] = (Word32)((rand() - RAND_MAX / 2) * 0.1 * 2.0 / RAND_MAX * BENCH_Q31);
+    for (int b = 0; b < 32; b++)
+        nc.normal_max_depth_dB[b] = (unsigned char)-12;
+    for (int k = 0; k < FB_BINS; k++)
+        eq.dB_Gain_float[k] = -6.0f;
+    DYNEQ_Parser(&dpeq, &eq, &dyneq_cfg);
+    NFC_Parser(&mcu_nfc, &nfc_cfg);
+
+    /* One analysis/synthesis pair, the unit app_stage_cycles_saved counts in */
+    for (int r = 0; r < FB_BENCH_REPEAT; r++)
+    {
+        Word32 block[FB_HOP];
+        uint64_t t;
+
+        FB_Init(&fb[0]);
+        t = bench_ns();
+        for (int f = 0; f < FB_BENCH_FRAMES; f++)
+        {
+            for (int i = 0; i < FB_HOP; i++)
+                block[i] = input[f][i];
+            FB_Analysis(&fb[0], block, &spec);
+            FB_Synthesis(&fb[0], &spec, block);
+        }
+        t = bench_ns() - t;
+        pair = fmin(pair, (double)t / FB_BENCH_FRAMES / 1000.0);
+    }
+    printf("analysis + synthesis: %.3f us/frame\n", pair);
+
+    for (int n = 1; n <= FB_BENCH_STAGES; n++)
+    {
+        double shared = fb_bench_run(n, 1);
+        double separate = fb_bench_run(n, 0);
+        double saved = separate - shared;
+        double estimate = (n - 1) * pair;
+
+        if (n == 1)
+            printf("      1 stage:  shared %.3f us, separate %.3f us\n", shared, separate);
+        else
+            BENCH_CHECK(fails, saved >= FB_BENCH_SAVED_MIN * estimate,
+                        "%d stages: shared %.3f us, separate %.3f us, saved %.3f us (estimate %.3f us)",
+                        n, shared, separate, saved, estimate);
+    }
+
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
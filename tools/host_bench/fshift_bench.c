@@ -0,0 +1,254 @@
+/**
+ * @file fshift_bench.c
+ * @brief Host harness for the frequency shifter (fshift.c)
+ *
+ * Open loop: steady tones from 200 Hz to 12 kHz through a 5 Hz shift must
+ * leave at f + 5 Hz, at the input level, with the image at f - 5 Hz at
+ * least FSHIFT_BENCH_IMAGE_MIN down.
+ *
+ * Closed loop: the feedback simulation behind the stable gain figures.
+ * The microphone picks up the source plus the output through a 24-tap
+ * feedback path 40 samples late. The NLMS canceller (AFC_Process) runs
+ * on it, then a broadband gain with a 2 ms forward delay, then the
+ * shifter, then AFC_Reference, matching the order in APP_Audio_Run. The
+ * gain rises in 1 dB steps until the output clips or grows. The first
+ * unstable gain of one run swings by several dB with the noise seed, so
+ * each setting is the mean over FSHIFT_BENCH_SEEDS runs; the shift must
+ * not cost more than FSHIFT_BENCH_GAIN_TOL of it for noise or a tone.
+ * Without the canceller the loop is only printed as a check of the path.
+ *
+ * Usage: fshift_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "basic_op.h"
+#include "afc_nlms.h"
+#include "fshift.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define FSHIFT_BENCH_HZ             5.0
+#define FSHIFT_BENCH_LEN            65536       /* open loop samples */
+#define FSHIFT_BENCH_TAIL           32768
+#define FSHIFT_BENCH_AMP            0.3
+#define FSHIFT_BENCH_LEVEL_TOL      0.5         /* dB */
+#define FSHIFT_BENCH_IMAGE_MIN      40.0        /* dB */
+
+#define FSHIFT_BENCH_PATH_DELAY     40          /* samples */
+#define FSHIFT_BENCH_PATH_LEN       24
+#define FSHIFT_BENCH_FWD_DELAY      64          /* samples, 2 ms */
+#define FSHIFT_BENCH_SECONDS        10
+#define FSHIFT_BENCH_MAX_GAIN       40          /* dB */
+#define FSHIFT_BENCH_SEEDS          6
+#define FSHIFT_BENCH_GAIN_TOL       0.5         /* dB */
+#define FSHIFT_BENCH_SAMPLES        (FSHIFT_BENCH_SECONDS * 31250)
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static FSHIFT_State_t fsh;
+static AFC_State_t afc;
+static double out[FSHIFT_BENCH_LEN];
+static double path[FSHIFT_BENCH_PATH_LEN];
+static double spk[FSHIFT_BENCH_SAMPLES];
+static double err[FSHIFT_BENCH_SAMPLES];
+static uint64_t shift_ns;
+static int shift_frames;
+static unsigned seed;
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+static double fshift_gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static Word32 fshift_q31(double x)
+{
+    x = (x > 0.999) ? 0.999 : (x < -0.999) ? -0.999 : x;
+    return (Word32)(x * BENCH_Q31);
+}
+
+/**
+ * @brief Check one steady tone through the shifter alone
+ */
+static int fshift_tone(double f0)
+{
+    const double *x = out + FSHIFT_BENCH_LEN - FSHIFT_BENCH_TAIL;
+    FSHIFT_Config_t cfg;
+    double ref, up, image, level;
+    int fails = 0;
+
+    FSHIFT_Parser((float)FSHIFT_BENCH_HZ, &cfg);
+    FSHIFT_Init(&fsh, &cfg);
+    for (int f = 0; f < FSHIFT_BENCH_LEN / AUDIO_BLOCK_SIZE; f++)
+    {
+        Word32 block[AUDIO_BLOCK_SIZE];
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+            block[i] = fshift_q31(FSHIFT_BENCH_AMP * sin(2.0 * M_PI * f0 * (f * AUDIO_BLOCK_SIZE + i) / BENCH_FS));
+        FSHIFT_Process(&fsh, block);
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+            out[f * AUDIO_BLOCK_SIZE + i] = block[i] / BENCH_Q31;
+    }
+
+    /* Hann power of a sine of amplitude a over n samples is (a n / 4)^2 */
+    ref = pow(FSHIFT_BENCH_AMP * FSHIFT_BENCH_TAIL / 4.0, 2.0);
+    up = bench_tone_power(x, FSHIFT_BENCH_TAIL, f0 + FSHIFT_BENCH_HZ);
+    image = 10.0 * log10(up / (bench_tone_power(x, FSHIFT_BENCH_TAIL, f0 - FSHIFT_BENCH_HZ) + 1e-30));
+    level = 10.0 * log10(up / ref);
+
+    BENCH_CHECK(fails, fabs(level) <= FSHIFT_BENCH_LEVEL_TOL && image >= FSHIFT_BENCH_IMAGE_MIN,
+                "tone %5.0f Hz -> %+.0f Hz  level %+5.2f dB  image %5.1f dB down", f0, FSHIFT_BENCH_HZ, level, image);
+    return fails;
+}
+
+/**
+ * @brief Run the loop at one gain
+ * @return true if it went unstable
+ */
+static bool fshift_loop(double gain_db, bool canceller, double shift, bool tonal)
+{
+    SM_CONFIG_FBC fbc = { 0 };
+    FSHIFT_Config_t cfg;
+    double g = pow(10.0, gain_db / 20.0);
+    double s1 = 0.0, s2 = 0.0, early = 0.0, late = 0.0;
+    const int frames = FSHIFT_BENCH_SAMPLES / AUDIO_BLOCK_SIZE;
+    int clip = 0;
+
+    fbc.TFBC_Enable = canceller;
+    fbc.EcTaps = 64;
+    fbc.MuDivNumTaps = (int)(0.5 / 64 * 32768);
+    fbc.DerivedQshift = 3;
+    fbc.ConvergenceSpeed = 2;
+    AFC_Init(&afc, &fbc, AUDIO_BLOCK_SIZE, 2);
+    FSHIFT_Parser((float)shift, &cfg);
+    FSHIFT_Init(&fsh, &cfg);
+    memset(spk, 0, sizeof(spk));
+    memset(err, 0, sizeof(err));
+    srand(seed);
+
+    for (int f = 0; f < frames; f++)
+    {
+        Word32 block[AUDIO_BLOCK_SIZE];
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        {
+            int t = f * AUDIO_BLOCK_SIZE + i;
+            double s = fshift_gauss() + 1.6 * s1 - 0.8 * s2;
+            double m;
+
+            s2 = s1;
+            s1 = s;
+            m = tonal ? 0.03 * sin(2.0 * M_PI * 1000.0 * t / BENCH_FS) + 0.002 * s : 0.01 * s;
+            for (int k = 0; k < FSHIFT_BENCH_PATH_LEN; k++)
+            {
+                if (t - FSHIFT_BENCH_PATH_DELAY - k >= 0)
+                    m += path[k] * spk[t - FSHIFT_BENCH_PATH_DELAY - k];
+            }
+            block[i] = fshift_q31(m);
+        }
+        if (canceller)
+            AFC_Process(&afc, block);
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        {
+            int t = f * AUDIO_BLOCK_SIZE + i;
+            double o;
+
+            err[t] = block[i] / BENCH_Q31;
+            o = (t >= FSHIFT_BENCH_FWD_DELAY) ? g * err[t - FSHIFT_BENCH_FWD_DELAY] : 0.0;
+            if (fabs(o) >= 0.999)
+                clip++;
+            block[i] = fshift_q31(o);
+        }
+        if (shift > 0.0)
+        {
+            uint64_t t0 = bench_ns();
+
+            FSHIFT_Process(&fsh, block);
+            shift_ns += bench_ns() - t0;
+            shift_frames++;
+        }
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        {
+            double o = block[i] / BENCH_Q31;
+
+            spk[f * AUDIO_BLOCK_SIZE + i] = o;
+            if (f > frames * 3 / 4)
+                late += o * o;
+            else if (f > frames / 4 && f < frames / 2)
+                early += o * o;
+        }
+        if (canceller)
+            AFC_Reference(&afc, block);
+    }
+    return clip > frames / 100 || late > 4.0 * early;
+}
+
+/**
+ * @brief First gain in 1 dB steps at which the loop goes unstable
+ */
+static int fshift_unstable(bool canceller, double shift, bool tonal)
+{
+    for (int g = 0; g <= FSHIFT_BENCH_MAX_GAIN; g++)
+    {
+        if (fshift_loop(g, canceller, shift, tonal))
+            return g;
+    }
+    return FSHIFT_BENCH_MAX_GAIN + 1;
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    static const double tones[] = { 200, 500, 1000, 2000, 4000, 8000, 12000 };
+    static const double shifts[] = { 0.0, 5.0, 10.0 };
+    int fails = 0;
+
+    for (unsigned i = 0; i < sizeof(tones) / sizeof(tones[0]); i++)
+        fails += fshift_tone(tones[i]);
+
+    for (int k = 0; k < FSHIFT_BENCH_PATH_LEN; k++)
+        path[k] = 0.08 * exp(-k / 5.0) * cos(2.0 * M_PI * k * 0.22);
+
+    seed = 1;
+    printf("no AFC, noise: unstable at %d dB\n", fshift_unstable(false, 0.0, false));
+
+    printf("first unstable gain with NLMS and PEM, mean of %d seeds, dB\n", FSHIFT_BENCH_SEEDS);
+    printf("                shift:  0 Hz  5 Hz 10 Hz\n");
+    for (int tonal = 0; tonal < 2; tonal++)
+    {
+        double g[3] = { 0.0 };
+        bool ok = true;
+
+        for (int s = 0; s < 3; s++)
+        {
+            for (seed = 1; seed <= FSHIFT_BENCH_SEEDS; seed++)
+                g[s] += (double)fshift_unstable(true, shifts[s], tonal) / FSHIFT_BENCH_SEEDS;
+            ok &= g[s] >= g[0] - FSHIFT_BENCH_GAIN_TOL;
+        }
+        BENCH_CHECK(fails, ok, "%-5s                 %5.1f %5.1f %5.1f", tonal ? "tone" : "noise", g[0], g[1], g[2]);
+    }
+
+    printf("%.0f ns/frame (host)\n", (double)shift_ns / shift_frames);
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
@@ -0,0 +1,247 @@
+/**
+ * @file level_bench.c
+ * @brief Accuracy and timing of the integer level kernels (level.h, level.c)
+ *
+ * Compares every scalar kernel against libm over its input range:
+ *   LVL_Log2, LVL_Log2_64   against log2 over 32 and 64 bits
+ *   LVL_Pow2                against 2^(y/256) where the result is >= 256
+ *   LVL_PowerDb, LVL_AmpDb  against 10 log10 and 20 log10
+ *   LVL_DbToGain            against 10^(dB/20) from -60 dB to +90 dB
+ *   LVL_Rsqrt               against 1/sqrt, relative
+ * and LVL_Follow against a double follower, which may trail by the rounding
+ * dead band of 2^15/c LSB. level.c is also built with the DSP extension
+ * modelled by host_bench/dsp/hw.h, as LVL_Follow_dsp, and the two-lane path
+ * must match the scalar one bit for bit, also at full scale, where the
+ * difference saturates and the follower must still stop at the level.
+ *
+ * The host times of the kernels against libm follow.
+ *
+ * Usage: level_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "level.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define LVL_BENCH_LOG2_MAX          0.011       /* octave */
+#define LVL_BENCH_POW2_MAX          0.01        /* octave */
+#define LVL_BENCH_POWER_DB_MAX      0.05        /* dB */
+#define LVL_BENCH_AMP_DB_MAX        0.1         /* dB */
+#define LVL_BENCH_GAIN_DB_MAX       0.15        /* dB, above -60 dB */
+#define LVL_BENCH_RSQRT_MAX         1e-4        /* relative */
+#define LVL_BENCH_BINS              33          /* bins of the 64-point filterbank */
+#define LVL_BENCH_FRAMES            20000
+#define LVL_BENCH_CALLS             10000000
+
+/* ----------------------------------------------------------------------------
+ * Function prototype definitions
+ * --------------------------------------------------------------------------*/
+
+/* LVL_Follow built with the DSP extension modelled */
+void LVL_Follow_dsp(Word16 *env, const Word16 *x, int n, Word16 attack, Word16 release);
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static volatile UWord32 sink;
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Next value of a step through the 32-bit range, dense near zero
+ */
+static uint64_t lvl_bench_next(uint64_t x)
+{
+    return x + (x >> 12) + 1;
+}
+
+/**
+ * @brief Random level within +/-16383, where no difference saturates
+ */
+static Word16 lvl_bench_level(void)
+{
+    return (Word16)(rand() % 32767 - 16383);
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    int fails = 0;
+    double e_log2 = 0.0, e_log2_64 = 0.0, e_pow2 = 0.0, e_power = 0.0;
+    double e_amp = 0.0, e_gain = 0.0, e_rsqrt = 0.0;
+    uint64_t x;
+    uint64_t t0;
+    double t_log2, t_libm_log2, t_rsqrt, t_libm_rsqrt, t_follow;
+
+    printf("level_bench: integer level kernels against libm\n");
+
+    for (x = 2; x <= 0xFFFFFFFFull; x = lvl_bench_next(x))
+    {
+        double l = log2((double)x);
+        double r = LVL_Rsqrt((UWord32)x) / 2147483648.0 * sqrt((double)x);
+
+        e_log2 = fmax(e_log2, fabs(LVL_Log2((UWord32)x) / 256.0 - l));
+        e_power = fmax(e_power, fabs(LVL_PowerDb((UWord32)x) / 256.0 - 10.0 * log10((double)x)));
+        e_amp = fmax(e_amp, fabs(LVL_AmpDb((UWord32)x) / 256.0 - 20.0 * log10((double)x)));
+        e_rsqrt = fmax(e_rsqrt, fabs(r - 1.0));
+    }
+    for (x = 1ull << 32; x < (1ull << 63); x += x >> 10)
+        e_log2_64 = fmax(e_log2_64, fabs(LVL_Log2_64(x) / 256.0 - log2((double)x)));
+
+    for (int y = 0; y < 32 * 256; y++)
+    {
+        UWord32 p = LVL_Pow2(y);
+
+        if (p >= 256)
+            e_pow2 = fmax(e_pow2, fabs(log2((double)p) - y / 256.0));
+    }
+    for (int db = -60 * 256; db <= 90 * 256; db++)
+        e_gain = fmax(e_gain, fabs(20.0 * log10(LVL_DbToGain(db) / 65536.0) - db / 256.0));
+
+    BENCH_CHECK(fails, e_log2 <= LVL_BENCH_LOG2_MAX,
+                "LVL_Log2     max error %.4f octave (limit %.3f)", e_log2, LVL_BENCH_LOG2_MAX);
+    BENCH_CHECK(fails, e_log2_64 <= LVL_BENCH_LOG2_MAX,
+                "LVL_Log2_64  max error %.4f octave above 2^32 (limit %.3f)", e_log2_64, LVL_BENCH_LOG2_MAX);
+    BENCH_CHECK(fails, e_pow2 <= LVL_BENCH_POW2_MAX,
+                "LVL_Pow2     max error %.4f octave (limit %.3f)", e_pow2, LVL_BENCH_POW2_MAX);
+    BENCH_CHECK(fails, e_power <= LVL_BENCH_POWER_DB_MAX,
+                "LVL_PowerDb  max error %.3f dB (limit %.2f)", e_power, LVL_BENCH_POWER_DB_MAX);
+    BENCH_CHECK(fails, e_amp <= LVL_BENCH_AMP_DB_MAX,
+                "LVL_AmpDb    max error %.3f dB (limit %.2f)", e_amp, LVL_BENCH_AMP_DB_MAX);
+    BENCH_CHECK(fails, e_gain <= LVL_BENCH_GAIN_DB_MAX,
+                "LVL_DbToGain max error %.3f dB from -60 to +90 dB (limit %.2f)", e_gain, LVL_BENCH_GAIN_DB_MAX);
+    BENCH_CHECK(fails, e_rsqrt <= LVL_BENCH_RSQRT_MAX,
+                "LVL_Rsqrt    max relative error %.2e (limit %.0e)", e_rsqrt, LVL_BENCH_RSQRT_MAX);
+
+    /* Follower: scalar against the DSP path, and against a double follower */
+    {
+        static Word16 env[LVL_BENCH_BINS], env_dsp[LVL_BENCH_BINS], in[LVL_BENCH_BINS];
+        static double ref[LVL_BENCH_BINS];
+        long differ = 0, differ_fs = 0, overshoot = 0;
+        double lag = 0.0, band = 32768.0 / 300.0;
+
+        srand(45);
+        for (int f = 0; f < LVL_BENCH_FRAMES; f++)
+        {
+            int n = 1 + f % LVL_BENCH_BINS;
+            Word16 attack = (Word16)(1 + rand() % 32767);
+            Word16 release = (Word16)(1 + rand() % 32767);
+
+            for (int i = 0; i < LVL_BENCH_BINS; i++)
+                in[i] = lvl_bench_level();
+            LVL_Follow(env, in, n, attack, release);
+            LVL_Follow_dsp(env_dsp, in, n, attack, release);
+            for (int i = 0; i < LVL_BENCH_BINS; i++)
+                differ += (env[i] != env_dsp[i]);
+        }
+
+        /* Full scale: the extremes in turn and random levels over the whole Word16 range */
+        for (int f = 0; f < LVL_BENCH_FRAMES; f++)
+        {
+            Word16 attack = (Word16)(1 + rand() % 32767);
+            Word16 release = (Word16)(1 + rand() % 32767);
+            Word16 prev[LVL_BENCH_BINS];
+
+            for (int i = 0; i < LVL_BENCH_BINS; i++)
+            {
+                if (f & 1)
+                    in[i] = (Word16)(rand() % 65536 - 32768);
+                else
+                    in[i] = (((f >> 1) + i) & 1) ? MAX_16 : MIN_16;
+                prev[i] = env[i];
+            }
+            LVL_Follow(env, in, LVL_BENCH_BINS, attack, release);
+            LVL_Follow_dsp(env_dsp, in, LVL_BENCH_BINS, attack, release);
+            for (int i = 0; i < LVL_BENCH_BINS; i++)
+            {
+                differ_fs += (env[i] != env_dsp[i]);
+                overshoot += (in[i] >= prev[i]) ? (env[i] < prev[i] || env[i] > in[i])
+                                                : (env[i] > prev[i] || env[i] < in[i]);
+            }
+        }
+
+        /* Slow random walk, fixed coefficients, double reference from the same start */
+        for (int i = 0; i < LVL_BENCH_BINS; i++)
+        {
+            in[i] = 0;
+            env[i] = 0;
+            ref[i] = 0.0;
+        }
+        for (int f = 0; f < LVL_BENCH_FRAMES; f++)
+        {
+            for (int i = 0; i < LVL_BENCH_BINS; i++)
+            {
+                in[i] = (Word16)(in[i] + rand() % 257 - 128);
+                in[i] = (in[i] > 16383) ? 16383 : ((in[i] < -16383) ? -16383 : in[i]);
+                ref[i] += (in[i] - ref[i]) * ((in[i] >= ref[i]) ? 3000.0 : 300.0) / 32768.0;
+            }
+            LVL_Follow(env, in, LVL_BENCH_BINS, 3000, 300);
+            for (int i = 0; i < LVL_BENCH_BINS; i++)
+                lag = fmax(lag, fabs(env[i] - ref[i]));
+        }
+
+        BENCH_CHECK(fails, differ == 0,
+                    "LVL_Follow   DSP path against scalar: %ld of %d levels differ",
+                    differ, LVL_BENCH_FRAMES * LVL_BENCH_BINS);
+        BENCH_CHECK(fails, differ_fs == 0 && overshoot == 0,
+                    "LVL_Follow   full scale: %ld of %d levels differ, %ld past the level",
+                    differ_fs, LVL_BENCH_FRAMES * LVL_BENCH_BINS, overshoot);
+        BENCH_CHECK(fails, lag <= band,
+                    "LVL_Follow   max distance from the double follower %.1f LSB (dead band %.1f)",
+                    lag, band);
+    }
+
+    /* Host times */
+    t0 = bench_ns();
+    for (UWord32 i = 1; i < LVL_BENCH_CALLS; i++)
+        sink += (UWord32)LVL_Log2(i * 2654435761u);
+    t_log2 = (double)(bench_ns() - t0) / LVL_BENCH_CALLS;
+
+    t0 = bench_ns();
+    for (UWord32 i = 1; i < LVL_BENCH_CALLS; i++)
+        sink += (UWord32)(256.0 * log2((double)(i * 2654435761u)));
+    t_libm_log2 = (double)(bench_ns() - t0) / LVL_BENCH_CALLS;
+
+    t0 = bench_ns();
+    for (UWord32 i = 1; i < LVL_BENCH_CALLS; i++)
+        sink += LVL_Rsqrt(i * 2654435761u);
+    t_rsqrt = (double)(bench_ns() - t0) / LVL_BENCH_CALLS;
+
+    t0 = bench_ns();
+    for (UWord32 i = 1; i < LVL_BENCH_CALLS; i++)
+        sink += (UWord32)(2147483648.0 / sqrt((double)(i * 2654435761u)));
+    t_libm_rsqrt = (double)(bench_ns() - t0) / LVL_BENCH_CALLS;
+
+    {
+        static Word16 env[LVL_BENCH_BINS], in[LVL_BENCH_BINS];
+
+        t0 = bench_ns();
+        for (int i = 0; i < 1000000; i++)
+        {
+            in[i % LVL_BENCH_BINS] = (Word16)(i & 4095);
+            LVL_Follow(env, in, LVL_BENCH_BINS, 3000, 300);
+        }
+        t_follow = (double)(bench_ns() - t0) / 1000000;
+        sink += (UWord32)env[0];
+    }
+
+    printf("host time: LVL_Log2 %.2f ns (libm %.2f), LVL_Rsqrt %.2f ns (libm %.2f), "
+           "LVL_Follow %.1f ns for %d bins\n",
+           t_log2, t_libm_log2, t_rsqrt, t_libm_rsqrt, t_follow, LVL_BENCH_BINS);
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,405 @@
+/**
+ * @file loader_test.c
+ * @brief Host harness for the DSP loader (loader.c)
+ *
+ * Maps the DSP memories at their CM33 addresses and loads images packed or
+ * stored by dsp_pack, with a software CRC block and a DMA that completes at
+ * once. Checks:
+ * - single-bit corruptions are reported at the right section, and the
+ *   fallback image set with setLoadFallback() is loaded and started; with
+ *   a corrupt fallback, or none, the DSP stays in reset
+ * - deferred regions are left untouched until loadDeferred(), their Control
+ *   bits are cleared at the release, and an image with a section only
+ *   partly inside a region is rejected
+ * - overlay manifests are found by name, loadOverlay() writes only its
+ *   region and resets the loop cache, and a variant with a section outside
+ *   its region or a bad CRC is refused; the host time of an 8000-byte
+ *   swap follows
+ *
+ * Linux only (MAP_FIXED at 0x20000000); run with address randomization off
+ * so the heap cannot land on those mappings.
+ *
+ * Usage: loader_test <dsp_pack> <scratch dir>
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "bench.h"
+#include "hw.h"
+#include "loader.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define LT_TRIALS                   600
+#define LT_IMAGE                    ((uint8_t *)0x30000000)
+#define LT_PACKED                   ((uint8_t *)0x31000000)
+#define LT_PM(offset)               ((uint8_t *)(uintptr_t)(DSP0_PM_BASE + (offset)))
+#define LT_DM(offset)               ((uint8_t *)(uintptr_t)(DSP_DRAM56_BASE + (offset)))
+#define LT_NONE                     (1ull << 40)
+#define LT_SWAPS                    1000
+
+/* ----------------------------------------------------------------------------
+ * Host peripherals
+ * --------------------------------------------------------------------------*/
+
+DMA_Type host_dma0;
+SYSCTRL_Type host_sysctrl;
+DSP_Type host_dsp;
+CD_Type host_coredebug;
+DWT_Type host_dwt;
+uint32_t SystemCoreClock = 16000000;
+
+static uint32_t dma_src, dma_dst, dma_words;
+static int dma_busy;
+static CRC_Mock crc_regs = { LT_NONE, LT_NONE, LT_NONE, 0 };
+static uint16_t crc_value;
+
+void Sys_DMA_ChannelConfig(DMA_Type *dma, uint32_t cfg, uint32_t words, uint32_t cnt, uint32_t src, uint32_t dst)
+{
+    dma_src = src;
+    dma_dst = dst;
+    dma_words = words;
+}
+
+void Sys_DMA_Mode_Enable(DMA_Type *dma, uint32_t mode)
+{
+    dma_busy = (mode == DMA_ENABLE);
+    if (dma_busy)
+    {
+        memcpy((void *)(uintptr_t)dma_dst, (const void *)(uintptr_t)dma_src, dma_words * 4);
+        dma->STATUS |= DMA_COMPLETE_INT_TRUE;
+    }
+}
+
+static void crc_feed(uint8_t b)
+{
+    crc_value ^= (uint16_t)(b << 8);
+    for (int i = 0; i < 8; i++)
+        crc_value = (crc_value & 0x8000) ? (uint16_t)((crc_value << 1) ^ 0x1021) : (uint16_t)(crc_value << 1);
+}
+
+CRC_Mock *crc_mock(void)
+{
+    if (crc_regs.VALUE != LT_NONE)
+        crc_value = (uint16_t)crc_regs.VALUE;
+    if (crc_regs.ADD_8 != LT_NONE)
+        crc_feed((uint8_t)crc_regs.ADD_8);
+    if (crc_regs.ADD_32 != LT_NONE)
+    {
+        for (int i = 0; i < 4; i++)
+            crc_feed((uint8_t)(crc_regs.ADD_32 >> (8 * i)));
+    }
+    crc_regs.VALUE = crc_regs.ADD_8 = crc_regs.ADD_32 = LT_NONE;
+    crc_regs.FINAL = crc_value;
+    return &crc_regs;
+}
+
+/* ----------------------------------------------------------------------------
+ * Local variables and functions
+ * --------------------------------------------------------------------------*/
+
+static const char *packer;
+static char scratch_in[512], scratch_out[512];
+static uint32_t packed_used;
+
+static void *lt_map(uintptr_t base, size_t size)
+{
+    void *p = mmap((void *)base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+
+    if (p == MAP_FAILED)
+    {
+        perror("mmap");
+        exit(2);
+    }
+    return p;
+}
+
+/**
+ * @brief Run a buffer through dsp_pack; stored raw behind a header with raw
+ */
+static void *lt_pack(const void *buffer, uint32_t size, int raw)
+{
+    char cmd[1200];
+    uint8_t *dst = LT_PACKED + packed_used;
+    FILE *f = fopen(scratch_in, "wb");
+    size_t n;
+
+    fwrite(buffer, 1, size, f);
+    fclose(f);
+    snprintf(cmd, sizeof(cmd), "%s %s %s %s >/dev/null", packer, raw ? "-s" : "", scratch_in, scratch_out);
+    if (system(cmd) != 0)
+    {
+        fprintf(stderr, "%s failed\n", cmd);
+        exit(2);
+    }
+    f = fopen(scratch_out, "rb");
+    n = fread(dst, 1, 1 << 20, f);
+    fclose(f);
+    packed_used += (n + 7) & ~3u;
+    return dst;
+}
+
+static void lt_flip(void *section)
+{
+    uint8_t *p = section;
+    const loadSectionHeader *h = section;
+
+    p[sizeof(*h) + rand() % h->packedSize] ^= (uint8_t)(1 << (rand() % 8));
+}
+
+/**
+ * @brief Corrupt one section of an image per trial and load it with a fallback
+ */
+static int lt_fallback(void)
+{
+    int detected = 0, fell_back = 0, held = 0, bad_fallbacks = 0, fails = 0;
+    int ok;
+
+    for (int t = 0; t < LT_TRIALS; t++)
+    {
+        int raw = t & 1;
+        int bad_fallback = (t % 10 == 0);
+        int which = rand() % 3;
+        memoryDescription pm[2], dm[1], fpm[1], fdm[1];
+        memoryOverview image, fallback;
+        const loadStatus *status;
+        static const uint32_t addresses[3] = { 0x100, 0x2000, 0x8001 };
+
+        packed_used = 0;
+        pm[0] = (memoryDescription){ lt_pack(LT_IMAGE, 6000, raw), 0, 7200, 0x100 };
+        pm[1] = (memoryDescription){ lt_pack(LT_IMAGE + 0x8000, 3000, !raw), 0, 3600, 0x2000 };
+        /* DSP address 0x8001: the packed buffer starts at the word, one byte before it */
+        dm[0] = (memoryDescription){ lt_pack(LT_IMAGE + 0x10000, 4001, raw), 4000, 4000, 0x8001 };
+        fpm[0] = (memoryDescription){ lt_pack(LT_IMAGE + 0x20000, 6000, 0), 0, 7200, 0x100 };
+        fdm[0] = (memoryDescription){ LT_IMAGE + 0x30000, 2000, 2000, 0x8000 };
+        image = (memoryOverview){ { pm, 2 }, { dm, 1 }, { NULL, 0 } };
+        fallback = (memoryOverview){ { fpm, 1 }, { fdm, 1 }, { NULL, 0 } };
+
+        lt_flip(which == 0 ? pm[0].buffer : which == 1 ? pm[1].buffer : dm[0].buffer);
+        if (bad_fallback)
+        {
+            lt_flip(fpm[0].buffer);
+            bad_fallbacks++;
+        }
+
+        host_dsp.CTRL[0] = 0;
+        setLoadFallback(&fallback);
+        loadDSPMemory(&image, 0);
+        status = getLoadStatus();
+
+        if (status->failures >= 1 && status->vAddress == addresses[which] &&
+            status->memory == (which == 2 ? LOAD_MEMORY_DM : LOAD_MEMORY_PM))
+            detected++;
+        if (bad_fallback)
+        {
+            if (!status->started && host_dsp.CTRL[0] == 0 && status->fallback && status->failures == 2)
+                held++;
+        }
+        else if (status->started && status->fallback && host_dsp.CTRL[0] == DSP_RESET &&
+                 memcmp(LT_PM(0x200), LT_IMAGE + 0x20000, 6000) == 0 &&
+                 memcmp(LT_DM(0), LT_IMAGE + 0x30000, 2000) == 0)
+        {
+            fell_back++;
+        }
+        if (dma_busy)
+        {
+            printf("FAIL  DMA left running\n");
+            return 1;
+        }
+    }
+    BENCH_CHECK(fails, detected == LT_TRIALS, "%d single-bit corruptions, %d reported at the right section",
+                     LT_TRIALS, detected);
+    BENCH_CHECK(fails, fell_back == LT_TRIALS - bad_fallbacks, "%d of %d fell back and ran the fallback image",
+                     fell_back, LT_TRIALS - bad_fallbacks);
+    BENCH_CHECK(fails, held == bad_fallbacks, "%d of %d with a corrupt fallback held in reset",
+                     held, bad_fallbacks);
+
+    /* A clean image, then a corrupt one with no fallback set */
+    {
+        memoryDescription pm[1];
+        memoryOverview image = { { pm, 1 }, { NULL, 0 }, { NULL, 0 } };
+
+        packed_used = 0;
+        pm[0] = (memoryDescription){ lt_pack(LT_IMAGE, 6000, 0), 0, 7200, 0x100 };
+        setLoadFallback(NULL);
+        loadDSPMemory(&image, 0);
+        ok = getLoadStatus()->failures == 0 && getLoadStatus()->started && memcmp(LT_PM(0x200), LT_IMAGE, 6000) == 0;
+        BENCH_CHECK(fails, ok, "clean image loads and starts");
+
+        lt_flip(pm[0].buffer);
+        host_dsp.CTRL[0] = 0;
+        loadDSPMemory(&image, 0);
+        ok = !getLoadStatus()->started && host_dsp.CTRL[0] == 0 && !getLoadStatus()->fallback;
+        BENCH_CHECK(fails, ok, "corrupt image without a fallback held in reset");
+    }
+    return fails;
+}
+
+/* Overlay manifests. The Makefile points __dsp_overlay_start__ and
+ * __dsp_overlay_end__ at this section, as sections.ld does on target. */
+#define LT_MANIFEST                 __attribute__((section("dsp_overlay"), used, aligned(8)))
+
+static const overlayRegion lt_afc = { "AFC", 0xC000, 0x2000, 1 << 7 };
+static memoryDescription lt_var_a[2], lt_var_b[1], lt_var_raw[1], lt_var_out[1], lt_var_crc[1];
+
+LT_MANIFEST overlayManifest lt_manifest_a = { "AFC_A", &lt_afc, { lt_var_a, 2 } };
+LT_MANIFEST overlayManifest lt_manifest_b = { "AFC_B", &lt_afc, { lt_var_b, 1 } };
+LT_MANIFEST overlayManifest lt_manifest_raw = { "AFC_B_RAW", &lt_afc, { lt_var_raw, 1 } };
+LT_MANIFEST overlayManifest lt_manifest_out = { "AFC_OUT", &lt_afc, { lt_var_out, 1 } };
+LT_MANIFEST overlayManifest lt_manifest_crc = { "AFC_CRC", &lt_afc, { lt_var_crc, 1 } };
+
+/**
+ * @brief Deferred regions: left out at boot, gated, loaded by loadDeferred()
+ */
+static int lt_deferred(void)
+{
+    static const overlayRegion afc = { "AFC", 0xC000, 0x2000, 1 << 7 };
+    static const overlayRegion test = { "TEST", 0xE000, 0x2000, 3 << 12 };
+    static const overlayRegion *const regions[] = { &afc, &test };
+    volatile uint16_t control = 0xFFFF;
+    memoryDescription pm[4];
+    memoryOverview image = { { pm, 4 }, { NULL, 0 }, { NULL, 0 } };
+    const loadStatus *status = getLoadStatus();
+    int fails = 0;
+    int ok;
+
+    packed_used = 0;
+    pm[0] = (memoryDescription){ LT_IMAGE, 0, 24000, 0x100 };                       /* resident */
+    pm[1] = (memoryDescription){ lt_pack(LT_IMAGE + 0x10000, 6000, 0), 0, 7200, 0x6000 };  /* AFC */
+    pm[2] = (memoryDescription){ LT_IMAGE + 0x20000, 0, 4800, 0x7100 };             /* TEST */
+    pm[3] = (memoryDescription){ LT_IMAGE + 0x30000, 0, 1440, 0x6E00 };             /* AFC into TEST */
+    setLoadFallback(NULL);
+    setLoadDeferred(regions, 2, &control);
+
+    memset(LT_PM(0), 0xA5, 0x10000);
+    host_dsp.CTRL[0] = 0;
+    loadDSPMemory(&image, 0);
+    ok = !status->started && status->straddles == 1 && host_dsp.CTRL[0] == 0 &&
+         LT_PM(0x200)[0] == 0xA5 && control == 0xFFFF;
+    BENCH_CHECK(fails, ok, "section straddling two regions rejects the image");
+
+    image.PM_cntx.count = 3;
+    loadDSPMemory(&image, 0);
+    ok = status->started && memcmp(LT_PM(0x200), LT_IMAGE, 20000) == 0;
+    for (int i = 0xC000; i < 0x10000; i++)
+        ok &= LT_PM(i)[0] == 0xA5;
+    BENCH_CHECK(fails, ok, "resident code loaded, deferred regions untouched");
+    ok = control == (uint16_t)~((1 << 7) | (3 << 12)) && status->held == ((1 << 7) | (3 << 12));
+    BENCH_CHECK(fails, ok, "deferred Control bits cleared at the release (0x%04x)", control);
+
+    host_sysctrl.CM33_LOOP_CACHE_CFG = 0;
+    ok = loadDeferred(&afc, 0) && memcmp(LT_PM(0xC000), LT_IMAGE + 0x10000, 6000) == 0 &&
+         LT_PM(0xE200)[0] == 0xA5 && host_sysctrl.CM33_LOOP_CACHE_CFG == 1;
+    ok &= loadDeferred(&test, 0) && memcmp(LT_PM(0xE200), LT_IMAGE + 0x20000, 4000) == 0;
+    BENCH_CHECK(fails, ok, "loadDeferred fills each region and resets the loop cache");
+
+    lt_flip(pm[1].buffer);
+    BENCH_CHECK(fails, !loadDeferred(&afc, 0), "loadDeferred reports a CRC failure");
+
+    setLoadDeferred(NULL, 0, NULL);
+    return fails;
+}
+
+/**
+ * @brief Overlay variants: found by name, confined to their region, timed
+ */
+static int lt_overlay(void)
+{
+    static uint8_t before[0x10000];
+    const overlayManifest *a = findOverlay("AFC_A");
+    const overlayManifest *b = findOverlay("AFC_B");
+    const overlayManifest *raw = findOverlay("AFC_B_RAW");
+    uint64_t t0;
+    double packed_us, raw_us;
+    int fails = 0;
+    int ok;
+
+    /* PRAM bytes = memSize * 5 / 6; DSP address * 2 = PRAM offset */
+    packed_used = 0;
+    lt_var_a[0] = (memoryDescription){ lt_pack(LT_IMAGE + 0x40000, 3000, 1), 0, 3600, 0x6000 };
+    lt_var_a[1] = (memoryDescription){ lt_pack(LT_IMAGE + 0x41000, 2000, 0), 0, 2400, 0x6800 };
+    lt_var_b[0] = (memoryDescription){ lt_pack(LT_IMAGE + 0x50000, 8000, 0), 0, 9600, 0x6000 };
+    lt_var_raw[0] = (memoryDescription){ LT_IMAGE + 0x50000, 0, 9600, 0x6000 };
+    lt_var_out[0] = (memoryDescription){ LT_IMAGE + 0x60000, 0, 1200, 0x6F00 };  /* ends past 0xE000 */
+    lt_var_crc[0] = (memoryDescription){ lt_pack(LT_IMAGE + 0x60000, 4000, 0), 0, 4800, 0x6000 };
+    lt_flip(lt_var_crc[0].buffer);
+
+    ok = a == &lt_manifest_a && b == &lt_manifest_b && raw == &lt_manifest_raw &&
+         findOverlay("AFC") == NULL && findOverlay("AFC_C") == NULL;
+    BENCH_CHECK(fails, ok, "findOverlay finds the variants by name and nothing else");
+
+    memset(LT_PM(0), 0xA5, 0x10000);
+    host_sysctrl.CM33_LOOP_CACHE_CFG = 0;
+    ok = loadOverlay(a, 0) && memcmp(LT_PM(0xC000), LT_IMAGE + 0x40000, 3000) == 0 &&
+         memcmp(LT_PM(0xD000), LT_IMAGE + 0x41000, 2000) == 0 && host_sysctrl.CM33_LOOP_CACHE_CFG == 1;
+    for (int i = 0; i < 0x10000; i++)
+        ok &= (i >= 0xC000 && i < 0xE000) || LT_PM(i)[0] == 0xA5;
+    BENCH_CHECK(fails, ok, "AFC_A fills its region, PRAM outside it untouched, loop cache reset");
+
+    ok = loadOverlay(b, 0) && memcmp(LT_PM(0xC000), LT_IMAGE + 0x50000, 8000) == 0 &&
+         LT_PM(0xE000)[0] == 0xA5;
+    BENCH_CHECK(fails, ok, "AFC_B replaces AFC_A");
+
+    memcpy(before, LT_PM(0), sizeof(before));
+    ok = !loadOverlay(findOverlay("AFC_OUT"), 0) && memcmp(before, LT_PM(0), sizeof(before)) == 0;
+    BENCH_CHECK(fails, ok, "a variant with a section outside its region is refused, PRAM untouched");
+
+    ok = !loadOverlay(findOverlay("AFC_CRC"), 0);
+    BENCH_CHECK(fails, ok, "a variant that fails its CRC is reported");
+
+    t0 = bench_ns();
+    for (int i = 0; i < LT_SWAPS; i++)
+        loadOverlay(b, 0);
+    packed_us = (double)(bench_ns() - t0) / LT_SWAPS / 1000.0;
+    t0 = bench_ns();
+    for (int i = 0; i < LT_SWAPS; i++)
+        loadOverlay(raw, 0);
+    raw_us = (double)(bench_ns() - t0) / LT_SWAPS / 1000.0;
+    ok = memcmp(LT_PM(0xC000), LT_IMAGE + 0x50000, 8000) == 0;
+    BENCH_CHECK(fails, ok, "repeated swaps leave the variant intact");
+    printf("host time: 8000-byte variant swap %.1f us packed, %.1f us raw "
+           "(on target see App_Codec_OverlayTime)\n", packed_us, raw_us);
+    return fails;
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    static const uintptr_t bases[] = { DSP0_PM_BASE, DSP1_PM_BASE, DSP_DRAM56_BASE, DSP_BRAM01_BASE, DSP_BRAM0_BASE };
+    int fails = 0;
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: loader_test <dsp_pack> <scratch dir>\n");
+        return 2;
+    }
+    packer = argv[1];
+    snprintf(scratch_in, sizeof(scratch_in), "%s/loader_test.bin", argv[2]);
+    snprintf(scratch_out, sizeof(scratch_out), "%s/loader_test.pack", argv[2]);
+
+    for (unsigned i = 0; i < sizeof(bases) / sizeof(bases[0]); i++)
+        lt_map(bases[i], 0x100000);
+    lt_map((uintptr_t)LT_IMAGE, 0x100000);
+    lt_map((uintptr_t)LT_PACKED, 0x1000000);
+
+    /* Compressible test data: random runs and back references */
+    srand(5);
+    for (int i = 0; i < 0x100000; i++)
+        LT_IMAGE[i] = (i % 900 < 300) ? (uint8_t)rand() : LT_IMAGE[i > 500 ? i - (1 + rand() % 400) : 0];
+
+    fails += lt_fallback();
+    fails += lt_deferred();
+    fails += lt_overlay();
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file nfc_bench.c
+ * @brief Host harness for the frequency compressor (nfc.c)
+ *
+ * Runs steady tones through FB_Analysis, NFC_Process and FB_Synthesis and
+ * checks that each leaves at fc * (f / fc)^(1 / ratio), at the input level
+ * and with little energy elsewhere. A tone within a bin of fc straddles the
+ * cutoff, half passed and half compressed, so only its level is checked.
+ * The cases with fc = 1000 Hz put the first compressed input under the
+ * cutoff bin, which NFC_Parser has to clamp; before the clamp that energy
+ * was lost. A sweep over the whole band gives the time per frame.
+ *
+ * Usage: nfc_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include "bench.h"
+#include "filterbank.h"
+#include "nfc.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define NFC_BENCH_LEN               32768       /* samples per case */
+#define NFC_BENCH_TAIL              8192        /* steady part that is analysed */
+#define NFC_BENCH_AMP               0.3
+#define NFC_BENCH_FREQ_TOL          (BENCH_FS / FB_FFT_LEN)     /* one bin */
+#define NFC_BENCH_LEVEL_TOL         2.0         /* dB */
+#define NFC_BENCH_ARTIFACT_MAX      -15.0       /* dB below the tone */
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static NFC_State_t nfc;
+static FB_State_t fb;
+static double out[NFC_BENCH_LEN];
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Run a tone, or a sweep of the given span, through the stage
+ * @return Host time per frame in ns
+ */
+static double nfc_run(double fc, double ratio, double f0, double span)
+{
+    MCU_Config_NFC mcu = { fc, ratio };
+    NFC_Config_t cfg;
+    FB_Spectrum_t spec;
+    double ph = 0.0;
+    uint64_t t = 0;
+
+    NFC_Parser(&mcu, &cfg);
+    NFC_Init(&nfc, &cfg);
+    FB_Init(&fb);
+
+    for (int f = 0; f < NFC_BENCH_LEN / FB_HOP; f++)
+    {
+        Word32 block[FB_HOP];
+        uint64_t t0;
+
+        for (int i = 0; i < FB_HOP; i++)
+        {
+            ph += 2.0 * M_PI * (f0 + span * (f * FB_HOP + i) / NFC_BENCH_LEN) / BENCH_FS;
+            block[i] = (Word32)(NFC_BENCH_AMP * sin(ph) * BENCH_Q31);
+        }
+        FB_Analysis(&fb, block, &spec);
+        t0 = bench_ns();
+        NFC_Process(&nfc, &fb, &spec);
+        t += bench_ns() - t0;
+        FB_Synthesis(&fb, &spec, block);
+        for (int i = 0; i < FB_HOP; i++)
+            out[f * FB_HOP + i] = block[i] / BENCH_Q31;
+    }
+    return (double)t / (NFC_BENCH_LEN / FB_HOP);
+}
+
+/**
+ * @brief Check one steady tone
+ */
+static int nfc_tone(double fc, double ratio, double f0)
+{
+    const double *x = out + NFC_BENCH_LEN - NFC_BENCH_TAIL;
+    double expect = (fc <= 0.0 || f0 <= fc) ? f0 : fc * pow(f0 / fc, 1.0 / ratio);
+    int edge = fc > 0.0 && fabs(f0 - fc) < NFC_BENCH_FREQ_TOL;
+    double best = 0.0, peak = 0.0, total = 0.0, near = 0.0;
+    double level, artifact;
+    int fails = 0;
+
+    nfc_run(fc, ratio, f0, 0.0);
+    for (double f = 20.0; f < BENCH_FS / 2; f += 10.0)
+    {
+        double p = bench_tone_power(x, NFC_BENCH_TAIL, f);
+
+        total += p;
+        if (p > best)
+        {
+            best = p;
+            peak = f;
+        }
+    }
+    for (double f = 20.0; f < BENCH_FS / 2; f += 10.0)
+    {
+        if (fabs(f - peak) <= 40.0)
+            near += bench_tone_power(x, NFC_BENCH_TAIL, f);
+    }
+    level = 20.0 * log10(bench_rms(x, NFC_BENCH_TAIL) / (NFC_BENCH_AMP / sqrt(2.0)));
+    artifact = 10.0 * log10((total - near) / total + 1e-12);
+
+    BENCH_CHECK(fails, fabs(level) <= NFC_BENCH_LEVEL_TOL
+                && (edge || (fabs(peak - expect) <= NFC_BENCH_FREQ_TOL && artifact <= NFC_BENCH_ARTIFACT_MAX)),
+                "fc %5.0f ratio %.1f tone %5.0f -> %5.0f Hz (expect %5.0f)  level %+5.1f dB  artifacts %5.1f dB%s",
+                fc, ratio, f0, peak, expect, level, artifact, edge ? "  (at cutoff)" : "");
+    return fails;
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    static const double tones[] = { 1000, 1100, 1500, 2500, 4000, 6000, 8000, 10000 };
+    static const double maps[][2] = { { 1000, 2.0 }, { 2000, 2.0 }, { 3000, 3.0 }, { 1500, 4.0 } };
+    int fails = 0;
+
+    for (unsigned m = 0; m < sizeof(maps) / sizeof(maps[0]); m++)
+    {
+        for (unsigned i = 0; i < sizeof(tones) / sizeof(tones[0]); i++)
+            fails += nfc_tone(maps[m][0], maps[m][1], tones[i]);
+    }
+    fails += nfc_tone(0.0, 1.0, 4000);
+
+    printf("sweep 500..14500 Hz, fc 1500 ratio 4: %.0f ns/frame (host)\n", nfc_run(1500, 4.0, 500, 14000));
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
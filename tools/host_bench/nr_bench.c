@@ -0,0 +1,199 @@
+/**
+ * @file nr_bench.c
+ * @brief Host harness for the Wiener noise reduction (nr_wiener.c)
+ *
+ * A tone complex gated 0.5 s on, 0.5 s off is mixed with white noise and run
+ * through FB_Analysis and NR_Process at a 12 dB depth. The clean tone and the
+ * noise also go through filterbanks of their own, and each frame their bins
+ * are scaled by the gains NR_Process chose for the mix, so the output speech
+ * and noise are known separately. Over the last half, once the tracker has
+ * settled, the output SNR must beat the input SNR by NR_BENCH_SNR_GAIN and
+ * the noise in the gaps must come down by about the depth. The input level
+ * steps from -20 to -60 dBFS, as the tracker works in the log2 domain and
+ * must not depend on it. The host time per NR_Process frame follows; the CM33
+ * figure is app_stage_cycles_max[APP_STAGE_NR] on the target.
+ *
+ * Usage: nr_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "basic_op.h"
+#include "nr_wiener.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define NR_BENCH_SECONDS            8
+#define NR_BENCH_FRAMES             ((int)(NR_BENCH_SECONDS * BENCH_FS / FB_HOP))
+#define NR_BENCH_GATE               0.5         /* s on, s off */
+#define NR_BENCH_DEPTH              12          /* dB, normal_max_depth_dB */
+#define NR_BENCH_NOISE_DB           (-6.0)      /* noise RMS against the tone RMS */
+#define NR_BENCH_SNR_GAIN           6.0         /* dB, least SNR improvement */
+#define NR_BENCH_DEPTH_TOL          3.0         /* dB, gap attenuation against the depth */
+#define NR_BENCH_TIMED              100000
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static const double tones[] = { 440.0, 1000.0, 2200.0, 3500.0 };
+
+static FB_State_t fb, fb_clean, fb_noise;
+static SM_CONFIG_NC nc;
+static NR_State_t nr;
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Gaussian-ish noise of unit variance
+ */
+static double nr_gauss(void)
+{
+    double s = 0.0;
+
+    for (int i = 0; i < 12; i++)
+        s += (double)rand() / RAND_MAX;
+    return s - 6.0;
+}
+
+/**
+ * @brief Scale every bin of a spectrum by the gains of the last NR_Process
+ */
+static void nr_apply(const FB_State_t *f, FB_Spectrum_t *spec, const Word16 *gain)
+{
+    for (int k = 0; k < FB_BINS; k++)
+    {
+        Word32 v = FB_GetBin(f, spec, k);
+
+        FB_SetBin(f, spec, k, pk_pack(mult_r(PK_LO(v), gain[k]), mult_r(PK_HI(v), gain[k])));
+    }
+}
+
+/**
+ * @brief Run one level; SNRs and the noise attenuation in the gaps over the last half
+ */
+static void nr_run(double level_db, double *snr_in, double *snr_out, double *gap_db)
+{
+    const double amp = pow(10.0, level_db / 20.0) * sqrt(2.0 / (sizeof(tones) / sizeof(tones[0])));
+    const double sigma = pow(10.0, (level_db + NR_BENCH_NOISE_DB) / 20.0);
+    double s_in = 0.0, n_in = 0.0, s_out = 0.0, n_out = 0.0, g_in = 0.0, g_out = 0.0;
+    long n = 0;
+
+    srand(27);
+    FB_Init(&fb);
+    FB_Init(&fb_clean);
+    FB_Init(&fb_noise);
+    NR_Init(&nr, &nc);
+
+    for (int f = 0; f < NR_BENCH_FRAMES; f++)
+    {
+        Word32 mix[FB_HOP], clean[FB_HOP], noise[FB_HOP];
+        FB_Spectrum_t spec, spec_clean, spec_noise;
+        bool measure = f >= NR_BENCH_FRAMES / 2;
+        bool gap = false;
+
+        for (int i = 0; i < FB_HOP; i++, n++)
+        {
+            double t = n / BENCH_FS;
+            double s = 0.0;
+            double w = sigma * nr_gauss();
+
+            gap = fmod(t, 2.0 * NR_BENCH_GATE) >= NR_BENCH_GATE;
+            if (!gap)
+                for (size_t j = 0; j < sizeof(tones) / sizeof(tones[0]); j++)
+                    s += amp * sin(2.0 * M_PI * tones[j] * t + j);
+            clean[i] = (Word32)(s * BENCH_Q31);
+            noise[i] = (Word32)(w * BENCH_Q31);
+            mix[i] = clean[i] + noise[i];
+            if (measure)
+            {
+                s_in += s * s;
+                n_in += w * w;
+                g_in += gap ? w * w : 0.0;
+            }
+        }
+
+        FB_Analysis(&fb, mix, &spec);
+        FB_Analysis(&fb_clean, clean, &spec_clean);
+        FB_Analysis(&fb_noise, noise, &spec_noise);
+        NR_Process(&nr, &fb, &spec);
+        nr_apply(&fb_clean, &spec_clean, nr.gain);
+        nr_apply(&fb_noise, &spec_noise, nr.gain);
+        FB_Synthesis(&fb_clean, &spec_clean, clean);
+        FB_Synthesis(&fb_noise, &spec_noise, noise);
+
+        if (!measure)
+            continue;
+        for (int i = 0; i < FB_HOP; i++)
+        {
+            double c = clean[i] / BENCH_Q31;
+            double w = noise[i] / BENCH_Q31;
+
+            s_out += c * c;
+            n_out += w * w;
+            g_out += gap ? w * w : 0.0;
+        }
+    }
+
+    *snr_in = 10.0 * log10(s_in / n_in);
+    *snr_out = 10.0 * log10(s_out / n_out);
+    *gap_db = 10.0 * log10(g_in / g_out);
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    FB_Spectrum_t spec, s;
+    Word32 block[FB_HOP];
+    uint64_t t;
+    int fails = 0;
+
+    for (int b = 0; b < 32; b++)
+        nc.normal_max_depth_dB[b] = (unsigned char)(-NR_BENCH_DEPTH);
+
+    for (int level = -20; level >= -60; level -= 20)
+    {
+        double snr_in, snr_out, gap;
+
+        nr_run(level, &snr_in, &snr_out, &gap);
+        BENCH_CHECK(fails, snr_out - snr_in >= NR_BENCH_SNR_GAIN,
+                    "%3d dBFS: SNR %5.1f dB in, %5.1f dB out, improvement %5.1f dB",
+                    level, snr_in, snr_out, snr_out - snr_in);
+        BENCH_CHECK(fails, fabs(gap - NR_BENCH_DEPTH) <= NR_BENCH_DEPTH_TOL,
+                    "%3d dBFS: noise in the gaps down %5.1f dB (depth %d dB)", level, gap, NR_BENCH_DEPTH);
+    }
+
+    /* Time per frame on a settled tracker */
+    FB_Init(&fb);
+    NR_Init(&nr, &nc);
+    for (int f = 0; f < NR_BENCH_FRAMES; f++)
+    {
+        for (int i = 0; i < FB_HOP; i++)
+            block[i] = (Word32)(0.01 * nr_gauss() * BENCH_Q31);
+        FB_Analysis(&fb, block, &spec);
+        NR_Process(&nr, &fb, &spec);
+    }
+    t = bench_ns();
+    for (int r = 0; r < NR_BENCH_TIMED; r++)
+    {
+        memcpy(&s, &spec, sizeof(s));
+        NR_Process(&nr, &fb, &s);
+    }
+    t = bench_ns() - t;
+
+    printf("host time: %.2f us/frame\n", (double)t / NR_BENCH_TIMED / 1000.0);
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file resample_bench.c
+ * @brief Host harness for the stream resampler (resample.c)
+ *
+ * For each source rate of resample.h, 8, 16, 24, 44.1 and 48 kHz, into
+ * SRC_OUT_RATE:
+ *   - a 1 kHz tone keeps its level, and the residual after the best-fit sine
+ *     gives the SNR
+ *   - image rejection: from 8 kHz, a 3 kHz tone against its images at
+ *     k * 8 kHz +/- 3 kHz; above the output rate, a tone past the output
+ *     Nyquist against what folds back into the band. Both are taken relative
+ *     to the 1 kHz tone. From 16 kHz the input band ends inside the
+ *     transition band, so the figure is printed but not checked.
+ *   - with the source clock 300 ppm fast and slow, the drift correction
+ *     holds the FIFO fill with no underrun or overrun
+ * The table that follows gives the multiplies per output sample, which
+ * scale the CM33 cost, and the host time per 16-sample SM_Dec block; the
+ * CM33 cost shows in the main-loop time of APP_Audio_StreamPump on target.
+ *
+ * Usage: resample_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "basic_op.h"
+#include "resample.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define SRC_BENCH_OUT               60000       /* output samples per tone */
+#define SRC_BENCH_DRIFT_OUT         200000      /* output samples per drift run */
+#define SRC_BENCH_WIN               4096        /* analysed tail */
+#define SRC_BENCH_AMP               0.5
+#define SRC_BENCH_PPM               300.0
+#define SRC_BENCH_LEVEL_TOL         1.0         /* dB */
+#define SRC_BENCH_SNR_MIN           50.0        /* dB */
+#define SRC_BENCH_IMAGE_MIN         60.0        /* dB */
+#define SRC_BENCH_TIMED             200000      /* blocks */
+
+/* ----------------------------------------------------------------------------
+ * Local variables
+ * --------------------------------------------------------------------------*/
+
+static const uint32_t rates[] = { 8000, 16000, 24000, 44100, 48000 };
+
+static SRC_Config_t cfg;
+static SRC_State_t src;
+static double y[SRC_BENCH_DRIFT_OUT];
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * @brief Stream a tone at rate * (1 + ppm) through the resampler into y[]
+ * @note  The source writes what it has produced by each SM_Dec block, as a
+ *        stream decoder would; the fill is tracked over the second half.
+ */
+static void src_run(uint32_t rate, double f, double ppm, int nout, int *fill_min, int *fill_max)
+{
+    const double rin = rate * (1.0 + ppm * 1e-6);
+    double due = 0.0;
+    long ni = 0;
+    int k = 0;
+
+    SRC_Parser(rate, &cfg);
+    SRC_Init(&src, &cfg);
+    *fill_min = SRC_FIFO;
+    *fill_max = 0;
+    while (k < nout)
+    {
+        Word32 o[AUDIO_BLOCK];
+
+        for (due += AUDIO_BLOCK * rin / SRC_OUT_RATE; due >= 1.0; due -= 1.0, ni++)
+        {
+            Word32 x = (Word32)lround(SRC_BENCH_AMP * BENCH_Q31 * sin(2.0 * M_PI * f * ni / rin));
+
+            SRC_Write(&src, &x, 1);
+        }
+        SRC_Read(&src, o, AUDIO_BLOCK);
+        for (int i = 0; i < AUDIO_BLOCK && k < nout; i++)
+            y[k++] = o[i] / BENCH_Q31;
+        if (k > nout / 2)
+        {
+            int fill = SRC_Fill(&src);
+
+            *fill_min = (fill < *fill_min) ? fill : *fill_min;
+            *fill_max = (fill > *fill_max) ? fill : *fill_max;
+        }
+    }
+}
+
+/**
+ * @brief Power at f of the analysed tail of y[], Hann window, output rate
+ */
+static double src_power(int nout, double f)
+{
+    const double *x = y + nout - SRC_BENCH_WIN;
+    double re = 0.0, im = 0.0;
+
+    for (int i = 0; i < SRC_BENCH_WIN; i++)
+    {
+        double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / SRC_BENCH_WIN);
+
+        re += w * x[i] * cos(2.0 * M_PI * f * i / SRC_OUT_RATE);
+        im += w * x[i] * sin(2.0 * M_PI * f * i / SRC_OUT_RATE);
+    }
+    return re * re + im * im;
+}
+
+/**
+ * @brief Level against SRC_BENCH_AMP and SNR of the tail against its best-fit sine
+ */
+static double src_snr(int nout, double f, double *level)
+{
+    const double *x = y + nout - SRC_BENCH_WIN;
+    double best = 0.0, bf = f;
+    double c = 0.0, s = 0.0, e = 0.0, p = 0.0;
+
+    /* The drift loop leaves a small steady step error, so search the frequency */
+    for (double span = f * 0.005; span > f * 1e-7; span /= 10.0)
+    {
+        double f0 = bf;
+
+        for (double ff = f0 - span; ff <= f0 + span; ff += span / 10.0)
+        {
+            double pw = src_power(nout, ff);
+
+            if (pw > best)
+            {
+                best = pw;
+                bf = ff;
+            }
+        }
+    }
+
+    for (int i = 0; i < SRC_BENCH_WIN; i++)
+    {
+        c += x[i] * cos(2.0 * M_PI * bf * i / SRC_OUT_RATE);
+        s += x[i] * sin(2.0 * M_PI * bf * i / SRC_OUT_RATE);
+    }
+    c *= 2.0 / SRC_BENCH_WIN;
+    s *= 2.0 / SRC_BENCH_WIN;
+    for (int i = 0; i < SRC_BENCH_WIN; i++)
+    {
+        double m = c * cos(2.0 * M_PI * bf * i / SRC_OUT_RATE) + s * sin(2.0 * M_PI * bf * i / SRC_OUT_RATE);
+
+        e += (x[i] - m) * (x[i] - m);
+        p += m * m;
+    }
+    *level = 20.0 * log10(sqrt(c * c + s * s) / SRC_BENCH_AMP);
+    return 10.0 * log10(p / e);
+}
+
+/**
+ * @brief Fold a frequency into 0..SRC_OUT_RATE/2
+ */
+static double src_fold(double f)
+{
+    f = fmod(f, SRC_OUT_RATE);
+    return (f > SRC_OUT_RATE / 2.0) ? SRC_OUT_RATE - f : f;
+}
+
+/**
+ * @brief Rejection in dB of the spurious tones, relative to ref, for a test tone at rate
+ * @param test  set to the test tone frequency
+ */
+static double src_image(uint32_t rate, double ref, double *test)
+{
+    double spur = 0.0;
+    int lo, hi;
+
+    if (rate < SRC_OUT_RATE)
+    {
+        /* Images at k * rate +/- f, folded into the output band */
+        *test = 3000.0;
+        src_run(rate, *test, 0.0, SRC_BENCH_OUT, &lo, &hi);
+        for (int k = 1; k <= 3; k++)
+        {
+            spur = fmax(spur, src_power(SRC_BENCH_OUT, src_fold(k * (double)rate - *test)));
+            spur = fmax(spur, src_power(SRC_BENCH_OUT, src_fold(k * (double)rate + *test)));
+        }
+    }
+    else
+    {
+        /* Halfway between the output Nyquist and the top of the input band */
+        *test = (SRC_OUT_RATE / 2.0 + fmin(rate / 2.0, SRC_OUT_RATE)) / 2.0;
+        src_run(rate, *test, 0.0, SRC_BENCH_OUT, &lo, &hi);
+        spur = src_power(SRC_BENCH_OUT, src_fold(*test));
+    }
+    return 10.0 * log10(ref / spur);
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const int nrates = sizeof(rates) / sizeof(rates[0]);
+    int taps[sizeof(rates) / sizeof(rates[0])];
+    double us[sizeof(rates) / sizeof(rates[0])];
+    int fails = 0;
+
+    for (int r = 0; r < nrates; r++)
+    {
+        uint32_t rate = rates[r];
+        double level, snr, ref, image, test;
+        int lo, hi, lo2, hi2, under, over;
+
+        src_run(rate, 1000.0, 0.0, SRC_BENCH_OUT, &lo, &hi);
+        snr = src_snr(SRC_BENCH_OUT, 1000.0, &level);
+        ref = src_power(SRC_BENCH_OUT, 1000.0);
+        taps[r] = cfg.taps;
+        BENCH_CHECK(fails, fabs(level) <= SRC_BENCH_LEVEL_TOL && snr >= SRC_BENCH_SNR_MIN,
+                    "%5.1f kHz: 1 kHz tone %5.2f dB, SNR %4.1f dB", rate / 1000.0, level, snr);
+
+        image = src_image(rate, ref, &test);
+        if (rate == 16000)
+            printf("      %5.1f kHz: %4.0f Hz tone, images %4.1f dB down (in the transition band, not checked)\n",
+                   rate / 1000.0, test, image);
+        else
+            BENCH_CHECK(fails, image >= SRC_BENCH_IMAGE_MIN, "%5.1f kHz: %4.0f Hz tone, images %4.1f dB down",
+                        rate / 1000.0, test, image);
+
+        src_run(rate, 1000.0, SRC_BENCH_PPM, SRC_BENCH_DRIFT_OUT, &lo, &hi);
+        under = (int)src.underruns;
+        over = (int)src.overruns;
+        src_run(rate, 1000.0, -SRC_BENCH_PPM, SRC_BENCH_DRIFT_OUT, &lo2, &hi2);
+        under += (int)src.underruns;
+        over += (int)src.overruns;
+        BENCH_CHECK(fails, under == 0 && over == 0,
+                    "%5.1f kHz: +/-%.0f ppm, fill %d..%d and %d..%d of %d, %d underruns, %d overruns",
+                    rate / 1000.0, SRC_BENCH_PPM, lo, hi, lo2, hi2, SRC_FIFO, under, over);
+
+        /* Host time per SM_Dec block with the FIFO kept above half */
+        {
+            Word32 in[64], o[AUDIO_BLOCK];
+            uint64_t t;
+
+            for (int j = 0; j < 64; j++)
+                in[j] = (rand() - RAND_MAX / 2) * 2;
+            SRC_Init(&src, &cfg);
+            t = bench_ns();
+            for (int b = 0; b < SRC_BENCH_TIMED; b++)
+            {
+                while (SRC_Fill(&src) < SRC_FIFO / 2 + 64)
+                    SRC_Write(&src, in, 64);
+                SRC_Read(&src, o, AUDIO_BLOCK);
+            }
+            us[r] = (double)(bench_ns() - t) / SRC_BENCH_TIMED / 1000.0;
+        }
+    }
+
+    printf("rate      taps  MACs/sample  host us/block\n");
+    for (int r = 0; r < nrates; r++)
+        printf("%5.1f kHz  %3d  %11d  %13.2f\n", rates[r] / 1000.0, taps[r], 2 * taps[r], us[r]);
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
@@ -0,0 +1,227 @@
+/**
+ * @file scene_bench.c
+ * @brief Replay harness for the scene classifier (scene.c)
+ *
+ * Replays nine labelled synthetic segments of 20 s each through the stages
+ * that feed the classifier on the target: VAD and the filterbank NR, each
+ * with its UPLOAD dump, plus the DSP's 8-band RMS_dBSPL, which is modelled
+ * here as the smoothed broadband power split evenly over the bands. Every
+ * SCENE_PERIOD frames SCENE_Classify decides as APP_Audio_Scene does.
+ *
+ * Checks that every decision in the second half of each segment matches
+ * its label, and that the switch comes within SCENE_BENCH_LATENCY_MAX.
+ * Prints the confusion matrix and the host time per decision.
+ *
+ * Usage: scene_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "basic_op.h"
+#include "filterbank.h"
+#include "nr_wiener.h"
+#include "vad.h"
+#include "scene.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define SCENE_BENCH_MAXDB           110.0       /* MCU_WDRC.maxdB */
+#define SCENE_BENCH_SEGMENT         20.0        /* s */
+#define SCENE_BENCH_LATENCY_MAX     6.0         /* s, SCENE_CONFIRM plus the feature smoothing */
+
+/* ----------------------------------------------------------------------------
+ * Local types and variables
+ * --------------------------------------------------------------------------*/
+
+typedef struct
+{
+    int label;
+    double signal_db;                   /* dB SPL, 0 for none */
+    double noise_db;
+} SceneSegment_t;
+
+static const SceneSegment_t segments[] =
+{
+    { SCENE_QUIET, 0, 35 },
+    { SCENE_SPEECH, 65, 40 },
+    { SCENE_NOISE, 0, 68 },
+    { SCENE_SPEECH_IN_NOISE, 72, 66 },
+    { SCENE_MUSIC, 72, 35 },
+    { SCENE_SPEECH, 62, 38 },
+    { SCENE_QUIET, 0, 38 },
+    { SCENE_MUSIC, 68, 45 },
+    { SCENE_NOISE, 0, 60 },
+};
+
+static const char *const names[SCENE_NUM] = { "quiet", "speech", "sp-noise", "noise", "music" };
+
+static FB_State_t fb;
+static FB_Spectrum_t spec;
+static NR_State_t nr;
+static SM_CONFIG_NC nc;
+static VAD_State_t vad;
+static SCENE_State_t scene;
+static SM_UPLOAD_DATA upload;
+
+static double phase[8];
+static double pink;
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+static double scene_uniform(void)
+{
+    return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+static double scene_gauss(void)
+{
+    return 0.866 * (scene_uniform() + scene_uniform() + scene_uniform() + scene_uniform());
+}
+
+/**
+ * @brief Peak amplitude of a sine at a level in dB SPL
+ */
+static double scene_amp(double db)
+{
+    return pow(10.0, (db - SCENE_BENCH_MAXDB) / 20.0) * 0.7071;
+}
+
+/**
+ * @brief One sample of a labelled scene
+ * @note  Speech is a gliding harmonic voice with a syllable envelope, music
+ *        a harmonic melody with sustained notes, noise slightly pink.
+ */
+static double scene_sample(const SceneSegment_t *seg, long n)
+{
+    double t = n / BENCH_FS;
+    double w = scene_gauss();
+    double s = 0.0;
+
+    pink = 0.97 * pink + 0.3 * w;
+    if (seg->label == SCENE_SPEECH || seg->label == SCENE_SPEECH_IN_NOISE)
+    {
+        double e = 0.5 + 0.5 * sin(2.0 * M_PI * 4.0 * t + sin(2.0 * M_PI * 0.7 * t));
+        double f = 150.0 * (1.0 + 0.1 * sin(2.0 * M_PI * 1.3 * t));
+
+        for (int h = 1; h <= 8; h++)
+        {
+            phase[h - 1] += 2.0 * M_PI * f * h / BENCH_FS;
+            s += sin(phase[h - 1]) / h;
+        }
+        s = scene_amp(seg->signal_db) * 2.8 * e * e * e * (0.6 * s + 0.3 * scene_gauss());
+    }
+    else if (seg->label == SCENE_MUSIC)
+    {
+        static const double notes[6] = { 220, 262, 330, 392, 440, 523 };
+        int k = (int)(t * 2.0) % 6;
+
+        for (int h = 1; h <= 6; h++)
+        {
+            phase[h - 1] += 2.0 * M_PI * notes[k] * h / BENCH_FS;
+            s += sin(phase[h - 1]) / h;
+        }
+        phase[7] += 2.0 * M_PI * notes[(k + 2) % 6] * 1.5 / BENCH_FS;
+        s += 0.5 * sin(phase[7]);
+        s = scene_amp(seg->signal_db) * (1.0 - 0.4 * fmod(t * 2.0, 1.0)) * 0.9 * s;
+    }
+    return s + scene_amp(seg->noise_db) * (0.6 * w + 0.4 * pink);
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const int nseg = sizeof(segments) / sizeof(segments[0]);
+    const int seg_frames = (int)(SCENE_BENCH_SEGMENT * BENCH_FS / FB_HOP);
+    int confusion[SCENE_NUM][SCENE_NUM] = { { 0 } };
+    VAD_Config_t vad_cfg;
+    SCENE_Config_t scene_cfg;
+    double power = 0.0;
+    uint64_t t = 0;
+    int decisions = 0, frames = 0;
+    long n = 0;
+    int fails = 0;
+
+    srand(1);
+    FB_Init(&fb);
+    NR_Init(&nr, &nc);
+    VAD_Parser(SCENE_BENCH_MAXDB, &vad_cfg);
+    VAD_Init(&vad, &vad_cfg);
+    SCENE_Parser(SCENE_BENCH_MAXDB, &scene_cfg);
+    SCENE_Init(&scene, &scene_cfg);
+
+    for (int s = 0; s < nseg; s++)
+    {
+        const SceneSegment_t *seg = &segments[s];
+        int latency = -1, right = 0, total = 0;
+
+        for (int f = 0; f < seg_frames; f++)
+        {
+            Word32 block[FB_HOP];
+            double e = 0.0;
+
+            for (int i = 0; i < FB_HOP; i++)
+            {
+                double x = scene_sample(seg, n++);
+
+                x = (x > 0.999) ? 0.999 : (x < -0.999) ? -0.999 : x;
+                block[i] = (Word32)(x * BENCH_Q31);
+                e += x * x;
+            }
+            power += 0.01 * (e / FB_HOP - power);
+
+            VAD_Process(&vad, block, NULL);
+            VAD_Dump(&vad, &upload);
+            FB_Analysis(&fb, block, &spec);
+            NR_Process(&nr, &fb, &spec);
+            NR_Dump(&nr, &upload);
+            for (int b = 0; b < 8; b++)
+                upload.RMS_dBSPL[b] = (short)lround(10.0 * log10(power / 0.5 / 8 + 1e-12) * 128.0);
+
+            if (++frames >= SCENE_PERIOD)
+            {
+                uint64_t t0 = bench_ns();
+
+                frames = 0;
+                SCENE_Classify(&scene, &upload);
+                t += bench_ns() - t0;
+                decisions++;
+
+                if (latency < 0 && scene.scene == seg->label)
+                    latency = f;
+                if (f > seg_frames / 2)
+                {
+                    confusion[seg->label][scene.scene]++;
+                    right += scene.scene == seg->label;
+                    total++;
+                }
+            }
+        }
+        BENCH_CHECK(fails, right == total && latency >= 0 && latency * FB_HOP / BENCH_FS <= SCENE_BENCH_LATENCY_MAX,
+                    "segment %d %-8s  %3d of %3d decisions right  switch after %.1f s", s, names[seg->label],
+                    right, total, (latency < 0) ? -1.0 : latency * FB_HOP / BENCH_FS);
+    }
+
+    printf("confusion over the second halves, rows are labels:\n");
+    for (int i = 0; i < SCENE_NUM; i++)
+    {
+        printf("  %-8s", names[i]);
+        for (int j = 0; j < SCENE_NUM; j++)
+            printf(" %4d", confusion[i][j]);
+        printf("\n");
+    }
+    printf("%.2f us/decision (host)\n", (double)t / decisions / 1000.0);
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file hw.h
+ * @brief Host stand-in for the RSL20 hw.h, enough to build loader.c
+ *
+ * Peripheral blocks are plain structs the harness owns. DSP memory lives at
+ * the real CM33 addresses, which the harness maps before loading; the CRC
+ * block is modelled in software by crc_mock().
+ */
+
+#ifndef TOOLS_HOST_BENCH_STUB_HW_H_
+#define TOOLS_HOST_BENCH_STUB_HW_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DSP0_PM_BASE                    0x20000000u
+#define DSP1_PM_BASE                    0x20100000u
+#define DSP_DRAM56_BASE                 0x20200000u
+#define DSP_BRAM01_BASE                 0x20300000u
+#define DSP_BRAM0_BASE                  0x20400000u
+
+typedef struct { volatile uint32_t STATUS; } DMA_Type;
+extern DMA_Type host_dma0;
+#define DMA0                            (&host_dma0)
+#define DMA_LITTLE_ENDIAN               0
+#define DEST_TRANS_LENGTH_SEL           0
+#define DMA_PRIORITY_0                  0
+#define DMA_SRC_ALWAYS_ON               0
+#define DMA_DEST_ALWAYS_ON              0
+#define WORD_SIZE_32BITS_TO_32BITS      0
+#define DMA_SRC_ADDR_INCR_1             0
+#define DMA_DEST_ADDR_INCR_1            0
+#define DMA_SRC_ADDR_LSB_TOGGLE_DISABLE 0
+#define DMA_CNT_INT_DISABLE             0
+#define DMA_COMPLETE_INT_DISABLE        0
+#define DMA_COMPLETE_INT_TRUE           2
+#define DMA_COMPLETE_INT_CLEAR          2
+#define DMA_ENABLE                      1
+#define DMA_DISABLE                     0
+void Sys_DMA_ChannelConfig(DMA_Type *dma, uint32_t cfg, uint32_t words, uint32_t cnt, uint32_t src, uint32_t dst);
+void Sys_DMA_Mode_Enable(DMA_Type *dma, uint32_t mode);
+
+typedef struct { uint32_t CM33_LOOP_CACHE_CFG; } SYSCTRL_Type;
+extern SYSCTRL_Type host_sysctrl;
+#define SYSCTRL                         (&host_sysctrl)
+
+typedef struct { uint32_t CTRL[2]; } DSP_Type;
+extern DSP_Type host_dsp;
+#define DSP                             (&host_dsp)
+#define DSP_RESET                       1
+
+typedef struct { uint32_t DEMCR; } CD_Type;
+extern CD_Type host_coredebug;
+#define CoreDebug                       (&host_coredebug)
+#define CoreDebug_DEMCR_TRCENA_Msk      1
+
+typedef struct { uint32_t CYCCNT, CTRL; } DWT_Type;
+extern DWT_Type host_dwt;
+#define DWT                             (&host_dwt)
+#define DWT_CTRL_CYCCNTENA_Msk          1
+
+extern uint32_t SystemCoreClock;
+
+/* CRC block: a write is consumed at the next access to the block */
+typedef struct { uint64_t VALUE, ADD_8, ADD_32; uint32_t FINAL; } CRC_Mock;
+CRC_Mock *crc_mock(void);
+#define CRC                             (crc_mock())
+#define CRC_LITTLE_ENDIAN               0
+#define CRC_BIT_ORDER_STANDARD          0
+#define CRC_CCITT_INIT_VALUE            0xFFFF
+#define SYS_CRC_CONFIG(x)               ((void)(x))
+
+#endif /* TOOLS_HOST_BENCH_STUB_HW_H_ */
@@ -0,0 +1,225 @@
+/**
+ * @file transient_bench.c
+ * @brief Transient test set for the transient suppressor (transient.c)
+ *
+ * No recordings ship with the tree, so synthetic impulses stand in for
+ * them, repeated every 300 ms over 3 s of background:
+ *   clatter  decaying 2.5, 4.1 and 5.7 kHz resonances
+ *   door     an 80 Hz thump with a noisy tail
+ *   clap     a 5 ms noise burst
+ * and the backgrounds are speech-like noise with 20 ms syllable onsets,
+ * music with slow attacks, and steady noise.
+ *
+ * Checks that every impulse is pulled down by TR_BENCH_IMPULSE_MIN within
+ * 2 ms of its onset, that the backgrounds alone are left nearly untouched
+ * (music never reduced, speech and noise only rarely and shallowly), and
+ * that the signal between impulses comes through TR_LOOKAHEAD late and
+ * otherwise unchanged. The time per frame follows.
+ *
+ * Usage: transient_bench
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "basic_op.h"
+#include "transient.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+#define TR_BENCH_MAXDB              120.0f      /* MCU_WDRC.maxdB */
+#define TR_BENCH_LEN                (31250 * 3)
+#define TR_BENCH_PERIOD             0.3         /* s between impulses */
+#define TR_BENCH_ONSET              0.002       /* s after each impulse that is checked */
+#define TR_BENCH_IMPULSE_MIN        5.0         /* dB peak reduction */
+#define TR_BENCH_PASS_SNR_MIN       25.0        /* dB, between impulses */
+#define TR_BENCH_DEPTH_DB           (6.02 / 256.0)      /* TR_State_t.depth to dB */
+
+/* ----------------------------------------------------------------------------
+ * Local types and variables
+ * --------------------------------------------------------------------------*/
+
+enum { TR_BENCH_SPEECH, TR_BENCH_MUSIC, TR_BENCH_NOISE };
+enum { TR_BENCH_NONE, TR_BENCH_CLATTER, TR_BENCH_DOOR, TR_BENCH_CLAP };
+
+static const char *const backgrounds[] = { "speech", "music", "noise" };
+static const char *const impulses[] = { "none", "clatter", "door", "clap" };
+
+/* Background share of the frames reduced, and deepest reduction, allowed */
+static const double bg_frames_max[] = { 0.10, 0.0, 0.02 };
+static const double bg_depth_max[] = { 6.0, 0.0, 12.0 };
+
+static TR_State_t tr;
+static double bg[TR_BENCH_LEN];
+static double imp[TR_BENCH_LEN];
+static Word32 x[TR_BENCH_LEN];
+static Word32 y[TR_BENCH_LEN];
+
+/* ----------------------------------------------------------------------------
+ * Local functions
+ * --------------------------------------------------------------------------*/
+
+static double tr_gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/**
+ * @brief Fill bg[] with one background
+ */
+static void tr_background(int kind)
+{
+    double s = 0.0;
+    double a = exp(-2.0 * M_PI * 700.0 / BENCH_FS);
+
+    for (int n = 0; n < TR_BENCH_LEN; n++)
+    {
+        if (kind == TR_BENCH_SPEECH)
+        {
+            double w = tr_gauss();
+            double t = fmod(n / BENCH_FS, 0.25);
+            double e = (t < 0.02) ? 0.03 + 0.97 * (0.5 - 0.5 * cos(M_PI * t / 0.02)) :
+                       (t < 0.15) ? 1.0 : 0.03 + 0.97 * exp(-(t - 0.15) / 0.02);
+
+            s = a * s + (1.0 - a) * w;
+            bg[n] = 0.01 * (0.3 * w + 3.0 * s) * e;
+        }
+        else if (kind == TR_BENCH_MUSIC)
+        {
+            double t = fmod(n / BENCH_FS, 0.5);
+            double e = (t < 0.02) ? t / 0.02 : exp(-(t - 0.02) / 0.3);
+            double p = 2.0 * M_PI * 440.0 * n / BENCH_FS;
+
+            bg[n] = 0.01 * e * (sin(p) + 0.5 * sin(2.0 * p) + 0.3 * sin(3.0 * p) + 0.2 * sin(8.0 * p));
+        }
+        else
+        {
+            bg[n] = 0.003 * tr_gauss();
+        }
+    }
+}
+
+/**
+ * @brief Fill imp[] with one impulse train
+ */
+static void tr_impulse(int kind)
+{
+    for (int n = 0; n < TR_BENCH_LEN; n++)
+    {
+        double t = fmod(n / BENCH_FS, TR_BENCH_PERIOD);
+
+        switch (kind)
+        {
+        case TR_BENCH_CLATTER:
+            imp[n] = 0.1 * exp(-t / 0.015) * (sin(2.0 * M_PI * 2500.0 * t) + 0.8 * sin(2.0 * M_PI * 4100.0 * t + 1.0) +
+                                              0.6 * sin(2.0 * M_PI * 5700.0 * t + 2.0));
+            break;
+        case TR_BENCH_DOOR:
+            imp[n] = 0.3 * exp(-t / 0.03) * (sin(2.0 * M_PI * 80.0 * t) + 0.3 * tr_gauss());
+            break;
+        case TR_BENCH_CLAP:
+            imp[n] = (t < 0.005) ? 0.3 * exp(-t / 0.002) * tr_gauss() : 0.0;
+            break;
+        default:
+            imp[n] = 0.0;
+            break;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Main
+ * --------------------------------------------------------------------------*/
+
+int main(void)
+{
+    TR_Config_t cfg;
+    uint64_t t = 0;
+    int frames = 0;
+    int fails = 0;
+
+    TR_Parser(TR_BENCH_MAXDB, &cfg);
+    for (int b = 0; b < 3; b++)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            double pin = 0.0, pout = 0.0, err = 0.0, sig = 0.0, depth = 0.0;
+            double reduced, snr;
+            int red = 0;
+            uint64_t t0;
+
+            srand(1);
+            tr_background(b);
+            tr_impulse(k);
+            TR_Init(&tr, &cfg);
+            for (int n = 0; n < TR_BENCH_LEN; n++)
+            {
+                double v = bg[n] + imp[n];
+
+                v = (v > 0.999) ? 0.999 : (v < -0.999) ? -0.999 : v;
+                x[n] = y[n] = (Word32)(v * BENCH_Q31);
+            }
+
+            t0 = bench_ns();
+            for (int f = 0; f < TR_BENCH_LEN / AUDIO_BLOCK_SIZE; f++)
+            {
+                TR_Process(&tr, y + f * AUDIO_BLOCK_SIZE);
+                if (tr.depth > 0)
+                    red++;
+                if (tr.depth * TR_BENCH_DEPTH_DB > depth)
+                    depth = tr.depth * TR_BENCH_DEPTH_DB;
+            }
+            t += bench_ns() - t0;
+            frames += TR_BENCH_LEN / AUDIO_BLOCK_SIZE;
+
+            /* Skip the first 100 ms, where the envelopes settle */
+            for (int n = TR_BENCH_LEN / 30; n < TR_BENCH_LEN - TR_LOOKAHEAD; n++)
+            {
+                double xi = x[n] / BENCH_Q31;
+                double yo = y[n + TR_LOOKAHEAD] / BENCH_Q31;
+                double p = fmod(n / BENCH_FS, TR_BENCH_PERIOD);
+
+                if (p < TR_BENCH_ONSET)
+                {
+                    pin = fmax(pin, fabs(xi));
+                    pout = fmax(pout, fabs(yo));
+                }
+                else if (p > TR_BENCH_PERIOD / 3)
+                {
+                    err += (yo - xi) * (yo - xi);
+                    sig += xi * xi;
+                }
+            }
+            reduced = (double)red / (TR_BENCH_LEN / AUDIO_BLOCK_SIZE);
+            snr = 10.0 * log10(sig / (err + 1e-30));
+
+            if (k == TR_BENCH_NONE)
+            {
+                BENCH_CHECK(fails, reduced <= bg_frames_max[b] && depth <= bg_depth_max[b] + 0.05 &&
+                            snr >= TR_BENCH_PASS_SNR_MIN,
+                            "%-6s alone          reduced in %4.1f%% of frames, at most %4.1f dB, SNR %4.1f dB",
+                            backgrounds[b], 100.0 * reduced, depth, snr);
+            }
+            else
+            {
+                double drop = 20.0 * log10(pin / pout);
+
+                BENCH_CHECK(fails, drop >= TR_BENCH_IMPULSE_MIN && snr >= TR_BENCH_PASS_SNR_MIN,
+                            "%-6s + %-8s  peak %5.1f -> %5.1f dBFS (%4.1f dB down), SNR between %4.1f dB",
+                            backgrounds[b], impulses[k], 20.0 * log10(pin), 20.0 * log10(pout), drop, snr);
+            }
+        }
+    }
+
+    printf("%.2f us/frame (host)\n", (double)t / frames / 1000.0);
+    printf("%s\n", fails ? "FAILED" : "passed");
+    return fails != 0;
+}